@@ -19,7 +19,27 @@ typedef struct
     uint32_t dst_stride;
 } hal_idu_decompress_info;
 
+typedef struct hal_idu_decompress_job
+{
+    hal_idu_decompress_info info;
+    uint8_t *dst;
+    void (*callback)(struct hal_idu_decompress_job *job);   /* called from whichever of the IDU IRQ,
+                                                               hal_idu_decompress_busy or a blocking
+                                                               call retires the job */
+    void *user_data;
+    volatile bool done;
+    bool success;
+    struct hal_idu_decompress_job *next;
+} hal_idu_decompress_job;
+
 void hal_dma_copy(hal_idu_dma_info *info, uint8_t *src, uint8_t *dst);
 bool hal_idu_decompress(hal_idu_decompress_info *info, uint8_t *dst);
 bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst);
+/* Queue a rect decode; jobs run back-to-back. hal_idu_irq_handler called from IDU_Handler retires
+ * them, otherwise polling hal_idu_decompress_busy or any blocking call does.
+ * Rejected when its DMA chains exceed CONFIG_REALTEK_IDU_HAL_LLI_ARENA_SIZE. */
+bool hal_idu_decompress_rect_async(hal_idu_decompress_job *job);
+bool hal_idu_decompress_busy(void);
+/* Returns false when the interrupt is not the HAL's, e.g. from IDU_Decode_Ex */
+bool hal_idu_irq_handler(void);
 void hal_dma_channel_init(uint8_t *high_speed_channel, uint8_t *low_speed_channel);
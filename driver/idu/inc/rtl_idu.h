@@ -114,6 +114,8 @@ typedef enum
     IDU_ERROR_END_EXCEED_BOUNDARY,
     IDU_ERROR_START_LARGER_THAN_END,
     IDU_ERROR_INVALID_PARAM,
+    IDU_ERROR_LLI_EXHAUSTED,
+    IDU_ERROR_BUSY,
 } IDU_ERROR;
 
 typedef enum
@@ -512,6 +514,8 @@ IDU_ERROR IDU_Decode(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *dma
  * \param[in] dma_cfg       determine which DMA channel is selected.
  * \return operation result
  * \retval IDU_SUCCESS    Operation started.
+ * \retval IDU_ERROR_BUSY The previous IDU_Decode_Ex/IDU_Decode_Direct still holds pool descriptors
+ *                       and IDU or its DMA is still running.
  * \retval others           Operation aborted.
  *
  * <b>Example usage</b>
@@ -620,6 +624,8 @@ void IDU_Init(IDU_InitTypeDef *IDU_init_struct);
  * \param[in] dma_cfg       determine which DMA channel is selected.
  * \return operation result
  * \retval IDU_SUCCESS    Operation success.
+ * \retval IDU_ERROR_BUSY The previous IDU_Decode_Ex/IDU_Decode_Direct still holds pool descriptors
+ *                       and IDU or its DMA is still running.
  * \retval others           Operation failure.
  *
  * <b>Example usage</b>
@@ -639,6 +645,64 @@ void IDU_Init(IDU_InitTypeDef *IDU_init_struct);
 IDU_ERROR IDU_Decode_Direct(uint8_t *file, IDU_decode_range *range,
                               IDU_DMA_config *dma_cfg);
 
+/**
+ * \brief  Return the DMA descriptors held by the last IDU_Decode_Ex/IDU_Decode_Direct to the pool
+ * \note   Call after the decode has finished. Optional: the next IDU_Decode_Ex/IDU_Decode_Direct
+ *         frees them itself once IDU and DMA have stopped. Releasing early is only needed to
+ *         make them available to IDU_Decode, or after a decode that failed with DMA left
+ *         running.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void IDU_Handler(void){
+        if(IDU_GetINTStatus(IDU_DECOMPRESS_FINISH_INT_STATUS_MSK) == SET){
+            IDU_ClearINTPendingBit(IDU_DECOMPRESS_FINISH_INT_STATUS_MSK);
+            IDU_Decode_Release();
+        }
+    }
+ * \endcode
+ */
+void IDU_Decode_Release(void);
+
+/**
+ * \brief  Get the peak number of DMA descriptors used from the IDU LLI pool
+ * \return high-water mark, compare against CONFIG_REALTEK_IDU_LLI_POOL_SIZE
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        DBG_DIRECT("IDU LLI high water %d", IDU_Get_LLI_High_Water());
+    }
+ * \endcode
+ */
+uint32_t IDU_Get_LLI_High_Water(void);
+
+/**
+ * \brief  Decode a compressed file on the CPU, without the IDU or GDMA
+ * \note   Output is laid out as by IDU_Decode, decoded per tools/idu_encoder's format and not
+ *         verified bit for bit against the IDU. YUV files are rejected unless
+ *         CONFIG_REALTEK_IDU_EXPERIMENTAL_YUV is set. Not reentrant: FastLZ column windows and
+ *         YUV-FastLZ lines go through a CONFIG_REALTEK_IDU_SW_LINE_BYTES scratch buffer.
+ * \param[in] file          compressed file.
+ * \param[in] range         decode range, NULL for the whole picture.
+ * \param[out] output       output buffer.
+ * \param[in] stride        output bytes per line, 0 for packed lines.
+ * \return operation result
+ * \retval IDU_SUCCESS    Operation success.
+ * \retval others           Operation failure.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        IDU_file_header* header = ( IDU_file_header*)file_data;
+        IDU_decode_range range = {0, header->raw_pic_height - 1, 0, header->raw_pic_width - 1};
+        IDU_Decode_SW(file_data, &range, buf, 0);
+    }
+ * \endcode
+ */
+IDU_ERROR IDU_Decode_SW(uint8_t *file, IDU_decode_range *range, uint8_t *output,
+                        uint32_t stride);
+
 /**
  * \brief  Get the start address of certain line in compressed file
  * \param[in] compressed_start_address          start address of entire compressed file.
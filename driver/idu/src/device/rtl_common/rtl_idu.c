@@ -15,15 +15,122 @@
  *                        Header Files
  *============================================================================*/
 #include "stdio.h"
+#include "string.h"
 #include "rtl_idu.h"
 #include "rtl_idu_int.h"
 
 /*============================================================================*
- *                           Public Functions
+ *                           Private Defines
+ *============================================================================*/
+#ifdef CONFIG_REALTEK_IDU_LLI_POOL_SIZE
+#define IDU_LLI_POOL_SIZE           CONFIG_REALTEK_IDU_LLI_POOL_SIZE
+#else
+#define IDU_LLI_POOL_SIZE           40
+#endif
+#define IDU_DMA_BLOCK_SIZE_MAX      65535
+
+typedef struct
+{
+    GDMA_LLIDef *rx_lli;
+    GDMA_LLIDef *tx_lli;
+    uint32_t rx_num;
+    uint32_t tx_num;
+    uint8_t rx_channel;
+    uint8_t tx_channel;
+} idu_lli_session_t;
+
+/*============================================================================*
+ *                           Private Variables
  *============================================================================*/
-GDMA_LLIDef RX_GDMA_LLIStruct[20];
-GDMA_LLIDef TX_GDMA_LLIStruct[20];
+static GDMA_LLIDef idu_lli_pool[IDU_LLI_POOL_SIZE];
+static uint8_t idu_lli_busy[IDU_LLI_POOL_SIZE];
+static uint32_t idu_lli_in_use = 0;
+static uint32_t idu_lli_high_water = 0;
+/* pool descriptors of the last IDU_Decode_Ex/IDU_Decode_Direct, owned by DMA until that decode
+   has stopped, empty when the decode needed none */
+static idu_lli_session_t idu_async_session = {0};
+
+/*============================================================================*
+ *                           Private Functions
+ *============================================================================*/
+static GDMA_LLIDef *idu_lli_alloc(uint32_t num)
+{
+    GDMA_LLIDef *lli = NULL;
+    uint32_t run = 0;
+    if (num == 0)
+    {
+        return NULL;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0; i < IDU_LLI_POOL_SIZE; i++)
+    {
+        run = idu_lli_busy[i] ? 0 : run + 1;
+        if (run == num)
+        {
+            uint32_t start = i + 1 - num;
+            memset(&idu_lli_busy[start], 1, num);
+            idu_lli_in_use += num;
+            if (idu_lli_in_use > idu_lli_high_water)
+            {
+                idu_lli_high_water = idu_lli_in_use;
+            }
+            lli = &idu_lli_pool[start];
+            break;
+        }
+    }
+    __set_PRIMASK(primask);
+    return lli;
+}
+
+static void idu_lli_free(GDMA_LLIDef *lli, uint32_t num)
+{
+    if (lli == NULL)
+    {
+        return;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&idu_lli_busy[lli - idu_lli_pool], 0, num);
+    idu_lli_in_use -= num;
+    __set_PRIMASK(primask);
+}
+
+/* Return the last session's descriptors to the pool once IDU and its DMA channels have stopped,
+   false while that decode is still running on them */
+static bool idu_session_reclaim(void)
+{
+    if ((idu_async_session.rx_lli == NULL) && (idu_async_session.tx_lli == NULL))
+    {
+        return true;
+    }
+    if ((IDU->IDU_CTL0 & BIT0) ||
+        ((idu_async_session.rx_lli != NULL) && rtl_idu_get_dma_busy_state(idu_async_session.rx_channel)) ||
+        ((idu_async_session.tx_lli != NULL) && rtl_idu_get_dma_busy_state(idu_async_session.tx_channel)))
+    {
+        return false;
+    }
+    IDU_Decode_Release();
+    return true;
+}
+
+static uint32_t idu_get_block_num(uint32_t word_size)
+{
+    uint32_t block_num = 0;
+    if (word_size >= IDU_DMA_BLOCK_SIZE_MAX)
+    {
+        block_num = word_size / IDU_DMA_BLOCK_SIZE_MAX;
+        if (word_size % IDU_DMA_BLOCK_SIZE_MAX)
+        {
+            block_num = block_num + 1;
+        }
+    }
+    return block_num;
+}
 
+/*============================================================================*
+ *                           Public Functions
+ *============================================================================*/
 void IDU_TxFifoClear(void)
 {
     IDU_CTL1_TypeDef idu_reg_0x04 = {.d32 = IDU->IDU_CTL1};
@@ -317,14 +424,11 @@ IDU_ERROR IDU_Decode(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *dma
     GDMA_ChannelTypeDef *RX_DMA = rtl_idu_get_dma_channel_int(dma_cfg->RX_DMA_channel_num);
     GDMA_ChannelTypeDef *TX_DMA = rtl_idu_get_dma_channel_int(dma_cfg->TX_DMA_channel_num);
 
-    uint32_t rx_block_num = 0;
-    if (DMA_compressed_data_size_word >= 65535)
+    uint32_t rx_block_num = idu_get_block_num(DMA_compressed_data_size_word);
+    GDMA_LLIDef *RX_GDMA_LLIStruct = idu_lli_alloc(rx_block_num);
+    if (rx_block_num && (RX_GDMA_LLIStruct == NULL))
     {
-        rx_block_num = DMA_compressed_data_size_word / 65535;
-        if (DMA_compressed_data_size_word % 65535)
-        {
-            rx_block_num = rx_block_num + 1;
-        }
+        return IDU_ERROR_LLI_EXHAUSTED;
     }
     /*--------------GDMA init-----------------------------*/
     GDMA_StructInit(&RX_GDMA_InitStruct);
@@ -389,14 +493,12 @@ IDU_ERROR IDU_Decode(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *dma
     }
 
     GDMA_InitTypeDef TX_GDMA_InitStruct;
-    uint32_t tx_block_num = 0;
-    if (DMA_decompressed_data_size_word >= 65535)
+    uint32_t tx_block_num = idu_get_block_num(DMA_decompressed_data_size_word);
+    GDMA_LLIDef *TX_GDMA_LLIStruct = idu_lli_alloc(tx_block_num);
+    if (tx_block_num && (TX_GDMA_LLIStruct == NULL))
     {
-        tx_block_num = DMA_decompressed_data_size_word / 65535;
-        if (DMA_decompressed_data_size_word % 65535)
-        {
-            tx_block_num = tx_block_num + 1;
-        }
+        idu_lli_free(RX_GDMA_LLIStruct, rx_block_num);
+        return IDU_ERROR_LLI_EXHAUSTED;
     }
     /*--------------GDMA init-----------------------------*/
     GDMA_StructInit(&TX_GDMA_InitStruct);
@@ -488,6 +590,8 @@ IDU_ERROR IDU_Decode(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *dma
     IDU_Cmd(DISABLE);
     while (!(IDU->IDU_CTL1 & BIT29));
     IDU_TxFifoClear();
+    idu_lli_free(RX_GDMA_LLIStruct, rx_block_num);
+    idu_lli_free(TX_GDMA_LLIStruct, tx_block_num);
     return err;
 }
 
@@ -499,6 +603,10 @@ IDU_ERROR IDU_Decode_Ex(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *
     uint32_t decompress_start_column;
     uint32_t decompress_end_column;
     RCC_PeriphClockCmd(APBPeriph_IDU, APBPeriph_IDU_CLOCK, ENABLE);
+    if (!idu_session_reclaim())
+    {
+        return IDU_ERROR_BUSY;
+    }
     if (file == NULL)
     {
         return IDU_ERROR_NULL_INPUT;
@@ -583,14 +691,11 @@ IDU_ERROR IDU_Decode_Ex(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *
     GDMA_InitTypeDef RX_GDMA_InitStruct;
     GDMA_ChannelTypeDef *RX_DMA = rtl_idu_get_dma_channel_int(dma_cfg->RX_DMA_channel_num);
     GDMA_ChannelTypeDef *TX_DMA = rtl_idu_get_dma_channel_int(dma_cfg->TX_DMA_channel_num);
-    uint32_t rx_block_num = 0;
-    if (DMA_compressed_data_size_word >= 65535)
+    uint32_t rx_block_num = idu_get_block_num(DMA_compressed_data_size_word);
+    GDMA_LLIDef *RX_GDMA_LLIStruct = idu_lli_alloc(rx_block_num);
+    if (rx_block_num && (RX_GDMA_LLIStruct == NULL))
     {
-        rx_block_num = DMA_compressed_data_size_word / 65535;
-        if (DMA_compressed_data_size_word % 65535)
-        {
-            rx_block_num = rx_block_num + 1;
-        }
+        return IDU_ERROR_LLI_EXHAUSTED;
     }
     /*--------------GDMA init-----------------------------*/
     GDMA_StructInit(&RX_GDMA_InitStruct);
@@ -654,14 +759,12 @@ IDU_ERROR IDU_Decode_Ex(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *
     }
 
     GDMA_InitTypeDef TX_GDMA_InitStruct;
-    uint32_t tx_block_num = 0;
-    if (DMA_decompressed_data_size_word >= 65535)
+    uint32_t tx_block_num = idu_get_block_num(DMA_decompressed_data_size_word);
+    GDMA_LLIDef *TX_GDMA_LLIStruct = idu_lli_alloc(tx_block_num);
+    if (tx_block_num && (TX_GDMA_LLIStruct == NULL))
     {
-        tx_block_num = DMA_decompressed_data_size_word / 65535;
-        if (DMA_decompressed_data_size_word % 65535)
-        {
-            tx_block_num = tx_block_num + 1;
-        }
+        idu_lli_free(RX_GDMA_LLIStruct, rx_block_num);
+        return IDU_ERROR_LLI_EXHAUSTED;
     }
     /*--------------GDMA init-----------------------------*/
     GDMA_StructInit(&TX_GDMA_InitStruct);
@@ -724,6 +827,12 @@ IDU_ERROR IDU_Decode_Ex(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *
         }
     }
     GDMA_Init(TX_DMA, &TX_GDMA_InitStruct);
+    idu_async_session.rx_lli = RX_GDMA_LLIStruct;
+    idu_async_session.rx_num = rx_block_num;
+    idu_async_session.tx_lli = TX_GDMA_LLIStruct;
+    idu_async_session.tx_num = tx_block_num;
+    idu_async_session.rx_channel = dma_cfg->RX_DMA_channel_num;
+    idu_async_session.tx_channel = dma_cfg->TX_DMA_channel_num;
 
     GDMA_Cmd(dma_cfg->RX_DMA_channel_num, ENABLE);
     GDMA_Cmd(dma_cfg->TX_DMA_channel_num, ENABLE);
@@ -784,6 +893,49 @@ IDU_ERROR IDU_Decode_Ex(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *
 
 IDU_ERROR IDU_Decode_Direct(uint8_t *file, IDU_decode_range *range, IDU_DMA_config *dma_cfg)
 {
-    return rtl_idu_decode_direct_int(file, range, dma_cfg, RX_GDMA_LLIStruct);
+    uint32_t rx_block_num = 0;
+    if (!idu_session_reclaim())
+    {
+        return IDU_ERROR_BUSY;
+    }
+    if (file != NULL)
+    {
+        IDU_file_header *header = (IDU_file_header *)file;
+        uint32_t start_line = (range != NULL) ? range->start_line : 0;
+        uint32_t end_line = (range != NULL) ? range->end_line : (header->raw_pic_height - 1);
+        if ((start_line <= end_line) && (end_line < header->raw_pic_height))
+        {
+            uint32_t compressed_data_size = IDU_Get_Line_Start_Address((uint32_t)file, end_line + 1) -
+                                            IDU_Get_Line_Start_Address((uint32_t)file, start_line);
+            rx_block_num = idu_get_block_num((compressed_data_size + 3) / 4);
+        }
+    }
+    GDMA_LLIDef *RX_GDMA_LLIStruct = idu_lli_alloc(rx_block_num);
+    if (rx_block_num && (RX_GDMA_LLIStruct == NULL))
+    {
+        return IDU_ERROR_LLI_EXHAUSTED;
+    }
+    IDU_ERROR err = rtl_idu_decode_direct_int(file, range, dma_cfg, RX_GDMA_LLIStruct);
+    if (err != IDU_SUCCESS)
+    {
+        idu_lli_free(RX_GDMA_LLIStruct, rx_block_num);
+        return err;
+    }
+    idu_async_session.rx_lli = RX_GDMA_LLIStruct;
+    idu_async_session.rx_num = rx_block_num;
+    idu_async_session.rx_channel = dma_cfg->RX_DMA_channel_num;
+    return err;
+}
+
+void IDU_Decode_Release(void)
+{
+    idu_lli_free(idu_async_session.rx_lli, idu_async_session.rx_num);
+    idu_lli_free(idu_async_session.tx_lli, idu_async_session.tx_num);
+    memset(&idu_async_session, 0, sizeof(idu_async_session));
+}
+
+uint32_t IDU_Get_LLI_High_Water(void)
+{
+    return idu_lli_high_water;
 }
 /******************* (C) COPYRIGHT 2023 Realtek Semiconductor Corporation *****END OF FILE****/
@@ -0,0 +1,429 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+**********************************************************************************************************
+* \file     rtl_idu_sw.c
+* \brief    This file provides the software decoder for IDU compressed files.
+* \details  Output follows IDU_Init: (end_column - start_column + 1) pixels per line, one line
+*           after another. Lines are located through the offset table after IDU_file_header.
+*           Decoding follows the format written by tools/idu_encoder, it is not checked bit
+*           for bit against the IDU. YUV needs CONFIG_REALTEK_IDU_EXPERIMENTAL_YUV.
+* \author
+* \date     2024-06-24
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+/*============================================================================*
+ *                        Header Files
+ *============================================================================*/
+#include "string.h"
+#include "rtl_idu.h"
+
+/*============================================================================*
+ *                           Private Defines
+ *============================================================================*/
+#ifdef CONFIG_REALTEK_IDU_SW_LINE_BYTES
+#define IDU_SW_LINE_BYTES           CONFIG_REALTEK_IDU_SW_LINE_BYTES
+#else
+#define IDU_SW_LINE_BYTES           2048
+#endif
+
+#ifdef RTL87x3EU
+#define IDU_SW_PIXEL_BYTES(code)    ((code) + 1)
+#else
+#define IDU_SW_PIXEL_BYTES(code)    ((code) + 2)
+#endif
+
+/*============================================================================*
+ *                           Private Variables
+ *============================================================================*/
+/* scratch for FastLZ lines that are windowed or carry YUV data, not reentrant */
+static uint8_t idu_sw_line[IDU_SW_LINE_BYTES];
+static const uint8_t idu_sw_blur_bits[4] = {0, 1, 2, 4};
+static const uint8_t idu_sw_group_pixels[3] = {1, 2, 4};
+
+/*============================================================================*
+ *                           Private Functions
+ *============================================================================*/
+/* Writes count copies of pixel with word stores once dst is aligned. */
+static uint8_t *idu_sw_fill(uint8_t *dst, const uint8_t *pixel, uint32_t bpp, uint32_t count)
+{
+    uint32_t total = count * bpp;
+    uint32_t i = 0;
+    if (bpp == 1)
+    {
+        memset(dst, pixel[0], count);
+        return dst + count;
+    }
+    while ((i < total) && ((uint32_t)(uintptr_t)(dst + i) & 3))
+    {
+        dst[i] = pixel[i % bpp];
+        i++;
+    }
+    if (total - i >= 12)
+    {
+        uint32_t pattern[3];
+        uint8_t *p = (uint8_t *)pattern;
+        uint32_t *d = (uint32_t *)(dst + i);
+        for (uint32_t k = 0; k < 12; k++)
+        {
+            p[k] = pixel[(i + k) % bpp];
+        }
+        if (bpp == 3)
+        {
+            for (; total - i >= 12; i += 12, d += 3)
+            {
+                d[0] = pattern[0];
+                d[1] = pattern[1];
+                d[2] = pattern[2];
+            }
+        }
+        else
+        {
+            for (; total - i >= 4; i += 4)
+            {
+                *d++ = pattern[0];
+            }
+        }
+    }
+    while (i < total)
+    {
+        dst[i] = pixel[i % bpp];
+        i++;
+    }
+    return dst + total;
+}
+
+static IDU_ERROR idu_sw_rle_line(const uint8_t *src, const uint8_t *end, uint8_t *dst,
+                                 uint32_t bpp, uint32_t len_bytes, uint32_t c0, uint32_t c1)
+{
+    uint32_t x = 0;
+    while (x <= c1)
+    {
+        if (src + len_bytes + bpp > end)
+        {
+            return IDU_ERROR_DECODE_FAIL;
+        }
+        uint32_t run = (len_bytes == 2) ? (src[0] | (src[1] << 8)) : src[0];
+        const uint8_t *pixel = src + len_bytes;
+        src = pixel + bpp;
+        if (run == 0)
+        {
+            return IDU_ERROR_DECODE_FAIL;
+        }
+        uint32_t first = (x > c0) ? x : c0;
+        uint32_t last = (x + run - 1 < c1) ? (x + run - 1) : c1;
+        if (first <= last)
+        {
+            dst = idu_sw_fill(dst, pixel, bpp, last - first + 1);
+        }
+        x += run;
+    }
+    return IDU_SUCCESS;
+}
+
+static IDU_ERROR idu_sw_fastlz_line(const uint8_t *src, const uint8_t *end, uint8_t *dst,
+                                    uint32_t out_len)
+{
+    uint32_t op = 0;
+    if (src >= end)
+    {
+        return (out_len == 0) ? IDU_SUCCESS : IDU_ERROR_DECODE_FAIL;
+    }
+    uint32_t ctrl = *src++ & 31;
+    while (1)
+    {
+        if (ctrl >= 32)
+        {
+            uint32_t len = (ctrl >> 5) - 1;
+            uint32_t ofs = (ctrl & 31) << 8;
+            if (len == 6)
+            {
+                if (src >= end)
+                {
+                    return IDU_ERROR_DECODE_FAIL;
+                }
+                len += *src++;
+            }
+            if (src >= end)
+            {
+                return IDU_ERROR_DECODE_FAIL;
+            }
+            ofs += *src++;
+            len += 3;
+            if ((ofs + 1 > op) || (op + len > out_len))
+            {
+                return IDU_ERROR_DECODE_FAIL;
+            }
+            const uint8_t *ref = dst + op - ofs - 1;
+            for (uint32_t i = 0; i < len; i++)
+            {
+                dst[op + i] = ref[i];
+            }
+            op += len;
+        }
+        else
+        {
+            ctrl++;
+            if ((src + ctrl > end) || (op + ctrl > out_len))
+            {
+                return IDU_ERROR_DECODE_FAIL;
+            }
+            memcpy(dst + op, src, ctrl);
+            src += ctrl;
+            op += ctrl;
+        }
+        /* lines are zero padded to a word, stop once the line is complete */
+        if ((op == out_len) || (src + 2 > end))
+        {
+            break;
+        }
+        ctrl = *src++;
+    }
+    return (op == out_len) ? IDU_SUCCESS : IDU_ERROR_DECODE_FAIL;
+}
+
+static uint8_t idu_sw_clamp(int32_t v)
+{
+    return (uint8_t)((v < 0) ? 0 : ((v > 255) ? 255 : v));
+}
+
+static void idu_sw_put_pixel(uint8_t *dst, uint32_t bpp, int32_t r, int32_t g, int32_t b, int32_t y)
+{
+    switch (bpp)
+    {
+    case 1:
+        dst[0] = idu_sw_clamp(y);
+        break;
+    case 2:
+        {
+            uint32_t v = ((idu_sw_clamp(r) >> 3) << 11) | ((idu_sw_clamp(g) >> 2) << 5) |
+                         (idu_sw_clamp(b) >> 3);
+            dst[0] = (uint8_t)v;
+            dst[1] = (uint8_t)(v >> 8);
+        }
+        break;
+    default:
+        dst[0] = idu_sw_clamp(b);
+        dst[1] = idu_sw_clamp(g);
+        dst[2] = idu_sw_clamp(r);
+        if (bpp == 4)
+        {
+            dst[3] = 0xFF;
+        }
+        break;
+    }
+}
+
+/*
+ * One group is (group pixels) Y samples followed by shared U and V, each (8 - blur) bits,
+ * packed MSB first. The chroma terms are computed once per group and reused for every Y.
+ */
+static IDU_ERROR idu_sw_yuv_line(const uint8_t *src, const uint8_t *end, uint8_t *dst,
+                                 uint32_t bpp, uint32_t sample, uint32_t blur, uint32_t c0, uint32_t c1)
+{
+    uint32_t group = idu_sw_group_pixels[sample];
+    uint32_t drop = idu_sw_blur_bits[blur];
+    uint32_t bits = 8 - drop;
+    uint32_t half = drop ? (1u << (drop - 1)) : 0;
+    uint32_t mask = (1u << bits) - 1;
+    uint32_t g0 = c0 / group;
+    uint32_t bitpos = g0 * (group + 2) * bits;
+    const uint8_t *ip = src + bitpos / 8;
+    uint32_t acc = 0, acc_bits = 0;
+    int32_t comp[6];
+
+    if (bitpos % 8)
+    {
+        if (ip >= end)
+        {
+            return IDU_ERROR_DECODE_FAIL;
+        }
+        acc = *ip++;
+        acc_bits = 8 - bitpos % 8;
+    }
+    for (uint32_t x = g0 * group; x <= c1; x += group)
+    {
+        if (bits == 8)
+        {
+            if (ip + group + 2 > end)
+            {
+                return IDU_ERROR_DECODE_FAIL;
+            }
+            for (uint32_t i = 0; i < group + 2; i++)
+            {
+                comp[i] = ip[i];
+            }
+            ip += group + 2;
+        }
+        else
+        {
+            for (uint32_t i = 0; i < group + 2; i++)
+            {
+                while (acc_bits < bits)
+                {
+                    if (ip >= end)
+                    {
+                        return IDU_ERROR_DECODE_FAIL;
+                    }
+                    acc = (acc << 8) | *ip++;
+                    acc_bits += 8;
+                }
+                acc_bits -= bits;
+                comp[i] = (int32_t)((((acc >> acc_bits) & mask) << drop) | half);
+            }
+        }
+        int32_t d = comp[group] - 128;
+        int32_t e = comp[group + 1] - 128;
+        int32_t rv = 409 * e + 128;
+        int32_t guv = -100 * d - 208 * e + 128;
+        int32_t bu = 516 * d + 128;
+        for (uint32_t i = 0; i < group; i++)
+        {
+            if ((x + i < c0) || (x + i > c1))
+            {
+                continue;
+            }
+            int32_t c = 298 * (comp[i] - 16);
+            idu_sw_put_pixel(dst, bpp, (c + rv) >> 8, (c + guv) >> 8, (c + bu) >> 8, comp[i]);
+            dst += bpp;
+        }
+    }
+    return IDU_SUCCESS;
+}
+
+/*============================================================================*
+ *                           Public Functions
+ *============================================================================*/
+IDU_ERROR IDU_Decode_SW(uint8_t *file, IDU_decode_range *range, uint8_t *output, uint32_t stride)
+{
+    uint32_t start_line, end_line, start_column, end_column;
+    if ((file == NULL) || (output == NULL))
+    {
+        return IDU_ERROR_NULL_INPUT;
+    }
+    IDU_file_header *header = (IDU_file_header *)file;
+    if (range != NULL)
+    {
+        if ((range->start_line >= header->raw_pic_height) || (range->start_column >= header->raw_pic_width))
+        {
+            return IDU_ERROR_START_EXCEED_BOUNDARY;
+        }
+        if ((range->start_line > range->end_line) || (range->start_column > range->end_column))
+        {
+            return IDU_ERROR_START_LARGER_THAN_END;
+        }
+        if ((range->end_line >= header->raw_pic_height) || (range->end_column >= header->raw_pic_width))
+        {
+            return IDU_ERROR_END_EXCEED_BOUNDARY;
+        }
+        start_line = range->start_line;
+        end_line = range->end_line;
+        start_column = range->start_column;
+        end_column = range->end_column;
+    }
+    else
+    {
+        start_line = 0;
+        end_line = header->raw_pic_height - 1;
+        start_column = 0;
+        end_column = header->raw_pic_width - 1;
+    }
+    uint32_t algorithm = header->algorithm_type.algorithm;
+    uint32_t feature_1 = header->algorithm_type.feature_1;
+    uint32_t feature_2 = header->algorithm_type.feature_2;
+    if ((!IS_IDU_ALGORITHM(algorithm)) || (!IS_IDU_PIXEL_BYTES(header->algorithm_type.pixel_bytes)))
+    {
+        return IDU_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t bpp = IDU_SW_PIXEL_BYTES(header->algorithm_type.pixel_bytes);
+    uint32_t raw_line_bytes = header->raw_pic_width * bpp;
+    bool full_line = (start_column == 0) && (end_column == header->raw_pic_width - 1);
+    uint32_t yuv_line_bytes = 0;
+    if (stride == 0)
+    {
+        stride = (end_column - start_column + 1) * bpp;
+    }
+    if (algorithm == IDU_ALGO_RLE)
+    {
+        if (!IS_IDU_RLE_BYTE_LEN(feature_1))
+        {
+            return IDU_ERROR_INVALID_PARAM;
+        }
+    }
+    else if (algorithm == IDU_ALGO_FASTLZ)
+    {
+        if (!full_line && (raw_line_bytes > IDU_SW_LINE_BYTES))
+        {
+            return IDU_ERROR_INVALID_PARAM;
+        }
+    }
+    else
+    {
+#ifndef CONFIG_REALTEK_IDU_EXPERIMENTAL_YUV
+        /* the YUV layouts are not verified against the IDU */
+        return IDU_ERROR_INVALID_PARAM;
+#endif
+        if (!IS_IDU_YUV_TYPE(feature_1))
+        {
+            return IDU_ERROR_INVALID_PARAM;
+        }
+        uint32_t group = idu_sw_group_pixels[feature_1];
+        uint32_t group_bits = (group + 2) * (8 - idu_sw_blur_bits[feature_2]);
+        yuv_line_bytes = ((header->raw_pic_width + group - 1) / group * group_bits + 7) / 8;
+        if ((algorithm == IDU_ALGO_YUV_BLUR_FASTLZ) && (yuv_line_bytes > IDU_SW_LINE_BYTES))
+        {
+            return IDU_ERROR_INVALID_PARAM;
+        }
+    }
+
+    const uint32_t *line_offset = (const uint32_t *)(file + sizeof(IDU_file_header));
+    for (uint32_t line = start_line; line <= end_line; line++)
+    {
+        const uint8_t *src = file + line_offset[line];
+        const uint8_t *end = file + line_offset[line + 1];
+        uint8_t *dst = output + (line - start_line) * stride;
+        IDU_ERROR err;
+        if (end < src)
+        {
+            return IDU_ERROR_DECODE_FAIL;
+        }
+        switch (algorithm)
+        {
+        case IDU_ALGO_RLE:
+            err = idu_sw_rle_line(src, end, dst, bpp, feature_1, start_column, end_column);
+            break;
+        case IDU_ALGO_FASTLZ:
+            if (full_line)
+            {
+                err = idu_sw_fastlz_line(src, end, dst, raw_line_bytes);
+            }
+            else
+            {
+                err = idu_sw_fastlz_line(src, end, idu_sw_line, raw_line_bytes);
+                memcpy(dst, idu_sw_line + start_column * bpp, (end_column - start_column + 1) * bpp);
+            }
+            break;
+        case IDU_ALGO_YUV_BLUR:
+            err = idu_sw_yuv_line(src, end, dst, bpp, feature_1, feature_2, start_column, end_column);
+            break;
+        default:
+            err = idu_sw_fastlz_line(src, end, idu_sw_line, yuv_line_bytes);
+            if (err == IDU_SUCCESS)
+            {
+                err = idu_sw_yuv_line(idu_sw_line, idu_sw_line + yuv_line_bytes, dst, bpp, feature_1,
+                                      feature_2, start_column, end_column);
+            }
+            break;
+        }
+        if (err != IDU_SUCCESS)
+        {
+            return err;
+        }
+    }
+    return IDU_SUCCESS;
+}
+
+/******************* (C) COPYRIGHT 2024 Realtek Semiconductor Corporation *****END OF FILE****/
@@ -4,7 +4,141 @@
 #include "rtl_idu_int.h"
 #include "rtl_idu.h"
 
+#ifdef CONFIG_REALTEK_IDU_HAL_LLI_ARENA_SIZE
+#define HAL_IDU_LLI_ARENA_SIZE      CONFIG_REALTEK_IDU_HAL_LLI_ARENA_SIZE
+#else
+/* two arenas of this many 20-byte descriptors, 2.5 KB of RAM at 64 */
+#define HAL_IDU_LLI_ARENA_SIZE      64
+#endif
+#define HAL_IDU_LLI_KEY_NUM         8
+
+typedef enum
+{
+    HAL_IDU_CHAIN_COPY = 1,
+    HAL_IDU_CHAIN_RX,
+    HAL_IDU_CHAIN_TX,
+} hal_idu_chain_type;
+
+typedef struct
+{
+    GDMA_LLIDef lli[HAL_IDU_LLI_ARENA_SIZE];
+    uint32_t num;                           /* length of the chain held in lli, 0 if none */
+    uint32_t key[HAL_IDU_LLI_KEY_NUM];      /* geometry the chain was built for */
+} hal_idu_lli_arena_t;
+
 static uint8_t high_speed_dma = 0xA5, low_speed_dma = 0xA5;
+/* high speed channel carries copies and IDU RX, low speed channel carries IDU TX */
+static hal_idu_lli_arena_t high_speed_arena, low_speed_arena;
+/* idu_hw_claimed: a blocking call or the job queue owns the IDU and both DMA channels,
+ * idu_job_running: the head job of the queue is on the hardware */
+static volatile bool idu_hw_claimed = false;
+static volatile bool idu_job_running = false;
+
+/* Chains longer than the arena fall back to the heap. */
+static GDMA_LLIDef *hal_idu_lli_get(hal_idu_lli_arena_t *arena, uint32_t num,
+                                    const uint32_t *key, bool *reuse)
+{
+    *reuse = false;
+    if (num > HAL_IDU_LLI_ARENA_SIZE)
+    {
+        GDMA_LLIDef *lli = os_mem_alloc(RAM_TYPE_DATA_ON, num * sizeof(GDMA_LLIDef));
+        assert_param(lli != NULL);
+        return lli;
+    }
+    if ((arena->num == num) && (memcmp(arena->key, key, sizeof(arena->key)) == 0))
+    {
+        *reuse = true;
+    }
+    else
+    {
+        arena->num = num;
+        memcpy(arena->key, key, sizeof(arena->key));
+    }
+    return arena->lli;
+}
+
+static void hal_idu_lli_put(hal_idu_lli_arena_t *arena, GDMA_LLIDef *lli)
+{
+    if ((lli != NULL) && (lli != arena->lli))
+    {
+        os_mem_free(lli);
+    }
+}
+
+static void hal_idu_job_kick(void);
+static hal_idu_decompress_job *hal_idu_job_service(void);
+
+/* Wait until the queue has drained and no other blocking call holds the hardware. Finished jobs
+ * are retired here as well, so this does not depend on hal_idu_irq_handler being wired up or
+ * able to preempt the caller. */
+static void hal_idu_claim(void)
+{
+    while (true)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (!idu_hw_claimed)
+        {
+            idu_hw_claimed = true;
+            __set_PRIMASK(primask);
+            return;
+        }
+        hal_idu_decompress_job *job = hal_idu_job_service();
+        __set_PRIMASK(primask);
+        if ((job != NULL) && (job->callback != NULL))
+        {
+            job->callback(job);
+        }
+    }
+}
+
+/* Hand the hardware back, starting any job queued meanwhile. */
+static void hal_idu_release(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    idu_hw_claimed = false;
+    hal_idu_job_kick();
+    __set_PRIMASK(primask);
+}
+
+/* RX chain length for a rect, 0 when a single block carries the compressed lines */
+static uint32_t hal_idu_rect_rx_block_num(hal_idu_decompress_info *info)
+{
+    uint32_t start_line_address = IDU_Get_Line_Start_Address(info->raw_data_address,
+                                                              info->start_line);
+    uint32_t compressed_data_size = IDU_Get_Line_Start_Address(info->raw_data_address,
+                                                                info->end_line + 1) - start_line_address;
+    uint32_t word_size = (compressed_data_size + 3) / 4;
+    if (word_size < 65535)
+    {
+        return 0;
+    }
+    return (word_size + 65534) / 65535;
+}
+
+/* Rects as wide as dst_stride land contiguously and need one TX block per 65535 words,
+ * others need one per line. */
+static bool hal_idu_rect_tx_packed(hal_idu_decompress_info *info)
+{
+    return info->dst_stride == info->length;
+}
+
+/* TX chain length for a rect, 0 when a single block carries the decoded lines */
+static uint32_t hal_idu_rect_tx_block_num(hal_idu_decompress_info *info)
+{
+    uint32_t line_num = info->end_line - info->start_line + 1;
+    if (!hal_idu_rect_tx_packed(info))
+    {
+        return line_num;
+    }
+    uint32_t word_size = info->length / 4 * line_num;
+    if (word_size < 65535)
+    {
+        return 0;
+    }
+    return (word_size + 65534) / 65535;
+}
 
 void hal_dma_copy(hal_idu_dma_info *info, uint8_t *src, uint8_t *dst)
 {
@@ -57,15 +191,16 @@ void hal_dma_copy(hal_idu_dma_info *info, uint8_t *src, uint8_t *dst)
         buffer_size = info->length;
     }
 
-    GDMA_LLIDef *GDMA_LLIStruct;
+    GDMA_LLIDef *GDMA_LLIStruct = NULL;
+    bool reuse = false;
+    hal_idu_claim();
     if (use_LLI)
     {
-        GDMA_LLIStruct = os_mem_alloc(RAM_TYPE_DATA_ON, dma_height * sizeof(GDMA_LLIDef));
-        if (GDMA_LLIStruct == NULL)
-        {
-            assert_param(GDMA_LLIStruct != NULL);
-        }
-        else
+        uint32_t key[HAL_IDU_LLI_KEY_NUM] = {(uint32_t)src, (uint32_t)dst, info->src_stride, info->dst_stride,
+                                             buffer_size, total_size, data_size, HAL_IDU_CHAIN_COPY
+                                            };
+        GDMA_LLIStruct = hal_idu_lli_get(&high_speed_arena, dma_height, key, &reuse);
+        if ((GDMA_LLIStruct != NULL) && !reuse)
         {
             memset(GDMA_LLIStruct, 0, dma_height * sizeof(GDMA_LLIDef));
         }
@@ -107,28 +242,34 @@ void hal_dma_copy(hal_idu_dma_info *info, uint8_t *src, uint8_t *dst)
         {
             if (i == dma_height - 1)
             {
-                GDMA_LLIStruct[i].SAR = start_address + info->src_stride * i;
-                GDMA_LLIStruct[i].DAR = (uint32_t)dest_address + info->dst_stride * i;
-                GDMA_LLIStruct[i].LLP = 0;
-                /* configure low 32 bit of CTL register */
-                GDMA_LLIStruct[i].CTL_LOW = (BIT(0)
-                                             | (RX_GDMA_InitStruct.GDMA_DestinationDataSize << 1)
-                                             | (data_size << 4)
-                                             | (RX_GDMA_InitStruct.GDMA_DestinationInc << 7)
-                                             | (RX_GDMA_InitStruct.GDMA_SourceInc << 9)
-                                             | (RX_GDMA_InitStruct.GDMA_DestinationMsize << 11)
-                                             | (RX_GDMA_InitStruct.GDMA_SourceMsize << 14)
-                                             | (RX_GDMA_InitStruct.GDMA_DIR << 20));
+                if (!reuse)
+                {
+                    GDMA_LLIStruct[i].SAR = start_address + info->src_stride * i;
+                    GDMA_LLIStruct[i].DAR = (uint32_t)dest_address + info->dst_stride * i;
+                    GDMA_LLIStruct[i].LLP = 0;
+                    /* configure low 32 bit of CTL register */
+                    GDMA_LLIStruct[i].CTL_LOW = (BIT(0)
+                                                 | (RX_GDMA_InitStruct.GDMA_DestinationDataSize << 1)
+                                                 | (data_size << 4)
+                                                 | (RX_GDMA_InitStruct.GDMA_DestinationInc << 7)
+                                                 | (RX_GDMA_InitStruct.GDMA_SourceInc << 9)
+                                                 | (RX_GDMA_InitStruct.GDMA_DestinationMsize << 11)
+                                                 | (RX_GDMA_InitStruct.GDMA_SourceMsize << 14)
+                                                 | (RX_GDMA_InitStruct.GDMA_DIR << 20));
+                }
                 /* configure high 32 bit of CTL register */
                 GDMA_LLIStruct[i].CTL_HIGH = buffer_size;
             }
             else
             {
-                GDMA_LLIStruct[i].SAR = start_address + info->src_stride * i;
-                GDMA_LLIStruct[i].DAR = (uint32_t)dest_address + info->dst_stride * i;
-                GDMA_LLIStruct[i].LLP = (uint32_t)&GDMA_LLIStruct[i + 1];
-                /* configure low 32 bit of CTL register */
-                GDMA_LLIStruct[i].CTL_LOW = rtl_idu_get_dma_ctl_low_int(dma_channel);
+                if (!reuse)
+                {
+                    GDMA_LLIStruct[i].SAR = start_address + info->src_stride * i;
+                    GDMA_LLIStruct[i].DAR = (uint32_t)dest_address + info->dst_stride * i;
+                    GDMA_LLIStruct[i].LLP = (uint32_t)&GDMA_LLIStruct[i + 1];
+                    /* configure low 32 bit of CTL register */
+                    GDMA_LLIStruct[i].CTL_LOW = rtl_idu_get_dma_ctl_low_int(dma_channel);
+                }
                 /* configure high 32 bit of CTL register */
                 if (total_size == 0)
                 {
@@ -145,10 +286,8 @@ void hal_dma_copy(hal_idu_dma_info *info, uint8_t *src, uint8_t *dst)
     GDMA_Cmd(high_speed_dma, ENABLE);
     while (GDMA_GetTransferINTStatus(high_speed_dma) != SET);
     GDMA_ClearINTPendingBit(high_speed_dma, GDMA_INT_Transfer);
-    if (use_LLI && GDMA_LLIStruct != NULL)
-    {
-        os_mem_free(GDMA_LLIStruct);
-    }
+    hal_idu_lli_put(&high_speed_arena, GDMA_LLIStruct);
+    hal_idu_release();
 }
 
 bool hal_idu_decompress(hal_idu_decompress_info *info, uint8_t *dst)
@@ -166,7 +305,12 @@ bool hal_idu_decompress(hal_idu_decompress_info *info, uint8_t *dst)
     dma_cfg.TX_DMA_channel_num = high_speed_dma;
     dma_cfg.TX_FIFO_INT_threshold = 8;
     dma_cfg.RX_FIFO_INT_threshold = 8;
+    hal_idu_claim();
     IDU_ERROR err = IDU_Decode((uint8_t *)header, &range, &dma_cfg);
+    /* IDU_Decode polls, drop the status it leaves behind for the IRQ */
+    IDU_ClearINTPendingBit(IDU_DECOMPRESS_FINISH_INT);
+    IDU_ClearINTPendingBit(IDU_DECOMPRESS_ERROR_INT);
+    hal_idu_release();
     if (err != IDU_SUCCESS)
     {
         return false;
@@ -177,7 +321,9 @@ bool hal_idu_decompress(hal_idu_decompress_info *info, uint8_t *dst)
     }
 }
 
-bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
+/* irq: raise IDU_IRQn on finish, otherwise the caller polls with the interrupt masked */
+static void hal_idu_rect_start(hal_idu_decompress_info *info, uint8_t *dst,
+                               GDMA_LLIDef **rx_lli, GDMA_LLIDef **tx_lli, bool irq)
 {
     uint32_t dst_start_address = (uint32_t)dst;
     RCC_PeriphClockCmd(APBPeriph_IDU, APBPeriph_IDU_CLOCK, ENABLE);
@@ -200,7 +346,6 @@ bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
                                                               decompress_start_line);
     uint32_t compressed_data_size = IDU_Get_Line_Start_Address(compressed_data_start_address,
                                                                 decompress_end_line + 1) - start_line_address;
-    IDU_ERROR err = IDU_SUCCESS;
     IDU_InitTypeDef IDU_struct_init;
     IDU_struct_init.algorithm_type            = (IDU_ALGORITHM)header->algorithm_type.algorithm;
     IDU_struct_init.head_throw_away_byte_num  = THROW_AWAY_0BYTE;
@@ -234,17 +379,10 @@ bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
     GDMA_InitTypeDef RX_GDMA_InitStruct;
     GDMA_ChannelTypeDef *RX_DMA = rtl_idu_get_dma_channel_int(dma_cfg->RX_DMA_channel_num);
     GDMA_ChannelTypeDef *TX_DMA = rtl_idu_get_dma_channel_int(dma_cfg->TX_DMA_channel_num);
-    GDMA_LLIDef *RX_GDMA_LLIStruct;
-    GDMA_LLIDef *TX_GDMA_LLIStruct;
-    uint32_t rx_block_num = 0;
-    if (DMA_compressed_data_size_word >= 65535)
-    {
-        rx_block_num = DMA_compressed_data_size_word / 65535;
-        if (DMA_compressed_data_size_word % 65535)
-        {
-            rx_block_num = rx_block_num + 1;
-        }
-    }
+    GDMA_LLIDef *RX_GDMA_LLIStruct = NULL;
+    GDMA_LLIDef *TX_GDMA_LLIStruct = NULL;
+    bool rx_reuse = false, tx_reuse = false;
+    uint32_t rx_block_num = hal_idu_rect_rx_block_num(info);
     /*--------------GDMA init-----------------------------*/
     GDMA_StructInit(&RX_GDMA_InitStruct);
     RX_GDMA_InitStruct.GDMA_ChannelNum          = dma_cfg->RX_DMA_channel_num;
@@ -265,7 +403,10 @@ bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
     rtl_idu_rx_handshake_init(&RX_GDMA_InitStruct);
     if (rx_block_num)
     {
-        RX_GDMA_LLIStruct = os_mem_alloc(RAM_TYPE_DATA_ON, sizeof(GDMA_LLIDef) * rx_block_num);
+        uint32_t key[HAL_IDU_LLI_KEY_NUM] = {start_line_address, DMA_compressed_data_size_word,
+                                             0, 0, 0, 0, 0, HAL_IDU_CHAIN_RX
+                                            };
+        RX_GDMA_LLIStruct = hal_idu_lli_get(&high_speed_arena, rx_block_num, key, &rx_reuse);
         RX_GDMA_InitStruct.GDMA_BufferSize = 65535;
         RX_GDMA_InitStruct.GDMA_Multi_Block_Mode = LLI_TRANSFER;
         RX_GDMA_InitStruct.GDMA_Multi_Block_En = 1;
@@ -278,29 +419,35 @@ bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
         {
             if (i == rx_block_num - 1)
             {
-                RX_GDMA_LLIStruct[i].SAR = RX_GDMA_InitStruct.GDMA_SourceAddr + 65535 * 4 * i;
-                RX_GDMA_LLIStruct[i].DAR = (uint32_t)(&IDU->RX_FIFO);
-                RX_GDMA_LLIStruct[i].LLP = 0;
-                /* configure low 32 bit of CTL register */
-                RX_GDMA_LLIStruct[i].CTL_LOW = (BIT(0)
-                                                | (RX_GDMA_InitStruct.GDMA_DestinationDataSize << 1)
-                                                | (GDMA_DataSize_Word << 4)
-                                                | (RX_GDMA_InitStruct.GDMA_DestinationInc << 7)
-                                                | (RX_GDMA_InitStruct.GDMA_SourceInc << 9)
-                                                | (RX_GDMA_InitStruct.GDMA_DestinationMsize << 11)
-                                                | (RX_GDMA_InitStruct.GDMA_SourceMsize << 14)
-                                                | (RX_GDMA_InitStruct.GDMA_DIR << 20));
+                if (!rx_reuse)
+                {
+                    RX_GDMA_LLIStruct[i].SAR = RX_GDMA_InitStruct.GDMA_SourceAddr + 65535 * 4 * i;
+                    RX_GDMA_LLIStruct[i].DAR = (uint32_t)(&IDU->RX_FIFO);
+                    RX_GDMA_LLIStruct[i].LLP = 0;
+                    /* configure low 32 bit of CTL register */
+                    RX_GDMA_LLIStruct[i].CTL_LOW = (BIT(0)
+                                                    | (RX_GDMA_InitStruct.GDMA_DestinationDataSize << 1)
+                                                    | (GDMA_DataSize_Word << 4)
+                                                    | (RX_GDMA_InitStruct.GDMA_DestinationInc << 7)
+                                                    | (RX_GDMA_InitStruct.GDMA_SourceInc << 9)
+                                                    | (RX_GDMA_InitStruct.GDMA_DestinationMsize << 11)
+                                                    | (RX_GDMA_InitStruct.GDMA_SourceMsize << 14)
+                                                    | (RX_GDMA_InitStruct.GDMA_DIR << 20));
+                }
                 /* configure high 32 bit of CTL register */
                 uint32_t block_size = DMA_compressed_data_size_word - 65535 * i;
                 RX_GDMA_LLIStruct[i].CTL_HIGH = block_size;
             }
             else
             {
-                RX_GDMA_LLIStruct[i].SAR = RX_GDMA_InitStruct.GDMA_SourceAddr + 65535 * 4 * i;
-                RX_GDMA_LLIStruct[i].DAR = (uint32_t)(&IDU->RX_FIFO);
-                RX_GDMA_LLIStruct[i].LLP = (uint32_t)&RX_GDMA_LLIStruct[i + 1];
-                /* configure low 32 bit of CTL register */
-                RX_GDMA_LLIStruct[i].CTL_LOW = rtl_idu_get_dma_ctl_low_int(RX_DMA);
+                if (!rx_reuse)
+                {
+                    RX_GDMA_LLIStruct[i].SAR = RX_GDMA_InitStruct.GDMA_SourceAddr + 65535 * 4 * i;
+                    RX_GDMA_LLIStruct[i].DAR = (uint32_t)(&IDU->RX_FIFO);
+                    RX_GDMA_LLIStruct[i].LLP = (uint32_t)&RX_GDMA_LLIStruct[i + 1];
+                    /* configure low 32 bit of CTL register */
+                    RX_GDMA_LLIStruct[i].CTL_LOW = rtl_idu_get_dma_ctl_low_int(RX_DMA);
+                }
                 /* configure high 32 bit of CTL register */
                 RX_GDMA_LLIStruct[i].CTL_HIGH = 65535;
             }
@@ -308,11 +455,14 @@ bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
     }
 
     GDMA_InitTypeDef TX_GDMA_InitStruct;
-    uint32_t tx_block_num = decompress_end_line - decompress_start_line + 1;
+    uint32_t tx_block_num = hal_idu_rect_tx_block_num(info);
+    uint32_t tx_word_size = buffer_size * (decompress_end_line - decompress_start_line + 1);
+    uint32_t tx_block_size = hal_idu_rect_tx_packed(info) ? 65535 : buffer_size;
+    uint32_t tx_block_stride = hal_idu_rect_tx_packed(info) ? 65535 * 4 : info->dst_stride;
     /*--------------GDMA init-----------------------------*/
     GDMA_StructInit(&TX_GDMA_InitStruct);
     TX_GDMA_InitStruct.GDMA_ChannelNum          = dma_cfg->TX_DMA_channel_num;
-    TX_GDMA_InitStruct.GDMA_BufferSize          = buffer_size;
+    TX_GDMA_InitStruct.GDMA_BufferSize          = tx_word_size;
     TX_GDMA_InitStruct.GDMA_DIR                 = GDMA_DIR_PeripheralToMemory;
     TX_GDMA_InitStruct.GDMA_SourceInc           = DMA_SourceInc_Fix;
     TX_GDMA_InitStruct.GDMA_DestinationInc      = DMA_DestinationInc_Inc;
@@ -329,8 +479,11 @@ bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
     rtl_idu_tx_handshake_init(&TX_GDMA_InitStruct);
     if (tx_block_num)
     {
-        TX_GDMA_LLIStruct = os_mem_alloc(RAM_TYPE_DATA_ON, sizeof(GDMA_LLIDef) * tx_block_num);
-        TX_GDMA_InitStruct.GDMA_BufferSize = buffer_size;
+        uint32_t key[HAL_IDU_LLI_KEY_NUM] = {dst_start_address, info->dst_stride, buffer_size,
+                                             0, 0, 0, 0, HAL_IDU_CHAIN_TX
+                                            };
+        TX_GDMA_LLIStruct = hal_idu_lli_get(&low_speed_arena, tx_block_num, key, &tx_reuse);
+        TX_GDMA_InitStruct.GDMA_BufferSize = tx_block_size;
         TX_GDMA_InitStruct.GDMA_Multi_Block_Mode = LLI_TRANSFER;
         TX_GDMA_InitStruct.GDMA_Multi_Block_En = 1;
         TX_GDMA_InitStruct.GDMA_Multi_Block_Struct = (uint32_t)TX_GDMA_LLIStruct;
@@ -342,30 +495,36 @@ bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
         {
             if (i == tx_block_num - 1)
             {
-                TX_GDMA_LLIStruct[i].SAR = (uint32_t)(&IDU->TX_FIFO);
-                TX_GDMA_LLIStruct[i].DAR = (uint32_t)dma_cfg->output_buf + info->dst_stride * i;
-                TX_GDMA_LLIStruct[i].LLP = 0;
-                /* configure low 32 bit of CTL register */
-                TX_GDMA_LLIStruct[i].CTL_LOW = (BIT(0)
-                                                | (TX_GDMA_InitStruct.GDMA_DestinationDataSize << 1)
-                                                | (TX_GDMA_InitStruct.GDMA_SourceDataSize << 4)
-                                                | (TX_GDMA_InitStruct.GDMA_DestinationInc << 7)
-                                                | (TX_GDMA_InitStruct.GDMA_SourceInc << 9)
-                                                | (TX_GDMA_InitStruct.GDMA_DestinationMsize << 11)
-                                                | (TX_GDMA_InitStruct.GDMA_SourceMsize << 14)
-                                                | (TX_GDMA_InitStruct.GDMA_DIR << 20));
+                if (!tx_reuse)
+                {
+                    TX_GDMA_LLIStruct[i].SAR = (uint32_t)(&IDU->TX_FIFO);
+                    TX_GDMA_LLIStruct[i].DAR = (uint32_t)dma_cfg->output_buf + tx_block_stride * i;
+                    TX_GDMA_LLIStruct[i].LLP = 0;
+                    /* configure low 32 bit of CTL register */
+                    TX_GDMA_LLIStruct[i].CTL_LOW = (BIT(0)
+                                                    | (TX_GDMA_InitStruct.GDMA_DestinationDataSize << 1)
+                                                    | (TX_GDMA_InitStruct.GDMA_SourceDataSize << 4)
+                                                    | (TX_GDMA_InitStruct.GDMA_DestinationInc << 7)
+                                                    | (TX_GDMA_InitStruct.GDMA_SourceInc << 9)
+                                                    | (TX_GDMA_InitStruct.GDMA_DestinationMsize << 11)
+                                                    | (TX_GDMA_InitStruct.GDMA_SourceMsize << 14)
+                                                    | (TX_GDMA_InitStruct.GDMA_DIR << 20));
+                }
                 /* configure high 32 bit of CTL register */
-                TX_GDMA_LLIStruct[i].CTL_HIGH = buffer_size;
+                TX_GDMA_LLIStruct[i].CTL_HIGH = tx_word_size - tx_block_size * i;
             }
             else
             {
-                TX_GDMA_LLIStruct[i].SAR = (uint32_t)(&IDU->TX_FIFO);
-                TX_GDMA_LLIStruct[i].DAR = (uint32_t)dma_cfg->output_buf + info->dst_stride * i;
-                TX_GDMA_LLIStruct[i].LLP = (uint32_t)&TX_GDMA_LLIStruct[i + 1];
-                /* configure low 32 bit of CTL register */
-                TX_GDMA_LLIStruct[i].CTL_LOW = rtl_idu_get_dma_ctl_low_int(TX_DMA);
+                if (!tx_reuse)
+                {
+                    TX_GDMA_LLIStruct[i].SAR = (uint32_t)(&IDU->TX_FIFO);
+                    TX_GDMA_LLIStruct[i].DAR = (uint32_t)dma_cfg->output_buf + tx_block_stride * i;
+                    TX_GDMA_LLIStruct[i].LLP = (uint32_t)&TX_GDMA_LLIStruct[i + 1];
+                    /* configure low 32 bit of CTL register */
+                    TX_GDMA_LLIStruct[i].CTL_LOW = rtl_idu_get_dma_ctl_low_int(TX_DMA);
+                }
                 /* configure high 32 bit of CTL register */
-                TX_GDMA_LLIStruct[i].CTL_HIGH = buffer_size;
+                TX_GDMA_LLIStruct[i].CTL_HIGH = tx_block_size;
             }
         }
     }
@@ -374,49 +533,198 @@ bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
 
     IDU_ClearINTPendingBit(IDU_DECOMPRESS_FINISH_INT);
     IDU_INTConfig(IDU_DECOMPRESS_FINISH_INT, ENABLE);
-    IDU_MaskINTConfig(IDU_DECOMPRESS_FINISH_INT, DISABLE);
+    IDU_MaskINTConfig(IDU_DECOMPRESS_FINISH_INT, irq ? DISABLE : ENABLE);
 
     IDU_ClearINTPendingBit(IDU_DECOMPRESS_ERROR_INT);
     IDU_INTConfig(IDU_DECOMPRESS_ERROR_INT, ENABLE);
-    IDU_MaskINTConfig(IDU_DECOMPRESS_ERROR_INT, DISABLE);
+    IDU_MaskINTConfig(IDU_DECOMPRESS_ERROR_INT, irq ? DISABLE : ENABLE);
 
+    *rx_lli = RX_GDMA_LLIStruct;
+    *tx_lli = TX_GDMA_LLIStruct;
     IDU_Cmd(ENABLE);
     IDU_Run(ENABLE);
-    while (IDU->IDU_CTL0 & BIT0);
+}
+
+static bool hal_idu_rect_finish(GDMA_LLIDef *rx_lli, GDMA_LLIDef *tx_lli)
+{
+    IDU_ERROR err = IDU_SUCCESS;
+    GDMA_ChannelTypeDef *RX_DMA = rtl_idu_get_dma_channel_int(high_speed_dma);
+    GDMA_ChannelTypeDef *TX_DMA = rtl_idu_get_dma_channel_int(low_speed_dma);
     if (IDU_GetINTStatus(IDU_DECOMPRESS_ERROR_INT))
     {
         err =  IDU_ERROR_DECODE_FAIL;
     }
 
-    if (rtl_idu_get_dma_busy_state(dma_cfg->RX_DMA_channel_num))
+    if (rtl_idu_get_dma_busy_state(high_speed_dma))
     {
         GDMA_SuspendCmd(TX_DMA, ENABLE);
         GDMA_SuspendCmd(RX_DMA, ENABLE);
         rtl_idu_wait_dma_idle(RX_DMA);
         rtl_idu_wait_dma_idle(TX_DMA);
-        GDMA_Cmd(dma_cfg->RX_DMA_channel_num, DISABLE);
-        GDMA_Cmd(dma_cfg->TX_DMA_channel_num, DISABLE);
+        GDMA_Cmd(high_speed_dma, DISABLE);
+        GDMA_Cmd(low_speed_dma, DISABLE);
     }
     IDU_RxFifoClear();
     IDU_Cmd(DISABLE);
     while (!(IDU->IDU_CTL1 & BIT29));
     IDU_TxFifoClear();
-    if (rx_block_num)
+    IDU_ClearINTPendingBit(IDU_DECOMPRESS_FINISH_INT);
+    IDU_ClearINTPendingBit(IDU_DECOMPRESS_ERROR_INT);
+    hal_idu_lli_put(&high_speed_arena, rx_lli);
+    hal_idu_lli_put(&low_speed_arena, tx_lli);
+    if (err != IDU_SUCCESS)
     {
-        os_mem_free(RX_GDMA_LLIStruct);
+        return false;
     }
-    if (tx_block_num)
+    else
     {
-        os_mem_free(TX_GDMA_LLIStruct);
+        return true;
     }
-    if (err != IDU_SUCCESS)
+}
+
+static void hal_idu_irq_enable(FunctionalState state)
+{
+    NVIC_InitTypeDef NVIC_InitStruct;
+    NVIC_InitStruct.NVIC_IRQChannel = IDU_IRQn;
+    NVIC_InitStruct.NVIC_IRQChannelPriority = 3;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = state;
+    NVIC_Init(&NVIC_InitStruct);
+}
+
+static hal_idu_decompress_job *idu_job_head = NULL, *idu_job_tail = NULL;
+static GDMA_LLIDef *idu_job_rx_lli = NULL, *idu_job_tx_lli = NULL;
+
+/* Caller keeps interrupts masked and the hardware unclaimed. Starts the head job, if any.
+ * IDU_IRQn is left enabled once the queue drains, IDU_Decode_Ex/Direct users share it. */
+static void hal_idu_job_kick(void)
+{
+    if (idu_job_head == NULL)
+    {
+        idu_job_running = false;
+        idu_hw_claimed = false;
+        return;
+    }
+    idu_hw_claimed = true;
+    idu_job_running = true;
+    hal_idu_irq_enable(ENABLE);
+    hal_idu_rect_start(&idu_job_head->info, idu_job_head->dst, &idu_job_rx_lli, &idu_job_tx_lli,
+                       true);
+}
+
+bool hal_idu_decompress_rect(hal_idu_decompress_info *info, uint8_t *dst)
+{
+    GDMA_LLIDef *rx_lli, *tx_lli;
+    hal_idu_claim();
+    hal_idu_rect_start(info, dst, &rx_lli, &tx_lli, false);
+    while (IDU->IDU_CTL0 & BIT0);
+    bool ret = hal_idu_rect_finish(rx_lli, tx_lli);
+    hal_idu_release();
+    return ret;
+}
+
+bool hal_idu_decompress_rect_async(hal_idu_decompress_job *job)
+{
+    if ((job == NULL) || (job->dst == NULL) || (job->info.raw_data_address == 0))
     {
         return false;
     }
+    IDU_file_header *header = (IDU_file_header *)job->info.raw_data_address;
+    if ((job->info.start_line > job->info.end_line) ||
+        (job->info.start_column > job->info.end_column) ||
+        (job->info.end_line >= header->raw_pic_height) ||
+        (job->info.end_column >= header->raw_pic_width) ||
+        (job->info.length % 4) || (job->info.dst_stride % 4))
+    {
+        return false;
+    }
+    /* jobs start from the IRQ, where the chains must fit the arenas rather than the heap */
+    if ((hal_idu_rect_tx_block_num(&job->info) > HAL_IDU_LLI_ARENA_SIZE) ||
+        (hal_idu_rect_rx_block_num(&job->info) > HAL_IDU_LLI_ARENA_SIZE))
+    {
+        return false;
+    }
+    job->done = false;
+    job->success = false;
+    job->next = NULL;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (idu_job_tail)
+    {
+        idu_job_tail->next = job;
+    }
     else
     {
+        idu_job_head = job;
+    }
+    idu_job_tail = job;
+    if (!idu_hw_claimed)
+    {
+        hal_idu_job_kick();
+    }
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/* Caller keeps interrupts masked. Once the IDU has stopped, retires the head job and starts the
+ * next one. Returns the retired job for its callback to run with interrupts restored. */
+static hal_idu_decompress_job *hal_idu_job_service(void)
+{
+    if (!idu_job_running || (IDU->IDU_CTL0 & BIT0))
+    {
+        return NULL;
+    }
+    hal_idu_decompress_job *job = idu_job_head;
+    job->success = hal_idu_rect_finish(idu_job_rx_lli, idu_job_tx_lli);
+    idu_job_rx_lli = NULL;
+    idu_job_tx_lli = NULL;
+    idu_job_head = job->next;
+    if (idu_job_head == NULL)
+    {
+        idu_job_tail = NULL;
+    }
+    hal_idu_job_kick();
+    job->done = true;
+    return job;
+}
+
+bool hal_idu_decompress_busy(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    hal_idu_decompress_job *job = hal_idu_job_service();
+    bool busy = idu_hw_claimed;
+    __set_PRIMASK(primask);
+    if ((job != NULL) && (job->callback != NULL))
+    {
+        job->callback(job);
+    }
+    return busy;
+}
+
+bool hal_idu_irq_handler(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!idu_hw_claimed)
+    {
+        __set_PRIMASK(primask);
+        return false;
+    }
+    if (!idu_job_running)
+    {
+        /* a blocking call polls the status itself, keep it for that call */
+        IDU_MaskINTConfig(IDU_DECOMPRESS_FINISH_INT | IDU_DECOMPRESS_ERROR_INT, ENABLE);
+        __set_PRIMASK(primask);
         return true;
     }
+    hal_idu_decompress_job *job = hal_idu_job_service();
+    __set_PRIMASK(primask);
+    if ((job != NULL) && (job->callback != NULL))
+    {
+        job->callback(job);
+    }
+    return true;
 }
 
 
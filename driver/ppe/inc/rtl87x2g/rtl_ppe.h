@@ -233,6 +233,7 @@ typedef enum
     PPE_ERROR_NULL_SOURCE,
     PPE_ERROR_NULL_TARGET,
     PPE_ERROR_OUT_OF_RANGE,
+    PPE_ERROR_LIST_FULL,
 } PPE_ERR;
 
 typedef enum
@@ -241,6 +242,36 @@ typedef enum
     PPE_SRC_OVER_MODE,  //D = (1 - a) * D + S * a;
 } PPE_BLEND_MODE;
 
+typedef enum
+{
+    PPE_ROTATE_0,
+    PPE_ROTATE_90,      /* clockwise */
+    PPE_ROTATE_180,
+    PPE_ROTATE_270,
+    PPE_FLIP_H,         /* mirror left and right */
+    PPE_FLIP_V,         /* mirror top and bottom */
+} PPE_ORIENT;
+
+typedef enum
+{
+    PPE_SCALE_STRETCH,  //source fills the destination rect, aspect ratio not kept
+    PPE_SCALE_FIT,      //whole source inside the destination rect, aspect ratio kept, centered
+    PPE_SCALE_FILL,     //source covers the destination rect, aspect ratio kept, centered and cropped
+} PPE_SCALE_MODE;
+
+typedef enum
+{
+    PPE_DITHER_NONE,        //channels are truncated
+    PPE_DITHER_ORDERED,     //4x4 Bayer threshold before truncation
+    PPE_DITHER_DIFFUSION,   //Floyd-Steinberg error diffusion
+} PPE_DITHER_MODE;
+
+typedef uint32_t ppe_job_t;
+
+#define PPE_JOB_INVALID                 ((ppe_job_t)0)
+
+typedef void (*ppe_job_callback_t)(ppe_job_t job, void *user_data);
+
 typedef struct
 {
     union
@@ -280,7 +311,7 @@ typedef struct
     bool global_alpha_en;
     uint16_t width;
     uint16_t height;
-    uint16_t stride;
+    uint16_t stride;            /* pixels per line, 0 if equal to width */
     uint32_t color_key_value;
     uint8_t global_alpha;
 } ppe_buffer_t;
@@ -293,6 +324,15 @@ typedef struct
     ppe_translate_t trans;
 } ppe_layer_t;
 
+/* input layers PPE blends in one job */
+#define PPE_INPUT_LAYER_MAX         15
+
+typedef struct
+{
+    ppe_buffer_t *src;
+    ppe_buffer_t *dst;
+} ppe_convert_item_t;
+
 typedef struct
 {
     ppe_layer_t *input_layer1;
@@ -302,6 +342,135 @@ typedef struct
     ppe_layer_t *output_layer;
 } ppe_input_list_t;
 
+/* LLI descriptor fetched by PPE: one PPE_LLI_LAYER per layer enabled in LL_CFG,
+   result layer first, followed by the address of the next descriptor (0 ends the list) */
+typedef struct
+{
+    PPE_LLI_LAYER result_layer;
+    PPE_LLI_LAYER input_layer[2];
+    uint32_t LLP;
+} PPE_LLI_NODE;
+
+/* register values that cannot be reloaded from a descriptor, commands with equal values share a run;
+   line_len is kept out of the PIC_CFG words and only compared for layers that read more than one line */
+typedef struct
+{
+    uint32_t func_cfg;
+    uint32_t sca_ratio_x;
+    uint32_t sca_ratio_y;
+    uint32_t result_pic_cfg;
+    uint32_t input_pic_cfg[2];
+    uint32_t key_color;
+} ppe_cmd_cfg_t;
+
+typedef struct
+{
+    PPE_LLI_NODE node;
+    ppe_cmd_cfg_t cfg;
+    uint16_t line_len[3];   /* result layer first, then input layers */
+} ppe_cmd_t;
+
+typedef struct
+{
+    ppe_cmd_t *cmd;
+    uint16_t cmd_max;
+    uint16_t cmd_num;
+    uint16_t run_start;
+    uint16_t run_num;
+} ppe_cmdlist_t;
+
+typedef struct
+{
+    ppe_rect_t rect;
+    uint32_t color;             /* ABGR8888 */
+} ppe_fill_t;
+
+#ifndef PPE_DAMAGE_RECT_MAX
+#define PPE_DAMAGE_RECT_MAX         16
+#endif
+
+/* merge two damage rects when the union adds fewer pixels than this, about the cost of one job setup */
+#ifndef PPE_DAMAGE_MERGE_PIXELS
+#define PPE_DAMAGE_MERGE_PIXELS     1024
+#endif
+
+/* default area in pixels up to which PPE_Clear_Rect and PPE_blend_rect use the CPU */
+#ifndef PPE_SW_THRESHOLD_PIXELS
+#define PPE_SW_THRESHOLD_PIXELS     256
+#endif
+
+/* result lines PPE_Scale_To_Rect writes in one job, taller outputs are split into bands */
+#ifndef PPE_SCALE_BAND_LINES
+#define PPE_SCALE_BAND_LINES        0xFFFF
+#endif
+
+/* lines ppe_convert hands to PPE in one job */
+#ifndef PPE_CONVERT_BAND_LINES
+#define PPE_CONVERT_BAND_LINES      64
+#endif
+
+typedef struct
+{
+    ppe_rect_t rect[PPE_DAMAGE_RECT_MAX];
+    uint8_t rect_num;
+    uint16_t width;
+    uint16_t height;
+} ppe_damage_t;
+
+/* MMIO writes done and avoided by the layer register shadow */
+typedef struct
+{
+    uint32_t write_cnt;
+    uint32_t skip_cnt;
+} ppe_reg_stat_t;
+
+/* PPE_Cmd(ENABLE) runs the job on the CPU model in ppe_simulation.c instead of the engine */
+#ifndef PPE_SIM_BACKEND
+#define PPE_SIM_BACKEND             0
+#endif
+
+/* job timing and traffic counters, read with PPE_Perf_GetStat */
+#ifndef PPE_PERF_EN
+#define PPE_PERF_EN                 0
+#endif
+
+#if PPE_PERF_EN
+/* latency histogram bins, two per power of two of timestamp ticks */
+#define PPE_PERF_HIST_BINS          64
+
+typedef enum
+{
+    PPE_PERF_OP_OTHER,       /* register level use outside the APIs below */
+    PPE_PERF_OP_SCALE,       /* PPE_Scale, PPE_Scale_Rect, PPE_Scale_Rect_Cover, PPE_Scale_To_Rect */
+    PPE_PERF_OP_CONVERT,     /* ppe_convert */
+    PPE_PERF_OP_CLEAR,       /* PPE_Clear, PPE_Clear_Rect */
+    PPE_PERF_OP_BLEND,       /* PPE_blend, PPE_blend_rect */
+    PPE_PERF_OP_BLEND_MULTI, /* PPE_blend_multi, PPE_blend_layers */
+    PPE_PERF_OP_CMDLIST,     /* PPE_CmdList_Submit, PPE_CmdList_Submit_Async */
+    PPE_PERF_OP_NUM,
+} PPE_PERF_OP;
+
+/* counters of one API family, times are in PPE_PERF_TIMESTAMP() ticks */
+typedef struct
+{
+    uint32_t call_cnt;          /* API calls, also the ones that did not start PPE */
+    uint32_t job_cnt;           /* PPE jobs run for these calls */
+    uint64_t setup_time;        /* API entry or previous job end to PPE_Cmd(ENABLE) */
+    uint64_t exec_time;         /* PPE_Cmd(ENABLE) to job end */
+    uint32_t latency_min;       /* setup and execution of one job */
+    uint32_t latency_max;
+    uint64_t pixels;            /* result pixels */
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+    uint32_t hist[PPE_PERF_HIST_BINS];
+} ppe_perf_op_t;
+
+typedef struct
+{
+    ppe_perf_op_t op[PPE_PERF_OP_NUM];
+} ppe_perf_stat_t;
+#endif
+
 /**
  * \defgroup    PPE_Interrupt PPE Interrupt
  * \{
@@ -386,6 +555,60 @@ typedef struct
 */
 void PPE_Cmd(FunctionalState state);
 
+/**
+ * \brief  Forget the driver copy of the layer registers
+ * \note   PPE_InitInputLayer and PPE_InitResultLayer keep a copy of what they wrote and skip
+ *         writing words that did not change. Call this after PPE was reset or powered down, or
+ *         after layer registers were written without these functions.
+ * \return None
+ */
+void PPE_RegShadow_Invalidate(void);
+
+/**
+ * \brief  Get the number of layer register writes done and skipped
+ * \param[out] stat        counters since start or the last PPE_RegShadow_ClearStat.
+ * \return None
+ */
+void PPE_RegShadow_GetStat(ppe_reg_stat_t *stat);
+
+/**
+ * \brief  Clear the layer register write counters
+ * \return None
+ */
+void PPE_RegShadow_ClearStat(void);
+
+#if PPE_PERF_EN
+/**
+ * \brief  Get the job timing and traffic counters
+ * \param[out] stat        counters per API family since start or the last PPE_Perf_ClearStat.
+ * \return None
+ */
+void PPE_Perf_GetStat(ppe_perf_stat_t *stat);
+
+/**
+ * \brief  Clear the job timing and traffic counters
+ * \note   Also starts the DWT cycle counter when PPE_PERF_TIMESTAMP is not provided.
+ * \return None
+ */
+void PPE_Perf_ClearStat(void);
+
+/**
+ * \brief  Get a job latency percentile of one API family
+ * \param[in] op           counters from PPE_Perf_GetStat.
+ * \param[in] percent      0 to 100.
+ * \return Upper bound of the histogram bin holding the percentile, in timestamp ticks
+ */
+uint32_t PPE_Perf_Percentile(ppe_perf_op_t *op, uint8_t percent);
+
+/**
+ * \brief  Print the counters as text, one line per API family that was called
+ * \param[out] buf         text buffer, always NUL terminated.
+ * \param[in] size         size of buf in bytes.
+ * \return Length of the text, cut at size - 1
+ */
+uint32_t PPE_Perf_Dump(char *buf, uint32_t size);
+#endif
+
 /**
  * \brief  Suspend PPE
  *
@@ -723,6 +946,100 @@ PPE_ERR PPE_Scale_Rect_Cover(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_tran
                              float x_ratio, float y_ratio,
                              ppe_rect_t *rect);
 
+/**
+ * \brief  Scale a part of image to an exact size on the target
+ * \param[in] image         input image.
+ * \param[in] buffer        target buffer, its width and height are not changed.
+ * \param[in] src_rect      part of image to be scaled, NULL for the whole image.
+ * \param[in] dst_rect      area of buffer the image is scaled to, NULL for the whole buffer.
+ *                          It may exceed the buffer, only the part inside buffer is written.
+ * \param[in] mode          how the source is fitted into dst_rect.
+ * \return operation result
+ * \retval PPE_SUCCESS             Operation success.
+ * \retval PPE_SUCCESS_NOT_CHANGE  Nothing of the scaled image lies inside buffer.
+ * \retval others                  Operation failure.
+ * \note   The Q16 step is computed with integer division so that the last destination pixel
+ *         samples the last source pixel, no floating point is used. Outputs taller than
+ *         PPE_SCALE_BAND_LINES run as several jobs, each restarting on a whole source line.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+        ppe_buffer_t image, buffer;
+        image.width = 25;
+        image.height = 25;
+        image.format = PPE_RGB888;
+        image.memory = (uint32_t*)SOURCE_PIC_1;
+        image.address = (uint32_t)image.memory;
+
+        buffer.width = 64;
+        buffer.height = 64;
+        buffer.format = PPE_RGB565;
+        buffer.memory = (uint32_t*)PIC_OUTPUT_LAYER;
+        buffer.address = (uint32_t)PIC_OUTPUT_LAYER;
+        ppe_rect_t dst_rect = {10, 5, 49, 34};
+        PPE_ERR err = PPE_Scale_To_Rect(&image, &buffer, NULL, &dst_rect, PPE_SCALE_FIT);
+    }
+ * \endcode
+ */
+PPE_ERR PPE_Scale_To_Rect(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_rect_t *src_rect,
+                          ppe_rect_t *dst_rect, PPE_SCALE_MODE mode);
+
+/**
+ * \brief  Convert an image to the format of dst
+ * \param[in] src           input image.
+ * \param[in] dst           output buffer, same width and height as src.
+ * \param[in] dither        dither applied where dst stores fewer R/G/B bits than src.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval PPE_ERROR_UNKNOWN_FORMAT  Unknown format, or A8/X8 on a buffer not aligned to 4 bytes.
+ * \retval others       Operation failure.
+ * \note   Without dithering, or when no precision is lost, PPE converts the image in jobs of
+ *         PPE_CONVERT_BAND_LINES lines. Dithering, and buffers not aligned to 4 bytes, use the
+ *         CPU, which works line by line and does not support A8 and X8. PPE_DITHER_DIFFUSION
+ *         falls back to PPE_DITHER_ORDERED for images wider than PPE_CONVERT_LINE_MAX.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        ppe_buffer_t image, buffer;
+        image.width = 25;
+        image.height = 25;
+        image.format = PPE_ARGB8888;
+        image.memory = (uint32_t*)SOURCE_PIC_1;
+        image.address = (uint32_t)image.memory;
+
+        buffer.width = 25;
+        buffer.height = 25;
+        buffer.format = PPE_RGB565;
+        buffer.memory = (uint32_t*)PIC_OUTPUT_LAYER;
+        buffer.address = (uint32_t)PIC_OUTPUT_LAYER;
+        PPE_ERR err = ppe_convert(&image, &buffer, PPE_DITHER_ORDERED);
+    }
+ * \endcode
+ */
+PPE_ERR ppe_convert(ppe_buffer_t *src, ppe_buffer_t *dst, PPE_DITHER_MODE dither);
+
+/**
+ * \brief  Convert a list of images, e.g. an asset pack at load time
+ * \param[in] item          source and destination of each image.
+ * \param[in] item_num      number of images.
+ * \param[in] dither        dither mode used for all images.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure of the first failing image, later ones are not converted.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        ppe_convert_item_t pack[2] = {{&icon_src, &icon_dst}, {&bg_src, &bg_dst}};
+        PPE_ERR err = ppe_convert_list(pack, 2, PPE_DITHER_DIFFUSION);
+    }
+ * \endcode
+ */
+PPE_ERR ppe_convert_list(ppe_convert_item_t *item, uint32_t item_num, PPE_DITHER_MODE dither);
+
 /**
  * \brief  Clear the image buffer with certain color in ABGR8888 format
  * \param[in] buffer        input image buffer.
@@ -849,6 +1166,31 @@ PPE_ERR PPE_blend(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *tr
 PPE_ERR PPE_blend_rect(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
                        ppe_rect_t *rect, PPE_BLEND_MODE blend_mode);
 
+/**
+ * \brief  blend source image rotated by a multiple of 90 degrees or mirrored to target buffer
+ * \note   PPE has no transform stage, so every orientation but PPE_ROTATE_0 is done by the CPU
+ *         walking the image in PPE_ORIENT_TILE_SIZE tiles. PPE_ROTATE_0 is PPE_blend.
+ * \param[in] image         source image.
+ * \param[in] buffer        target image buffer.
+ * \param[in] trans         top left corner of the rotated image in buffer.
+ * \param[in] orient        rotation or mirror applied to image.
+ * \param[in] blend_mode    blend mode.
+ * \return operation result
+ * \retval PPE_SUCCESS                 Operation success, or nothing to draw.
+ * \retval PPE_ERROR_UNKNOWN_FORMAT    A8/X8 image or buffer, which the CPU path does not handle.
+ * \retval others                      Operation failure.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        ppe_translate_t trans = {0, 0};
+        PPE_Blit_Orient(&frame_buffer, &panel_buffer, &trans, PPE_ROTATE_90, PPE_BYPASS_MODE);
+    }
+ * \endcode
+ */
+PPE_ERR PPE_Blit_Orient(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
+                        PPE_ORIENT orient, PPE_BLEND_MODE blend_mode);
+
 
 /**
  * \brief  blend multiple images to target buffer
@@ -860,6 +1202,9 @@ PPE_ERR PPE_blend_rect(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_
  * \return operation result
  * \retval PPE_SUCCESS  Operation success.
  * \retval others       Operation failure.
+ * \note   With PPE_OCCLUSION_CULL_EN, a layer is dropped when opaque layers above it cover it,
+ *         and is cut to the rectangle still showing when one of them covers a full side of it.
+ *         Opaque layers have no alpha channel, no color key and no global alpha below 0xFF.
  *
  * <b>Example usage</b>
  * \code{.c}
@@ -907,6 +1252,39 @@ PPE_ERR PPE_blend_rect(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_
  */
 PPE_ERR PPE_blend_multi(ppe_input_list_t list);
 
+/**
+ * \brief  blend any number of layers to target buffer
+ * \note   layers[0] is the bottom layer. Up to PPE_INPUT_LAYER_MAX layers are blended in one job,
+ *         the same way as PPE_blend_multi. Layers beyond that are drawn in further jobs of
+ *         PPE_INPUT_LAYER_MAX - 1 layers each, on top of the target, which is read back only
+ *         inside the bounding box of the layers of that job. No intermediate buffer is used.
+ *         Layers that miss the target are skipped.
+ * \param[in] layers        array of source layers, must not be NULL when layer_num is not 0.
+ * \param[in] layer_num     number of layers.
+ * \param[in] output        target layer.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        ppe_layer_t face[12];
+        ppe_layer_t screen;
+        memset(face, 0, sizeof(face));
+        memset(&screen, 0, sizeof(screen));
+        screen.buffer.memory = (uint32_t*)address0;
+        screen.buffer.address = address0;
+        screen.buffer.width = 454;
+        screen.buffer.height = 454;
+        screen.buffer.format = PPE_RGB565;
+        ...
+        PPE_ERR err = PPE_blend_layers(face, 12, &screen);
+    }
+ * \endcode
+ */
+PPE_ERR PPE_blend_layers(ppe_layer_t *layers, uint32_t layer_num, ppe_layer_t *output);
+
 /**
  * \brief  Get pixel size of certain format
  * \param[in] format        pixel format of PPE
@@ -921,6 +1299,25 @@ PPE_ERR PPE_blend_multi(ppe_input_list_t list);
  */
 uint8_t ppe_get_format_data_len(PPE_PIXEL_FORMAT format);
 
+/**
+ * \brief  Set the size below which PPE_Clear_Rect and PPE_blend_rect run on the CPU
+ * \note   Programming a job costs about as much as blending a few hundred pixels in software, so
+ *         clipped areas of at most pixels are drawn by the CPU when both formats carry RGB.
+ *         The CPU path first waits for the running job, so results keep their issue order.
+ *         Async calls that take it complete immediately. The crossover depends on CPU clock
+ *         and memory, measure it per board.
+ * \param[in] pixels        area limit in pixels, 0 always uses PPE.
+ * \return None
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        PPE_SetSoftwareThreshold(0);
+    }
+ * \endcode
+ */
+void PPE_SetSoftwareThreshold(uint32_t pixels);
+
 /**
  * \brief  Get intersected area
  * \param[in] result_rect       porinter to rect that stores result
@@ -945,6 +1342,406 @@ uint8_t ppe_get_format_data_len(PPE_PIXEL_FORMAT format);
  * \endcode
  */
 bool ppe_rect_intersect(ppe_rect_t *result_rect, ppe_rect_t *rect1, ppe_rect_t *rect2);
+
+/**
+ * \brief  Check whether an asynchronous PPE job has finished
+ * \param[in] job           job handle returned by one of the *_Async functions.
+ * \return job state
+ * \retval true         the job has finished, or job is PPE_JOB_INVALID.
+ * \retval false        the job is still running on PPE.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        ppe_job_t job;
+        PPE_Clear_Async(&buffer, 0xFFFF00FF, NULL, NULL, &job);
+        while (!PPE_JobPoll(job))
+        {
+            //User operation
+        }
+    }
+ * \endcode
+ */
+bool PPE_JobPoll(ppe_job_t job);
+
+/**
+ * \brief  Wait until an asynchronous PPE job has finished
+ * \param[in] job           job handle returned by one of the *_Async functions.
+ * \return None
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        ppe_job_t job;
+        PPE_Clear_Async(&buffer, 0xFFFF00FF, NULL, NULL, &job);
+        //User operation
+        PPE_JobWait(job);
+    }
+ * \endcode
+ */
+void PPE_JobWait(ppe_job_t job);
+
+/**
+ * \brief  Complete the running asynchronous job, call it from the PPE interrupt handler
+ * \note   The job callback is invoked from this function, i.e. in interrupt context.
+ *         Without it, PPE_JobPoll, PPE_JobWait and the blocking APIs retire a finished job
+ *         from GLB_CTL and the raw interrupt state instead, and run the callback there.
+ * \return None
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void PPE_Handler(void)
+    {
+        PPE_JobIRQHandler();
+    }
+ * \endcode
+ */
+void PPE_JobIRQHandler(void);
+
+/**
+ * \brief  Non-blocking version of PPE_Scale
+ * \note   If a previous asynchronous job is still running, this function waits for it before
+ *         programming PPE. The job finishes on PPE_ALL_OVER_INT, see PPE_JobIRQHandler.
+ * \param[in] image         input image.
+ * \param[in] buffer        output image buffer.
+ * \param[in] x_ratio       scale ration on x-axis.
+ * \param[in] y_ratio       scale ration on y-axis.
+ * \param[in] callback      called when the job finishes, can be NULL.
+ * \param[in] user_data     argument passed to callback.
+ * \param[out] job          handle of the submitted job, can be NULL.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure, callback will not be called.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    static void scale_done(ppe_job_t job, void *user_data)
+    {
+        //User operation
+    }
+
+    void test_code(void){
+        ppe_job_t job;
+        PPE_ERR err = PPE_Scale_Async(&image, &buffer, 3, 0.8, scale_done, NULL, &job);
+    }
+ * \endcode
+ */
+PPE_ERR PPE_Scale_Async(ppe_buffer_t *image, ppe_buffer_t *buffer, float x_ratio, float y_ratio,
+                        ppe_job_callback_t callback, void *user_data, ppe_job_t *job);
+
+/**
+ * \brief  Non-blocking version of PPE_Scale_Rect
+ * \param[in] image         input image.
+ * \param[in] buffer        output image buffer.
+ * \param[in] x_ratio       scale ration on x-axis.
+ * \param[in] y_ratio       scale ration on y-axis.
+ * \param[in] rect          the boundary of the part to be scaled.
+ * \param[in] callback      called when the job finishes, can be NULL.
+ * \param[in] user_data     argument passed to callback.
+ * \param[out] job          handle of the submitted job, can be NULL.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure, callback will not be called.
+ */
+PPE_ERR PPE_Scale_Rect_Async(ppe_buffer_t *image, ppe_buffer_t *buffer, float x_ratio,
+                             float y_ratio, ppe_rect_t *rect,
+                             ppe_job_callback_t callback, void *user_data, ppe_job_t *job);
+
+/**
+ * \brief  Non-blocking version of PPE_Clear
+ * \param[in] buffer        input image buffer.
+ * \param[in] color         specified color in ABGR8888 format
+ * \param[in] callback      called when the job finishes, can be NULL.
+ * \param[in] user_data     argument passed to callback.
+ * \param[out] job          handle of the submitted job, can be NULL.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure, callback will not be called.
+ */
+PPE_ERR PPE_Clear_Async(ppe_buffer_t *buffer, uint32_t color,
+                        ppe_job_callback_t callback, void *user_data, ppe_job_t *job);
+
+/**
+ * \brief  Non-blocking version of PPE_Clear_Rect
+ * \param[in] buffer        input image buffer.
+ * \param[in] rect          specified range
+ * \param[in] color         specified color in ABGR8888 format
+ * \param[in] callback      called when the job finishes, can be NULL.
+ * \param[in] user_data     argument passed to callback.
+ * \param[out] job          handle of the submitted job, can be NULL.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure, callback will not be called.
+ */
+PPE_ERR PPE_Clear_Rect_Async(ppe_buffer_t *buffer, ppe_rect_t *rect, uint32_t color,
+                             ppe_job_callback_t callback, void *user_data, ppe_job_t *job);
+
+/**
+ * \brief  Non-blocking version of PPE_blend
+ * \param[in] image         source image.
+ * \param[in] buffer        target image buffer.
+ * \param[in] trans         translate information of source image.
+ * \param[in] blend_mode    blend mode.
+ * \param[in] callback      called when the job finishes, can be NULL.
+ * \param[in] user_data     argument passed to callback.
+ * \param[out] job          handle of the submitted job, can be NULL.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure, callback will not be called.
+ */
+PPE_ERR PPE_blend_Async(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
+                        PPE_BLEND_MODE blend_mode,
+                        ppe_job_callback_t callback, void *user_data, ppe_job_t *job);
+
+/**
+ * \brief  Non-blocking version of PPE_blend_rect
+ * \param[in] image         source image.
+ * \param[in] buffer        target image buffer.
+ * \param[in] trans         translate information of source image.
+ * \param[in] rect          the boundary of the part to be blended.
+ * \param[in] blend_mode    blend mode.
+ * \param[in] callback      called when the job finishes, can be NULL.
+ * \param[in] user_data     argument passed to callback.
+ * \param[out] job          handle of the submitted job, can be NULL.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure, callback will not be called.
+ */
+PPE_ERR PPE_blend_rect_Async(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
+                             ppe_rect_t *rect, PPE_BLEND_MODE blend_mode,
+                             ppe_job_callback_t callback, void *user_data, ppe_job_t *job);
+
+/**
+ * \brief  Non-blocking version of PPE_blend_multi
+ * \param[in] list          input and output layers.
+ * \param[in] callback      called when the job finishes, can be NULL.
+ * \param[in] user_data     argument passed to callback.
+ * \param[out] job          handle of the submitted job, can be NULL.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure, callback will not be called.
+ */
+PPE_ERR PPE_blend_multi_Async(ppe_input_list_t list,
+                              ppe_job_callback_t callback, void *user_data, ppe_job_t *job);
+
+/**
+ * \brief  Initialize a command list on caller provided storage
+ * \param[in] list          command list.
+ * \param[in] cmd           storage for the recorded commands.
+ * \param[in] cmd_max       number of elements in cmd.
+ * \return None
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    static ppe_cmd_t frame_cmd[64];
+    static ppe_cmdlist_t frame;
+
+    void test_code(void){
+        PPE_CmdList_Init(&frame, frame_cmd, 64);
+    }
+ * \endcode
+ */
+void PPE_CmdList_Init(ppe_cmdlist_t *list, ppe_cmd_t *cmd, uint16_t cmd_max);
+
+/**
+ * \brief  Drop all recorded commands, must not be called while the list is being executed
+ * \param[in] list          command list.
+ * \return None
+ */
+void PPE_CmdList_Reset(ppe_cmdlist_t *list);
+
+/**
+ * \brief  Record a PPE_Scale operation
+ * \note   buffer->width and buffer->height are updated at record time, same as PPE_Scale.
+ * \param[in] list          command list.
+ * \param[in] image         input image.
+ * \param[in] buffer        output image buffer.
+ * \param[in] x_ratio       scale ration on x-axis.
+ * \param[in] y_ratio       scale ration on y-axis.
+ * \return operation result
+ * \retval PPE_SUCCESS          Operation recorded.
+ * \retval PPE_ERROR_LIST_FULL  No room left in list.
+ * \retval others               Operation failure.
+ */
+PPE_ERR PPE_CmdList_Scale(ppe_cmdlist_t *list, ppe_buffer_t *image, ppe_buffer_t *buffer,
+                          float x_ratio, float y_ratio);
+
+/**
+ * \brief  Record a PPE_Clear_Rect operation
+ * \param[in] list          command list.
+ * \param[in] buffer        input image buffer.
+ * \param[in] rect          specified range
+ * \param[in] color         specified color in ABGR8888 format
+ * \return operation result
+ * \retval PPE_SUCCESS          Operation recorded, or nothing to draw.
+ * \retval PPE_ERROR_LIST_FULL  No room left in list.
+ * \retval others               Operation failure.
+ */
+PPE_ERR PPE_CmdList_Clear_Rect(ppe_cmdlist_t *list, ppe_buffer_t *buffer, ppe_rect_t *rect,
+                               uint32_t color);
+
+/**
+ * \brief  Record a PPE_blend_rect operation
+ * \param[in] list          command list.
+ * \param[in] image         source image.
+ * \param[in] buffer        target image buffer.
+ * \param[in] trans         translate information of source image.
+ * \param[in] rect          the boundary of the part to be blended.
+ * \param[in] blend_mode    blend mode.
+ * \return operation result
+ * \retval PPE_SUCCESS          Operation recorded, or nothing to draw.
+ * \retval PPE_ERROR_LIST_FULL  No room left in list.
+ * \retval others               Operation failure.
+ */
+PPE_ERR PPE_CmdList_blend_rect(ppe_cmdlist_t *list, ppe_buffer_t *image, ppe_buffer_t *buffer,
+                               ppe_translate_t *trans, ppe_rect_t *rect, PPE_BLEND_MODE blend_mode);
+
+/**
+ * \brief  Record a PPE_blend operation
+ * \param[in] list          command list.
+ * \param[in] image         source image.
+ * \param[in] buffer        target image buffer.
+ * \param[in] trans         translate information of source image.
+ * \param[in] blend_mode    blend mode.
+ * \return operation result
+ * \retval PPE_SUCCESS          Operation recorded, or nothing to draw.
+ * \retval PPE_ERROR_LIST_FULL  No room left in list.
+ * \retval others               Operation failure.
+ */
+PPE_ERR PPE_CmdList_blend(ppe_cmdlist_t *list, ppe_buffer_t *image, ppe_buffer_t *buffer,
+                          ppe_translate_t *trans, PPE_BLEND_MODE blend_mode);
+
+/**
+ * \brief  Execute all recorded commands and wait for them to finish
+ * \note   Consecutive commands that share function, output layer, source formats, color key
+ *         and scale ratio are linked into one hardware linked-list run, so the whole run costs
+ *         a single register setup and start. Address and window size come from each command's
+ *         descriptor. Line length is a PIC_CFG field the descriptor cannot reload, so a layer
+ *         only splits a run when it reads more than one line with a different line length.
+ *         list->run_num reports how many runs were needed.
+ * \param[in] list          command list.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        PPE_CmdList_Reset(&frame);
+        PPE_CmdList_Clear_Rect(&frame, &fb, &bg_rect, 0xFF000000);
+        for (uint32_t i = 0; i < icon_num; i++)
+        {
+            PPE_CmdList_blend(&frame, &icon[i], &fb, &icon_pos[i], PPE_SRC_OVER_MODE);
+        }
+        PPE_CmdList_Submit(&frame);
+    }
+ * \endcode
+ */
+PPE_ERR PPE_CmdList_Submit(ppe_cmdlist_t *list);
+
+/**
+ * \brief  Non-blocking version of PPE_CmdList_Submit
+ * \note   list must stay untouched until the job finishes.
+ * \param[in] list          command list.
+ * \param[in] callback      called when the last command finishes, can be NULL.
+ * \param[in] user_data     argument passed to callback.
+ * \param[out] job          handle of the submitted job, can be NULL.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure, callback will not be called.
+ */
+PPE_ERR PPE_CmdList_Submit_Async(ppe_cmdlist_t *list, ppe_job_callback_t callback,
+                                 void *user_data, ppe_job_t *job);
+
+/**
+ * \brief  Fill many rects of one buffer with a single command list submission
+ * \note   Fills are painted in array order. A fill is merged into an earlier fill of the same
+ *         color when they share an edge and no fill in between overlaps it, fill[] is rewritten
+ *         in place with the merged rects. Merged rects within the software threshold that do
+ *         not overlap a queued PPE fill are written by the CPU with 32-bit stores, the rest are
+ *         recorded into list and run as linked-list jobs. list is reset first, and submitted
+ *         early if it fills up.
+ * \param[in] list          scratch command list.
+ * \param[in] buffer        target image buffer.
+ * \param[in,out] fill      rects and colors, rewritten with the merged rects.
+ * \param[in] fill_num      number of fills.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success, or nothing to draw.
+ * \retval others       Operation failure.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    void test_code(void){
+        ppe_fill_t bar[3] = {{{0, 100, 79, 103}, 0xFF00FF00},
+                             {{80, 100, 159, 103}, 0xFF00FF00},
+                             {{160, 100, 239, 103}, 0xFF404040}};
+        PPE_Clear_Rect_List(&frame, &fb, bar, 3);
+    }
+ * \endcode
+ */
+PPE_ERR PPE_Clear_Rect_List(ppe_cmdlist_t *list, ppe_buffer_t *buffer, ppe_fill_t *fill,
+                            uint32_t fill_num);
+
+/**
+ * \brief  Initialize damage tracking for a screen
+ * \param[in] damage        damage list.
+ * \param[in] width         screen width, damage outside the screen is dropped.
+ * \param[in] height        screen height.
+ * \return None
+ */
+void PPE_Damage_Init(ppe_damage_t *damage, uint16_t width, uint16_t height);
+
+/**
+ * \brief  Drop all damage rects
+ * \param[in] damage        damage list.
+ * \return None
+ */
+void PPE_Damage_Reset(ppe_damage_t *damage);
+
+/**
+ * \brief  Invalidate an area of the screen
+ * \note   rect is clipped to the screen and merged with the recorded rects whenever the union
+ *         wastes less than PPE_DAMAGE_MERGE_PIXELS pixels. When the list is full, rect is merged
+ *         into the rect that gives the smallest union.
+ * \param[in] damage        damage list.
+ * \param[in] rect          invalidated area in screen coordinates, right and bottom inclusive.
+ * \return None
+ */
+void PPE_Damage_Add(ppe_damage_t *damage, ppe_rect_t *rect);
+
+/**
+ * \brief  Get the number of pixels to be recomposed
+ * \param[in] damage        damage list.
+ * \return total area of the recorded rects
+ */
+uint32_t PPE_Damage_Area(ppe_damage_t *damage);
+
+/**
+ * \brief  Recompose the damaged areas of a frame with PPE_blend_multi and reset damage
+ * \note   list describes the whole frame the same way as for PPE_blend_multi. Each damage rect is
+ *         composed as one job that only reads and writes the pixels inside it, input layers that
+ *         do not touch the rect are skipped.
+ * \param[in] damage        damage list.
+ * \param[in] list          layers of the frame, output_layer is the screen buffer.
+ * \return operation result
+ * \retval PPE_SUCCESS  Operation success.
+ * \retval others       Operation failure, damage is kept.
+ *
+ * <b>Example usage</b>
+ * \code{.c}
+    static ppe_damage_t damage;
+
+    void test_code(void){
+        PPE_Damage_Init(&damage, 454, 454);
+        ...
+        ppe_rect_t second_hand = {200, 20, 253, 240};
+        PPE_Damage_Add(&damage, &second_hand);
+        PPE_Damage_Add(&damage, &old_second_hand);
+        PPE_Damage_Compose(&damage, list);
+    }
+ * \endcode
+ */
+PPE_ERR PPE_Damage_Compose(ppe_damage_t *damage, ppe_input_list_t list);
 /** End of PPE_Exported_Functions
   * \}
   */
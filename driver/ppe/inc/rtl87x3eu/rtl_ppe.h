@@ -171,6 +171,16 @@ typedef enum
     PPE_CONST_MASK_MODE,
 } PPE_BLEND_MODE;
 
+typedef enum
+{
+    PPE_ROTATE_0,
+    PPE_ROTATE_90,      /* clockwise */
+    PPE_ROTATE_180,
+    PPE_ROTATE_270,
+    PPE_FLIP_H,         /* mirror left and right */
+    PPE_FLIP_V,         /* mirror top and bottom */
+} PPE_ORIENT;
+
 typedef enum
 {
     PPE_BLEND_SRC,
@@ -365,6 +375,81 @@ typedef struct
     float m[3][3];    /*! The 3x3 matrix itself, in [row][column] order. */
 } ppe_matrix_t;
 
+typedef int32_t ppe_fixed_t;    /*! Q16.16 */
+
+#define PPE_FIXED_ONE           ((ppe_fixed_t)0x10000)
+
+typedef struct
+{
+    ppe_fixed_t m[3][3];    /*! Q16.16 matrix, in [row][column] order. */
+} ppe_matrix_fixed_t;
+
+/* MMIO writes done and avoided by the layer register shadow */
+typedef struct
+{
+    uint32_t write_cnt;
+    uint32_t skip_cnt;
+} ppe_reg_stat_t;
+
+/* PPE_Cmd(ENABLE) runs the job on the CPU model in ppe_simulation.c instead of the engine */
+#ifndef PPE_SIM_BACKEND
+#define PPE_SIM_BACKEND             0
+#endif
+
+/* job timing and traffic counters, read with PPE_Perf_GetStat */
+#ifndef PPE_PERF_EN
+#define PPE_PERF_EN                 0
+#endif
+
+#if PPE_PERF_EN
+/* latency histogram bins, two per power of two of timestamp ticks */
+#define PPE_PERF_HIST_BINS          64
+
+typedef enum
+{
+    PPE_PERF_OP_OTHER,
+    PPE_PERF_OP_BLIT,
+    PPE_PERF_OP_MASK,
+    PPE_PERF_OP_NUM,
+} PPE_PERF_OP;
+
+/* counters of one API family, times are in PPE_PERF_TIMESTAMP() ticks */
+typedef struct
+{
+    uint32_t call_cnt;          /* API calls, also the ones that did not start PPE */
+    uint32_t job_cnt;           /* PPE jobs run for these calls */
+    uint64_t setup_time;        /* API entry or previous job end to PPE_Cmd(ENABLE) */
+    uint64_t exec_time;         /* PPE_Cmd(ENABLE) to job end */
+    uint32_t latency_min;       /* setup and execution of one job */
+    uint32_t latency_max;
+    uint64_t pixels;            /* result pixels */
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+    uint32_t hist[PPE_PERF_HIST_BINS];
+} ppe_perf_op_t;
+
+typedef struct
+{
+    ppe_perf_op_t op[PPE_PERF_OP_NUM];
+} ppe_perf_stat_t;
+#endif
+
+/* palette of an I8/I4/I2/I1 source, hash is the content key PPE_CLUT_Load compares */
+typedef struct
+{
+    uint32_t *clut;
+    uint16_t size;
+    uint32_t hash;
+} ppe_clut_t;
+
+/* palettes written to the CLUT and loads avoided because the palette was resident */
+typedef struct
+{
+    uint32_t load_cnt;
+    uint32_t skip_cnt;
+    uint32_t word_cnt;
+} ppe_clut_stat_t;
+
 typedef struct
 {
     int x;
@@ -373,6 +458,12 @@ typedef struct
     uint32_t h;
 } ppe_rect_t;
 
+typedef struct
+{
+    ppe_rect_t rect;
+    uint32_t color;
+} ppe_fill_t;
+
 typedef struct
 {
     int x;
@@ -400,6 +491,17 @@ typedef struct
     bool high_quality;
 } ppe_buffer_t;
 
+/* one PPE_Blit_Inverse call, clut is NULL for sources without palette */
+typedef struct
+{
+    ppe_buffer_t *dst;
+    ppe_buffer_t *src;
+    ppe_matrix_t *inverse;
+    ppe_rect_t *rect;
+    PPE_BLEND_METHOD method;
+    ppe_clut_t *clut;
+} ppe_blit_job_t;
+
 /** End of PPE_Exported_Constants
   * \}
   */
@@ -444,8 +546,27 @@ PPE_ERR PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix
                      PPE_BLEND_MODE mode);
 PPE_ERR PPE_Blit_Inverse(ppe_buffer_t *dst, ppe_buffer_t *src, uint8_t *output, ppe_matrix_t *inverse,
                              ppe_rect_t *rect, PPE_BLEND_METHOD method);
+/* src rotated by a multiple of 90 degrees or mirrored with its top left corner at (x, y), the
+   coefficients are built directly instead of inverting a matrix */
+PPE_ERR PPE_Blit_Orient(ppe_buffer_t *dst, ppe_buffer_t *src, int32_t x, int32_t y,
+                        PPE_ORIENT orient, PPE_BLEND_METHOD method);
 PPE_ERR PPE_Blend_Handshake(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_rect_t *rect);
 
+/* layer Init functions skip words that match the driver copy, forget it after PPE lost its
+   registers or they were written directly */
+void PPE_RegShadow_Invalidate(void);
+void PPE_RegShadow_GetStat(ppe_reg_stat_t *stat);
+void PPE_RegShadow_ClearStat(void);
+
+#if PPE_PERF_EN
+/* per API family job counters, PPE_Perf_Percentile gives the upper bound of the histogram bin
+   holding the percentile, PPE_Perf_Dump prints one line per family that was called */
+void PPE_Perf_GetStat(ppe_perf_stat_t *stat);
+void PPE_Perf_ClearStat(void);
+uint32_t PPE_Perf_Percentile(ppe_perf_op_t *op, uint8_t percent);
+uint32_t PPE_Perf_Dump(char *buf, uint32_t size);
+#endif
+
 void PPE_CLK_ENABLE(FunctionalState NewState);
 void PPE_Finish(void);
 uint8_t PPE_Get_Pixel_Size(PPE_PIXEL_FORMAT format);
@@ -457,14 +578,41 @@ void ppe_perspective(float px, float py, ppe_matrix_t *matrix);
 int  ppe_get_transform_matrix(ppe_point4_t src, ppe_point4_t dst, ppe_matrix_t *mat);
 void ppe_matrix_inverse(ppe_matrix_t *matrix);
 void ppe_mat_multiply(ppe_matrix_t *matrix, ppe_matrix_t *mult);
+void ppe_fixed_get_identity(ppe_matrix_fixed_t *matrix);
+void ppe_matrix_to_fixed(ppe_matrix_t *matrix, ppe_matrix_fixed_t *fixed);
+void ppe_fixed_to_matrix(ppe_matrix_fixed_t *fixed, ppe_matrix_t *matrix);
+void ppe_fixed_mat_multiply(ppe_matrix_fixed_t *matrix, ppe_matrix_fixed_t *mult);
+void ppe_fixed_translate(ppe_fixed_t x, ppe_fixed_t y, ppe_matrix_fixed_t *matrix);
+void ppe_fixed_scale(ppe_fixed_t scale_x, ppe_fixed_t scale_y, ppe_matrix_fixed_t *matrix);
+void ppe_fixed_rotate(int16_t degrees, ppe_matrix_fixed_t *matrix);
+bool ppe_fixed_matrix_inverse(ppe_matrix_fixed_t *matrix);
+/* inverse of the float matrix in double precision, rounded to Q16.16 once */
+bool ppe_matrix_inverse_fixed(ppe_matrix_t *matrix, ppe_matrix_fixed_t *fixed);
+void ppe_fixed_matrix2complement(ppe_matrix_fixed_t *matrix, uint32_t *comp);
+/* returns the Q16.16 form (inverted if inverse is true) of matrix, cached by matrix contents */
+bool ppe_matrix_cache_get(ppe_matrix_t *matrix, bool inverse, ppe_matrix_fixed_t *result);
 bool ppe_get_area(ppe_rect_t *result_rect, ppe_rect_t *source_rect, ppe_matrix_t *matrix,
                   ppe_buffer_t *buffer);
 PPE_ERR PPE_Blend_Multi(ppe_buffer_t *dst, ppe_buffer_t *src_1,
                             ppe_buffer_t *src_2, ppe_buffer_t *src_3, PPE_BLEND_MODE mode);
 PPE_ERR PPE_Mask(ppe_buffer_t *dst, uint32_t color, ppe_rect_t *rect);
+/* fills in array order, merges same color fills that share an edge within PPE_MASK_LIST_BATCH
+   unmerged fills (fill is left as is), small opaque fills are CPU stores and the rest one
+   PPE_Mask each */
+PPE_ERR PPE_Mask_List(ppe_buffer_t *dst, ppe_fill_t *fill, uint16_t fill_num);
 PPE_ERR PPE_Blit_Inverse_Simulate(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_matrix_t *matrix, ppe_matrix_t *inverse,
                              ppe_rect_t *rect, PPE_BLEND_METHOD method);
 void PPE_Register_CLUT(uint32_t* clut, uint16_t size);
+/* palettes with equal hash and size are treated as identical, the CLUT is only written on a change */
+uint32_t PPE_CLUT_Hash(uint32_t *clut, uint16_t size);
+void PPE_CLUT_Init(ppe_clut_t *palette, uint32_t *clut, uint16_t size);
+bool PPE_CLUT_Load(ppe_clut_t *palette);
+void PPE_CLUT_Invalidate(void);
+void PPE_CLUT_GetStat(ppe_clut_stat_t *stat);
+void PPE_CLUT_ClearStat(void);
+/* runs the jobs in order, except that a job using the resident palette may go before earlier
+   ones it does not overlap, to save palette loads */
+PPE_ERR PPE_Blit_Batch(ppe_blit_job_t *job, uint16_t job_num);
 void PPE_CLK_ENABLE_IN_DLPS(FunctionalState NewState);
 void PPE_test(void);
 /** End of PPE_Exported_Functions
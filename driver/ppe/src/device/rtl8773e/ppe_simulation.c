@@ -0,0 +1,389 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+**********************************************************************************************************
+* \file     ppe_simulation.c
+* \brief    Software model of the RTL8773E PPE 2.0 datapath.
+* \details  PPE_Simulation_Run is the engine side of PPE_Cmd when PPE_SIM_BACKEND is set, it
+*           reads the job back from the layer registers and renders it with PPE_Simulation.
+*********************************************************************************************************
+*/
+
+/*============================================================================*
+ *                        Header Files
+ *============================================================================*/
+#include "ppe_simulation.h"
+#include "string.h"
+
+/*============================================================================*
+ *                          Private Macros
+ *============================================================================*/
+#define MIN(x, y)               (((x) < (y)) ? (x) : (y))
+#define PPE_SIM_A(c)            (((c) >> 24) & 0xFF)
+#define PPE_SIM_R(c)            (((c) >> 16) & 0xFF)
+#define PPE_SIM_G(c)            (((c) >> 8) & 0xFF)
+#define PPE_SIM_B(c)            ((c) & 0xFF)
+#define PPE_SIM_ARGB(a, r, g, b) (((uint32_t)(a) << 24) | ((uint32_t)(r) << 16) | \
+                                  ((uint32_t)(g) << 8) | (uint32_t)(b))
+
+/*============================================================================*
+ *                          Private Types
+ *============================================================================*/
+typedef enum
+{
+    PPE_SIM_RGB,
+    PPE_SIM_ALPHA,              /* A8, color comes from Const_Pixel */
+    PPE_SIM_OPAQUE,             /* X8, opaque Const_Pixel */
+} PPE_SIM_FORMAT_KIND;
+
+typedef struct
+{
+    uint8_t shift;
+    uint8_t bits;
+} ppe_sim_channel_t;
+
+typedef struct
+{
+    uint8_t bpp;
+    uint8_t kind;
+    ppe_sim_channel_t a;
+    ppe_sim_channel_t r;
+    ppe_sim_channel_t g;
+    ppe_sim_channel_t b;
+} ppe_sim_format_t;
+
+/*============================================================================*
+ *                          Private Variables
+ *============================================================================*/
+/* channel position inside the pixel word, the first letter of the format name is the most
+   significant channel */
+static const ppe_sim_format_t ppe_sim_format[] =
+{
+    [PPE_ABGR8888] = {32, PPE_SIM_RGB, {24, 8}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_ARGB8888] = {32, PPE_SIM_RGB, {24, 8}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_XBGR8888] = {32, PPE_SIM_RGB, {0, 0}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_XRGB8888] = {32, PPE_SIM_RGB, {0, 0}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_BGRA8888] = {32, PPE_SIM_RGB, {0, 8}, {8, 8}, {16, 8}, {24, 8}},
+    [PPE_RGBA8888] = {32, PPE_SIM_RGB, {0, 8}, {24, 8}, {16, 8}, {8, 8}},
+    [PPE_BGRX8888] = {32, PPE_SIM_RGB, {0, 0}, {8, 8}, {16, 8}, {24, 8}},
+    [PPE_RGBX8888] = {32, PPE_SIM_RGB, {0, 0}, {24, 8}, {16, 8}, {8, 8}},
+    [PPE_ABGR4444] = {16, PPE_SIM_RGB, {12, 4}, {0, 4}, {4, 4}, {8, 4}},
+    [PPE_ARGB4444] = {16, PPE_SIM_RGB, {12, 4}, {8, 4}, {4, 4}, {0, 4}},
+    [PPE_XBGR4444] = {16, PPE_SIM_RGB, {0, 0}, {0, 4}, {4, 4}, {8, 4}},
+    [PPE_XRGB4444] = {16, PPE_SIM_RGB, {0, 0}, {8, 4}, {4, 4}, {0, 4}},
+    [PPE_BGRA4444] = {16, PPE_SIM_RGB, {0, 4}, {4, 4}, {8, 4}, {12, 4}},
+    [PPE_RGBA4444] = {16, PPE_SIM_RGB, {0, 4}, {12, 4}, {8, 4}, {4, 4}},
+    [PPE_BGRX4444] = {16, PPE_SIM_RGB, {0, 0}, {4, 4}, {8, 4}, {12, 4}},
+    [PPE_RGBX4444] = {16, PPE_SIM_RGB, {0, 0}, {12, 4}, {8, 4}, {4, 4}},
+    [PPE_ABGR2222] = {8, PPE_SIM_RGB, {6, 2}, {0, 2}, {2, 2}, {4, 2}},
+    [PPE_ARGB2222] = {8, PPE_SIM_RGB, {6, 2}, {4, 2}, {2, 2}, {0, 2}},
+    [PPE_XBGR2222] = {8, PPE_SIM_RGB, {0, 0}, {0, 2}, {2, 2}, {4, 2}},
+    [PPE_XRGB2222] = {8, PPE_SIM_RGB, {0, 0}, {4, 2}, {2, 2}, {0, 2}},
+    [PPE_BGRA2222] = {8, PPE_SIM_RGB, {0, 2}, {2, 2}, {4, 2}, {6, 2}},
+    [PPE_RGBA2222] = {8, PPE_SIM_RGB, {0, 2}, {6, 2}, {4, 2}, {2, 2}},
+    [PPE_BGRX2222] = {8, PPE_SIM_RGB, {0, 0}, {2, 2}, {4, 2}, {6, 2}},
+    [PPE_RGBX2222] = {8, PPE_SIM_RGB, {0, 0}, {6, 2}, {4, 2}, {2, 2}},
+    [PPE_ABGR8565] = {24, PPE_SIM_RGB, {16, 8}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_ARGB8565] = {24, PPE_SIM_RGB, {16, 8}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_XBGR8565] = {24, PPE_SIM_RGB, {0, 0}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_XRGB8565] = {24, PPE_SIM_RGB, {0, 0}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_BGRA5658] = {24, PPE_SIM_RGB, {0, 8}, {8, 5}, {13, 6}, {19, 5}},
+    [PPE_RGBA5658] = {24, PPE_SIM_RGB, {0, 8}, {19, 5}, {13, 6}, {8, 5}},
+    [PPE_BGRX5658] = {24, PPE_SIM_RGB, {0, 0}, {8, 5}, {13, 6}, {19, 5}},
+    [PPE_RGBX5658] = {24, PPE_SIM_RGB, {0, 0}, {19, 5}, {13, 6}, {8, 5}},
+    [PPE_ABGR1555] = {16, PPE_SIM_RGB, {15, 1}, {0, 5}, {5, 5}, {10, 5}},
+    [PPE_ARGB1555] = {16, PPE_SIM_RGB, {15, 1}, {10, 5}, {5, 5}, {0, 5}},
+    [PPE_XBGR1555] = {16, PPE_SIM_RGB, {0, 0}, {0, 5}, {5, 5}, {10, 5}},
+    [PPE_XRGB1555] = {16, PPE_SIM_RGB, {0, 0}, {10, 5}, {5, 5}, {0, 5}},
+    [PPE_BGRA5551] = {16, PPE_SIM_RGB, {0, 1}, {1, 5}, {6, 5}, {11, 5}},
+    [PPE_RGBA5551] = {16, PPE_SIM_RGB, {0, 1}, {11, 5}, {6, 5}, {1, 5}},
+    [PPE_BGRX5551] = {16, PPE_SIM_RGB, {0, 0}, {1, 5}, {6, 5}, {11, 5}},
+    [PPE_RGBX5551] = {16, PPE_SIM_RGB, {0, 0}, {11, 5}, {6, 5}, {1, 5}},
+    [PPE_BGR888] = {24, PPE_SIM_RGB, {0, 0}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_RGB888] = {24, PPE_SIM_RGB, {0, 0}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_BGR565] = {16, PPE_SIM_RGB, {0, 0}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_RGB565] = {16, PPE_SIM_RGB, {0, 0}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_A8] = {8, PPE_SIM_ALPHA, {0, 8}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_X8] = {8, PPE_SIM_OPAQUE, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_ABGR8666] = {32, PPE_SIM_RGB, {18, 8}, {0, 6}, {6, 6}, {12, 6}},
+    [PPE_ARGB8666] = {32, PPE_SIM_RGB, {18, 8}, {12, 6}, {6, 6}, {0, 6}},
+    [PPE_XBGR8666] = {32, PPE_SIM_RGB, {0, 0}, {0, 6}, {6, 6}, {12, 6}},
+    [PPE_XRGB8666] = {32, PPE_SIM_RGB, {0, 0}, {12, 6}, {6, 6}, {0, 6}},
+    [PPE_BGRA6668] = {32, PPE_SIM_RGB, {0, 8}, {8, 6}, {14, 6}, {20, 6}},
+    [PPE_RGBA6668] = {32, PPE_SIM_RGB, {0, 8}, {20, 6}, {14, 6}, {8, 6}},
+    [PPE_BGRX6668] = {32, PPE_SIM_RGB, {0, 0}, {8, 6}, {14, 6}, {20, 6}},
+    [PPE_RGBX6668] = {32, PPE_SIM_RGB, {0, 0}, {20, 6}, {14, 6}, {8, 6}},
+};
+
+static PPE_Input_Layer_Typedef *const ppe_sim_input_reg[PPE_MAX_INPUTLAYER] =
+{
+    PPE_InputLayer1, PPE_InputLayer2, PPE_InputLayer3, PPE_InputLayer4,
+};
+
+/*============================================================================*
+ *                          Private Functions
+ *============================================================================*/
+/* x / 255 rounded to nearest for x <= 255 * 255 * 2 */
+static inline uint32_t ppe_sim_div255(uint32_t x)
+{
+    return (x + 128 + ((x + 128) >> 8)) >> 8;
+}
+
+/* widen a channel to 8 bits by repeating its bits, 0x1F -> 0xFF */
+static uint8_t ppe_sim_expand(uint32_t value, uint8_t bits)
+{
+    uint32_t c = value << (8 - bits);
+    for (uint8_t filled = bits; filled < 8; filled *= 2)
+    {
+        c |= c >> filled;
+    }
+    return c & 0xFF;
+}
+
+static uint32_t ppe_sim_field(uint32_t word, ppe_sim_channel_t channel)
+{
+    return (word >> channel.shift) & ((1UL << channel.bits) - 1);
+}
+
+static bool ppe_sim_format_valid(PPE_PIXEL_FORMAT format)
+{
+    return ((uint32_t)format < sizeof(ppe_sim_format) / sizeof(ppe_sim_format[0])) &&
+           (ppe_sim_format[format].bpp != 0);
+}
+
+static uint32_t ppe_sim_read(uint32_t addr, uint32_t line_len, uint8_t bpp, uint32_t x, uint32_t y)
+{
+    uint8_t *p = PPE_SIM_ADDR(addr) + y * line_len + x * (bpp / 8);
+    uint32_t word = 0;
+
+    for (uint8_t i = 0; i < bpp / 8; i++)
+    {
+        word |= (uint32_t)p[i] << (8 * i);
+    }
+    return word;
+}
+
+static void ppe_sim_write(uint32_t addr, uint32_t line_len, uint8_t bpp, uint32_t x, uint32_t y,
+                          uint32_t word)
+{
+    uint8_t *p = PPE_SIM_ADDR(addr) + y * line_len + x * (bpp / 8);
+
+    for (uint8_t i = 0; i < bpp / 8; i++)
+    {
+        p[i] = (word >> (8 * i)) & 0xFF;
+    }
+}
+
+/* keyed pixels read as transparent, Color_Key_Min/Max hold 0xRRGGBB */
+static uint32_t ppe_sim_fetch(PPE_InputLayer_Init_Typedef *layer, uint32_t x, uint32_t y)
+{
+    uint32_t color = PPE_Simulation_Get_Pixel(layer->Layer_Address, layer->Line_Length,
+                                              layer->Pixel_Color_Format, x, y, layer->Const_Pixel);
+    if (layer->Color_Key_Mode < PPE_COLOR_KEY_INSIDE)
+    {
+        return color;
+    }
+    bool inside = (PPE_SIM_R(color) >= PPE_SIM_R(layer->Color_Key_Min)) &&
+                  (PPE_SIM_R(color) <= PPE_SIM_R(layer->Color_Key_Max)) &&
+                  (PPE_SIM_G(color) >= PPE_SIM_G(layer->Color_Key_Min)) &&
+                  (PPE_SIM_G(color) <= PPE_SIM_G(layer->Color_Key_Max)) &&
+                  (PPE_SIM_B(color) >= PPE_SIM_B(layer->Color_Key_Min)) &&
+                  (PPE_SIM_B(color) <= PPE_SIM_B(layer->Color_Key_Max));
+    if (inside == (layer->Color_Key_Mode == PPE_COLOR_KEY_INSIDE))
+    {
+        color &= 0xFFFFFF;
+    }
+    return color;
+}
+
+static uint32_t ppe_sim_bilinear(uint32_t c00, uint32_t c10, uint32_t c01, uint32_t c11,
+                                 uint32_t fx, uint32_t fy)
+{
+    uint32_t w00 = (256 - fx) * (256 - fy);
+    uint32_t w10 = fx * (256 - fy);
+    uint32_t w01 = (256 - fx) * fy;
+    uint32_t w11 = fx * fy;
+    uint32_t color = 0;
+
+    for (uint8_t shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t c = (((c00 >> shift) & 0xFF) * w00 + ((c10 >> shift) & 0xFF) * w10 +
+                      ((c01 >> shift) & 0xFF) * w01 + ((c11 >> shift) & 0xFF) * w11 + 0x8000) >> 16;
+        color |= c << shift;
+    }
+    return color;
+}
+
+/* source pixel of layer seen at canvas pixel (x, y), false if it falls outside the layer */
+static bool ppe_sim_sample(PPE_InputLayer_Init_Typedef *layer, int32_t x, int32_t y, uint32_t *color)
+{
+    int64_t sx = (int64_t)(int32_t)layer->Transfer_Matrix_E11 * x +
+                 (int64_t)(int32_t)layer->Transfer_Matrix_E12 * y + (int32_t)layer->Transfer_Matrix_E13;
+    int64_t sy = (int64_t)(int32_t)layer->Transfer_Matrix_E21 * x +
+                 (int64_t)(int32_t)layer->Transfer_Matrix_E22 * y + (int32_t)layer->Transfer_Matrix_E23;
+    int64_t sw = (int64_t)(int32_t)layer->Transfer_Matrix_E31 * x +
+                 (int64_t)(int32_t)layer->Transfer_Matrix_E32 * y + (int32_t)layer->Transfer_Matrix_E33;
+
+    if (sw <= 0)
+    {
+        return false;
+    }
+    /* Q16.16 position in the source picture */
+    int64_t u = (sx * 65536) / sw;
+    int64_t v = (sy * 65536) / sw;
+    int32_t iu = (int32_t)(u >> 16);
+    int32_t iv = (int32_t)(v >> 16);
+
+    int32_t x_max = MIN((int32_t)layer->Layer_Window_Xmax, (int32_t)layer->Pic_Width - 1);
+    int32_t y_max = MIN((int32_t)layer->Layer_Window_Ymax, (int32_t)layer->Pic_Height - 1);
+    if ((iu < layer->Layer_Window_Xmin) || (iu > x_max) || (iv < layer->Layer_Window_Ymin) ||
+        (iv > y_max))
+    {
+        return false;
+    }
+
+    if (layer->Pixel_Source == PPE_LAYER_SRC_CONST)
+    {
+        *color = layer->Const_Pixel;
+        return true;
+    }
+    if (layer->Read_Matrix_Size == PPV2_READ_MATRIX_2X2)
+    {
+        int32_t iu1 = MIN(iu + 1, x_max);
+        int32_t iv1 = MIN(iv + 1, y_max);
+        *color = ppe_sim_bilinear(ppe_sim_fetch(layer, iu, iv), ppe_sim_fetch(layer, iu1, iv),
+                                  ppe_sim_fetch(layer, iu, iv1), ppe_sim_fetch(layer, iu1, iv1),
+                                  (u >> 8) & 0xFF, (v >> 8) & 0xFF);
+    }
+    else
+    {
+        *color = ppe_sim_fetch(layer, iu, iv);
+    }
+
+    /* Const_Pixel alpha works as the layer opacity */
+    uint32_t a = ppe_sim_div255(PPE_SIM_A(*color) * PPE_SIM_A(layer->Const_Pixel));
+    *color = (*color & 0xFFFFFF) | (a << 24);
+    return true;
+}
+
+static uint8_t ppe_sim_mix(uint32_t s, uint32_t d, uint32_t sa)
+{
+    return ppe_sim_div255(s * sa + d * (255 - sa));
+}
+
+static uint32_t ppe_sim_src_over(uint32_t dst, uint32_t src)
+{
+    uint32_t sa = PPE_SIM_A(src);
+
+    return PPE_SIM_ARGB(sa + ppe_sim_div255(PPE_SIM_A(dst) * (255 - sa)),
+                        ppe_sim_mix(PPE_SIM_R(src), PPE_SIM_R(dst), sa),
+                        ppe_sim_mix(PPE_SIM_G(src), PPE_SIM_G(dst), sa),
+                        ppe_sim_mix(PPE_SIM_B(src), PPE_SIM_B(dst), sa));
+}
+
+/*============================================================================*
+ *                           Public Functions
+ *============================================================================*/
+uint32_t PPE_Simulation_Get_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                  uint32_t x, uint32_t y, uint32_t const_pixel)
+{
+    const ppe_sim_format_t *f = &ppe_sim_format[format];
+    uint32_t word = ppe_sim_read(addr, line_len, f->bpp, x, y);
+
+    switch (f->kind)
+    {
+    case PPE_SIM_ALPHA:
+        return (const_pixel & 0xFFFFFF) | (word << 24);
+    case PPE_SIM_OPAQUE:
+        return const_pixel | 0xFF000000;
+    default:
+        break;
+    }
+
+    uint8_t a = (f->a.bits != 0) ? ppe_sim_expand(ppe_sim_field(word, f->a), f->a.bits) : 0xFF;
+    return PPE_SIM_ARGB(a, ppe_sim_expand(ppe_sim_field(word, f->r), f->r.bits),
+                        ppe_sim_expand(ppe_sim_field(word, f->g), f->g.bits),
+                        ppe_sim_expand(ppe_sim_field(word, f->b), f->b.bits));
+}
+
+PPE_err PPE_Simulation_Set_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                 uint32_t x, uint32_t y, uint32_t color)
+{
+    if (!ppe_sim_format_valid(format))
+    {
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+    const ppe_sim_format_t *f = &ppe_sim_format[format];
+    uint32_t word = 0;
+
+    switch (f->kind)
+    {
+    case PPE_SIM_ALPHA:
+        word = PPE_SIM_A(color);
+        break;
+    case PPE_SIM_OPAQUE:
+        break;
+    default:
+        /* narrowing drops the low bits */
+        word = ((PPE_SIM_A(color) >> (8 - f->a.bits)) << f->a.shift) |
+               ((PPE_SIM_R(color) >> (8 - f->r.bits)) << f->r.shift) |
+               ((PPE_SIM_G(color) >> (8 - f->g.bits)) << f->g.shift) |
+               ((PPE_SIM_B(color) >> (8 - f->b.bits)) << f->b.shift);
+        break;
+    }
+    ppe_sim_write(addr, line_len, f->bpp, x, y, word);
+    return PPE_SUCCESS;
+}
+
+PPE_err PPE_Simulation(PPE_ResultLayer_Init_Typedef *result, PPE_InputLayer_Init_Typedef *input,
+                       uint32_t layer_en)
+{
+    if (!ppe_sim_format_valid(result->Color_Format))
+    {
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+    for (int32_t y = 0; y < (int32_t)result->Canvas_Height; y++)
+    {
+        for (int32_t x = 0; x < (int32_t)result->Canvas_Width; x++)
+        {
+            uint32_t color = result->BackGround;
+            uint32_t src;
+
+            for (uint8_t i = 0; i < PPE_MAX_INPUTLAYER; i++)
+            {
+                if ((layer_en & BIT(i)) && ppe_sim_sample(&input[i], x, y, &src))
+                {
+                    color = ppe_sim_src_over(color, src);
+                }
+            }
+            PPE_Simulation_Set_Pixel(result->Layer_Address, result->Line_Length, result->Color_Format,
+                                     x, y, color);
+        }
+    }
+    return PPE_SUCCESS;
+}
+
+void PPE_Simulation_Run(void)
+{
+    PPE_REG_LYR_ENABLE_TypeDef lyr_enable = {.d32 = PPE->REG_LYR_ENABLE};
+    PPE_ResultLayer_Init_Typedef result;
+    PPE_InputLayer_Init_Typedef input[PPE_MAX_INPUTLAYER];
+
+    PPE_ResultLayer_StructInit(&result);
+    for (uint8_t i = 0; i < PPE_MAX_INPUTLAYER; i++)
+    {
+        PPE_InputLayer_StructInit((PPE_INPUT_LAYER_INDEX)(PPE_INPUT_1 + i), &input[i]);
+    }
+    PPE_Simulation(&result, input, lyr_enable.b.input_lyr_en);
+
+    /* job end: the FSM stops and raises the frame and all over interrupts, clears written to
+       INTR_CLR since the last job are applied first as the register file cannot see them */
+    PPE_REG_GLB_STATUS_TypeDef glb_status = {.d32 = PPE->REG_GLB_STATUS};
+    glb_status.b.run_state = 0;
+    PPE->REG_GLB_STATUS = glb_status.d32;
+    volatile uint32_t *intr_raw = (volatile uint32_t *)&PPE->REG_INTR_RAW;
+    *intr_raw = (*intr_raw & ~PPE->REG_INTR_CLR) | BIT0 | BIT1;
+    PPE->REG_INTR_CLR = 0;
+}
+
+/******************* (C) COPYRIGHT 2024 Realtek Semiconductor Corporation *****END OF FILE****/
@@ -0,0 +1,110 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     ppe_simulation.h
+* \brief    Software model of the RTL8773E PPE 2.0 datapath.
+* \details  PPE_Simulation takes the same init structs that are programmed into the PPE registers
+*           and renders the canvas on the CPU, so compositions can be checked and profiled on a
+*           host without silicon.
+*           Built with PPE_SIM_BACKEND set, PPE_Cmd(ENABLE) calls PPE_Simulation_Run instead of
+*           starting the engine, so every PPE_* call runs on the model. The model is checked
+*           against the driver's CPU fills and copies, not against silicon.
+*********************************************************************************************************
+*/
+
+/*============================================================================*
+ *               Define to prevent recursive inclusion
+ *============================================================================*/
+#ifndef PPE_SIMULATION_H
+#define PPE_SIMULATION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================*
+ *                        Header Files
+ *============================================================================*/
+#include "rtl_ppe.h"
+
+/*============================================================================*
+ *                         Constants
+ *============================================================================*/
+/* Layer_Address values are 32 bit, a host build that keeps buffers above 4GB
+   can map them to real pointers by redefining this */
+#ifndef PPE_SIM_ADDR
+#define PPE_SIM_ADDR(addr)      ((uint8_t *)(uintptr_t)(addr))
+#endif
+
+/* bit in layer_en that enables input[i] */
+#define PPE_SIM_LAYER1_EN       BIT0
+#define PPE_SIM_LAYER2_EN       BIT1
+#define PPE_SIM_LAYER3_EN       BIT2
+#define PPE_SIM_LAYER4_EN       BIT3
+
+/*============================================================================*
+ *                         Functions
+ *============================================================================*/
+/**
+ * \brief  Render the canvas the way PPE does for the given layer setup
+ * \note   The canvas starts as BackGround. Pixel (x, y) of the canvas is mapped through the
+ *         Transfer_Matrix_Exx of each enabled input layer, the Q16.16 source position is
+ *         truncated, or sampled 2x2 when Read_Matrix_Size is PPV2_READ_MATRIX_2X2. Keyed pixels
+ *         are transparent, Const_Pixel alpha scales the pixel, and the layers are blended source
+ *         over in order (input[0] first). The result is then packed into Color_Format.
+ *         Line_Length is in bytes, as the driver programs it.
+ * \param[in] result        result layer setup, Layer_Address is written.
+ * \param[in] input         array of four input layer setups.
+ * \param[in] layer_en      PPE_SIM_LAYER1_EN to PPE_SIM_LAYER4_EN.
+ * \return operation result
+ * \retval PPE_SUCCESS                 Operation success.
+ * \retval PPE_ERR_INVALID_PARAMETER   Color_Format is not a PPE format.
+ */
+PPE_err PPE_Simulation(PPE_ResultLayer_Init_Typedef *result, PPE_InputLayer_Init_Typedef *input,
+                       uint32_t layer_en);
+
+/**
+ * \brief  Read one pixel of a buffer as ARGB8888
+ * \param[in] addr          buffer address.
+ * \param[in] line_len      line length in bytes.
+ * \param[in] format        pixel format, A8/X8 take RGB from const_pixel.
+ * \param[in] x             column.
+ * \param[in] y             row.
+ * \param[in] const_pixel   ARGB8888 constant color of the layer.
+ * \return pixel in ARGB8888
+ */
+uint32_t PPE_Simulation_Get_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                  uint32_t x, uint32_t y, uint32_t const_pixel);
+
+/**
+ * \brief  Write one ARGB8888 pixel to a buffer
+ * \param[in] addr          buffer address.
+ * \param[in] line_len      line length in bytes.
+ * \param[in] format        pixel format.
+ * \param[in] x             column.
+ * \param[in] y             row.
+ * \param[in] color         pixel in ARGB8888.
+ * \return operation result
+ * \retval PPE_SUCCESS                 Operation success.
+ * \retval PPE_ERR_INVALID_PARAMETER   format is not a PPE format.
+ */
+PPE_err PPE_Simulation_Set_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                 uint32_t x, uint32_t y, uint32_t color);
+
+/**
+ * \brief  Run the job programmed in the PPE registers on the model
+ * \note   Reads the result layer and the enabled input layers back with the StructInit calls,
+ *         renders them with PPE_Simulation and leaves REG_GLB_STATUS and REG_INTR_RAW as the
+ *         engine does when the frame is over. Linked list jobs are not modelled, the driver
+ *         programs every job with LLP 0.
+ */
+void PPE_Simulation_Run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PPE_SIMULATION_H */
+
+/******************* (C) COPYRIGHT 2024 Realtek Semiconductor Corporation *****END OF FILE****/
@@ -15,9 +15,17 @@
  *                        Header Files
  *============================================================================*/
 #include "rtl_ppe.h"
+#if PPE_PERF_EN
+#include "stdio.h"
+#endif
 #include "string.h"
 #include "os_sync.h"
 #include "math.h"
+#include "rtl_ppe_quad.h"
+#include "rtl_ppe_orient.h"
+#if PPE_SIM_BACKEND
+#include "ppe_simulation.h"
+#endif
 
 /*============================================================================*
  *                          Private Macros
@@ -25,19 +33,205 @@
 #define USE_PPE_MAT     1
 #define ABS(x)               (((x) < 0)    ? -(x) :  (x))
 #define EPS                  1.1920929e-7f
+#ifndef PPE_MATRIX_CACHE_NUM
+#define PPE_MATRIX_CACHE_NUM 4
+#endif
+#ifndef PPE_REG_SHADOW_EN
+#define PPE_REG_SHADOW_EN       1
+#endif
+#ifndef PPE_BLIT_BAND_LINES
+#define PPE_BLIT_BAND_LINES     16      /* result lines per PPE_Blit band before bands are merged */
+#endif
+#ifndef PPE_BLIT_BAND_MERGE_PIXELS
+#define PPE_BLIT_BAND_MERGE_PIXELS 256  /* merge two bands when their union adds fewer pixels than this */
+#endif
+#ifndef PPE_MASK_SW_PIXELS
+#define PPE_MASK_SW_PIXELS      256     /* opaque PPE_Mask_List fills up to this area are CPU stores */
+#endif
+#ifndef PPE_MASK_LIST_BATCH
+#define PPE_MASK_LIST_BATCH     16      /* fills PPE_Mask_List merges at a time, on the stack */
+#endif
+
+/*job timing counters, timestamps come from the DWT cycle counter unless the platform provides
+  another free running 32 bit counter as PPE_PERF_TIMESTAMP()*/
+#include "rtl_ppe_perf.h"
+#if PPE_PERF_EN
+#define PPE_PERF_BEGIN(op)      PPE_Perf_Begin(op)
+#define PPE_PERF_START()        PPE_Perf_Start()
+#define PPE_PERF_DONE()         PPE_Perf_Done()
+#else
+#define PPE_PERF_BEGIN(op)
+#define PPE_PERF_START()
+#define PPE_PERF_DONE()
+#endif
 
 /*============================================================================*
  *                          Private Variables
  *============================================================================*/
 typedef struct
 {
-    float p[3];
-} ppe_pox_t;
+    ppe_matrix_t key;
+    ppe_matrix_fixed_t value;
+    bool inverse;
+    bool valid;
+} ppe_matrix_cache_t;
+
+static ppe_matrix_cache_t ppe_matrix_cache[PPE_MATRIX_CACHE_NUM];
+static uint8_t ppe_matrix_cache_next = 0;
+
+/*layer registers are mirrored in blocks of 0x80 bytes starting at PPE_REG_BASE, a word is only
+  trusted after it was read or written through the shadow*/
+#if PPE_REG_SHADOW_EN
+#define PPE_SHADOW_LAYER_SHIFT  7
+#define PPE_SHADOW_LAYER_WORDS  32
+#define PPE_SHADOW_LAYER_NUM    5
+
+static uint32_t ppe_shadow[PPE_SHADOW_LAYER_NUM][PPE_SHADOW_LAYER_WORDS];
+static uint32_t ppe_shadow_valid[PPE_SHADOW_LAYER_NUM];
+#endif
+static ppe_reg_stat_t ppe_reg_stat;
+
+#if PPE_PERF_EN
+static ppe_perf_stat_t ppe_perf;
+static PPE_PERF_OP ppe_perf_op = PPE_PERF_OP_OTHER;
+static uint32_t ppe_perf_mark = 0;      /* API entry or end of the previous job */
+static bool ppe_perf_running = false;
+static PPE_PERF_OP ppe_perf_job_op;
+static uint32_t ppe_perf_job_start;
+static uint32_t ppe_perf_job_setup;
+static uint32_t ppe_perf_job_pixels;
+static uint32_t ppe_perf_job_read;
+static uint32_t ppe_perf_job_write;
+#endif
 
 /*============================================================================*
  *                          Private Functions
  *============================================================================*/
 static bool inv_matrix2complement(ppe_matrix_t *matrix, uint32_t *comp);
+static void pos_transfer(ppe_matrix_t *matrix, ppe_pox_t *pox);
+
+static uint32_t PPE_Shadow_Read(volatile uint32_t *reg)
+{
+#if PPE_REG_SHADOW_EN
+    uint32_t offset = (uint32_t)reg - PPE_REG_BASE;
+    uint32_t layer = offset >> PPE_SHADOW_LAYER_SHIFT;
+    uint32_t word = (offset & ((1UL << PPE_SHADOW_LAYER_SHIFT) - 1)) >> 2;
+
+    if (!(ppe_shadow_valid[layer] & (1UL << word)))
+    {
+        ppe_shadow[layer][word] = *reg;
+        ppe_shadow_valid[layer] |= (1UL << word);
+    }
+    return ppe_shadow[layer][word];
+#else
+    return *reg;
+#endif
+}
+
+static void PPE_Shadow_Write(volatile uint32_t *reg, uint32_t value)
+{
+#if PPE_REG_SHADOW_EN
+    uint32_t offset = (uint32_t)reg - PPE_REG_BASE;
+    uint32_t layer = offset >> PPE_SHADOW_LAYER_SHIFT;
+    uint32_t word = (offset & ((1UL << PPE_SHADOW_LAYER_SHIFT) - 1)) >> 2;
+
+    if ((ppe_shadow_valid[layer] & (1UL << word)) && (ppe_shadow[layer][word] == value))
+    {
+        ppe_reg_stat.skip_cnt++;
+        return;
+    }
+    ppe_shadow[layer][word] = value;
+    ppe_shadow_valid[layer] |= (1UL << word);
+#endif
+    *reg = value;
+    ppe_reg_stat.write_cnt++;
+}
+
+#if PPE_PERF_EN
+static void PPE_Perf_Begin(PPE_PERF_OP op)
+{
+    ppe_perf.op[op].call_cnt++;
+    ppe_perf_op = op;
+    ppe_perf_mark = PPE_PERF_TIMESTAMP();
+}
+
+/*pixels and bytes of the job about to start, taken from the layers it was programmed with. A
+  transformed input is assumed to be read once per result pixel at most*/
+static void PPE_Perf_Traffic(void)
+{
+    PPE_REG_LYR_ENABLE_TypeDef ppe_reg_lyr_enable_0x04 = {.d32 = PPE->REG_LYR_ENABLE};
+    PPE_REG_CANVAS_SIZE_TypeDef ppe_reg_canvas_size_0x68 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_CANVAS_SIZE)};
+    PPE_REG_LYR0_PIC_CFG_TypeDef ppe_reg_lyr0_pic_cfg_0x6C = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_PIC_CFG)};
+
+    ppe_perf_job_pixels = ppe_reg_canvas_size_0x68.b.canvas_width * ppe_reg_canvas_size_0x68.b.canvas_height;
+    ppe_perf_job_write = ppe_perf_job_pixels * PPE_Get_Pixel_Size((PPE_PIXEL_FORMAT)ppe_reg_lyr0_pic_cfg_0x6C.b.format);
+    ppe_perf_job_read = 0;
+    for (uint8_t i = 0; i < PPE_MAX_INPUTLAYER; i++)
+    {
+        PPE_Input_Layer_Typedef *input_layer = (PPE_Input_Layer_Typedef *)(PPE_Input_Layer1_BASE + i * 0x80);
+        PPE_REG_LYRx_PIC_CFG_TypeDef ppe_reg_lyrx_pic_cfg_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_PIC_CFG)};
+        if (!(ppe_reg_lyr_enable_0x04.b.input_lyr_en & BIT(i)) ||
+            (ppe_reg_lyrx_pic_cfg_t.b.pic_src != PPE_LAYER_SRC_FROM_DMA))
+        {
+            continue;
+        }
+        PPE_REG_LYRx_WIN_MIN_TypeDef ppe_reg_lyrx_win_min_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_WIN_MIN)};
+        PPE_REG_LYRx_WIN_MAX_TypeDef ppe_reg_lyrx_win_max_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_WIN_MAX)};
+        uint32_t pixels = (ppe_reg_lyrx_win_max_t.b.win_x_max - ppe_reg_lyrx_win_min_t.b.win_x_min + 1) *
+                          (ppe_reg_lyrx_win_max_t.b.win_y_max - ppe_reg_lyrx_win_min_t.b.win_y_min + 1);
+        if (pixels > ppe_perf_job_pixels)
+        {
+            pixels = ppe_perf_job_pixels;
+        }
+        ppe_perf_job_read += pixels * PPE_Get_Pixel_Size((PPE_PIXEL_FORMAT)ppe_reg_lyrx_pic_cfg_t.b.format);
+    }
+}
+
+static void PPE_Perf_Done(void)
+{
+    uint32_t now = PPE_PERF_TIMESTAMP();
+    ppe_perf_op_t *op = &ppe_perf.op[ppe_perf_job_op];
+    uint32_t latency;
+
+    if (!ppe_perf_running)
+    {
+        return;
+    }
+    ppe_perf_running = false;
+    ppe_perf_mark = now;
+    latency = ppe_perf_job_setup + (now - ppe_perf_job_start);
+
+    op->job_cnt++;
+    op->setup_time += ppe_perf_job_setup;
+    op->exec_time += now - ppe_perf_job_start;
+    if ((op->job_cnt == 1) || (latency < op->latency_min))
+    {
+        op->latency_min = latency;
+    }
+    if (latency > op->latency_max)
+    {
+        op->latency_max = latency;
+    }
+    op->pixels += ppe_perf_job_pixels;
+    op->read_bytes += ppe_perf_job_read;
+    op->write_bytes += ppe_perf_job_write;
+    op->hist[ppe_perf_bin(latency)]++;
+}
+
+static void PPE_Perf_Start(void)
+{
+    if (ppe_perf_running)
+    {
+        /*nobody waited for the previous job, PPE only takes a new one after it ended*/
+        PPE_Perf_Done();
+    }
+    PPE_Perf_Traffic();
+    ppe_perf_job_op = ppe_perf_op;
+    ppe_perf_running = true;
+    ppe_perf_job_start = PPE_PERF_TIMESTAMP();
+    ppe_perf_job_setup = ppe_perf_job_start - ppe_perf_mark;
+}
+#endif
 
 /*============================================================================*
  *                           Public Functions
@@ -53,6 +247,58 @@ int  ppe_get_transform_matrix(ppe_point4_t src, ppe_point4_t dst, ppe_matrix_t *
 void ppe_matrix_inverse(ppe_matrix_t *matrix);
 void ppe_mat_multiply(ppe_matrix_t *matrix, ppe_matrix_t *mult);
 #endif
+
+void PPE_RegShadow_Invalidate(void)
+{
+#if PPE_REG_SHADOW_EN
+    memset(ppe_shadow_valid, 0, sizeof(ppe_shadow_valid));
+#endif
+}
+
+void PPE_RegShadow_GetStat(ppe_reg_stat_t *stat)
+{
+    *stat = ppe_reg_stat;
+}
+
+void PPE_RegShadow_ClearStat(void)
+{
+    ppe_reg_stat.write_cnt = 0;
+    ppe_reg_stat.skip_cnt = 0;
+}
+
+#if PPE_PERF_EN
+void PPE_Perf_GetStat(ppe_perf_stat_t *stat)
+{
+    *stat = ppe_perf;
+}
+
+void PPE_Perf_ClearStat(void)
+{
+    PPE_PERF_TIMESTAMP_INIT();
+    memset(&ppe_perf, 0, sizeof(ppe_perf));
+    ppe_perf_running = false;
+}
+
+uint32_t PPE_Perf_Percentile(ppe_perf_op_t *op, uint8_t percent)
+{
+    return ppe_perf_percentile(op, percent);
+}
+
+uint32_t PPE_Perf_Dump(char *buf, uint32_t size)
+{
+    static const char *const op_name[PPE_PERF_OP_NUM] =
+    {
+    "other",
+    "blit",
+    "mask",
+    "blend_multi",
+    "handshake",
+    };
+
+    return ppe_perf_dump(&ppe_perf, op_name, buf, size);
+}
+#endif
+
 void PPE_CLK_ENABLE(FunctionalState NewState)
 {
 
@@ -67,6 +313,9 @@ void PPE_CLK_ENABLE(FunctionalState NewState)
         reg_value = *(uint32_t *)(0x40000210UL);
         reg_value &= ~(BIT24);
         *(uint32_t *)(0x40000210UL) = reg_value;
+
+        /*layer registers are lost with the function*/
+        PPE_RegShadow_Invalidate();
     }
     else
     {
@@ -93,7 +342,14 @@ void PPE_Cmd(FunctionalState NewState)
     }
     else
     {
+        PPE_PERF_START();
+#if PPE_SIM_BACKEND
+        /* the model has finished the job when it returns, run_state is left at 0 */
+        PPE_Simulation_Run();
+        return;
+#else
         ppe_reg_glb_status_0x00.b.run_state = 0x1;
+#endif
     }
 
     PPE->REG_GLB_STATUS = ppe_reg_glb_status_0x00.d32;
@@ -118,30 +374,30 @@ void PPE_Init(PPE_Init_Typedef *PPE_Init_Struct)
 
 void PPE_ResultLayer_Init(PPE_ResultLayer_Init_Typedef *PPE_ResultLyaer_Init_Struct)
 {
-    PPE_REG_LYR0_ADDR_TypeDef ppe_reg_lyr0_addr_0x60 = {.d32 = PPE_ResultLayer->REG_LYR0_ADDR};
+    PPE_REG_LYR0_ADDR_TypeDef ppe_reg_lyr0_addr_0x60 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_ADDR)};
     ppe_reg_lyr0_addr_0x60.b.addr                = PPE_ResultLyaer_Init_Struct->Layer_Address;
-    PPE_ResultLayer->REG_LYR0_ADDR               = ppe_reg_lyr0_addr_0x60.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_ADDR, ppe_reg_lyr0_addr_0x60.d32);
 
-    PPE_REG_CANVAS_SIZE_TypeDef ppe_reg_canvas_size_0x68 = {.d32 = PPE_ResultLayer->REG_CANVAS_SIZE};
+    PPE_REG_CANVAS_SIZE_TypeDef ppe_reg_canvas_size_0x68 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_CANVAS_SIZE)};
     ppe_reg_canvas_size_0x68.b.canvas_width          = PPE_ResultLyaer_Init_Struct->Canvas_Width;
     ppe_reg_canvas_size_0x68.b.canvas_height         = PPE_ResultLyaer_Init_Struct->Canvas_Height;
-    PPE_ResultLayer->REG_CANVAS_SIZE                 = ppe_reg_canvas_size_0x68.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_CANVAS_SIZE, ppe_reg_canvas_size_0x68.d32);
 
-    PPE_REG_LYR0_PIC_CFG_TypeDef  ppe_reg_lyr0_pic_cfg_0x6C = {.d32 = PPE_ResultLayer->REG_LYR0_PIC_CFG};
+    PPE_REG_LYR0_PIC_CFG_TypeDef  ppe_reg_lyr0_pic_cfg_0x6C = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_PIC_CFG)};
     ppe_reg_lyr0_pic_cfg_0x6C.b.format                  = PPE_ResultLyaer_Init_Struct->Color_Format;
     ppe_reg_lyr0_pic_cfg_0x6C.b.line_length             = PPE_ResultLyaer_Init_Struct->Line_Length;
     ppe_reg_lyr0_pic_cfg_0x6C.b.background_blend        = ENABLE;
-    PPE_ResultLayer->REG_LYR0_PIC_CFG                   = ppe_reg_lyr0_pic_cfg_0x6C.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_PIC_CFG, ppe_reg_lyr0_pic_cfg_0x6C.d32);
 
-    PPE_REG_BACKGROUND_TypeDef ppe_reg_background_0x70 = {.d32 = PPE_ResultLayer->REG_BACKGROUND};
+    PPE_REG_BACKGROUND_TypeDef ppe_reg_background_0x70 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_BACKGROUND)};
     ppe_reg_background_0x70.b.background           = PPE_ResultLyaer_Init_Struct->BackGround;
-    PPE_ResultLayer->REG_BACKGROUND                = ppe_reg_background_0x70.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_BACKGROUND, ppe_reg_background_0x70.d32);
 
-    PPE_REG_LYR0_BUS_CFG_TypeDef ppe_reg_lyr0_bus_cfg_0x74 = {.d32 = PPE_ResultLayer->REG_LYR0_BUS_CFG};
+    PPE_REG_LYR0_BUS_CFG_TypeDef ppe_reg_lyr0_bus_cfg_0x74 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_BUS_CFG)};
     ppe_reg_lyr0_bus_cfg_0x74.b.incr                   = PPE_ResultLyaer_Init_Struct->LayerBus_Inc;
-    PPE_ResultLayer->REG_LYR0_BUS_CFG                  = ppe_reg_lyr0_bus_cfg_0x74.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_BUS_CFG, ppe_reg_lyr0_bus_cfg_0x74.d32);
 
-    PPE_REG_LYR0_HS_CFG_TypeDef ppe_reg_lyr0_hs_cfg_0x78 = {.d32 = PPE_ResultLayer->REG_LYR0_HS_CFG};
+    PPE_REG_LYR0_HS_CFG_TypeDef ppe_reg_lyr0_hs_cfg_0x78 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_HS_CFG)};
     ppe_reg_lyr0_hs_cfg_0x78.b.hs_en                 =
         PPE_ResultLyaer_Init_Struct->Layer_HW_Handshake_En;
     ppe_reg_lyr0_hs_cfg_0x78.b.hw_index              =
@@ -150,7 +406,7 @@ void PPE_ResultLayer_Init(PPE_ResultLayer_Init_Typedef *PPE_ResultLyaer_Init_Str
         PPE_ResultLyaer_Init_Struct->Layer_HW_Handshake_Polarity;
     ppe_reg_lyr0_hs_cfg_0x78.b.msize_log             =
         PPE_ResultLyaer_Init_Struct->Layer_HW_Handshake_MsizeLog;
-    PPE_ResultLayer->REG_LYR0_HS_CFG                 = ppe_reg_lyr0_hs_cfg_0x78.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_HS_CFG, ppe_reg_lyr0_hs_cfg_0x78.d32);
 
     PPE_REG_LD_CFG_TypeDef ppe_reg_ld_cfg_0x08  = {.d32 = PPE->REG_LD_CFG};
     ppe_reg_ld_cfg_0x08.b.reload_en        &= ~BIT0;
@@ -161,6 +417,12 @@ void PPE_ResultLayer_Init(PPE_ResultLayer_Init_Typedef *PPE_ResultLyaer_Init_Str
     ppe_reg_ll_cfg_0x0c.b.ll_en           &= ~BIT0;
     ppe_reg_ll_cfg_0x0c.b.ll_en           |= PPE_ResultLyaer_Init_Struct->MultiFrame_LLP_En;
     PPE->REG_LL_CFG                        = ppe_reg_ll_cfg_0x0c.d32;
+
+    if (PPE_ResultLyaer_Init_Struct->MultiFrame_Reload_En || PPE_ResultLyaer_Init_Struct->MultiFrame_LLP_En)
+    {
+        /*PPE reloads the layer behind the shadow*/
+        PPE_RegShadow_Invalidate();
+    }
 }
 
 void PPE_InputLayer_Init(PPE_INPUT_LAYER_INDEX intput_layer_index, \
@@ -191,16 +453,16 @@ void PPE_InputLayer_Init(PPE_INPUT_LAYER_INDEX intput_layer_index, \
         }
     }
 
-    PPE_REG_LYRx_ADDR_TypeDef ppe_reg_lyrx_addr_t = {.d32 = input_layer->REG_LYRx_ADDR};
+    PPE_REG_LYRx_ADDR_TypeDef ppe_reg_lyrx_addr_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_ADDR)};
     ppe_reg_lyrx_addr_t.b.addr                = PPE_InputLayer_Init_Struct->Layer_Address;
-    input_layer->REG_LYRx_ADDR                  = ppe_reg_lyrx_addr_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_ADDR, ppe_reg_lyrx_addr_t.d32);
 
-    PPE_REG_LYRx_PIC_SIZE_TypeDef ppe_reg_lyrx_pic_size_t = {.d32 = input_layer->REG_LYRx_PIC_SIZE};
+    PPE_REG_LYRx_PIC_SIZE_TypeDef ppe_reg_lyrx_pic_size_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_PIC_SIZE)};
     ppe_reg_lyrx_pic_size_t.b.pic_width               = PPE_InputLayer_Init_Struct->Pic_Width;
     ppe_reg_lyrx_pic_size_t.b.pic_height              = PPE_InputLayer_Init_Struct->Pic_Height;
-    input_layer->REG_LYRx_PIC_SIZE                      = ppe_reg_lyrx_pic_size_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_PIC_SIZE, ppe_reg_lyrx_pic_size_t.d32);
 
-    PPE_REG_LYRx_PIC_CFG_TypeDef ppe_reg_lyrx_pic_cfg_t     = {.d32 = input_layer->REG_LYRx_PIC_CFG};
+    PPE_REG_LYRx_PIC_CFG_TypeDef ppe_reg_lyrx_pic_cfg_t     = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_PIC_CFG)};
     ppe_reg_lyrx_pic_cfg_t.b.line_length                = PPE_InputLayer_Init_Struct->Line_Length;
     ppe_reg_lyrx_pic_cfg_t.b.color_key_mode             =
         PPE_InputLayer_Init_Struct->Color_Key_Mode;
@@ -209,18 +471,18 @@ void PPE_InputLayer_Init(PPE_INPUT_LAYER_INDEX intput_layer_index, \
         PPE_InputLayer_Init_Struct->Pixel_Color_Format;
     ppe_reg_lyrx_pic_cfg_t.b.input_lyr_read_matrix_size =
         PPE_InputLayer_Init_Struct->Read_Matrix_Size;
-    input_layer->REG_LYRx_PIC_CFG                         = ppe_reg_lyrx_pic_cfg_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_PIC_CFG, ppe_reg_lyrx_pic_cfg_t.d32);
 
-    PPE_REG_LYRx_FIXED_COLOR_TypeDef ppe_reg_lyrx_fixed_color_t = {.d32 = input_layer->REG_LYRx_FIXED_COLOR};
+    PPE_REG_LYRx_FIXED_COLOR_TypeDef ppe_reg_lyrx_fixed_color_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_FIXED_COLOR)};
     ppe_reg_lyrx_fixed_color_t.b.const_pixel                =
         PPE_InputLayer_Init_Struct->Const_Pixel;
-    input_layer->REG_LYRx_FIXED_COLOR                         = ppe_reg_lyrx_fixed_color_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_FIXED_COLOR, ppe_reg_lyrx_fixed_color_t.d32);
 
-    PPE_REG_LYRx_BUS_CFG_TypeDef ppe_reg_lyrx_bus_cfg_t = {.d32 = input_layer->REG_LYRx_BUS_CFG};
+    PPE_REG_LYRx_BUS_CFG_TypeDef ppe_reg_lyrx_bus_cfg_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_BUS_CFG)};
     ppe_reg_lyrx_bus_cfg_t.b.incr                   = PPE_InputLayer_Init_Struct->LayerBus_Inc;
-    input_layer->REG_LYRx_BUS_CFG                     = ppe_reg_lyrx_bus_cfg_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_BUS_CFG, ppe_reg_lyrx_bus_cfg_t.d32);
 
-    PPE_REG_LYRx_HS_CFG_TypeDef ppe_reg_lyrx_hs_cfg_t = {.d32 = input_layer->REG_LYRx_HS_CFG};
+    PPE_REG_LYRx_HS_CFG_TypeDef ppe_reg_lyrx_hs_cfg_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_HS_CFG)};
     ppe_reg_lyrx_hs_cfg_t.b.hs_en                 =
         PPE_InputLayer_Init_Struct->Layer_HW_Handshake_En;
     ppe_reg_lyrx_hs_cfg_t.b.hw_index              =
@@ -229,44 +491,35 @@ void PPE_InputLayer_Init(PPE_INPUT_LAYER_INDEX intput_layer_index, \
         PPE_InputLayer_Init_Struct->Layer_HW_Handshake_MsizeLog;
     ppe_reg_lyrx_hs_cfg_t.b.polar                 =
         PPE_InputLayer_Init_Struct->Layer_HW_Handshake_Polarity;
-    input_layer->REG_LYRx_HS_CFG                    = ppe_reg_lyrx_hs_cfg_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_HS_CFG, ppe_reg_lyrx_hs_cfg_t.d32);
 
-    PPE_REG_LYRx_WIN_MIN_TypeDef ppe_reg_lyrx_win_min_t = {.d32 = input_layer->REG_LYRx_WIN_MIN};
+    PPE_REG_LYRx_WIN_MIN_TypeDef ppe_reg_lyrx_win_min_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_WIN_MIN)};
     ppe_reg_lyrx_win_min_t.b.win_x_min              = PPE_InputLayer_Init_Struct->Layer_Window_Xmin;
     ppe_reg_lyrx_win_min_t.b.win_y_min              = PPE_InputLayer_Init_Struct->Layer_Window_Ymin;
-    input_layer->REG_LYRx_WIN_MIN                     = ppe_reg_lyrx_win_min_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_WIN_MIN, ppe_reg_lyrx_win_min_t.d32);
 
-    PPE_REG_LYRx_WIN_MAX_TypeDef ppe_reg_lyrx_win_max_t = {.d32 = input_layer->REG_LYRx_WIN_MAX};
+    PPE_REG_LYRx_WIN_MAX_TypeDef ppe_reg_lyrx_win_max_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_WIN_MAX)};
     ppe_reg_lyrx_win_max_t.b.win_x_max              = PPE_InputLayer_Init_Struct->Layer_Window_Xmax;
     ppe_reg_lyrx_win_max_t.b.win_y_max              = PPE_InputLayer_Init_Struct->Layer_Window_Ymax;
-    input_layer->REG_LYRx_WIN_MAX                     = ppe_reg_lyrx_win_max_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_WIN_MAX, ppe_reg_lyrx_win_max_t.d32);
 
-    PPE_REG_LYRx_KEY_MIN_TypeDef ppe_reg_lyrx_key_min_t = {.d32 = input_layer->REG_LYRx_KEY_MIN};
+    PPE_REG_LYRx_KEY_MIN_TypeDef ppe_reg_lyrx_key_min_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_KEY_MIN)};
     ppe_reg_lyrx_key_min_t.b.color_key_min          = PPE_InputLayer_Init_Struct->Color_Key_Min;
-    input_layer->REG_LYRx_KEY_MIN                     = ppe_reg_lyrx_key_min_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_KEY_MIN, ppe_reg_lyrx_key_min_t.d32);
 
-    PPE_REG_LYRx_KEY_MAX_TypeDef ppe_reg_lyrx_key_max_t = {.d32 = input_layer->REG_LYRx_KEY_MAX};
+    PPE_REG_LYRx_KEY_MAX_TypeDef ppe_reg_lyrx_key_max_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_KEY_MAX)};
     ppe_reg_lyrx_key_max_t.b.color_key_max          = PPE_InputLayer_Init_Struct->Color_Key_Max;
-    input_layer->REG_LYRx_KEY_MAX                     = ppe_reg_lyrx_key_max_t.d32;
-
-    input_layer->REG_LYRx_TRANS_MATRIX_E11            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E11;
-    input_layer->REG_LYRx_TRANS_MATRIX_E12            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E12;
-    input_layer->REG_LYRx_TRANS_MATRIX_E13            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E13;
-    input_layer->REG_LYRx_TRANS_MATRIX_E21            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E21;
-    input_layer->REG_LYRx_TRANS_MATRIX_E22            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E22;
-    input_layer->REG_LYRx_TRANS_MATRIX_E23            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E23;
-    input_layer->REG_LYRx_TRANS_MATRIX_E31            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E31;
-    input_layer->REG_LYRx_TRANS_MATRIX_E32            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E32;
-    input_layer->REG_LYRx_TRANS_MATRIX_E33            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E33;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_KEY_MAX, ppe_reg_lyrx_key_max_t.d32);
+
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E11, PPE_InputLayer_Init_Struct->Transfer_Matrix_E11);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E12, PPE_InputLayer_Init_Struct->Transfer_Matrix_E12);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E13, PPE_InputLayer_Init_Struct->Transfer_Matrix_E13);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E21, PPE_InputLayer_Init_Struct->Transfer_Matrix_E21);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E22, PPE_InputLayer_Init_Struct->Transfer_Matrix_E22);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E23, PPE_InputLayer_Init_Struct->Transfer_Matrix_E23);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E31, PPE_InputLayer_Init_Struct->Transfer_Matrix_E31);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E32, PPE_InputLayer_Init_Struct->Transfer_Matrix_E32);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E33, PPE_InputLayer_Init_Struct->Transfer_Matrix_E33);
 
     PPE_REG_LD_CFG_TypeDef ppe_reg_ld_cfg_0x08 = {.d32 = PPE->REG_LD_CFG};
     ppe_reg_ld_cfg_0x08.b.reload_en       &= ~BIT(intput_layer_index);
@@ -279,6 +532,12 @@ void PPE_InputLayer_Init(PPE_INPUT_LAYER_INDEX intput_layer_index, \
     ppe_reg_ll_cfg_0x0c.b.ll_en           |= (PPE_InputLayer_Init_Struct->MultiFrame_LLP_En <<
                                                 intput_layer_index);
     PPE->REG_LL_CFG                        = ppe_reg_ll_cfg_0x0c.d32;
+
+    if (PPE_InputLayer_Init_Struct->MultiFrame_Reload_En || PPE_InputLayer_Init_Struct->MultiFrame_LLP_En)
+    {
+        /*PPE reloads the layer behind the shadow*/
+        PPE_RegShadow_Invalidate();
+    }
 }
 
 
@@ -582,79 +841,31 @@ uint8_t PPE_Get_Pixel_Size(PPE_PIXEL_FORMAT format)
 void PPE_Finish(void)
 {
     while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+    PPE_PERF_DONE();
 }
 
-PPE_err PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix,
-                     PPE_BLEND_MODE mode)
+/* grow pending by the band right below it when the rect holding both wastes few pixels */
+static bool ppe_blit_band_merge(ppe_rect_t *pending, ppe_rect_t *band)
 {
-    if (image->opacity == 0)
-    {
-        return PPE_SUCCESS;
-    }
-    if (target->address == NULL)
-    {
-        return PPE_ERR_NULL_TARGET;
-    }
-    if (image->address == NULL)
-    {
-        return PPE_ERR_NULL_SOURCE;
-    }
-    if ((image->win_x_max <= image->win_x_min) || (image->win_y_max <= image->win_y_min))
-    {
-        return PPE_ERR_INVALID_RANGE;
-    }
-
-    if (matrix == NULL)
-    {
-        return PPE_ERR_INVALID_MATRIX;
-    }
-    ppe_matrix_t inv_matrix;
-    memcpy(&inv_matrix, matrix, sizeof(ppe_matrix_t));
+    int32_t left = (pending->x < band->x) ? pending->x : band->x;
+    int32_t right = ((pending->x + (int32_t)pending->w) > (band->x + (int32_t)band->w)) ?
+                    (pending->x + pending->w) : (band->x + band->w);
+    uint32_t waste = (right - left) * (pending->h + band->h) - pending->w * pending->h - band->w * band->h;
 
-    uint32_t comp[9];
-    if (!check_inverse(matrix))
-    {
-        return PPE_ERR_INVALID_MATRIX;
-    }
-    else
+    if ((pending->y + (int32_t)pending->h != band->y) || (waste >= PPE_BLIT_BAND_MERGE_PIXELS))
     {
-        ppe_matrix_inverse(&inv_matrix);
+        return false;
     }
+    pending->x = left;
+    pending->w = right - left;
+    pending->h += band->h;
+    return true;
+}
 
-    ppe_rect_t rect = {.x = 0, .y = 0, .w = target->width, .h = target->height};
-    ppe_rect_t src_rect = {.x = 0, .y = 0, .w = image->width, .h = image->height};
-    ppe_get_area(&rect, &src_rect, matrix, target);
-    if ((rect.x + rect.w <= 0) || (rect.y + rect.h <= 0)
-        || (rect.x >= target->width) || (rect.y >= target->height))
-    {
-        return PPE_SUCCESS;
-    }
-    if (rect.x < 0)
-    {
-        rect.w = rect.w + rect.x;
-        rect.x = 0;
-    }
-    if (rect.y < 0)
-    {
-        rect.h = rect.h + rect.y;
-        rect.y = 0;
-    }
-    if (rect.x + rect.w >= target->width)
-    {
-        rect.w = target->width - rect.x;
-    }
-    if (rect.y + rect.h >= target->height)
-    {
-        rect.h = target->height - rect.y;
-    }
-    if (rect.x != 0 || rect.y != 0)
-    {
-        ppe_translate(rect.x, rect.y, &inv_matrix);
-    }
-    if (!inv_matrix2complement(&inv_matrix, comp))
-    {
-        return PPE_SUCCESS;
-    }
+/* one PPE_Blit job for rect of target, comp maps rect to image coordinates */
+static void ppe_blit_program(ppe_buffer_t *target, ppe_buffer_t *image, uint32_t *comp,
+                             ppe_rect_t *rect, PPE_BLEND_MODE mode)
+{
     uint32_t color = ((image->opacity << 24) | 0x000000);
 
     PPE_CLK_ENABLE(ENABLE);
@@ -712,9 +923,9 @@ PPE_err PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix
     PPE_input_layer2_init.Layer_HW_Handshake_Polarity     = PPE_HW_HS_ACTIVE_HIGH;
     PPE_input_layer2_init.Layer_HW_Handshake_MsizeLog     = PPE_MSIZE_16;
     PPE_input_layer2_init.Layer_Window_Xmin               = 0;
-    PPE_input_layer2_init.Layer_Window_Xmax               = rect.w;
+    PPE_input_layer2_init.Layer_Window_Xmax               = rect->w;
     PPE_input_layer2_init.Layer_Window_Ymin               = 0;
-    PPE_input_layer2_init.Layer_Window_Ymax               = rect.h;
+    PPE_input_layer2_init.Layer_Window_Ymax               = rect->h;
 
     uint32_t ct = 0;
     PPE_input_layer2_init.Transfer_Matrix_E11             = comp[ct++];
@@ -735,9 +946,9 @@ PPE_err PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix
         PPE_InputLayer_Init_Typedef PPE_input_layer1_init;
         PPE_InputLayer_StructInit(PPE_INPUT_1, &PPE_input_layer1_init);
         PPE_input_layer1_init.Layer_Address                   = target->address +
-                                                                  (rect.y * target->width + rect.x) * PPE_Get_Pixel_Size(target->format);
-        PPE_input_layer1_init.Pic_Height                      = (uint32_t)rect.h;
-        PPE_input_layer1_init.Pic_Width                       = (uint32_t)rect.w;
+                                                                  (rect->y * target->width + rect->x) * PPE_Get_Pixel_Size(target->format);
+        PPE_input_layer1_init.Pic_Height                      = (uint32_t)rect->h;
+        PPE_input_layer1_init.Pic_Width                       = (uint32_t)rect->w;
         PPE_input_layer1_init.Line_Length                     = target->width * PPE_Get_Pixel_Size(
                                                                       target->format);
         PPE_input_layer1_init.Pixel_Source                    = PPE_LAYER_SRC_FROM_DMA;
@@ -752,9 +963,9 @@ PPE_err PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix
         PPE_input_layer1_init.Layer_HW_Handshake_Polarity     = PPE_HW_HS_ACTIVE_HIGH;
         PPE_input_layer1_init.Layer_HW_Handshake_MsizeLog     = PPE_MSIZE_16;
         PPE_input_layer1_init.Layer_Window_Xmin               = 0;
-        PPE_input_layer1_init.Layer_Window_Xmax               = rect.w;
+        PPE_input_layer1_init.Layer_Window_Xmax               = rect->w;
         PPE_input_layer1_init.Layer_Window_Ymin               = 0;
-        PPE_input_layer1_init.Layer_Window_Ymax               = rect.h;
+        PPE_input_layer1_init.Layer_Window_Ymax               = rect->h;
 
         PPE_input_layer1_init.Transfer_Matrix_E11             = 0x10000;
         PPE_input_layer1_init.Transfer_Matrix_E12             = 0;
@@ -773,8 +984,8 @@ PPE_err PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix
         PPE_InputLayer_Init_Typedef PPE_input_layer1_init;
         PPE_InputLayer_StructInit(PPE_INPUT_1, &PPE_input_layer1_init);
         PPE_input_layer1_init.Layer_Address                   = NULL;
-        PPE_input_layer1_init.Pic_Height                      = (uint32_t)rect.h;
-        PPE_input_layer1_init.Pic_Width                       = (uint32_t)rect.w;
+        PPE_input_layer1_init.Pic_Height                      = (uint32_t)rect->h;
+        PPE_input_layer1_init.Pic_Width                       = (uint32_t)rect->w;
         PPE_input_layer1_init.Line_Length                     = target->width * PPE_Get_Pixel_Size(
                                                                       target->format);
         PPE_input_layer1_init.Pixel_Source                    = PPE_LAYER_SRC_CONST;
@@ -789,9 +1000,9 @@ PPE_err PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix
         PPE_input_layer1_init.Layer_HW_Handshake_Polarity     = PPE_HW_HS_ACTIVE_HIGH;
         PPE_input_layer1_init.Layer_HW_Handshake_MsizeLog     = PPE_MSIZE_16;
         PPE_input_layer1_init.Layer_Window_Xmin               = 0;
-        PPE_input_layer1_init.Layer_Window_Xmax               = rect.w;
+        PPE_input_layer1_init.Layer_Window_Xmax               = rect->w;
         PPE_input_layer1_init.Layer_Window_Ymin               = 0;
-        PPE_input_layer1_init.Layer_Window_Ymax               = rect.h;
+        PPE_input_layer1_init.Layer_Window_Ymax               = rect->h;
 
         PPE_input_layer1_init.Transfer_Matrix_E11             = 0x10000;
         PPE_input_layer1_init.Transfer_Matrix_E12             = 0;
@@ -815,9 +1026,9 @@ PPE_err PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix
     PPE_ResultLayer_Init_Typedef PPE_ResultLayer0_Init;
     PPE_ResultLayer_StructInit(&PPE_ResultLayer0_Init);
     PPE_ResultLayer0_Init.Layer_Address                   = target->address +
-                                                              (rect.y * target->width + rect.x) * PPE_Get_Pixel_Size(target->format);
-    PPE_ResultLayer0_Init.Canvas_Height                   = rect.h;
-    PPE_ResultLayer0_Init.Canvas_Width                    = rect.w;
+                                                              (rect->y * target->width + rect->x) * PPE_Get_Pixel_Size(target->format);
+    PPE_ResultLayer0_Init.Canvas_Height                   = rect->h;
+    PPE_ResultLayer0_Init.Canvas_Width                    = rect->w;
     PPE_ResultLayer0_Init.Line_Length                     = target->width * PPE_Get_Pixel_Size(
                                                                   target->format);
     PPE_ResultLayer0_Init.Color_Format                    = target->format;
@@ -828,13 +1039,308 @@ PPE_err PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix
     PPE_ResultLayer_Init(&PPE_ResultLayer0_Init);
 
     PPE_Cmd(ENABLE);
-    //while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+}
+
+/* complement coefficients of inv_matrix moved to the top left corner of rect */
+static void ppe_blit_get_comp(ppe_matrix_fixed_t *inv_matrix, ppe_rect_t *rect, uint32_t *comp)
+{
+    ppe_matrix_fixed_t matrix = *inv_matrix;
+
+    if (rect->x != 0 || rect->y != 0)
+    {
+        ppe_fixed_translate(rect->x * PPE_FIXED_ONE, rect->y * PPE_FIXED_ONE, &matrix);
+    }
+    ppe_fixed_matrix2complement(&matrix, comp);
+}
+
+static void ppe_blit_run(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_fixed_t *inv_matrix,
+                         ppe_rect_t *rect, PPE_BLEND_MODE mode)
+{
+    uint32_t comp[9];
+
+    ppe_blit_get_comp(inv_matrix, rect, comp);
+    ppe_blit_program(target, image, comp, rect, mode);
+}
+
+/* part of target the transformed image touches, false if it is outside target */
+static bool ppe_blit_get_rect(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix,
+                              ppe_rect_t *rect)
+{
+    ppe_rect_t src_rect = {.x = 0, .y = 0, .w = image->width, .h = image->height};
+
+    rect->x = 0;
+    rect->y = 0;
+    rect->w = target->width;
+    rect->h = target->height;
+    ppe_get_area(rect, &src_rect, matrix, target);
+    if ((rect->x + rect->w <= 0) || (rect->y + rect->h <= 0)
+        || (rect->x >= target->width) || (rect->y >= target->height))
+    {
+        return false;
+    }
+    if (rect->x < 0)
+    {
+        rect->w = rect->w + rect->x;
+        rect->x = 0;
+    }
+    if (rect->y < 0)
+    {
+        rect->h = rect->h + rect->y;
+        rect->y = 0;
+    }
+    if (rect->x + rect->w >= target->width)
+    {
+        rect->w = target->width - rect->x;
+    }
+    if (rect->y + rect->h >= target->height)
+    {
+        rect->h = target->height - rect->y;
+    }
+    return true;
+}
+
+PPE_err PPE_Blit(ppe_buffer_t *target, ppe_buffer_t *image, ppe_matrix_t *matrix,
+                     PPE_BLEND_MODE mode)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLIT);
+    if (image->opacity == 0)
+    {
+        return PPE_SUCCESS;
+    }
+    if (target->address == NULL)
+    {
+        return PPE_ERR_NULL_TARGET;
+    }
+    if (image->address == NULL)
+    {
+        return PPE_ERR_NULL_SOURCE;
+    }
+    if ((image->win_x_max <= image->win_x_min) || (image->win_y_max <= image->win_y_min))
+    {
+        return PPE_ERR_INVALID_RANGE;
+    }
+
+    if (matrix == NULL)
+    {
+        return PPE_ERR_INVALID_MATRIX;
+    }
+    ppe_matrix_fixed_t inv_matrix;
+
+    if (!check_inverse(matrix) || !ppe_matrix_cache_get(matrix, true, &inv_matrix))
+    {
+        return PPE_ERR_INVALID_MATRIX;
+    }
+
+    ppe_rect_t rect;
+    ppe_rect_t src_rect = {.x = 0, .y = 0, .w = image->width, .h = image->height};
+    if (!ppe_blit_get_rect(target, image, matrix, &rect))
+    {
+        return PPE_SUCCESS;
+    }
+    ppe_pox_t quad[4];
+    if ((mode != PPE_SRC_OVER_MODE) || !ppe_get_quad(matrix, &src_rect, quad))
+    {
+        ppe_blit_run(target, image, &inv_matrix, &rect, mode);
+        return PPE_SUCCESS;
+    }
+
+    /* blending leaves target as it is outside the image, so only the part of each band of
+       lines the transformed image covers is run, instead of its whole bounding rect */
+    ppe_rect_t pending = {.x = 0, .y = 0, .w = 0, .h = 0};
+    for (int32_t y = rect.y; y < rect.y + (int32_t)rect.h; y += PPE_BLIT_BAND_LINES)
+    {
+        ppe_rect_t band = {.x = rect.x, .y = y, .w = rect.w, .h = rect.y + rect.h - y};
+        if (band.h > PPE_BLIT_BAND_LINES)
+        {
+            band.h = PPE_BLIT_BAND_LINES;
+        }
+        if (!ppe_blit_band_span(quad, &rect, &band))
+        {
+            continue;
+        }
+        if ((pending.w != 0) && ppe_blit_band_merge(&pending, &band))
+        {
+            continue;
+        }
+        if (pending.w != 0)
+        {
+            ppe_blit_run(target, image, &inv_matrix, &pending, mode);
+            while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+            PPE_PERF_DONE();
+        }
+        pending = band;
+    }
+    if (pending.w != 0)
+    {
+        /* the last band is left running like a single job */
+        ppe_blit_run(target, image, &inv_matrix, &pending, mode);
+    }
+    return PPE_SUCCESS;
+}
+
+/* eased progress of a keyframe segment, t in [0, 1] */
+static float ppe_anim_ease(PPE_EASE ease, float t)
+{
+    switch (ease)
+    {
+    case PPE_EASE_IN:
+        return t * t;
+    case PPE_EASE_OUT:
+        return t * (2.0f - t);
+    case PPE_EASE_IN_OUT:
+        return t * t * (3.0f - 2.0f * t);
+    default:
+        return t;
+    }
+}
+
+/* keyframe values at index, held before the first and after the last keyframe */
+static void ppe_anim_sample(ppe_anim_t *anim, uint16_t index, ppe_keyframe_t *value)
+{
+    ppe_keyframe_t *key = anim->key;
+    uint16_t k = 0;
+
+    while ((k + 1 < anim->key_num) && (key[k + 1].frame <= index))
+    {
+        k++;
+    }
+    *value = key[k];
+    if ((k + 1 >= anim->key_num) || (index <= key[k].frame))
+    {
+        return;
+    }
+
+    float t = ppe_anim_ease(anim->ease, (float)(index - key[k].frame) / (key[k + 1].frame - key[k].frame));
+    value->x += (key[k + 1].x - key[k].x) * t;
+    value->y += (key[k + 1].y - key[k].y) * t;
+    value->scale_x += (key[k + 1].scale_x - key[k].scale_x) * t;
+    value->scale_y += (key[k + 1].scale_y - key[k].scale_y) * t;
+    value->angle += (key[k + 1].angle - key[k].angle) * t;
+}
+
+PPE_err PPE_Anim_Precompute(ppe_anim_t *anim, ppe_buffer_t *target, ppe_buffer_t *image,
+                            ppe_anim_frame_t *frame, uint16_t frame_num)
+{
+    if ((anim == NULL) || (anim->key == NULL) || (anim->key_num == 0) || (frame == NULL))
+    {
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+    for (uint16_t k = 1; k < anim->key_num; k++)
+    {
+        if (anim->key[k].frame <= anim->key[k - 1].frame)
+        {
+            return PPE_ERR_INVALID_PARAMETER;
+        }
+    }
+
+    for (uint16_t i = 0; i < frame_num; i++)
+    {
+        ppe_keyframe_t value;
+        ppe_matrix_t matrix;
+        ppe_matrix_fixed_t inv_matrix;
+
+        ppe_anim_sample(anim, i, &value);
+        ppe_get_identity(&matrix);
+        ppe_translate(value.x, value.y, &matrix);
+        ppe_rotate(value.angle, &matrix);
+        ppe_scale(value.scale_x, value.scale_y, &matrix);
+        ppe_translate(-anim->pivot_x, -anim->pivot_y, &matrix);
+
+        /* a frame scaled to nothing or outside target is kept with an empty rect */
+        memset(&frame[i], 0, sizeof(ppe_anim_frame_t));
+        if (!check_inverse(&matrix))
+        {
+            continue;
+        }
+        if (!ppe_matrix_inverse_fixed(&matrix, &inv_matrix) ||
+            !ppe_blit_get_rect(target, image, &matrix, &frame[i].rect))
+        {
+            memset(&frame[i].rect, 0, sizeof(ppe_rect_t));
+            continue;
+        }
+        ppe_blit_get_comp(&inv_matrix, &frame[i].rect, frame[i].comp);
+    }
+    return PPE_SUCCESS;
+}
+
+PPE_err PPE_Blit_Frame(ppe_buffer_t *target, ppe_buffer_t *image, ppe_anim_frame_t *frame,
+                       PPE_BLEND_MODE mode)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLIT);
+    if (frame == NULL)
+    {
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+    if ((image->opacity == 0) || (frame->rect.w == 0) || (frame->rect.h == 0))
+    {
+        return PPE_SUCCESS;
+    }
+    if (target->address == NULL)
+    {
+        return PPE_ERR_NULL_TARGET;
+    }
+    if (image->address == NULL)
+    {
+        return PPE_ERR_NULL_SOURCE;
+    }
+    ppe_blit_program(target, image, frame->comp, &frame->rect, mode);
+    return PPE_SUCCESS;
+}
+
+PPE_err PPE_Blit_Orient(ppe_buffer_t *target, ppe_buffer_t *image, int32_t x, int32_t y,
+                        PPE_ORIENT orient, PPE_BLEND_MODE mode)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLIT);
+    if (image->opacity == 0)
+    {
+        return PPE_SUCCESS;
+    }
+    if (target->address == NULL)
+    {
+        return PPE_ERR_NULL_TARGET;
+    }
+    if (image->address == NULL)
+    {
+        return PPE_ERR_NULL_SOURCE;
+    }
+    if (orient > PPE_FLIP_V)
+    {
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+
+    bool swap = (orient == PPE_ROTATE_90) || (orient == PPE_ROTATE_270);
+    int32_t x_max = x + (swap ? image->height : image->width);
+    int32_t y_max = y + (swap ? image->width : image->height);
+    ppe_rect_t rect = {.x = (x < 0) ? 0 : x, .y = (y < 0) ? 0 : y};
+    if (x_max > target->width)
+    {
+        x_max = target->width;
+    }
+    if (y_max > target->height)
+    {
+        y_max = target->height;
+    }
+    if ((x_max <= rect.x) || (y_max <= rect.y))
+    {
+        return PPE_SUCCESS;
+    }
+    rect.w = x_max - rect.x;
+    rect.h = y_max - rect.y;
+
+    uint32_t comp[9];
+    ppe_orient_get_comp(orient, image, rect.x - x, rect.y - y, comp);
+
+    /* every sample is a whole source pixel, a 2x2 read would only fetch more */
+    ppe_buffer_t source = *image;
+    source.high_quality = false;
+    ppe_blit_program(target, &source, comp, &rect, mode);
     return PPE_SUCCESS;
 }
 
 PPE_err PPE_Blit_Inverse(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_matrix_t *inverse,
                              ppe_rect_t *rect, PPE_BLEND_MODE mode)
 {
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLIT);
     if (dst->address == NULL)
     {
         return PPE_ERR_NULL_TARGET;
@@ -855,22 +1361,14 @@ PPE_err PPE_Blit_Inverse(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_matrix_t *inv
     {
         return PPE_ERR_INVALID_MATRIX;
     }
-    ppe_matrix_t matrix;
-    ppe_get_identity(&matrix);
-    memcpy(&matrix, inverse, sizeof(ppe_matrix_t));
-    ppe_translate(rect->x, rect->y, &matrix);
+    ppe_matrix_fixed_t matrix;
     uint32_t comp[9];
-    if (!check_inverse(inverse))
+    if (!check_inverse(inverse) || !ppe_matrix_cache_get(inverse, false, &matrix))
     {
         return PPE_ERR_INVALID_MATRIX;
     }
-    else
-    {
-        if (!inv_matrix2complement(&matrix, comp))
-        {
-            return PPE_SUCCESS;
-        }
-    }
+    ppe_fixed_translate(rect->x * PPE_FIXED_ONE, rect->y * PPE_FIXED_ONE, &matrix);
+    ppe_fixed_matrix2complement(&matrix, comp);
 
     if (src->opacity == 0)
     {
@@ -1066,6 +1564,7 @@ PPE_err PPE_Blit_Inverse(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_matrix_t *inv
 
 PPE_err PPE_Mask(ppe_buffer_t *dst, uint32_t color, ppe_rect_t *rect)
 {
+    PPE_PERF_BEGIN(PPE_PERF_OP_MASK);
     if (dst->address == NULL)
     {
         return PPE_ERR_NULL_TARGET;
@@ -1206,32 +1705,188 @@ PPE_err PPE_Mask(ppe_buffer_t *dst, uint32_t color, ppe_rect_t *rect)
         PPE_InputLayer_Init(PPE_INPUT_1, &PPE_input_layer1_init);
     }
 
-    PPE_InputLayer_enable(PPE_INPUT_3, DISABLE);
-    PPE_InputLayer_enable(PPE_INPUT_4, DISABLE);
+    PPE_InputLayer_enable(PPE_INPUT_3, DISABLE);
+    PPE_InputLayer_enable(PPE_INPUT_4, DISABLE);
+
+    PPE_ResultLayer_Init_Typedef PPE_ResultLayer0_Init;
+    PPE_ResultLayer_StructInit(&PPE_ResultLayer0_Init);
+    PPE_ResultLayer0_Init.Layer_Address                   = dst->address +
+                                                              (rect->y * dst->width + rect->x) * PPE_Get_Pixel_Size(dst->format);
+    PPE_ResultLayer0_Init.Canvas_Height                   = rect->h;
+    PPE_ResultLayer0_Init.Canvas_Width                    = rect->w;
+    PPE_ResultLayer0_Init.Line_Length                     = dst->width * PPE_Get_Pixel_Size(
+                                                                  dst->format);
+    PPE_ResultLayer0_Init.Color_Format                    = dst->format;
+    PPE_ResultLayer0_Init.BackGround                      = dst->const_color;
+    PPE_ResultLayer0_Init.LayerBus_Inc                    = PPE_AWBURST_INC;
+    PPE_ResultLayer0_Init.MultiFrame_Reload_En            = DISABLE;
+    PPE_ResultLayer0_Init.MultiFrame_LLP_En               = DISABLE;
+    PPE_ResultLayer_Init(&PPE_ResultLayer0_Init);
+
+    PPE_Cmd(ENABLE);
+    while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+    PPE_PERF_DONE();
+    return PPE_SUCCESS;
+}
+
+/* grow rect by add when both have the same rows or columns and touch, so the union is exact */
+static bool ppe_rect_join(ppe_rect_t *rect, ppe_rect_t *add)
+{
+    if ((rect->y == add->y) && (rect->h == add->h))
+    {
+        if ((add->x == rect->x + (int)rect->w) || (rect->x == add->x + (int)add->w))
+        {
+            rect->x = (rect->x < add->x) ? rect->x : add->x;
+            rect->w += add->w;
+            return true;
+        }
+    }
+    if ((rect->x == add->x) && (rect->w == add->w))
+    {
+        if ((add->y == rect->y + (int)rect->h) || (rect->y == add->y + (int)add->h))
+        {
+            rect->y = (rect->y < add->y) ? rect->y : add->y;
+            rect->h += add->h;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ppe_rect_overlap(ppe_rect_t *a, ppe_rect_t *b)
+{
+    return (a->x < b->x + (int)b->w) && (b->x < a->x + (int)a->w) &&
+           (a->y < b->y + (int)b->h) && (b->y < a->y + (int)a->h);
+}
+
+/* opaque fill of a small rect inside dst with 32-bit CPU stores, false leaves it to PPE */
+static bool ppe_mask_sw(ppe_buffer_t *dst, uint32_t color, ppe_rect_t *rect)
+{
+    uint32_t word;
+    if (((color >> 24) * dst->opacity / 255 != 0xFF) || (rect->w * rect->h > PPE_MASK_SW_PIXELS))
+    {
+        return false;
+    }
+    if ((rect->x < 0) || (rect->y < 0) || (rect->x + rect->w > dst->width) ||
+        (rect->y + rect->h > dst->height))
+    {
+        return false;
+    }
+    if ((dst->format == PPE_ARGB8888) || (dst->format == PPE_XRGB8888))
+    {
+        word = color;
+    }
+    else if (dst->format == PPE_RGB565)
+    {
+        word = ((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) | ((color >> 3) & 0x001F);
+        word |= word << 16;
+    }
+    else
+    {
+        return false;
+    }
+
+    uint8_t len = PPE_Get_Pixel_Size(dst->format);
+    uint32_t pitch = dst->width * len;
+    uint8_t *line = (uint8_t *)dst->address + rect->y * pitch + rect->x * len;
+    for (uint32_t y = 0; y < rect->h; y++, line += pitch)
+    {
+        uint8_t *p = line;
+        uint32_t count = rect->w;
+        if ((len == 2) && ((uint32_t)p & 2))
+        {
+            *(uint16_t *)p = (uint16_t)word;
+            p += 2;
+            count--;
+        }
+        uint32_t *w = (uint32_t *)p;
+        for (uint32_t i = (count * len) >> 2; i != 0; i--)
+        {
+            *w++ = word;
+        }
+        if ((len == 2) && (count & 1))
+        {
+            *(uint16_t *)w = (uint16_t)word;
+        }
+    }
+    return true;
+}
+
+static PPE_err ppe_mask_batch(ppe_buffer_t *dst, ppe_fill_t *fill, uint16_t num)
+{
+    for (uint16_t i = 0; i < num; i++)
+    {
+        if (!ppe_mask_sw(dst, fill[i].color, &fill[i].rect))
+        {
+            PPE_err err = PPE_Mask(dst, fill[i].color, &fill[i].rect);
+            if (err != PPE_SUCCESS)
+            {
+                return err;
+            }
+        }
+    }
+    return PPE_SUCCESS;
+}
+
+PPE_err PPE_Mask_List(ppe_buffer_t *dst, ppe_fill_t *fill, uint16_t fill_num)
+{
+    ppe_fill_t batch[PPE_MASK_LIST_BATCH];
+    uint16_t num = 0;
 
-    PPE_ResultLayer_Init_Typedef PPE_ResultLayer0_Init;
-    PPE_ResultLayer_StructInit(&PPE_ResultLayer0_Init);
-    PPE_ResultLayer0_Init.Layer_Address                   = dst->address +
-                                                              (rect->y * dst->width + rect->x) * PPE_Get_Pixel_Size(dst->format);
-    PPE_ResultLayer0_Init.Canvas_Height                   = rect->h;
-    PPE_ResultLayer0_Init.Canvas_Width                    = rect->w;
-    PPE_ResultLayer0_Init.Line_Length                     = dst->width * PPE_Get_Pixel_Size(
-                                                                  dst->format);
-    PPE_ResultLayer0_Init.Color_Format                    = dst->format;
-    PPE_ResultLayer0_Init.BackGround                      = dst->const_color;
-    PPE_ResultLayer0_Init.LayerBus_Inc                    = PPE_AWBURST_INC;
-    PPE_ResultLayer0_Init.MultiFrame_Reload_En            = DISABLE;
-    PPE_ResultLayer0_Init.MultiFrame_LLP_En               = DISABLE;
-    PPE_ResultLayer_Init(&PPE_ResultLayer0_Init);
+    if (dst->address == NULL)
+    {
+        return PPE_ERR_NULL_TARGET;
+    }
+    if ((fill == NULL) && (fill_num != 0))
+    {
+        return PPE_ERR_NULL_SOURCE;
+    }
 
-    PPE_Cmd(ENABLE);
-    while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
-    return PPE_SUCCESS;
+    /* CPU stores must not race a job that is still running */
+    PPE_Finish();
+    for (uint16_t i = 0; i < fill_num; i++)
+    {
+        bool merged = false;
+        if ((fill[i].rect.w == 0) || (fill[i].rect.h == 0))
+        {
+            continue;
+        }
+        /* merge a fill into an earlier one of the same color unless a fill in between covers it,
+           painting it earlier must not change the result */
+        for (uint16_t j = num; j-- > 0;)
+        {
+            if ((batch[j].color == fill[i].color) && ppe_rect_join(&batch[j].rect, &fill[i].rect))
+            {
+                merged = true;
+                break;
+            }
+            if (ppe_rect_overlap(&batch[j].rect, &fill[i].rect))
+            {
+                break;
+            }
+        }
+        if (merged)
+        {
+            continue;
+        }
+        if (num == PPE_MASK_LIST_BATCH)
+        {
+            PPE_err err = ppe_mask_batch(dst, batch, num);
+            if (err != PPE_SUCCESS)
+            {
+                return err;
+            }
+            num = 0;
+        }
+        batch[num++] = fill[i];
+    }
+    return ppe_mask_batch(dst, batch, num);
 }
 
 PPE_err PPE_Blend_Multi(ppe_buffer_t *dst, ppe_buffer_t *src_1,
                             ppe_buffer_t *src_2, ppe_buffer_t *src_3, PPE_BLEND_MODE mode)
 {
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLEND_MULTI);
     if (dst->address == NULL)
     {
         return PPE_ERR_NULL_TARGET;
@@ -1563,30 +2218,15 @@ PPE_err PPE_Blend_Multi(ppe_buffer_t *dst, ppe_buffer_t *src_1,
 
     PPE_Cmd(ENABLE);
     while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+    PPE_PERF_DONE();
     return PPE_SUCCESS;
 }
 
 #if IDU_HANDSHAKE
 #include "rtl_idu.h"
-PPE_err PPE_Blend_Handshake(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_rect_t *rect)
+/* layer 2 reads src from the IDU TX FIFO, layer 1 and the result layer cover rect of dst */
+static void ppe_handshake_program(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_rect_t *rect)
 {
-    if (dst->address == NULL)
-    {
-        return PPE_ERR_NULL_TARGET;
-    }
-    if (src->address == NULL)
-    {
-        return PPE_ERR_NULL_SOURCE;
-    }
-    if ((src->win_x_max <= src->win_x_min) || (src->win_y_max <= src->win_y_min))
-    {
-        return PPE_ERR_INVALID_RANGE;
-    }
-    if (src->opacity == 0)
-    {
-        return PPE_ERR_INVALID_MATRIX;
-    }
-
     uint32_t color = ((src->opacity << 24) | 0x000000);
 
     PPE_CLK_ENABLE(ENABLE);
@@ -1710,10 +2350,138 @@ PPE_err PPE_Blend_Handshake(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_rect_t *re
     PPE_ResultLayer0_Init.MultiFrame_Reload_En            = DISABLE;
     PPE_ResultLayer0_Init.MultiFrame_LLP_En               = DISABLE;
     PPE_ResultLayer_Init(&PPE_ResultLayer0_Init);
+}
+
+PPE_err PPE_Blend_Handshake(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_rect_t *rect)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_HANDSHAKE);
+    if (dst->address == NULL)
+    {
+        return PPE_ERR_NULL_TARGET;
+    }
+    if (src->address == NULL)
+    {
+        return PPE_ERR_NULL_SOURCE;
+    }
+    if ((src->win_x_max <= src->win_x_min) || (src->win_y_max <= src->win_y_min))
+    {
+        return PPE_ERR_INVALID_RANGE;
+    }
+    if (src->opacity == 0)
+    {
+        return PPE_ERR_INVALID_MATRIX;
+    }
+
+    ppe_handshake_program(dst, src, rect);
     IDU_Cmd(ENABLE);// logic function enable
     IDU_Run(ENABLE);
     PPE_Cmd(ENABLE);
     while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+    PPE_PERF_DONE();
+    return PPE_SUCCESS;
+}
+
+static PPE_err ppe_idu_error(IDU_ERROR err)
+{
+    switch (err)
+    {
+    case IDU_ERROR_BUSY:
+        return PPE_ERR_IDU_BUSY;
+    case IDU_ERROR_LLI_EXHAUSTED:
+        return PPE_ERR_IDU_LLI_EXHAUSTED;
+    case IDU_ERROR_START_EXCEED_BOUNDARY:
+    case IDU_ERROR_START_LARGER_THAN_END:
+    case IDU_ERROR_END_EXCEED_BOUNDARY:
+        return PPE_ERR_INVALID_RANGE;
+    case IDU_ERROR_NULL_INPUT:
+        return PPE_ERR_NULL_SOURCE;
+    default:
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+}
+
+PPE_err PPE_Blit_Compressed(ppe_buffer_t *dst, ppe_buffer_t *src, int16_t x, int16_t y,
+                            IDU_DMA_config *dma_cfg)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_HANDSHAKE);
+    if (src->opacity == 0)
+    {
+        return PPE_SUCCESS;
+    }
+    if (dst->address == NULL)
+    {
+        return PPE_ERR_NULL_TARGET;
+    }
+    if (src->address == NULL)
+    {
+        return PPE_ERR_NULL_SOURCE;
+    }
+    if (dma_cfg == NULL)
+    {
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+
+    IDU_file_header *header = (IDU_file_header *)src->address;
+    if (PPE_Get_Pixel_Size(src->format) != header->algorithm_type.pixel_bytes + 2)
+    {
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+
+    /* clip against dst, the IDU only decodes the visible lines and columns */
+    int32_t x_min = x;
+    int32_t y_min = y;
+    int32_t x_max = x + header->raw_pic_width;
+    int32_t y_max = y + header->raw_pic_height;
+    if (x_min < 0)
+    {
+        x_min = 0;
+    }
+    if (y_min < 0)
+    {
+        y_min = 0;
+    }
+    if (x_max > dst->width)
+    {
+        x_max = dst->width;
+    }
+    if (y_max > dst->height)
+    {
+        y_max = dst->height;
+    }
+    if ((x_max <= x_min) || (y_max <= y_min))
+    {
+        return PPE_SUCCESS;
+    }
+
+    IDU_decode_range range;
+    range.start_column = x_min - x;
+    range.end_column = x_max - x - 1;
+    range.start_line = y_min - y;
+    range.end_line = y_max - y - 1;
+
+    ppe_rect_t rect = {.x = x_min, .y = y_min, .w = x_max - x_min, .h = y_max - y_min};
+    ppe_buffer_t layer = *src;
+    layer.width = rect.w;
+    layer.height = rect.h;
+    layer.win_x_min = 0;
+    layer.win_x_max = rect.w;
+    layer.win_y_min = 0;
+    layer.win_y_max = rect.h;
+
+    /* IDU is only configured here and starts below, nothing is left to undo if it fails */
+    IDU_ERROR err = IDU_Decode_Direct((uint8_t *)src->address, &range, dma_cfg);
+    if (err != IDU_SUCCESS)
+    {
+        return ppe_idu_error(err);
+    }
+    ppe_handshake_program(dst, &layer, &rect);
+    IDU_Cmd(ENABLE);
+    IDU_Run(ENABLE);
+    PPE_Cmd(ENABLE);
+    while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+    while (IDU->IDU_CTL0 & BIT0);
+    IDU_Decode_Release();
+    PPE_PERF_DONE();
     return PPE_SUCCESS;
 }
 #endif
@@ -2044,6 +2812,240 @@ bool inv_matrix2complement(ppe_matrix_t *matrix, uint32_t *comp)
     return true;
 }
 
+static inline ppe_fixed_t ppe_fixed_mul(ppe_fixed_t a, ppe_fixed_t b)
+{
+    return (ppe_fixed_t)(((int64_t)a * b) >> 16);
+}
+
+/* num / den in Q16.16, num and den must have the same scale; false when den is lost to the
+   range reduction or the quotient does not fit */
+static bool ppe_fixed_div64(int64_t num, int64_t den, ppe_fixed_t *result)
+{
+    if (den < 0)
+    {
+        num = -num;
+        den = -den;
+    }
+    while ((den >= ((int64_t)1 << 46)) || (num >= ((int64_t)1 << 46)) || (num <= -((int64_t)1 << 46)))
+    {
+        num >>= 1;
+        den >>= 1;
+    }
+    if (den == 0)
+    {
+        return false;
+    }
+    int64_t quotient = (num * 65536) / den;
+    if ((quotient > INT32_MAX) || (quotient < INT32_MIN))
+    {
+        return false;
+    }
+    *result = (ppe_fixed_t)quotient;
+    return true;
+}
+
+/* value in Q16.16 rounded to nearest, false when it does not fit */
+static bool ppe_fixed_from_double(double value, ppe_fixed_t *result)
+{
+    double scaled = floor(value * 65536.0 + 0.5);
+    if (!(scaled < 2147483648.0) || !(scaled >= -2147483648.0))
+    {
+        return false;
+    }
+    *result = (ppe_fixed_t)scaled;
+    return true;
+}
+
+void ppe_fixed_get_identity(ppe_matrix_fixed_t *matrix)
+{
+    memset(matrix, 0, sizeof(ppe_matrix_fixed_t));
+    matrix->m[0][0] = PPE_FIXED_ONE;
+    matrix->m[1][1] = PPE_FIXED_ONE;
+    matrix->m[2][2] = PPE_FIXED_ONE;
+}
+
+void ppe_matrix_to_fixed(ppe_matrix_t *matrix, ppe_matrix_fixed_t *fixed)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            fixed->m[i][j] = (ppe_fixed_t)(matrix->m[i][j] * 65536);
+        }
+    }
+}
+
+void ppe_fixed_to_matrix(ppe_matrix_fixed_t *fixed, ppe_matrix_t *matrix)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            matrix->m[i][j] = fixed->m[i][j] / 65536.0f;
+        }
+    }
+}
+
+void ppe_fixed_mat_multiply(ppe_matrix_fixed_t *matrix, ppe_matrix_fixed_t *mult)
+{
+    ppe_matrix_fixed_t m;
+    memcpy(&m, matrix, sizeof(ppe_matrix_fixed_t));
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            int64_t sum = (int64_t)m.m[row][0] * mult->m[0][col] + \
+                          (int64_t)m.m[row][1] * mult->m[1][col] + \
+                          (int64_t)m.m[row][2] * mult->m[2][col];
+            matrix->m[row][col] = (ppe_fixed_t)(sum >> 16);
+        }
+    }
+}
+
+void ppe_fixed_translate(ppe_fixed_t x, ppe_fixed_t y, ppe_matrix_fixed_t *matrix)
+{
+    /* M * T only changes the third column */
+    for (int row = 0; row < 3; row++)
+    {
+        matrix->m[row][2] += ppe_fixed_mul(matrix->m[row][0], x) + ppe_fixed_mul(matrix->m[row][1], y);
+    }
+}
+
+void ppe_fixed_scale(ppe_fixed_t scale_x, ppe_fixed_t scale_y, ppe_matrix_fixed_t *matrix)
+{
+    for (int row = 0; row < 3; row++)
+    {
+        matrix->m[row][0] = ppe_fixed_mul(matrix->m[row][0], scale_x);
+        matrix->m[row][1] = ppe_fixed_mul(matrix->m[row][1], scale_y);
+    }
+}
+
+void ppe_fixed_rotate(int16_t degrees, ppe_matrix_fixed_t *matrix)
+{
+    ppe_fixed_t cos_angle = ((int32_t)ppe_fix_cos(degrees) * 65536) / 32767;
+    ppe_fixed_t sin_angle = ((int32_t)ppe_fix_sin(degrees) * 65536) / 32767;
+    ppe_matrix_fixed_t r = { { {cos_angle, -sin_angle, 0},
+            {sin_angle, cos_angle, 0},
+            {0, 0, PPE_FIXED_ONE}
+        }
+    };
+
+    ppe_fixed_mat_multiply(matrix, &r);
+}
+
+bool ppe_fixed_matrix_inverse(ppe_matrix_fixed_t *matrix)
+{
+    int64_t m00 = matrix->m[0][0], m01 = matrix->m[0][1], m02 = matrix->m[0][2];
+    int64_t m10 = matrix->m[1][0], m11 = matrix->m[1][1], m12 = matrix->m[1][2];
+    int64_t m20 = matrix->m[2][0], m21 = matrix->m[2][1], m22 = matrix->m[2][2];
+
+    /* adjugate in Q32.32 */
+    int64_t c00 = m11 * m22 - m12 * m21;
+    int64_t c10 = -(m22 * m10 - m12 * m20);
+    int64_t c20 = m10 * m21 - m20 * m11;
+    int64_t c01 = -(m01 * m22 - m02 * m21);
+    int64_t c11 = m22 * m00 - m20 * m02;
+    int64_t c21 = -(m00 * m21 - m20 * m01);
+    int64_t c02 = m01 * m12 - m11 * m02;
+    int64_t c12 = -(m00 * m12 - m02 * m10);
+    int64_t c22 = m00 * m11 - m01 * m10;
+
+    int64_t detal = m00 * (c00 >> 16) + m01 * (c10 >> 16) + m02 * (c20 >> 16);
+    if (detal == 0)
+    {
+        return false;
+    }
+
+    ppe_matrix_fixed_t inv;
+    if (!ppe_fixed_div64(c00, detal, &inv.m[0][0]) || !ppe_fixed_div64(c10, detal, &inv.m[1][0]) ||
+        !ppe_fixed_div64(c20, detal, &inv.m[2][0]) || !ppe_fixed_div64(c01, detal, &inv.m[0][1]) ||
+        !ppe_fixed_div64(c11, detal, &inv.m[1][1]) || !ppe_fixed_div64(c21, detal, &inv.m[2][1]) ||
+        !ppe_fixed_div64(c02, detal, &inv.m[0][2]) || !ppe_fixed_div64(c12, detal, &inv.m[1][2]) ||
+        !ppe_fixed_div64(c22, detal, &inv.m[2][2]))
+    {
+        return false;
+    }
+    memcpy(matrix, &inv, sizeof(ppe_matrix_fixed_t));
+    return true;
+}
+
+bool ppe_matrix_inverse_fixed(ppe_matrix_t *matrix, ppe_matrix_fixed_t *fixed)
+{
+    double m00 = matrix->m[0][0], m01 = matrix->m[0][1], m02 = matrix->m[0][2];
+    double m10 = matrix->m[1][0], m11 = matrix->m[1][1], m12 = matrix->m[1][2];
+    double m20 = matrix->m[2][0], m21 = matrix->m[2][1], m22 = matrix->m[2][2];
+
+    double adj[3][3] =
+    {
+        {m11 * m22 - m12 * m21, -(m01 * m22 - m02 * m21), m01 * m12 - m11 * m02},
+        {-(m22 * m10 - m12 * m20), m22 * m00 - m20 * m02, -(m00 * m12 - m02 * m10)},
+        {m10 * m21 - m20 * m11, -(m00 * m21 - m20 * m01), m00 * m11 - m01 * m10},
+    };
+    double detal = m00 * adj[0][0] + m01 * adj[1][0] + m02 * adj[2][0];
+    if (detal == 0)
+    {
+        return false;
+    }
+
+    ppe_matrix_fixed_t inv;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            if (!ppe_fixed_from_double(adj[i][j] / detal, &inv.m[i][j]))
+            {
+                return false;
+            }
+        }
+    }
+    memcpy(fixed, &inv, sizeof(ppe_matrix_fixed_t));
+    return true;
+}
+
+void ppe_fixed_matrix2complement(ppe_matrix_fixed_t *matrix, uint32_t *comp)
+{
+    /* Transfer_Matrix_Exx take Q16.16 in two's complement */
+    memcpy(comp, matrix->m, 9 * sizeof(uint32_t));
+}
+
+bool ppe_matrix_cache_get(ppe_matrix_t *matrix, bool inverse, ppe_matrix_fixed_t *result)
+{
+    for (uint8_t i = 0; i < PPE_MATRIX_CACHE_NUM; i++)
+    {
+        ppe_matrix_cache_t *entry = &ppe_matrix_cache[i];
+        if (entry->valid && (entry->inverse == inverse) &&
+            (memcmp(&entry->key, matrix, sizeof(ppe_matrix_t)) == 0))
+        {
+            memcpy(result, &entry->value, sizeof(ppe_matrix_fixed_t));
+            return true;
+        }
+    }
+
+    /* the inverse is taken from the float matrix, rounding the forward matrix to Q16.16 first
+       moves the perspective terms */
+    ppe_matrix_fixed_t value;
+    if (inverse)
+    {
+        if (!ppe_matrix_inverse_fixed(matrix, &value))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        ppe_matrix_to_fixed(matrix, &value);
+    }
+
+    ppe_matrix_cache_t *entry = &ppe_matrix_cache[ppe_matrix_cache_next];
+    ppe_matrix_cache_next = (ppe_matrix_cache_next + 1) % PPE_MATRIX_CACHE_NUM;
+    memcpy(&entry->key, matrix, sizeof(ppe_matrix_t));
+    memcpy(&entry->value, &value, sizeof(ppe_matrix_fixed_t));
+    entry->inverse = inverse;
+    entry->valid = true;
+    memcpy(result, &value, sizeof(ppe_matrix_fixed_t));
+    return true;
+}
+
 static void pos_transfer(ppe_matrix_t *matrix, ppe_pox_t *pox)
 {
     float m_row0, m_row1, m_row2;
@@ -0,0 +1,411 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+**********************************************************************************************************
+* \file     ppe_simulation.c
+* \brief    Software model of the RTL87x2G PPE datapath.
+* \details  PPE_Simulation_Run is the engine side of PPE_Cmd when PPE_SIM_BACKEND is set, it
+*           reads the job back from the layer registers, renders it with PPE_Simulation and
+*           walks the linked list the way the engine fetches it.
+*********************************************************************************************************
+*/
+
+/*============================================================================*
+ *                        Header Files
+ *============================================================================*/
+#include "ppe_simulation.h"
+#include "string.h"
+
+/*============================================================================*
+ *                          Private Macros
+ *============================================================================*/
+#define MIN(x, y)               (((x) < (y)) ? (x) : (y))
+#define PPE_SIM_MASK_RB         0x00FF00FFU
+
+/*============================================================================*
+ *                          Private Types
+ *============================================================================*/
+typedef struct
+{
+    uint8_t shift;
+    uint8_t bits;
+} ppe_sim_channel_t;
+
+typedef struct
+{
+    uint8_t len;
+    ppe_sim_channel_t a;
+    ppe_sim_channel_t r;
+    ppe_sim_channel_t g;
+    ppe_sim_channel_t b;
+} ppe_sim_format_t;
+
+/*============================================================================*
+ *                          Private Variables
+ *============================================================================*/
+/* bytes per pixel and channel position in the pixel word read in little endian order, width 0
+   means the channel is not stored */
+static const ppe_sim_format_t ppe_sim_format[PPE_RGBX6668 + 1] =
+{
+    [PPE_ABGR8888] = {4, {24, 8}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_ARGB8888] = {4, {24, 8}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_XBGR8888] = {4, {0, 0}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_XRGB8888] = {4, {0, 0}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_BGRA8888] = {4, {0, 8}, {8, 8}, {16, 8}, {24, 8}},
+    [PPE_RGBA8888] = {4, {0, 8}, {24, 8}, {16, 8}, {8, 8}},
+    [PPE_BGRX8888] = {4, {0, 0}, {8, 8}, {16, 8}, {24, 8}},
+    [PPE_RGBX8888] = {4, {0, 0}, {24, 8}, {16, 8}, {8, 8}},
+    [PPE_ABGR4444] = {2, {12, 4}, {0, 4}, {4, 4}, {8, 4}},
+    [PPE_ARGB4444] = {2, {12, 4}, {8, 4}, {4, 4}, {0, 4}},
+    [PPE_XBGR4444] = {2, {0, 0}, {0, 4}, {4, 4}, {8, 4}},
+    [PPE_XRGB4444] = {2, {0, 0}, {8, 4}, {4, 4}, {0, 4}},
+    [PPE_BGRA4444] = {2, {0, 4}, {4, 4}, {8, 4}, {12, 4}},
+    [PPE_RGBA4444] = {2, {0, 4}, {12, 4}, {8, 4}, {4, 4}},
+    [PPE_BGRX4444] = {2, {0, 0}, {4, 4}, {8, 4}, {12, 4}},
+    [PPE_RGBX4444] = {2, {0, 0}, {12, 4}, {8, 4}, {4, 4}},
+    [PPE_ABGR2222] = {1, {6, 2}, {0, 2}, {2, 2}, {4, 2}},
+    [PPE_ARGB2222] = {1, {6, 2}, {4, 2}, {2, 2}, {0, 2}},
+    [PPE_XBGR2222] = {1, {0, 0}, {0, 2}, {2, 2}, {4, 2}},
+    [PPE_XRGB2222] = {1, {0, 0}, {4, 2}, {2, 2}, {0, 2}},
+    [PPE_BGRA2222] = {1, {0, 2}, {2, 2}, {4, 2}, {6, 2}},
+    [PPE_RGBA2222] = {1, {0, 2}, {6, 2}, {4, 2}, {2, 2}},
+    [PPE_BGRX2222] = {1, {0, 0}, {2, 2}, {4, 2}, {6, 2}},
+    [PPE_RGBX2222] = {1, {0, 0}, {6, 2}, {4, 2}, {2, 2}},
+    [PPE_ABGR8565] = {3, {16, 8}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_ARGB8565] = {3, {16, 8}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_XBGR8565] = {3, {0, 0}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_XRGB8565] = {3, {0, 0}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_BGRA5658] = {3, {0, 8}, {8, 5}, {13, 6}, {19, 5}},
+    [PPE_RGBA5658] = {3, {0, 8}, {19, 5}, {13, 6}, {8, 5}},
+    [PPE_BGRX5658] = {3, {0, 0}, {8, 5}, {13, 6}, {19, 5}},
+    [PPE_RGBX5658] = {3, {0, 0}, {19, 5}, {13, 6}, {8, 5}},
+    [PPE_ABGR1555] = {2, {15, 1}, {0, 5}, {5, 5}, {10, 5}},
+    [PPE_ARGB1555] = {2, {15, 1}, {10, 5}, {5, 5}, {0, 5}},
+    [PPE_XBGR1555] = {2, {0, 0}, {0, 5}, {5, 5}, {10, 5}},
+    [PPE_XRGB1555] = {2, {0, 0}, {10, 5}, {5, 5}, {0, 5}},
+    [PPE_BGRA5551] = {2, {0, 1}, {1, 5}, {6, 5}, {11, 5}},
+    [PPE_RGBA5551] = {2, {0, 1}, {11, 5}, {6, 5}, {1, 5}},
+    [PPE_BGRX5551] = {2, {0, 0}, {1, 5}, {6, 5}, {11, 5}},
+    [PPE_RGBX5551] = {2, {0, 0}, {11, 5}, {6, 5}, {1, 5}},
+    [PPE_BGR888] = {3, {0, 0}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_RGB888] = {3, {0, 0}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_BGR565] = {2, {0, 0}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_RGB565] = {2, {0, 0}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_A8] = {1, {0, 8}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_X8] = {1, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_ABGR8666] = {4, {18, 8}, {0, 6}, {6, 6}, {12, 6}},
+    [PPE_ARGB8666] = {4, {18, 8}, {12, 6}, {6, 6}, {0, 6}},
+    [PPE_XBGR8666] = {4, {0, 0}, {0, 6}, {6, 6}, {12, 6}},
+    [PPE_XRGB8666] = {4, {0, 0}, {12, 6}, {6, 6}, {0, 6}},
+    [PPE_BGRA6668] = {4, {0, 8}, {8, 6}, {14, 6}, {20, 6}},
+    [PPE_RGBA6668] = {4, {0, 8}, {20, 6}, {14, 6}, {8, 6}},
+    [PPE_BGRX6668] = {4, {0, 0}, {8, 6}, {14, 6}, {20, 6}},
+    [PPE_RGBX6668] = {4, {0, 0}, {20, 6}, {14, 6}, {8, 6}},
+};
+
+/*============================================================================*
+ *                          Private Functions
+ *============================================================================*/
+static bool ppe_sim_format_valid(PPE_PIXEL_FORMAT format)
+{
+    return ((uint32_t)format <= PPE_RGBX6668) && (ppe_sim_format[format].len != 0);
+}
+
+/* widen a channel to 8 bits by repeating its bits, 0x1F -> 0xFF */
+static uint32_t ppe_sim_expand(uint32_t word, ppe_sim_channel_t channel, uint32_t absent)
+{
+    if (channel.bits == 0)
+    {
+        return absent;
+    }
+    uint32_t c = ((word >> channel.shift) & ((1UL << channel.bits) - 1)) << (8 - channel.bits);
+    for (uint8_t filled = channel.bits; filled < 8; filled *= 2)
+    {
+        c |= c >> filled;
+    }
+    return c & 0xFF;
+}
+
+static uint32_t ppe_sim_narrow(uint32_t value, ppe_sim_channel_t channel)
+{
+    if (channel.bits == 0)
+    {
+        return 0;
+    }
+    return (value >> (8 - channel.bits)) << channel.shift;
+}
+
+static uint32_t ppe_sim_read(uint32_t addr, uint32_t line_len, uint8_t len, uint32_t x, uint32_t y)
+{
+    uint8_t *p = PPE_SIM_ADDR(addr) + (y * line_len + x) * len;
+    uint32_t word = 0;
+
+    for (uint8_t i = 0; i < len; i++)
+    {
+        word |= (uint32_t)p[i] << (8 * i);
+    }
+    return word;
+}
+
+static void ppe_sim_write(uint32_t addr, uint32_t line_len, uint8_t len, uint32_t x, uint32_t y,
+                          uint32_t word)
+{
+    uint8_t *p = PPE_SIM_ADDR(addr) + (y * line_len + x) * len;
+
+    for (uint8_t i = 0; i < len; i++)
+    {
+        p[i] = (word >> (8 * i)) & 0xFF;
+    }
+}
+
+/* D = S * a + D * (1 - a) on both 8 bit lane pairs of a word, the alpha lane gets
+   a + Da * (1 - a) */
+static uint32_t ppe_sim_blend(uint32_t src, uint32_t dst, uint32_t alpha)
+{
+    alpha += alpha >> 7;
+    uint32_t inv = 256 - alpha;
+    uint32_t rb = (((src & PPE_SIM_MASK_RB) * alpha + (dst & PPE_SIM_MASK_RB) * inv) >> 8) &
+                  PPE_SIM_MASK_RB;
+    uint32_t ag = (((src >> 8) & 0xFF) | 0x00FF0000) * alpha + ((dst >> 8) & PPE_SIM_MASK_RB) * inv;
+    return rb | (ag & ~PPE_SIM_MASK_RB);
+}
+
+/* pixel of layer at result pixel (x, y), false if the layer does not cover it or the pixel is
+   keyed */
+static bool ppe_sim_fetch(PPE_InputLayer_InitTypeDef *layer, uint32_t x, uint32_t y,
+                          uint32_t *color)
+{
+    if ((x < layer->start_x) || (x >= layer->start_x + layer->width) ||
+        (y < layer->start_y) || (y >= layer->start_y + layer->height))
+    {
+        return false;
+    }
+    if (layer->src == PPE_LAYER_SRC_CONST)
+    {
+        *color = layer->const_ABGR8888_value;
+        return true;
+    }
+    uint8_t len = ppe_sim_format[layer->format].len;
+    uint32_t raw = ppe_sim_read(layer->src_addr, layer->line_len, len, x - layer->start_x,
+                                y - layer->start_y);
+    uint32_t key_mask = (len == 4) ? 0xFFFFFFFF : ((1UL << (len * 8)) - 1);
+    if (layer->color_key_en && ((raw & key_mask) == (layer->key_color_value & key_mask)))
+    {
+        return false;
+    }
+    *color = PPE_Simulation_Get_Pixel(layer->src_addr, layer->line_len, layer->format,
+                                      x - layer->start_x, y - layer->start_y,
+                                      layer->const_ABGR8888_value);
+    return true;
+}
+
+static void ppe_sim_load_input(uint8_t id, PPE_InputLayer_InitTypeDef *layer)
+{
+    PPE_INPUT_LAYER_TypeDef *reg = &PPE_LAYER->INPUT_LAYER[id - 1];
+    PPE_LAYERX_POS_TypeDef pos = {.d32 = reg->LAYERx_POS};
+    PPE_LAYERX_WIN_SIZE_TypeDef win_size = {.d32 = reg->LAYERx_WIN_SIZE};
+    PPE_LAYERX_PIC_CFG_TypeDef pic_cfg = {.d32 = reg->LAYERx_PIC_CFG};
+
+    PPE_InputLayer_StructInit(layer);
+    layer->src_addr = reg->LAYERx_ADDR_L;
+    layer->start_x = pos.b.start_x;
+    layer->start_y = pos.b.start_y;
+    layer->width = win_size.b.width;
+    layer->height = win_size.b.height;
+    layer->const_ABGR8888_value = reg->LAYERx_CONST_PIX;
+    layer->key_color_value = reg->LAYERx_KEY_COLOR;
+    layer->line_len = pic_cfg.b.line_len;
+    layer->format = (PPE_PIXEL_FORMAT)pic_cfg.b.format;
+    layer->src = (PPE_PIXEL_SOURCE)pic_cfg.b.pix_src;
+    layer->color_key_en = (FunctionalState)pic_cfg.b.key_en;
+}
+
+static void ppe_sim_load_result(PPE_ResultLayer_InitTypeDef *result)
+{
+    PPE_LAYER0_WIN_SIZE_TypeDef win_size = {.d32 = PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE};
+    PPE_LAYER0_PIC_CFG_TypeDef pic_cfg = {.d32 = PPE_LAYER->RESULT_LAYER.LAYER0_PIC_CFG};
+
+    PPE_ResultLayer_StructInit(result);
+    result->src_addr = PPE_LAYER->RESULT_LAYER.LAYER0_ADDR_L;
+    result->width = win_size.b.width;
+    result->height = win_size.b.height;
+    result->line_len = pic_cfg.b.line_len;
+    result->format = (PPE_PIXEL_FORMAT)pic_cfg.b.format;
+}
+
+/* next PPE_LLI_NODE into the layers enabled in LL_CFG, one PPE_LLI_LAYER each with the result
+   layer first, then LLP. Returns false at the end of the list */
+static bool ppe_sim_load_lli(void)
+{
+    PPE_LL_CFG_TypeDef ll_cfg = {.d32 = PPE->LL_CFG};
+    if ((ll_cfg.b.layer_ll_en == 0) || (PPE->LLP == 0))
+    {
+        return false;
+    }
+    PPE_LLI_LAYER *lli = (PPE_LLI_LAYER *)PPE_SIM_ADDR(PPE->LLP);
+    if (ll_cfg.b.layer_ll_en & BIT0)
+    {
+        PPE_LAYER->RESULT_LAYER.LAYER0_ADDR_L = lli->LAYER_ADDR;
+        PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE = lli->LAYER_WINSIZE;
+        lli++;
+    }
+    for (uint8_t i = 0; i < PPE_SIM_INPUT_LAYER_MAX; i++)
+    {
+        if (ll_cfg.b.layer_ll_en & BIT(i + 1))
+        {
+            PPE_LAYER->INPUT_LAYER[i].LAYERx_ADDR_L = lli->LAYER_ADDR;
+            PPE_LAYER->INPUT_LAYER[i].LAYERx_POS = lli->LAYER_POS;
+            PPE_LAYER->INPUT_LAYER[i].LAYERx_WIN_SIZE = lli->LAYER_WINSIZE;
+            PPE_LAYER->INPUT_LAYER[i].LAYERx_CONST_PIX = lli->LAYER_CONST_PIX;
+            lli++;
+        }
+    }
+    PPE->LLP = *(uint32_t *)lli;
+    return true;
+}
+
+/*============================================================================*
+ *                           Public Functions
+ *============================================================================*/
+uint32_t PPE_Simulation_Get_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                  uint32_t x, uint32_t y, uint32_t const_pixel)
+{
+    const ppe_sim_format_t *f = &ppe_sim_format[format];
+    uint32_t word = ppe_sim_read(addr, line_len, f->len, x, y);
+
+    if (format == PPE_A8)
+    {
+        return (const_pixel & 0xFFFFFF) | (word << 24);
+    }
+    if (format == PPE_X8)
+    {
+        return const_pixel | 0xFF000000;
+    }
+    return (ppe_sim_expand(word, f->a, 0xFF) << 24) | (ppe_sim_expand(word, f->b, 0) << 16) |
+           (ppe_sim_expand(word, f->g, 0) << 8) | ppe_sim_expand(word, f->r, 0);
+}
+
+PPE_ERR PPE_Simulation_Set_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                 uint32_t x, uint32_t y, uint32_t color)
+{
+    if (!ppe_sim_format_valid(format))
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+    const ppe_sim_format_t *f = &ppe_sim_format[format];
+    uint32_t word = ppe_sim_narrow(color >> 24, f->a) | ppe_sim_narrow((color >> 16) & 0xFF, f->b) |
+                    ppe_sim_narrow((color >> 8) & 0xFF, f->g) | ppe_sim_narrow(color & 0xFF, f->r);
+
+    ppe_sim_write(addr, line_len, f->len, x, y, word);
+    return PPE_SUCCESS;
+}
+
+PPE_ERR PPE_Simulation(PPE_InitTypeDef *init, PPE_ResultLayer_InitTypeDef *result,
+                       PPE_InputLayer_InitTypeDef *input, uint32_t sca_ratio_x, uint32_t sca_ratio_y)
+{
+    uint32_t layer_num = (init->function == PPE_FUNCTION_SCALE) ? 1 : init->blend_layer_num;
+
+    if (!IS_PPE_FUNCTION(init->function) || (layer_num == 0) ||
+        (layer_num > PPE_SIM_INPUT_LAYER_MAX))
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+    if (!ppe_sim_format_valid(result->format))
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+    for (uint32_t i = 0; i < layer_num; i++)
+    {
+        if ((input[i].src == PPE_LAYER_SRC_FROM_DMA) && !ppe_sim_format_valid(input[i].format))
+        {
+            return PPE_ERROR_UNKNOWN_FORMAT;
+        }
+    }
+
+    if (init->function == PPE_FUNCTION_SCALE)
+    {
+        if ((input->width == 0) || (input->height == 0))
+        {
+            return PPE_SUCCESS;
+        }
+        for (uint32_t y = 0; y < result->height; y++)
+        {
+            uint32_t sy = MIN((uint32_t)(((uint64_t)y * sca_ratio_y) >> 16), input->height - 1);
+            for (uint32_t x = 0; x < result->width; x++)
+            {
+                uint32_t sx = MIN((uint32_t)(((uint64_t)x * sca_ratio_x) >> 16), input->width - 1);
+                uint32_t color = (input->src == PPE_LAYER_SRC_CONST) ? input->const_ABGR8888_value :
+                                 PPE_Simulation_Get_Pixel(input->src_addr, input->line_len,
+                                                          input->format, sx, sy,
+                                                          input->const_ABGR8888_value);
+                PPE_Simulation_Set_Pixel(result->src_addr, result->line_len, result->format, x, y,
+                                         color);
+            }
+        }
+        return PPE_SUCCESS;
+    }
+
+    for (uint32_t y = 0; y < result->height; y++)
+    {
+        for (uint32_t x = 0; x < result->width; x++)
+        {
+            /* layer 1 is the background, it is taken as it is */
+            uint32_t color = 0;
+            uint32_t src;
+
+            if (ppe_sim_fetch(&input[0], x, y, &src))
+            {
+                color = src;
+            }
+            for (uint32_t i = 1; i < layer_num; i++)
+            {
+                if (!ppe_sim_fetch(&input[i], x, y, &src))
+                {
+                    continue;
+                }
+                uint32_t alpha = src >> 24;
+                if (input[i].src == PPE_LAYER_SRC_FROM_DMA)
+                {
+                    alpha = alpha * (input[i].const_ABGR8888_value >> 24) / 255;
+                }
+                if (alpha == 0)
+                {
+                    continue;
+                }
+                color = (alpha < 0xFF) ? ppe_sim_blend(src, color, alpha) : src;
+            }
+            PPE_Simulation_Set_Pixel(result->src_addr, result->line_len, result->format, x, y, color);
+        }
+    }
+    return PPE_SUCCESS;
+}
+
+void PPE_Simulation_Run(void)
+{
+    PPE_FUNC_CFG_TypeDef func_cfg = {.d32 = PPE->FUNC_CFG};
+    PPE_InitTypeDef init = {.function = func_cfg.b.func_sel, .blend_layer_num = func_cfg.b.blend_lay};
+    PPE_ResultLayer_InitTypeDef result;
+    PPE_InputLayer_InitTypeDef input[PPE_SIM_INPUT_LAYER_MAX];
+    uint32_t layer_num = (init.function == PPE_FUNCTION_SCALE) ? 1 :
+                         MIN(init.blend_layer_num, PPE_SIM_INPUT_LAYER_MAX);
+
+    do
+    {
+        ppe_sim_load_result(&result);
+        for (uint8_t i = 0; i < layer_num; i++)
+        {
+            ppe_sim_load_input(i + 1, &input[i]);
+        }
+        PPE_Simulation(&init, &result, input, PPE->SCA_RATIO_X, PPE->SCA_RATIO_Y);
+    }
+    while (ppe_sim_load_lli());
+
+    /* job end: glb_en drops and the frame and all over interrupts are raised, clears written to
+       INTR_CLR since the last job are applied first as the register file cannot see them */
+    PPE->GLB_CTL &= ~BIT0;
+    PPE->INTR_RAW = (PPE->INTR_RAW & ~PPE->INTR_CLR) | PPE_ALL_OVER_INT | PPE_FR_OVER_INT;
+    PPE->INTR_CLR = 0;
+    PPE->INTR_ST = PPE->INTR_RAW & ~PPE->INTR_MASK;
+}
+
+/******************* (C) COPYRIGHT 2024 Realtek Semiconductor Corporation *****END OF FILE****/
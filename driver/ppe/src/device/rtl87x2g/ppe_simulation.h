@@ -0,0 +1,113 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     ppe_simulation.h
+* \brief    Software model of the RTL87x2G PPE datapath.
+* \details  PPE_Simulation takes the same init structs that are programmed into the PPE registers
+*           and renders the result layer on the CPU, so compositions can be checked and profiled
+*           on a host without silicon.
+*           Built with PPE_SIM_BACKEND set, PPE_Cmd(ENABLE) calls PPE_Simulation_Run instead of
+*           starting the engine, so every PPE_* call runs on the model. The model is checked
+*           against the driver's CPU kernels, not against silicon.
+*********************************************************************************************************
+*/
+
+/*============================================================================*
+ *               Define to prevent recursive inclusion
+ *============================================================================*/
+#ifndef PPE_SIMULATION_H
+#define PPE_SIMULATION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================*
+ *                        Header Files
+ *============================================================================*/
+#include "rtl_ppe.h"
+
+/*============================================================================*
+ *                         Constants
+ *============================================================================*/
+/* src_addr values are 32 bit, a host build that keeps buffers above 4GB can map them to real
+   pointers by redefining this */
+#ifndef PPE_SIM_ADDR
+#define PPE_SIM_ADDR(addr)      ((uint8_t *)(uintptr_t)(addr))
+#endif
+
+/* input layers in the register file, blend_lay counts up to this many */
+#define PPE_SIM_INPUT_LAYER_MAX 15
+
+/*============================================================================*
+ *                         Functions
+ *============================================================================*/
+/**
+ * \brief  Render the result window the way PPE does for the given layer setup
+ * \note   PPE_FUNCTION_ALPHA_BLEND: input[0] is copied into the result, keyed pixels read as
+ *         0. input[1] to input[blend_layer_num - 1] are then blended on top in order, the
+ *         alpha of a DMA pixel is scaled by const_ABGR8888_value alpha and a const layer uses
+ *         const_ABGR8888_value itself. Keyed or fully transparent pixels leave the result as
+ *         it is. A layer covers [start_x, start_x + width) x [start_y, start_y + height) of
+ *         the result window.
+ *         PPE_FUNCTION_SCALE: result pixel (x, y) is input[0] pixel
+ *         ((x * sca_ratio_x) >> 16, (y * sca_ratio_y) >> 16), nearest neighbour.
+ *         line_len is in pixels, as the driver programs it.
+ * \param[in] init          function and blend_layer_num.
+ * \param[in] result        result layer setup, src_addr is written.
+ * \param[in] input         array of input layer setups, input[0] is layer 1.
+ * \param[in] sca_ratio_x   SCA_RATIO_X, source step per result pixel in Q16.16.
+ * \param[in] sca_ratio_y   SCA_RATIO_Y, source step per result line in Q16.16.
+ * \return operation result
+ * \retval PPE_SUCCESS                 Operation success.
+ * \retval PPE_ERROR_UNKNOWN_FORMAT    result or input format is not a PPE format.
+ * \retval PPE_ERROR_INVALID_PARAM     function or blend_layer_num is out of range.
+ */
+PPE_ERR PPE_Simulation(PPE_InitTypeDef *init, PPE_ResultLayer_InitTypeDef *result,
+                       PPE_InputLayer_InitTypeDef *input, uint32_t sca_ratio_x, uint32_t sca_ratio_y);
+
+/**
+ * \brief  Read one pixel of a buffer as ABGR8888
+ * \param[in] addr          buffer address.
+ * \param[in] line_len      line length in pixels.
+ * \param[in] format        pixel format, A8/X8 take BGR from const_pixel.
+ * \param[in] x             column.
+ * \param[in] y             row.
+ * \param[in] const_pixel   ABGR8888 constant color of the layer.
+ * \return pixel in ABGR8888, formats without alpha are opaque
+ */
+uint32_t PPE_Simulation_Get_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                  uint32_t x, uint32_t y, uint32_t const_pixel);
+
+/**
+ * \brief  Write one ABGR8888 pixel to a buffer
+ * \param[in] addr          buffer address.
+ * \param[in] line_len      line length in pixels.
+ * \param[in] format        pixel format.
+ * \param[in] x             column.
+ * \param[in] y             row.
+ * \param[in] color         pixel in ABGR8888, narrowed channels drop their low bits.
+ * \return operation result
+ * \retval PPE_SUCCESS                 Operation success.
+ * \retval PPE_ERROR_UNKNOWN_FORMAT    format is not a PPE format.
+ */
+PPE_ERR PPE_Simulation_Set_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                 uint32_t x, uint32_t y, uint32_t color);
+
+/**
+ * \brief  Run the job programmed in the PPE registers on the model
+ * \note   Reads the result layer, the input layers, FUNC_CFG and SCA_RATIO back from the
+ *         registers and renders them with PPE_Simulation. While LL_CFG has layers enabled and
+ *         LLP is not 0, the next PPE_LLI_NODE is loaded into those layers and rendered too.
+ *         GLB_CTL and INTR_RAW are left as the engine leaves them when all frames are over.
+ */
+void PPE_Simulation_Run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PPE_SIMULATION_H */
+
+/******************* (C) COPYRIGHT 2024 Realtek Semiconductor Corporation *****END OF FILE****/
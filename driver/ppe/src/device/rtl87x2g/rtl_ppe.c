@@ -15,8 +15,16 @@
  *                        Header Files
  *============================================================================*/
 #include "rtl_ppe.h"
+#if PPE_PERF_EN
+#include "stdio.h"
+#endif
 #include "rtl_rcc.h"
+#include "rtl_nvic.h"
 #include "stddef.h"
+#include "string.h"
+#if PPE_SIM_BACKEND
+#include "ppe_simulation.h"
+#endif
 
 /*============================================================================*
  *                          Private Macros
@@ -24,854 +32,3007 @@
 #define MIN(x, y)           (((x)<(y))?(x):(y))
 #define MAX(x, y)           (((x)>(y))?(x):(y))
 
+/*lanes of a 32 bit word holding two 8 bit channels, or the three fields of a spread RGB565 pixel*/
+#define PPE_SW_MASK_RB          0x00FF00FFU
+#define PPE_SW_MASK_565         0x07E0F81FU
+
+#ifndef PPE_REG_SHADOW_EN
+#define PPE_REG_SHADOW_EN       1
+#endif
+
+/*drop or shrink blend_multi layers hidden under opaque layers above them*/
+#ifndef PPE_OCCLUSION_CULL_EN
+#define PPE_OCCLUSION_CULL_EN   1
+#endif
+
+/*number of upcoming layers PPE_blend_layers looks at when it groups the layers of a pass, 32 at most*/
+#ifndef PPE_BLEND_LOOKAHEAD
+#define PPE_BLEND_LOOKAHEAD     16
+#endif
+
+/*widest line ppe_convert can error diffuse, sets the size of the error line buffer*/
+#ifndef PPE_CONVERT_LINE_MAX
+#define PPE_CONVERT_LINE_MAX    480
+#endif
+
+/*side of the square tiles PPE_Blit_Orient walks when a rotation reads src down its columns*/
+#ifndef PPE_ORIENT_TILE_SIZE
+#define PPE_ORIENT_TILE_SIZE    32
+#endif
+
+/*job timing counters, timestamps come from the DWT cycle counter unless the platform provides
+  another free running 32 bit counter as PPE_PERF_TIMESTAMP()*/
+#include "rtl_ppe_perf.h"
+#if PPE_PERF_EN
+#define PPE_PERF_BEGIN(op)      PPE_Perf_Begin(op)
+#define PPE_PERF_START()        PPE_Perf_Start()
+#define PPE_PERF_DONE()         PPE_Perf_Done()
+#else
+#define PPE_PERF_BEGIN(op)
+#define PPE_PERF_START()
+#define PPE_PERF_DONE()
+#endif
+
 /*============================================================================*
- *                           Public Functions
+ *                          Private Variables
  *============================================================================*/
-bool ppe_rect_intersect(ppe_rect_t *result_rect, ppe_rect_t *rect1, ppe_rect_t *rect2)
+static volatile ppe_job_t ppe_job_issued = PPE_JOB_INVALID;
+static volatile ppe_job_t ppe_job_done = PPE_JOB_INVALID;
+static ppe_job_callback_t ppe_job_callback = NULL;
+static void *ppe_job_user_data = NULL;
+static bool ppe_job_async = false;
+static bool ppe_job_started = false;
+static ppe_cmdlist_t *ppe_job_cmdlist = NULL;
+static uint32_t ppe_sw_threshold = PPE_SW_THRESHOLD_PIXELS;
+/*error carried to the next line by PPE_DITHER_DIFFUSION, per R/G/B channel, index x + 1 holds
+  the error for column x*/
+static int16_t ppe_sw_diffuse[3][PPE_CONVERT_LINE_MAX + 1];
+
+/*channel layout of every format, shift and width of each channel in the pixel word read in
+  little endian order, width 0 means the channel is not stored*/
+typedef struct
 {
-//     if(result_rect == NULL || rect1 == NULL || rect2 == NULL)
-//     {
-//         return false;
-//     }
-    result_rect->left = MAX(rect1->left, rect2->left);
-    result_rect->top = MAX(rect1->top, rect2->top);
-    result_rect->right = MIN(rect1->right, rect2->right);
-    result_rect->bottom = MIN(rect1->bottom, rect2->bottom);
-    if (result_rect->top > result_rect->bottom || result_rect->left > result_rect->right)
-    {
-        return false;
-    }
-    else
+    uint8_t shift;
+    uint8_t bits;
+} ppe_sw_channel_t;
+
+typedef struct
+{
+    ppe_sw_channel_t a;
+    ppe_sw_channel_t r;
+    ppe_sw_channel_t g;
+    ppe_sw_channel_t b;
+} ppe_sw_format_t;
+
+static const ppe_sw_format_t ppe_sw_format[PPE_RGBX6668 + 1] =
+{
+    [PPE_ABGR8888] = {{24, 8}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_ARGB8888] = {{24, 8}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_XBGR8888] = {{0, 0}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_XRGB8888] = {{0, 0}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_BGRA8888] = {{0, 8}, {8, 8}, {16, 8}, {24, 8}},
+    [PPE_RGBA8888] = {{0, 8}, {24, 8}, {16, 8}, {8, 8}},
+    [PPE_BGRX8888] = {{0, 0}, {8, 8}, {16, 8}, {24, 8}},
+    [PPE_RGBX8888] = {{0, 0}, {24, 8}, {16, 8}, {8, 8}},
+    [PPE_ABGR4444] = {{12, 4}, {0, 4}, {4, 4}, {8, 4}},
+    [PPE_ARGB4444] = {{12, 4}, {8, 4}, {4, 4}, {0, 4}},
+    [PPE_XBGR4444] = {{0, 0}, {0, 4}, {4, 4}, {8, 4}},
+    [PPE_XRGB4444] = {{0, 0}, {8, 4}, {4, 4}, {0, 4}},
+    [PPE_BGRA4444] = {{0, 4}, {4, 4}, {8, 4}, {12, 4}},
+    [PPE_RGBA4444] = {{0, 4}, {12, 4}, {8, 4}, {4, 4}},
+    [PPE_BGRX4444] = {{0, 0}, {4, 4}, {8, 4}, {12, 4}},
+    [PPE_RGBX4444] = {{0, 0}, {12, 4}, {8, 4}, {4, 4}},
+    [PPE_ABGR2222] = {{6, 2}, {0, 2}, {2, 2}, {4, 2}},
+    [PPE_ARGB2222] = {{6, 2}, {4, 2}, {2, 2}, {0, 2}},
+    [PPE_XBGR2222] = {{0, 0}, {0, 2}, {2, 2}, {4, 2}},
+    [PPE_XRGB2222] = {{0, 0}, {4, 2}, {2, 2}, {0, 2}},
+    [PPE_BGRA2222] = {{0, 2}, {2, 2}, {4, 2}, {6, 2}},
+    [PPE_RGBA2222] = {{0, 2}, {6, 2}, {4, 2}, {2, 2}},
+    [PPE_BGRX2222] = {{0, 0}, {2, 2}, {4, 2}, {6, 2}},
+    [PPE_RGBX2222] = {{0, 0}, {6, 2}, {4, 2}, {2, 2}},
+    [PPE_ABGR8565] = {{16, 8}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_ARGB8565] = {{16, 8}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_XBGR8565] = {{0, 0}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_XRGB8565] = {{0, 0}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_BGRA5658] = {{0, 8}, {8, 5}, {13, 6}, {19, 5}},
+    [PPE_RGBA5658] = {{0, 8}, {19, 5}, {13, 6}, {8, 5}},
+    [PPE_BGRX5658] = {{0, 0}, {8, 5}, {13, 6}, {19, 5}},
+    [PPE_RGBX5658] = {{0, 0}, {19, 5}, {13, 6}, {8, 5}},
+    [PPE_ABGR1555] = {{15, 1}, {0, 5}, {5, 5}, {10, 5}},
+    [PPE_ARGB1555] = {{15, 1}, {10, 5}, {5, 5}, {0, 5}},
+    [PPE_XBGR1555] = {{0, 0}, {0, 5}, {5, 5}, {10, 5}},
+    [PPE_XRGB1555] = {{0, 0}, {10, 5}, {5, 5}, {0, 5}},
+    [PPE_BGRA5551] = {{0, 1}, {1, 5}, {6, 5}, {11, 5}},
+    [PPE_RGBA5551] = {{0, 1}, {11, 5}, {6, 5}, {1, 5}},
+    [PPE_BGRX5551] = {{0, 0}, {1, 5}, {6, 5}, {11, 5}},
+    [PPE_RGBX5551] = {{0, 0}, {11, 5}, {6, 5}, {1, 5}},
+    [PPE_BGR888] = {{0, 0}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_RGB888] = {{0, 0}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_BGR565] = {{0, 0}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_RGB565] = {{0, 0}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_A8] = {{0, 8}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_X8] = {{0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_ABGR8666] = {{18, 8}, {0, 6}, {6, 6}, {12, 6}},
+    [PPE_ARGB8666] = {{18, 8}, {12, 6}, {6, 6}, {0, 6}},
+    [PPE_XBGR8666] = {{0, 0}, {0, 6}, {6, 6}, {12, 6}},
+    [PPE_XRGB8666] = {{0, 0}, {12, 6}, {6, 6}, {0, 6}},
+    [PPE_BGRA6668] = {{0, 8}, {8, 6}, {14, 6}, {20, 6}},
+    [PPE_RGBA6668] = {{0, 8}, {20, 6}, {14, 6}, {8, 6}},
+    [PPE_BGRX6668] = {{0, 0}, {8, 6}, {14, 6}, {20, 6}},
+    [PPE_RGBX6668] = {{0, 0}, {20, 6}, {14, 6}, {8, 6}},
+};
+
+/*============================================================================*
+ *                          Private Functions
+ *============================================================================*/
+static void PPE_CmdList_LoadRun(ppe_cmdlist_t *list);
+static void PPE_CmdList_Finish(void);
+static PPE_ERR PPE_Damage_ClipLayer(ppe_layer_t *layer, ppe_rect_t *area, ppe_layer_t *sub);
+static bool ppe_layer_target_rect(ppe_layer_t *layer, ppe_layer_t *output, ppe_rect_t *rect);
+
+/*layer registers are mirrored in blocks of 0x40 bytes starting at PPE_CFG_REG_BASE, a word is only
+  trusted after it was read or written through the shadow*/
+#if PPE_REG_SHADOW_EN
+#define PPE_SHADOW_LAYER_SHIFT  6
+#define PPE_SHADOW_LAYER_WORDS  9
+#define PPE_SHADOW_LAYER_NUM    16
+
+static uint32_t ppe_shadow[PPE_SHADOW_LAYER_NUM][PPE_SHADOW_LAYER_WORDS];
+static uint16_t ppe_shadow_valid[PPE_SHADOW_LAYER_NUM];
+#endif
+static ppe_reg_stat_t ppe_reg_stat;
+
+#if PPE_PERF_EN
+static ppe_perf_stat_t ppe_perf;
+static PPE_PERF_OP ppe_perf_op = PPE_PERF_OP_OTHER;
+static uint32_t ppe_perf_mark = 0;      /* API entry or end of the previous job */
+static bool ppe_perf_running = false;
+static PPE_PERF_OP ppe_perf_job_op;
+static uint32_t ppe_perf_job_start;
+static uint32_t ppe_perf_job_setup;
+static uint32_t ppe_perf_job_pixels;
+static uint32_t ppe_perf_job_read;
+static uint32_t ppe_perf_job_write;
+#endif
+
+static uint32_t PPE_Shadow_Read(volatile uint32_t *reg)
+{
+#if PPE_REG_SHADOW_EN
+    uint32_t offset = (uint32_t)reg - PPE_CFG_REG_BASE;
+    uint32_t layer = offset >> PPE_SHADOW_LAYER_SHIFT;
+    uint32_t word = (offset & ((1UL << PPE_SHADOW_LAYER_SHIFT) - 1)) >> 2;
+
+    if (!(ppe_shadow_valid[layer] & (1UL << word)))
     {
-        return true;
+        ppe_shadow[layer][word] = *reg;
+        ppe_shadow_valid[layer] |= (1UL << word);
     }
+    return ppe_shadow[layer][word];
+#else
+    return *reg;
+#endif
 }
 
-void PPE_Cmd(FunctionalState state)
+static void PPE_Shadow_Write(volatile uint32_t *reg, uint32_t value)
 {
-    //PPE cannot be disabled by user
-    if (state)
+#if PPE_REG_SHADOW_EN
+    uint32_t offset = (uint32_t)reg - PPE_CFG_REG_BASE;
+    uint32_t layer = offset >> PPE_SHADOW_LAYER_SHIFT;
+    uint32_t word = (offset & ((1UL << PPE_SHADOW_LAYER_SHIFT) - 1)) >> 2;
+
+    if ((ppe_shadow_valid[layer] & (1UL << word)) && (ppe_shadow[layer][word] == value))
     {
-        PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
-        ppe_reg_0x400.b.glb_en = state;
-        PPE->GLB_CTL = ppe_reg_0x400.d32;
+        ppe_reg_stat.skip_cnt++;
+        return;
     }
+    ppe_shadow[layer][word] = value;
+    ppe_shadow_valid[layer] |= (1UL << word);
+#endif
+    *reg = value;
+    ppe_reg_stat.write_cnt++;
 }
 
-void PPE_Suspend(void)
+#if PPE_PERF_EN
+static void PPE_Perf_Begin(PPE_PERF_OP op)
 {
-    PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
-    ppe_reg_0x400.b.susp = SET;
-    PPE->GLB_CTL = ppe_reg_0x400.d32;
+    ppe_perf.op[op].call_cnt++;
+    ppe_perf_op = op;
+    ppe_perf_mark = PPE_PERF_TIMESTAMP();
 }
 
-void PPE_Resume(void)
+/*pixels and bytes of the job about to start, taken from the layers it was programmed with*/
+static void PPE_Perf_Traffic(void)
 {
-    PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
-    if (ppe_reg_0x400.b.all_inact)
+    PPE_FUNC_CFG_TypeDef ppe_reg_0x404 = {.d32 = PPE->FUNC_CFG};
+    PPE_LAYER0_WIN_SIZE_TypeDef ppe_reg_0x0c = {.d32 = PPE_Shadow_Read(&PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE)};
+    PPE_LAYER0_PIC_CFG_TypeDef ppe_reg_0x14 = {.d32 = PPE_Shadow_Read(&PPE_LAYER->RESULT_LAYER.LAYER0_PIC_CFG)};
+    uint8_t layer_num = ppe_reg_0x404.b.blend_lay;
+
+    if (ppe_reg_0x404.b.func_sel == PPE_FUNCTION_SCALE)
     {
-        ppe_reg_0x400.b.resume = SET;
-        PPE->GLB_CTL = ppe_reg_0x400.d32;
+        layer_num = 1;
     }
-}
-
-void PPE_Abort(void)
-{
-    PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
-    if (ppe_reg_0x400.b.all_inact)
+    ppe_perf_job_pixels = ppe_reg_0x0c.b.width * ppe_reg_0x0c.b.height;
+    ppe_perf_job_write = ppe_perf_job_pixels * ppe_get_format_data_len((PPE_PIXEL_FORMAT)ppe_reg_0x14.b.format);
+    ppe_perf_job_read = 0;
+    for (uint8_t i = 0; (i < layer_num) && (i < PPE_INPUT_LAYER_MAX); i++)
     {
-        ppe_reg_0x400.b.abort = SET;
-        PPE->GLB_CTL = ppe_reg_0x400.d32;
+        PPE_LAYERX_PIC_CFG_TypeDef ppe_reg_0x54 = {.d32 = PPE_Shadow_Read(&PPE_LAYER->INPUT_LAYER[i].LAYERx_PIC_CFG)};
+        PPE_LAYERX_WIN_SIZE_TypeDef ppe_reg_0x4c = {.d32 = PPE_Shadow_Read(&PPE_LAYER->INPUT_LAYER[i].LAYERx_WIN_SIZE)};
+        if (ppe_reg_0x54.b.pix_src == PPE_LAYER_SRC_FROM_DMA)
+        {
+            ppe_perf_job_read += ppe_reg_0x4c.b.width * ppe_reg_0x4c.b.height *
+                                 ppe_get_format_data_len((PPE_PIXEL_FORMAT)ppe_reg_0x54.b.format);
+        }
     }
 }
 
-ITStatus PPE_ChannelInactiveCheck(uint8_t chn_id)
+static void PPE_Perf_Done(void)
 {
-    assert_param(IS_PPE_CHN_INDEX(chn_id));
-    ITStatus rv = RESET;
-    PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
-    if (ppe_reg_0x400.b.chn_inact & (BIT0 << chn_id))
+    uint32_t now = PPE_PERF_TIMESTAMP();
+    ppe_perf_op_t *op = &ppe_perf.op[ppe_perf_job_op];
+    uint32_t latency;
+
+    if (!ppe_perf_running)
     {
-        rv = SET;
+        return;
     }
-    return rv;
-}
+    ppe_perf_running = false;
+    ppe_perf_mark = now;
+    latency = ppe_perf_job_setup + (now - ppe_perf_job_start);
 
-void PPE_Secure(FunctionalState state)
-{
-    PPE_MISC_TypeDef ppe_reg_0x420 = {.d32 = PPE->MISC};
-    if (state)
+    op->job_cnt++;
+    op->setup_time += ppe_perf_job_setup;
+    op->exec_time += now - ppe_perf_job_start;
+    if ((op->job_cnt == 1) || (latency < op->latency_min))
     {
-        ppe_reg_0x420.b.secure = SET;
+        op->latency_min = latency;
     }
-    else
+    if (latency > op->latency_max)
     {
-        ppe_reg_0x420.b.secure = RESET;
+        op->latency_max = latency;
     }
-    PPE->MISC = ppe_reg_0x420.d32;
+    op->pixels += ppe_perf_job_pixels;
+    op->read_bytes += ppe_perf_job_read;
+    op->write_bytes += ppe_perf_job_write;
+    op->hist[ppe_perf_bin(latency)]++;
 }
 
-ITStatus PPE_GetINTStatus(uint32_t PPE_INT)
+static void PPE_Perf_Start(void)
 {
-    //assert_param(IS_PPE_INT(PPE_INT));
-    ITStatus bit_status = RESET;
-    if (PPE->INTR_ST & PPE_INT)
+    if (ppe_perf_running)
     {
-        bit_status = SET;
+        /*nobody waited for the previous job, PPE only takes a new one after it ended*/
+        PPE_Perf_Done();
     }
-    return bit_status;
+    PPE_Perf_Traffic();
+    ppe_perf_job_op = ppe_perf_op;
+    ppe_perf_running = true;
+    ppe_perf_job_start = PPE_PERF_TIMESTAMP();
+    ppe_perf_job_setup = ppe_perf_job_start - ppe_perf_mark;
 }
+#endif
 
-ITStatus PPE_GetINTStatusRaw(uint32_t PPE_INT)
+/*stride is counted in pixels, 0 or any value below width means the buffer is tightly packed*/
+static uint32_t ppe_buffer_stride(ppe_buffer_t *buffer)
 {
-    //assert_param(IS_PPE_INT(PPE_INT));
-    ITStatus bit_status = RESET;
-    if (PPE->INTR_RAW & PPE_INT)
+    if (buffer->stride > buffer->width)
     {
-        bit_status = SET;
+        return buffer->stride;
     }
-    return bit_status;
+    return buffer->width;
 }
 
-void PPE_ClearINTPendingBit(uint32_t PPE_INT)
+static ppe_job_t PPE_JobNextID(void)
 {
-    //assert_param(IS_PPE_INT(PPE_INT));
-    PPE->INTR_CLR |= PPE_INT;
+    ppe_job_t id = ppe_job_issued + 1;
+    if (id == PPE_JOB_INVALID)
+    {
+        id++;
+    }
+    return id;
 }
 
-void PPE_MaskINTConfig(uint32_t PPE_INT_MSK, FunctionalState NewState)
+static void PPE_JobComplete(void)
 {
-    /* Check the parameters */
-    //assert_param(IS_PPE_INT(PPE_INT_MSK));
-    //assert_param(IS_FUNCTIONAL_STATE(NewState));
-    if (NewState == ENABLE)
+    ppe_job_callback_t callback = ppe_job_callback;
+    void *user_data = ppe_job_user_data;
+
+    ppe_job_callback = NULL;
+    ppe_job_user_data = NULL;
+    ppe_job_done = ppe_job_issued;
+    if (callback != NULL)
     {
-        PPE->INTR_MASK |= PPE_INT_MSK;
+        callback(ppe_job_done, user_data);
     }
-    else
+}
+
+static void PPE_JobFinish(void)
+{
+    PPE_PERF_DONE();
+    PPE_ClearINTPendingBit(PPE_ALL_OVER_INT);
+    if (ppe_job_cmdlist != NULL)
     {
-        PPE->INTR_MASK &= ~PPE_INT_MSK;
+        if (ppe_job_cmdlist->run_start < ppe_job_cmdlist->cmd_num)
+        {
+            PPE_CmdList_LoadRun(ppe_job_cmdlist);
+            PPE_Cmd(ENABLE);
+            return;
+        }
+        PPE_CmdList_Finish();
+        ppe_job_cmdlist = NULL;
     }
+    PPE_MaskINTConfig(PPE_ALL_OVER_INT, ENABLE);
+    PPE_JobComplete();
 }
 
-void PPE_AutoReloadCmd(FunctionalState NewState)
+/*retire a finished job from GLB_CTL and the raw interrupt state, so waiting does not depend on
+  PPE_JobIRQHandler being wired to the PPE interrupt*/
+static void PPE_JobService(void)
 {
-    //assert_param(IS_FUNCTIONAL_STATE(NewState));
-    PPE_RELOAD_CFG_TypeDef ppe_reg_0x408 = {.d32 = PPE->RELOAD_CFG};
-    if (NewState)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if ((ppe_job_done != ppe_job_issued) && !(PPE->GLB_CTL & BIT0) &&
+        (PPE_GetINTStatusRaw(PPE_ALL_OVER_INT) == SET))
     {
-        ppe_reg_0x408.b.layer_reload_en = SET;
+        PPE_JobFinish();
     }
-    else
+    __set_PRIMASK(primask);
+}
+
+/*registers must not be touched while an asynchronous job is still running*/
+static void PPE_WaitIdle(void)
+{
+    while (ppe_job_done != ppe_job_issued)
     {
-        ppe_reg_0x408.b.layer_reload_en = RESET;
+        PPE_JobService();
     }
-    PPE->RELOAD_CFG = ppe_reg_0x408.d32;
 }
 
-void PPE_AutoClearCmd(FunctionalState NewState)
+static void PPE_Start(void)
 {
-    //assert_param(IS_FUNCTIONAL_STATE(NewState));
-    PPE_RELOAD_CFG_TypeDef ppe_reg_0x408 = {.d32 = PPE->RELOAD_CFG};
-    if (NewState)
+    if (ppe_job_async)
     {
-        ppe_reg_0x408.b.auto_clr = SET;
+        ppe_job_started = true;
+        ppe_job_issued = PPE_JobNextID();
+        PPE_ClearINTPendingBit(PPE_ALL_OVER_INT);
+        PPE_MaskINTConfig(PPE_ALL_OVER_INT, DISABLE);
+        PPE_Cmd(ENABLE);
     }
     else
     {
-        ppe_reg_0x408.b.auto_clr = RESET;
+        PPE_Cmd(ENABLE);
+        while (PPE->GLB_CTL & BIT0);
+        PPE_PERF_DONE();
     }
-    PPE->RELOAD_CFG = ppe_reg_0x408.d32;
 }
 
-void PPE_SetValid(FunctionalState NewState)
+static void PPE_JobBegin(ppe_job_callback_t callback, void *user_data)
 {
-    //assert_param(IS_FUNCTIONAL_STATE(NewState));
-    PPE_RELOAD_CFG_TypeDef ppe_reg_0x408 = {.d32 = PPE->RELOAD_CFG};
-    if (NewState)
+    PPE_WaitIdle();
+    ppe_job_callback = callback;
+    ppe_job_user_data = user_data;
+    ppe_job_started = false;
+    ppe_job_async = true;
+}
+
+static PPE_ERR PPE_JobEnd(PPE_ERR err, ppe_job_t *job)
+{
+    ppe_job_async = false;
+    if (!ppe_job_started)
     {
-        ppe_reg_0x408.b.set_valid = SET;
+        /*nothing was sent to the engine, retire the job right away*/
+        if ((err != PPE_SUCCESS) && (err != PPE_SUCCESS_NOT_CHANGE))
+        {
+            ppe_job_callback = NULL;
+        }
+        ppe_job_issued = PPE_JobNextID();
+        PPE_JobComplete();
     }
-    else
+    if (job != NULL)
     {
-        ppe_reg_0x408.b.set_valid = RESET;
+        *job = ppe_job_issued;
     }
-    PPE->RELOAD_CFG = ppe_reg_0x408.d32;
+    return err;
 }
 
-void PPE_structInit(PPE_InitTypeDef *PPE_init_struct)
+/*A8 and X8 carry no color of their own and stay on PPE*/
+static bool ppe_sw_format_supported(PPE_PIXEL_FORMAT format)
 {
-    //assert_param(PPE_init_struct != NULL);
-    PPE_init_struct->function = PPE_FUNCTION_ALPHA_BLEND;
+    return (format <= PPE_RGBX6668) && (ppe_sw_format[format].g.bits != 0);
 }
 
-void PPE_InputLayer_StructInit(PPE_InputLayer_InitTypeDef *layer_init_struct)
+static bool ppe_sw_accept(ppe_rect_t *rect)
 {
-    layer_init_struct->byte_swap = PPE_NO_SWAP;
-    layer_init_struct->AXCACHE = 0;
-    layer_init_struct->AXSIZE = 0;
-    layer_init_struct->color_key_en = 0;
-    layer_init_struct->const_ABGR8888_value = 0xFFFFFFFF;
-    layer_init_struct->format = PPE_BGRA8888;
-    layer_init_struct->handshake_en = DISABLE;
-    layer_init_struct->height = 0;
-    layer_init_struct->width = 0;
-    layer_init_struct->start_x = 0;
-    layer_init_struct->start_y = 0;
-    layer_init_struct->polarity = PPE_POLARITY_HIGH;
+    uint32_t area = (rect->right - rect->left + 1) * (rect->bottom - rect->top + 1);
+    return area <= ppe_sw_threshold;
 }
 
-void PPE_ResultLayer_StructInit(PPE_ResultLayer_InitTypeDef *layer_init_struct)
+static uint32_t ppe_sw_read(const uint8_t *p, uint8_t len)
 {
-    layer_init_struct->byte_swap = PPE_NO_SWAP;
-    layer_init_struct->AXCACHE = 0;
-    layer_init_struct->AXSIZE = 0;
-    layer_init_struct->format = PPE_BGRA8888;
-    layer_init_struct->handshake_en = DISABLE;
-    layer_init_struct->height = 0;
-    layer_init_struct->width = 0;
-    layer_init_struct->polarity = PPE_POLARITY_HIGH;
+    switch (len)
+    {
+    case 4:
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    case 3:
+        return p[0] | (p[1] << 8) | (p[2] << 16);
+    case 2:
+        return p[0] | (p[1] << 8);
+    default:
+        return p[0];
+    }
 }
 
-void PPE_Init(PPE_InitTypeDef *PPE_init_struct)
+static void ppe_sw_write(uint8_t *p, uint8_t len, uint32_t value)
 {
-    //assert_param(PPE_init_struct != NULL);
-    //assert_param(IS_PPE_FUNCTION(PPE_init_struct->function));
-    PPE_FUNC_CFG_TypeDef ppe_reg_0x404 = {.d32 = PPE->FUNC_CFG};
-    switch (PPE_init_struct->function)
+    p[0] = value;
+    if (len > 1)
     {
-    case PPE_FUNCTION_ALPHA_BLEND:
-        {
-            //assert_param(IS_PPE_ALPHA_BLEND_LAYER_NUM(PPE_init_struct->blend_layer_num));
-            ppe_reg_0x404.b.func_sel = PPE_FUNCTION_ALPHA_BLEND;
-            ppe_reg_0x404.b.blend_lay = PPE_init_struct->blend_layer_num;
-            break;
-        }
-    case PPE_FUNCTION_SCALE:
-        {
-            ppe_reg_0x404.b.func_sel = PPE_FUNCTION_SCALE;
-            break;
-        }
+        p[1] = value >> 8;
+    }
+    if (len > 2)
+    {
+        p[2] = value >> 16;
+    }
+    if (len > 3)
+    {
+        p[3] = value >> 24;
     }
-    PPE->FUNC_CFG = ppe_reg_0x404.d32;
 }
 
-void PPE_InitInputLayer(uint8_t id, PPE_InputLayer_InitTypeDef *layer_init_struct)
+/*widen a channel to 8 bits by replicating its high bits, so full scale stays full scale*/
+static uint32_t ppe_sw_channel_get(uint32_t raw, ppe_sw_channel_t ch, uint32_t absent)
 {
-    uint8_t cov_layer_id = id - 1;
-    PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_ADDR_L = layer_init_struct->src_addr;
-    PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_CONST_PIX = layer_init_struct->const_ABGR8888_value;
-    PPE_LAYERX_POS_TypeDef ppe_reg_0x48 = {.d32 = PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_POS};
-    ppe_reg_0x48.b.start_x = layer_init_struct->start_x;
-    ppe_reg_0x48.b.start_y = layer_init_struct->start_y;
-    PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_POS = ppe_reg_0x48.d32;
-
-    PPE_LAYERX_WIN_SIZE_TypeDef ppe_reg_0x4c = {.d32 = PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_WIN_SIZE};
-    ppe_reg_0x4c.b.width = layer_init_struct->width;
-    ppe_reg_0x4c.b.height = layer_init_struct->height;
-    PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_WIN_SIZE = ppe_reg_0x4c.d32;
+    if (ch.bits == 0)
+    {
+        return absent;
+    }
+    uint32_t value = ((raw >> ch.shift) & ((1U << ch.bits) - 1)) << (8 - ch.bits);
+    for (uint32_t s = ch.bits; s < 8; s <<= 1)
+    {
+        value |= value >> s;
+    }
+    return value;
+}
 
-    PPE_LAYERX_PIC_CFG_TypeDef ppe_reg_0x54 = {.d32 = PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_PIC_CFG};
-    ppe_reg_0x54.b.pix_src = layer_init_struct->src;
-    ppe_reg_0x54.b.format = layer_init_struct->format;
-    ppe_reg_0x54.b.key_en = layer_init_struct->color_key_en;
-    ppe_reg_0x54.b.line_len = layer_init_struct->line_len;
-    PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_PIC_CFG = ppe_reg_0x54.d32;
+static uint32_t ppe_sw_channel_put(uint32_t value, ppe_sw_channel_t ch)
+{
+    if (ch.bits == 0)
+    {
+        return 0;
+    }
+    return (value >> (8 - ch.bits)) << ch.shift;
+}
 
-    PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_KEY_COLOR = layer_init_struct->key_color_value;
+/*raw pixel to ABGR8888, formats without alpha are opaque*/
+static uint32_t ppe_sw_decode(PPE_PIXEL_FORMAT format, uint32_t raw)
+{
+    const ppe_sw_format_t *f = &ppe_sw_format[format];
 
-    PPE_LAYERX_HS_CFG_TypeDef ppe_reg_0x60 = {.d32 = PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_HS_CFG};
-    ppe_reg_0x60.b.hw_index = layer_init_struct->hw_index;
-    ppe_reg_0x60.b.msize_log = layer_init_struct->handshake_msize;
-    ppe_reg_0x60.b.hs_en = layer_init_struct->handshake_en;
-    ppe_reg_0x60.b.polar = layer_init_struct->polarity;
-    ppe_reg_0x60.b.hwhs = layer_init_struct->handshake_mode;
-    PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_HS_CFG = ppe_reg_0x60.d32;
+    return (ppe_sw_channel_get(raw, f->a, 0xFF) << 24) | (ppe_sw_channel_get(raw, f->b, 0) << 16) |
+           (ppe_sw_channel_get(raw, f->g, 0) << 8) | ppe_sw_channel_get(raw, f->r, 0);
+}
 
-    PPE_LAYERX_BUS_CFG_TypeDef ppe_reg_0x5c = {.d32 = PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_BUS_CFG};
-    ppe_reg_0x5c.b.axcache = layer_init_struct->AXCACHE;
-    ppe_reg_0x5c.b.axsize = layer_init_struct->AXSIZE;
-    ppe_reg_0x5c.b.incr = layer_init_struct->INCR;
-    ppe_reg_0x5c.b.max_axlen_log = layer_init_struct->MAX_AXLEN_LOG;
-    ppe_reg_0x5c.b.prior = layer_init_struct->PRIOR;
-    PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_BUS_CFG = ppe_reg_0x5c.d32;
+static uint32_t ppe_sw_encode(PPE_PIXEL_FORMAT format, uint32_t abgr)
+{
+    const ppe_sw_format_t *f = &ppe_sw_format[format];
 
+    return ppe_sw_channel_put(abgr >> 24, f->a) | ppe_sw_channel_put((abgr >> 16) & 0xFF, f->b) |
+           ppe_sw_channel_put((abgr >> 8) & 0xFF, f->g) | ppe_sw_channel_put(abgr & 0xFF, f->r);
 }
 
-void PPE_InitResultLayer(PPE_ResultLayer_InitTypeDef *layer_init_struct)
+/*D = S * a + D * (1 - a) on both 8 bit lane pairs of a word at once, the alpha lane gets
+  a + Da * (1 - a). Works for any channel order as long as source and target share it*/
+static uint32_t ppe_sw_blend_8888(uint32_t src, uint32_t dst, uint32_t alpha)
 {
-    PPE_LAYER->RESULT_LAYER.LAYER0_ADDR_L = layer_init_struct->src_addr;
-    PPE_LAYER0_WIN_SIZE_TypeDef ppe_reg_0x0c = {.d32 = PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE};
-    ppe_reg_0x0c.b.width = layer_init_struct->width;
-    ppe_reg_0x0c.b.height = layer_init_struct->height;
-    PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE = ppe_reg_0x0c.d32;
+    alpha += alpha >> 7;
+    uint32_t inv = 256 - alpha;
+    uint32_t rb = (((src & PPE_SW_MASK_RB) * alpha + (dst & PPE_SW_MASK_RB) * inv) >> 8) &
+                  PPE_SW_MASK_RB;
+    uint32_t ag = (((src >> 8) & 0xFF) | 0x00FF0000) * alpha + ((dst >> 8) & PPE_SW_MASK_RB) * inv;
 
-    PPE_LAYER0_PIC_CFG_TypeDef ppe_reg_0x14 = {.d32 = PPE_LAYER->RESULT_LAYER.LAYER0_PIC_CFG};
-    ppe_reg_0x14.b.format = layer_init_struct->format;
-    ppe_reg_0x14.b.line_len = layer_init_struct->line_len;
-    PPE_LAYER->RESULT_LAYER.LAYER0_PIC_CFG = ppe_reg_0x14.d32;
+    return rb | (ag & ~PPE_SW_MASK_RB);
+}
 
-    PPE_LAYER0_HS_CFG_TypeDef ppe_reg_0x20 = {.d32 = PPE_LAYER->RESULT_LAYER.LAYER0_HS_CFG};
-    ppe_reg_0x20.b.hw_index = layer_init_struct->hw_index;
-    ppe_reg_0x20.b.msize_log = layer_init_struct->handshake_msize;
-    ppe_reg_0x20.b.hs_en = layer_init_struct->handshake_en;
-    ppe_reg_0x20.b.polar = layer_init_struct->polarity;
-    ppe_reg_0x20.b.hw_hs = layer_init_struct->handshake_mode;
-    PPE_LAYER->RESULT_LAYER.LAYER0_HS_CFG = ppe_reg_0x20.d32;
+/*src is the 8888 pixel with the same RGB order as the 565 target, the three fields are spread
+  over a 32 bit word so that they are scaled with one multiply*/
+static uint16_t ppe_sw_blend_565(uint32_t src, uint16_t dst, uint32_t alpha)
+{
+    uint32_t s = ((src >> 8) & 0xF800) | ((src >> 5) & 0x07E0) | ((src >> 3) & 0x001F);
+    uint32_t a = (alpha + 4) >> 3;
 
-    PPE_LAYER0_BUS_CFG_TypeDef ppe_reg_0x1c = {.d32 = PPE_LAYER->RESULT_LAYER.LAYER0_BUS_CFG};
-    ppe_reg_0x1c.b.axcache = layer_init_struct->AXCACHE;
-    ppe_reg_0x1c.b.axsize = layer_init_struct->AXSIZE;
-    ppe_reg_0x1c.b.incr = layer_init_struct->INCR;
-    ppe_reg_0x1c.b.max_axlen_log = layer_init_struct->MAX_AXLEN_LOG;
-    ppe_reg_0x1c.b.prior = layer_init_struct->PRIOR;
-    ppe_reg_0x1c.b.byte_swap = layer_init_struct->byte_swap;
-    PPE_LAYER->RESULT_LAYER.LAYER0_BUS_CFG = ppe_reg_0x1c.d32;
+    s = (s | (s << 16)) & PPE_SW_MASK_565;
+    uint32_t d = (dst | (dst << 16)) & PPE_SW_MASK_565;
+    d = ((((s - d) * a) >> 5) + d) & PPE_SW_MASK_565;
+    return d | (d >> 16);
 }
 
-static void PPE_LLI_Init_result_LAYER(PPE_LLI_LAYER *LLI_layer, uint32_t input_layer_num)
+/*fill one line of pixels with the raw value, with word stores when the pattern repeats every
+  4 bytes*/
+static void ppe_sw_fill_line(uint8_t *dst, uint8_t len, uint32_t raw, uint32_t count)
 {
-    LLI_layer->LAYER_ADDR                   = PPE_LAYER->RESULT_LAYER.LAYER0_ADDR_L;
-    LLI_layer->LAYER_POS                    = 0;
-    LLI_layer->LAYER_WINSIZE                = PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE;
-    LLI_layer->LAYER_CONST_PIX              = 0;
+    if ((len == 2) || (len == 4))
+    {
+        uint32_t word = (len == 2) ? ((raw & 0xFFFF) | (raw << 16)) : raw;
+        while ((((uint32_t)dst & 3) != 0) && (count != 0))
+        {
+            ppe_sw_write(dst, len, raw);
+            dst += len;
+            count--;
+        }
+        uint32_t *p = (uint32_t *)dst;
+        for (uint32_t i = (count * len) >> 2; i != 0; i--)
+        {
+            *p++ = word;
+        }
+        dst = (uint8_t *)p;
+        count -= ((count * len) >> 2) * 4 / len;
+    }
+    while (count--)
+    {
+        ppe_sw_write(dst, len, raw);
+        dst += len;
+    }
 }
 
-static void PPE_LLI_Init_Input_LAYER(PPE_LLI_LAYER *LLI_layer, uint32_t input_layer_num)
+/*composite one line of src onto dst, src_step is in bytes and 0 repeats the same source pixel*/
+static void ppe_sw_blend_line(uint8_t *dst, PPE_PIXEL_FORMAT dst_format, const uint8_t *src,
+                              PPE_PIXEL_FORMAT src_format, int32_t src_step, uint32_t count,
+                              uint8_t global_alpha, bool key_en, uint32_t key, bool bypass)
 {
-    LLI_layer->LAYER_ADDR                   = PPE_LAYER->INPUT_LAYER[input_layer_num - 1].LAYERx_ADDR_L;
-    LLI_layer->LAYER_POS                    = PPE_LAYER->INPUT_LAYER[input_layer_num - 1].LAYERx_POS;
-    LLI_layer->LAYER_WINSIZE                = PPE_LAYER->INPUT_LAYER[input_layer_num -
-                                                                                     1].LAYERx_WIN_SIZE;
-    LLI_layer->LAYER_CONST_PIX              = PPE_LAYER->INPUT_LAYER[input_layer_num -
-                                                                                     1].LAYERx_CONST_PIX;
-}
+    uint8_t dst_len = ppe_get_format_data_len(dst_format);
+    uint8_t src_len = ppe_get_format_data_len(src_format);
+    uint32_t key_mask = (src_len == 4) ? 0xFFFFFFFF : ((1U << (src_len * 8)) - 1);
 
-PPE_ERR PPE_Scale(ppe_buffer_t *image, ppe_buffer_t *buffer, float x_ratio, float y_ratio)
-{
-    if (buffer == NULL)
+    if (!bypass && !key_en)
     {
-        return PPE_ERROR_NULL_TARGET;
+        if (((src_format == PPE_ABGR8888) && ((dst_format == PPE_ABGR8888) || (dst_format == PPE_XBGR8888)))
+            || ((src_format == PPE_ARGB8888) && ((dst_format == PPE_ARGB8888) || (dst_format == PPE_XRGB8888))))
+        {
+            for (; count != 0; count--, src += src_step, dst += 4)
+            {
+                uint32_t s = ppe_sw_read(src, 4);
+                uint32_t alpha = (s >> 24) * global_alpha / 255;
+                if (alpha == 0)
+                {
+                    continue;
+                }
+                ppe_sw_write(dst, 4, (alpha == 0xFF) ? s : ppe_sw_blend_8888(s, ppe_sw_read(dst, 4), alpha));
+            }
+            return;
+        }
+        if (((src_format == PPE_ARGB8888) && (dst_format == PPE_RGB565))
+            || ((src_format == PPE_ABGR8888) && (dst_format == PPE_BGR565)))
+        {
+            for (; count != 0; count--, src += src_step, dst += 2)
+            {
+                uint32_t s = ppe_sw_read(src, 4);
+                uint32_t alpha = (s >> 24) * global_alpha / 255;
+                if (alpha == 0)
+                {
+                    continue;
+                }
+                ppe_sw_write(dst, 2, ppe_sw_blend_565(s, ppe_sw_read(dst, 2), alpha));
+            }
+            return;
+        }
     }
-    if (image == NULL)
+    if (bypass && !key_en && (src_format == dst_format) && (src_step == src_len) &&
+        (ppe_sw_format[src_format].a.bits == 0) && (global_alpha == 0xFF))
     {
-        return PPE_ERROR_NULL_SOURCE;
+        memcpy(dst, src, count * dst_len);
+        return;
     }
-    PPE_InputLayer_InitTypeDef PPE_Input_Layer;
-    PPE_ResultLayer_InitTypeDef PPE_Result_Layer;
-    PPE_InitTypeDef PPE_Init_User;
 
-    PPE_InputLayer_StructInit(&PPE_Input_Layer);
-    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
-    PPE_structInit(&PPE_Init_User);
-    if ((image->address % 4) || (buffer->address % 4))
+    for (; count != 0; count--, src += src_step, dst += dst_len)
     {
-        return PPE_ERROR_ADDR_NOT_ALIGNED;
+        uint32_t raw = ppe_sw_read(src, src_len);
+        if (key_en && ((raw & key_mask) == (key & key_mask)))
+        {
+            /*a keyed pixel is transparent, bypass writes the empty background*/
+            if (bypass)
+            {
+                ppe_sw_write(dst, dst_len, 0);
+            }
+            continue;
+        }
+        uint32_t s = ppe_sw_decode(src_format, raw);
+        uint32_t alpha = (s >> 24) * global_alpha / 255;
+        if (bypass)
+        {
+            /*PPE bypasses by blending over an empty layer, so alpha scales the color*/
+            if (alpha < 0xFF)
+            {
+                s = ppe_sw_blend_8888(s, 0, alpha);
+            }
+            ppe_sw_write(dst, dst_len, ppe_sw_encode(dst_format, s));
+            continue;
+        }
+        if (alpha == 0)
+        {
+            continue;
+        }
+        if (alpha < 0xFF)
+        {
+            s = ppe_sw_blend_8888(s, ppe_sw_decode(dst_format, ppe_sw_read(dst, dst_len)), alpha);
+        }
+        ppe_sw_write(dst, dst_len, ppe_sw_encode(dst_format, s));
     }
-    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
-
-    PPE_Input_Layer.src_addr                = (uint32_t)image->memory;
-    PPE_Input_Layer.start_x                 = 0;
-    PPE_Input_Layer.start_y                 = 0;
-    PPE_Input_Layer.width                   = image->width;
-    PPE_Input_Layer.height                  = image->height;
-    PPE_Input_Layer.const_ABGR8888_value    = 0XFFFFFFFF;
-    PPE_Input_Layer.format                  = image->format;
-    PPE_Input_Layer.src                     = PPE_LAYER_SRC_FROM_DMA;
-    PPE_Input_Layer.color_key_en            = DISABLE;
-    PPE_Input_Layer.line_len                = PPE_Input_Layer.width;
-    PPE_Input_Layer.key_color_value         = 0x0;
-    PPE_Input_Layer.AXSIZE                  = 2; // 32bit bandwidth;
-    PPE_Input_Layer.INCR                    = PPE_ARBURST_INCR;
-    PPE_Input_Layer.AXCACHE                 = 1;
-    PPE_Input_Layer.MAX_AXLEN_LOG           = PPE_MAX_AXLEN_127;
-    PPE_Input_Layer.PRIOR                   = 0;
-    PPE_Input_Layer.byte_swap               = PPE_NO_SWAP;
-    PPE_Input_Layer.handshake_mode          = PPE_DMA_SW_HANDSHAKE;
-    PPE_Input_Layer.polarity                = PPE_POLARITY_HIGH;
-    PPE_Input_Layer.handshake_en            = DISABLE;
-    PPE_Input_Layer.handshake_msize         = PPE_MSIZE_2;
-    PPE_Input_Layer.hw_index                = 0;
-    PPE_InitInputLayer(1, &PPE_Input_Layer);
-
-    PPE->SCA_RATIO_X = (uint32_t)(65536 / x_ratio); // 65536/ratio_x,ratio = 2
-    PPE->SCA_RATIO_Y = (uint32_t)(65536 / y_ratio);
-    buffer->width   = (uint32_t)PPE_Input_Layer.width * x_ratio;
-    buffer->height  = (uint32_t)PPE_Input_Layer.height * y_ratio;
-
-    PPE_Result_Layer.src_addr               = (uint32_t)buffer->memory;
-    PPE_Result_Layer.width                  = buffer->width;
-    PPE_Result_Layer.height                 = buffer->height;
-    PPE_Result_Layer.format                 = buffer->format;
-    PPE_Result_Layer.line_len               = PPE_Result_Layer.width;
-    PPE_Result_Layer.AXSIZE                 = 2;    // 32bit bandwidth
-    PPE_Result_Layer.INCR                   = PPE_ARBURST_INCR;
-    PPE_Result_Layer.AXCACHE                = 1;
-    PPE_Result_Layer.MAX_AXLEN_LOG          = PPE_MAX_AXLEN_127;
-    PPE_Result_Layer.PRIOR                  = 0;
-    PPE_Result_Layer.byte_swap              = PPE_NO_SWAP;
-    PPE_Result_Layer.handshake_mode         = PPE_DMA_SW_HANDSHAKE;
-    PPE_Result_Layer.polarity               = PPE_POLARITY_HIGH;
-    PPE_Result_Layer.handshake_en           = DISABLE;
-    PPE_Result_Layer.handshake_msize        = PPE_MSIZE_2;
-    PPE_Result_Layer.hw_index               = 0;
-    PPE_InitResultLayer(&PPE_Result_Layer);
-
-    PPE_Init_User.function          =   PPE_FUNCTION_SCALE;
-    PPE_Init(&PPE_Init_User);
-
-    PPE_Secure(ENABLE);
-    PPE_Cmd(ENABLE);
-    while (PPE->GLB_CTL & BIT0);
-
-    return PPE_SUCCESS;
 }
 
-uint8_t ppe_get_format_data_len(PPE_PIXEL_FORMAT format)
+static void ppe_sw_clear_rect(ppe_buffer_t *buffer, ppe_rect_t *rect, uint32_t color)
 {
-    if (((format >= PPE_ABGR8888) && (format <= PPE_RGBX8888))
-        || ((format >= PPE_ABGR8666) && (format <= PPE_RGBX6668)))
+    uint8_t len = ppe_get_format_data_len(buffer->format);
+    uint32_t pitch = ppe_buffer_stride(buffer) * len;
+    uint32_t width = rect->right - rect->left + 1;
+    uint8_t *line = (uint8_t *)buffer->memory + rect->top * pitch + rect->left * len;
+    uint8_t alpha = buffer->global_alpha_en ? buffer->global_alpha : 0xFF;
+
+    if (((color >> 24) * alpha / 255) == 0xFF)
     {
-        return 4;
+        /*opaque, the first line is the pattern for the rest*/
+        ppe_sw_fill_line(line, len, ppe_sw_encode(buffer->format, color), width);
+        for (int32_t y = rect->top + 1; y <= rect->bottom; y++)
+        {
+            memcpy(line + pitch, line, width * len);
+            line += pitch;
+        }
+        return;
     }
-    if (((format >= PPE_ABGR4444) && (format <= PPE_RGBX4444))
-        || ((format >= PPE_ABGR1555) && (format <= PPE_RGBX5551))
-        || ((format >= PPE_BGR565) && (format <= PPE_RGB565)))
+    for (int32_t y = rect->top; y <= rect->bottom; y++, line += pitch)
     {
-        return 2;
+        ppe_sw_blend_line(line, buffer->format, (const uint8_t *)&color, PPE_ABGR8888, 0, width, alpha,
+                          false, 0, false);
     }
-    if (((format >= PPE_ABGR2222) && (format <= PPE_RGBX2222))
-        || ((format >= PPE_A8) && (format <= PPE_X8)))
+}
+
+static void ppe_sw_blend_rect(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_rect_t *source_rect,
+                              ppe_rect_t *blend_area, PPE_BLEND_MODE blend_mode)
+{
+    uint8_t src_len = ppe_get_format_data_len(image->format);
+    uint8_t dst_len = ppe_get_format_data_len(buffer->format);
+    uint32_t src_pitch = ppe_buffer_stride(image) * src_len;
+    uint32_t dst_pitch = ppe_buffer_stride(buffer) * dst_len;
+    const uint8_t *src = (const uint8_t *)image->memory + source_rect->top * src_pitch +
+                         source_rect->left * src_len;
+    uint8_t *dst = (uint8_t *)buffer->memory + blend_area->top * dst_pitch + blend_area->left * dst_len;
+    uint32_t width = blend_area->right - blend_area->left + 1;
+
+    for (int32_t y = blend_area->top; y <= blend_area->bottom; y++, src += src_pitch, dst += dst_pitch)
     {
-        return 1;
+        ppe_sw_blend_line(dst, buffer->format, src, image->format, src_len, width,
+                          image->global_alpha_en ? image->global_alpha : 0xFF,
+                          image->color_key_en, image->color_key_value, blend_mode == PPE_BYPASS_MODE);
     }
-    if (((format >= PPE_ABGR8565) && (format <= PPE_RGBX5658))
-        || ((format >= PPE_BGR888) && (format <= PPE_RGB888)))
-    {
-        return 3;
+}
+
+/*source of placed pixel (u, v) is (a * u + b * v, d * u + e * v) as {a, b, d, e}, counted from
+  the last column or row of the image when a coefficient along it is negative*/
+static const int8_t ppe_orient_axis[][4] =
+{
+    [PPE_ROTATE_0]      = {1, 0, 0, 1},
+    [PPE_ROTATE_90]     = {0, 1, -1, 0},
+    [PPE_ROTATE_180]    = {-1, 0, 0, -1},
+    [PPE_ROTATE_270]    = {0, -1, 1, 0},
+    [PPE_FLIP_H]        = {-1, 0, 0, 1},
+    [PPE_FLIP_V]        = {1, 0, 0, -1},
+};
+
+static void ppe_sw_blit_orient(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
+                               ppe_rect_t *area, PPE_ORIENT orient, PPE_BLEND_MODE blend_mode)
+{
+    const int8_t *axis = ppe_orient_axis[orient];
+    int32_t src_len = ppe_get_format_data_len(image->format);
+    int32_t src_pitch = ppe_buffer_stride(image) * src_len;
+    uint8_t dst_len = ppe_get_format_data_len(buffer->format);
+    uint32_t dst_pitch = ppe_buffer_stride(buffer) * dst_len;
+    int32_t step_u = axis[0] * src_len + axis[2] * src_pitch;
+    int32_t step_v = axis[1] * src_len + axis[3] * src_pitch;
+    int32_t first_x = ((axis[0] < 0) || (axis[1] < 0)) ? (image->width - 1) : 0;
+    int32_t first_y = ((axis[2] < 0) || (axis[3] < 0)) ? (image->height - 1) : 0;
+    const uint8_t *origin = (const uint8_t *)image->memory + first_y * src_pitch + first_x * src_len;
+
+    /*rows of a rotation read src columns, square tiles keep the src lines they touch in cache*/
+    int32_t tile_w = (axis[0] == 0) ? PPE_ORIENT_TILE_SIZE : (area->right - area->left + 1);
+    for (int32_t tile_y = area->top; tile_y <= area->bottom; tile_y += PPE_ORIENT_TILE_SIZE)
+    {
+        int32_t tile_bottom = MIN(tile_y + PPE_ORIENT_TILE_SIZE - 1, area->bottom);
+        for (int32_t tile_x = area->left; tile_x <= area->right; tile_x += tile_w)
+        {
+            uint32_t width = MIN(tile_w, area->right - tile_x + 1);
+            for (int32_t y = tile_y; y <= tile_bottom; y++)
+            {
+                const uint8_t *src = origin + (tile_x - trans->x) * step_u + (y - trans->y) * step_v;
+                uint8_t *dst = (uint8_t *)buffer->memory + y * dst_pitch + tile_x * dst_len;
+                ppe_sw_blend_line(dst, buffer->format, src, image->format, step_u, width,
+                                  image->global_alpha_en ? image->global_alpha : 0xFF,
+                                  image->color_key_en, image->color_key_value, blend_mode == PPE_BYPASS_MODE);
+            }
+        }
     }
-    return 0;
 }
 
-PPE_ERR PPE_Scale_Rect(ppe_buffer_t *image, ppe_buffer_t *buffer, float x_ratio, float y_ratio,
-                       ppe_rect_t *rect)
+/*ordered dither thresholds, 0..15*/
+static const uint8_t ppe_sw_bayer[4][4] =
 {
-    if (buffer == NULL)
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+/*low bits of an 8 bit channel that get lost when converting, 0 if nothing is lost*/
+static uint8_t ppe_sw_lost_bits(ppe_sw_channel_t src, ppe_sw_channel_t dst)
+{
+    if ((dst.bits == 0) || (dst.bits >= 8) || (src.bits <= dst.bits))
     {
-        return PPE_ERROR_NULL_TARGET;
+        return 0;
     }
-    if (image == NULL)
+    return 8 - dst.bits;
+}
+
+/*add the R, G and B bytes of threshold to abgr, saturating each lane at 0xFF*/
+static uint32_t ppe_sw_add_sat(uint32_t abgr, uint32_t threshold)
+{
+    uint32_t rb = (abgr & PPE_SW_MASK_RB) + (threshold & PPE_SW_MASK_RB);
+    uint32_t g = (abgr & 0xFF00) + (threshold & 0xFF00);
+
+    rb |= ((rb >> 8) & 0x00010001) * 0xFF;
+    g |= ((g >> 16) & 1) * 0xFF00;
+    return (abgr & 0xFF000000) | (rb & PPE_SW_MASK_RB) | (g & 0xFF00);
+}
+
+/*convert one line, threshold holds the packed dither of the line's Bayer row or is NULL*/
+static void ppe_sw_convert_line(uint8_t *dst, PPE_PIXEL_FORMAT dst_format, const uint8_t *src,
+                                PPE_PIXEL_FORMAT src_format, uint32_t count, const uint32_t *threshold)
+{
+    uint8_t src_len = ppe_get_format_data_len(src_format);
+    uint8_t dst_len = ppe_get_format_data_len(dst_format);
+
+    for (uint32_t x = 0; x < count; x++, src += src_len, dst += dst_len)
     {
-        return PPE_ERROR_NULL_SOURCE;
+        uint32_t abgr = ppe_sw_decode(src_format, ppe_sw_read(src, src_len));
+        if (threshold != NULL)
+        {
+            abgr = ppe_sw_add_sat(abgr, threshold[x & 3]);
+        }
+        ppe_sw_write(dst, dst_len, ppe_sw_encode(dst_format, abgr));
     }
-    PPE_InputLayer_InitTypeDef PPE_Input_Layer;
-    PPE_ResultLayer_InitTypeDef PPE_Result_Layer;
-    PPE_InitTypeDef PPE_Init_User;
+}
 
-    PPE_InputLayer_StructInit(&PPE_Input_Layer);
-    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
-    PPE_structInit(&PPE_Init_User);
-    if ((image->address % 4) || (buffer->address % 4))
+/*Floyd-Steinberg on R, G and B, alpha is truncated*/
+static void ppe_sw_diffuse_line(uint8_t *dst, PPE_PIXEL_FORMAT dst_format, const uint8_t *src,
+                                PPE_PIXEL_FORMAT src_format, uint32_t count)
+{
+    uint8_t src_len = ppe_get_format_data_len(src_format);
+    uint8_t dst_len = ppe_get_format_data_len(dst_format);
+    const ppe_sw_format_t *f = &ppe_sw_format[dst_format];
+    ppe_sw_channel_t ch[3] = {f->r, f->g, f->b};
+    int32_t right[3] = {0, 0, 0};
+    int32_t below_left[3] = {0, 0, 0};
+    int32_t below[3] = {0, 0, 0};
+
+    for (uint32_t x = 0; x < count; x++, src += src_len, dst += dst_len)
     {
-        return PPE_ERROR_ADDR_NOT_ALIGNED;
+        uint32_t abgr = ppe_sw_decode(src_format, ppe_sw_read(src, src_len));
+        uint32_t out = abgr & 0xFF000000;
+
+        for (uint8_t c = 0; c < 3; c++)
+        {
+            int32_t v = (int32_t)((abgr >> (8 * c)) & 0xFF) + ppe_sw_diffuse[c][x + 1] + right[c];
+            v = (v < 0) ? 0 : ((v > 0xFF) ? 0xFF : v);
+            uint32_t q = ppe_sw_channel_get(ppe_sw_channel_put(v, ch[c]), ch[c], v);
+            int32_t e = v - (int32_t)q;
+
+            out |= q << (8 * c);
+            right[c] = e * 7 / 16;
+            ppe_sw_diffuse[c][x] = below_left[c] + e * 3 / 16;
+            below_left[c] = below[c] + e * 5 / 16;
+            below[c] = e / 16;
+        }
+        ppe_sw_write(dst, dst_len, ppe_sw_encode(dst_format, out));
     }
-    if ((rect == NULL) || (rect->top > rect->bottom) || (rect->left > rect->right)
-        || (rect->right >= image->width) || (rect->bottom >= image->height))
+    for (uint8_t c = 0; c < 3; c++)
     {
-        return PPE_ERROR_INVALID_PARAM;
+        ppe_sw_diffuse[c][count] = below_left[c];
     }
-    uint8_t format_len = ppe_get_format_data_len(image->format);
-    if (!format_len)
+}
+
+/*============================================================================*
+ *                           Public Functions
+ *============================================================================*/
+bool ppe_rect_intersect(ppe_rect_t *result_rect, ppe_rect_t *rect1, ppe_rect_t *rect2)
+{
+//     if(result_rect == NULL || rect1 == NULL || rect2 == NULL)
+//     {
+//         return false;
+//     }
+    result_rect->left = MAX(rect1->left, rect2->left);
+    result_rect->top = MAX(rect1->top, rect2->top);
+    result_rect->right = MIN(rect1->right, rect2->right);
+    result_rect->bottom = MIN(rect1->bottom, rect2->bottom);
+    if (result_rect->top > result_rect->bottom || result_rect->left > result_rect->right)
     {
-        return PPE_ERROR_UNKNOWN_FORMAT;
+        return false;
     }
-
-    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
-
-    PPE_Input_Layer.src_addr                = (uint32_t)(image->address +
-                                                         (rect->left + image->width * rect->top) * format_len);
-    PPE_Input_Layer.start_x                 = 0;
-    PPE_Input_Layer.start_y                 = 0;
-    PPE_Input_Layer.width                   = rect->right - rect->left + 1;
-    PPE_Input_Layer.height                  = rect->bottom - rect->top + 1;
-    PPE_Input_Layer.const_ABGR8888_value    = 0XFFFFFFFF;
-    PPE_Input_Layer.format                  = image->format;
-    PPE_Input_Layer.src                     = PPE_LAYER_SRC_FROM_DMA;
-    PPE_Input_Layer.color_key_en            = DISABLE;
-    PPE_Input_Layer.line_len                = image->width;
-    PPE_Input_Layer.key_color_value         = 0x000000;
-    PPE_Input_Layer.AXSIZE                  = 2; // 32bit bandwidth;
-    PPE_Input_Layer.INCR                    = PPE_ARBURST_INCR;
-    PPE_Input_Layer.AXCACHE                 = 1;
-    PPE_Input_Layer.MAX_AXLEN_LOG           = PPE_MAX_AXLEN_127;
-    PPE_Input_Layer.PRIOR                   = 0;
-    PPE_Input_Layer.byte_swap               = PPE_NO_SWAP;
-    PPE_Input_Layer.handshake_mode          = PPE_DMA_SW_HANDSHAKE;
-    PPE_Input_Layer.polarity                = PPE_POLARITY_HIGH;
-    PPE_Input_Layer.handshake_en            = DISABLE;
-    PPE_Input_Layer.handshake_msize         = PPE_MSIZE_2;
-    PPE_Input_Layer.hw_index                = 0;
-    PPE_InitInputLayer(1, &PPE_Input_Layer);
-    PPE->SCA_RATIO_X = (uint32_t)(65536 / x_ratio); // 65536/ratio_x,ratio = 2
-    PPE->SCA_RATIO_Y = (uint32_t)(65536 / y_ratio);
-    buffer->width   = (uint32_t)PPE_Input_Layer.width * x_ratio;
-    buffer->height  = (uint32_t)PPE_Input_Layer.height * y_ratio;
-    if (buffer->height == 0 || buffer->height == 0)
+    else
     {
-        return PPE_SUCCESS_NOT_CHANGE;
+        return true;
     }
-    PPE_Result_Layer.src_addr               = (uint32_t)buffer->memory;
-    PPE_Result_Layer.width                  = buffer->width;
-    PPE_Result_Layer.height                 = buffer->height;
-    PPE_Result_Layer.format                 = buffer->format;
-    PPE_Result_Layer.line_len               = PPE_Result_Layer.width;
-    PPE_Result_Layer.AXSIZE                 = 2;    // 32bit bandwidth
-    PPE_Result_Layer.INCR                   = PPE_ARBURST_INCR;
-    PPE_Result_Layer.AXCACHE                = 1;
-    PPE_Result_Layer.MAX_AXLEN_LOG          = PPE_MAX_AXLEN_127;
-    PPE_Result_Layer.PRIOR                  = 0;
-    PPE_Result_Layer.byte_swap              = PPE_NO_SWAP;
-    PPE_Result_Layer.handshake_mode         = PPE_DMA_SW_HANDSHAKE;
-    PPE_Result_Layer.polarity               = PPE_POLARITY_HIGH;
-    PPE_Result_Layer.handshake_en           = DISABLE;
-    PPE_Result_Layer.handshake_msize        = PPE_MSIZE_2;
-    PPE_Result_Layer.hw_index               = 0;
-    PPE_InitResultLayer(&PPE_Result_Layer);
+}
 
-    PPE_Init_User.function          =   PPE_FUNCTION_SCALE;
-    PPE_Init(&PPE_Init_User);
+void PPE_RegShadow_Invalidate(void)
+{
+#if PPE_REG_SHADOW_EN
+    memset(ppe_shadow_valid, 0, sizeof(ppe_shadow_valid));
+#endif
+}
 
-    PPE_Secure(ENABLE);
-    PPE_Cmd(ENABLE);
-    while (PPE->GLB_CTL & BIT0);
+void PPE_RegShadow_GetStat(ppe_reg_stat_t *stat)
+{
+    *stat = ppe_reg_stat;
+}
 
-    return PPE_SUCCESS;
+void PPE_RegShadow_ClearStat(void)
+{
+    ppe_reg_stat.write_cnt = 0;
+    ppe_reg_stat.skip_cnt = 0;
+}
+
+#if PPE_PERF_EN
+void PPE_Perf_GetStat(ppe_perf_stat_t *stat)
+{
+    *stat = ppe_perf;
+}
+
+void PPE_Perf_ClearStat(void)
+{
+    PPE_PERF_TIMESTAMP_INIT();
+    memset(&ppe_perf, 0, sizeof(ppe_perf));
+    ppe_perf_running = false;
+}
+
+uint32_t PPE_Perf_Percentile(ppe_perf_op_t *op, uint8_t percent)
+{
+    return ppe_perf_percentile(op, percent);
+}
+
+uint32_t PPE_Perf_Dump(char *buf, uint32_t size)
+{
+    static const char *const op_name[PPE_PERF_OP_NUM] =
+    {
+    "other",
+    "scale",
+    "convert",
+    "clear",
+    "blend",
+    "blend_multi",
+    "cmdlist",
+    };
+
+    return ppe_perf_dump(&ppe_perf, op_name, buf, size);
+}
+#endif
+
+void PPE_Cmd(FunctionalState state)
+{
+    //PPE cannot be disabled by user
+    if (state)
+    {
+        PPE_PERF_START();
+#if PPE_SIM_BACKEND
+        /* the model has finished the job when it returns, glb_en is left at 0 */
+        PPE_Simulation_Run();
+        return;
+#endif
+        PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
+        ppe_reg_0x400.b.glb_en = state;
+        PPE->GLB_CTL = ppe_reg_0x400.d32;
+    }
+}
+
+void PPE_Suspend(void)
+{
+    PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
+    ppe_reg_0x400.b.susp = SET;
+    PPE->GLB_CTL = ppe_reg_0x400.d32;
+}
+
+void PPE_Resume(void)
+{
+    PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
+    if (ppe_reg_0x400.b.all_inact)
+    {
+        ppe_reg_0x400.b.resume = SET;
+        PPE->GLB_CTL = ppe_reg_0x400.d32;
+    }
+}
+
+void PPE_Abort(void)
+{
+    PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
+    if (ppe_reg_0x400.b.all_inact)
+    {
+        ppe_reg_0x400.b.abort = SET;
+        PPE->GLB_CTL = ppe_reg_0x400.d32;
+    }
+}
+
+ITStatus PPE_ChannelInactiveCheck(uint8_t chn_id)
+{
+    assert_param(IS_PPE_CHN_INDEX(chn_id));
+    ITStatus rv = RESET;
+    PPE_GLB_CTL_TypeDef ppe_reg_0x400 = {.d32 = PPE->GLB_CTL};
+    if (ppe_reg_0x400.b.chn_inact & (BIT0 << chn_id))
+    {
+        rv = SET;
+    }
+    return rv;
+}
+
+void PPE_Secure(FunctionalState state)
+{
+    PPE_MISC_TypeDef ppe_reg_0x420 = {.d32 = PPE->MISC};
+    if (state)
+    {
+        ppe_reg_0x420.b.secure = SET;
+    }
+    else
+    {
+        ppe_reg_0x420.b.secure = RESET;
+    }
+    PPE->MISC = ppe_reg_0x420.d32;
+}
+
+ITStatus PPE_GetINTStatus(uint32_t PPE_INT)
+{
+    //assert_param(IS_PPE_INT(PPE_INT));
+    ITStatus bit_status = RESET;
+    if (PPE->INTR_ST & PPE_INT)
+    {
+        bit_status = SET;
+    }
+    return bit_status;
+}
+
+ITStatus PPE_GetINTStatusRaw(uint32_t PPE_INT)
+{
+    //assert_param(IS_PPE_INT(PPE_INT));
+    ITStatus bit_status = RESET;
+    if (PPE->INTR_RAW & PPE_INT)
+    {
+        bit_status = SET;
+    }
+    return bit_status;
+}
+
+void PPE_ClearINTPendingBit(uint32_t PPE_INT)
+{
+    //assert_param(IS_PPE_INT(PPE_INT));
+    PPE->INTR_CLR |= PPE_INT;
+}
+
+void PPE_MaskINTConfig(uint32_t PPE_INT_MSK, FunctionalState NewState)
+{
+    /* Check the parameters */
+    //assert_param(IS_PPE_INT(PPE_INT_MSK));
+    //assert_param(IS_FUNCTIONAL_STATE(NewState));
+    if (NewState == ENABLE)
+    {
+        PPE->INTR_MASK |= PPE_INT_MSK;
+    }
+    else
+    {
+        PPE->INTR_MASK &= ~PPE_INT_MSK;
+    }
+}
+
+void PPE_AutoReloadCmd(FunctionalState NewState)
+{
+    //assert_param(IS_FUNCTIONAL_STATE(NewState));
+    PPE_RELOAD_CFG_TypeDef ppe_reg_0x408 = {.d32 = PPE->RELOAD_CFG};
+    if (NewState)
+    {
+        ppe_reg_0x408.b.layer_reload_en = SET;
+    }
+    else
+    {
+        ppe_reg_0x408.b.layer_reload_en = RESET;
+    }
+    PPE->RELOAD_CFG = ppe_reg_0x408.d32;
+}
+
+void PPE_AutoClearCmd(FunctionalState NewState)
+{
+    //assert_param(IS_FUNCTIONAL_STATE(NewState));
+    PPE_RELOAD_CFG_TypeDef ppe_reg_0x408 = {.d32 = PPE->RELOAD_CFG};
+    if (NewState)
+    {
+        ppe_reg_0x408.b.auto_clr = SET;
+    }
+    else
+    {
+        ppe_reg_0x408.b.auto_clr = RESET;
+    }
+    PPE->RELOAD_CFG = ppe_reg_0x408.d32;
+}
+
+void PPE_SetValid(FunctionalState NewState)
+{
+    //assert_param(IS_FUNCTIONAL_STATE(NewState));
+    PPE_RELOAD_CFG_TypeDef ppe_reg_0x408 = {.d32 = PPE->RELOAD_CFG};
+    if (NewState)
+    {
+        ppe_reg_0x408.b.set_valid = SET;
+    }
+    else
+    {
+        ppe_reg_0x408.b.set_valid = RESET;
+    }
+    PPE->RELOAD_CFG = ppe_reg_0x408.d32;
+}
+
+void PPE_structInit(PPE_InitTypeDef *PPE_init_struct)
+{
+    //assert_param(PPE_init_struct != NULL);
+    PPE_init_struct->function = PPE_FUNCTION_ALPHA_BLEND;
+}
+
+void PPE_InputLayer_StructInit(PPE_InputLayer_InitTypeDef *layer_init_struct)
+{
+    layer_init_struct->byte_swap = PPE_NO_SWAP;
+    layer_init_struct->AXCACHE = 0;
+    layer_init_struct->AXSIZE = 0;
+    layer_init_struct->color_key_en = 0;
+    layer_init_struct->const_ABGR8888_value = 0xFFFFFFFF;
+    layer_init_struct->format = PPE_BGRA8888;
+    layer_init_struct->handshake_en = DISABLE;
+    layer_init_struct->height = 0;
+    layer_init_struct->width = 0;
+    layer_init_struct->start_x = 0;
+    layer_init_struct->start_y = 0;
+    layer_init_struct->polarity = PPE_POLARITY_HIGH;
+}
+
+void PPE_ResultLayer_StructInit(PPE_ResultLayer_InitTypeDef *layer_init_struct)
+{
+    layer_init_struct->byte_swap = PPE_NO_SWAP;
+    layer_init_struct->AXCACHE = 0;
+    layer_init_struct->AXSIZE = 0;
+    layer_init_struct->format = PPE_BGRA8888;
+    layer_init_struct->handshake_en = DISABLE;
+    layer_init_struct->height = 0;
+    layer_init_struct->width = 0;
+    layer_init_struct->polarity = PPE_POLARITY_HIGH;
+}
+
+void PPE_Init(PPE_InitTypeDef *PPE_init_struct)
+{
+    //assert_param(PPE_init_struct != NULL);
+    //assert_param(IS_PPE_FUNCTION(PPE_init_struct->function));
+    PPE_FUNC_CFG_TypeDef ppe_reg_0x404 = {.d32 = PPE->FUNC_CFG};
+    switch (PPE_init_struct->function)
+    {
+    case PPE_FUNCTION_ALPHA_BLEND:
+        {
+            //assert_param(IS_PPE_ALPHA_BLEND_LAYER_NUM(PPE_init_struct->blend_layer_num));
+            ppe_reg_0x404.b.func_sel = PPE_FUNCTION_ALPHA_BLEND;
+            ppe_reg_0x404.b.blend_lay = PPE_init_struct->blend_layer_num;
+            break;
+        }
+    case PPE_FUNCTION_SCALE:
+        {
+            ppe_reg_0x404.b.func_sel = PPE_FUNCTION_SCALE;
+            break;
+        }
+    }
+    PPE->FUNC_CFG = ppe_reg_0x404.d32;
+}
+
+void PPE_InitInputLayer(uint8_t id, PPE_InputLayer_InitTypeDef *layer_init_struct)
+{
+    uint8_t cov_layer_id = id - 1;
+    PPE_Shadow_Write(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_ADDR_L, layer_init_struct->src_addr);
+    PPE_Shadow_Write(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_CONST_PIX, layer_init_struct->const_ABGR8888_value);
+    PPE_LAYERX_POS_TypeDef ppe_reg_0x48 = {.d32 = PPE_Shadow_Read(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_POS)};
+    ppe_reg_0x48.b.start_x = layer_init_struct->start_x;
+    ppe_reg_0x48.b.start_y = layer_init_struct->start_y;
+    PPE_Shadow_Write(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_POS, ppe_reg_0x48.d32);
+
+    PPE_LAYERX_WIN_SIZE_TypeDef ppe_reg_0x4c = {.d32 = PPE_Shadow_Read(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_WIN_SIZE)};
+    ppe_reg_0x4c.b.width = layer_init_struct->width;
+    ppe_reg_0x4c.b.height = layer_init_struct->height;
+    PPE_Shadow_Write(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_WIN_SIZE, ppe_reg_0x4c.d32);
+
+    PPE_LAYERX_PIC_CFG_TypeDef ppe_reg_0x54 = {.d32 = PPE_Shadow_Read(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_PIC_CFG)};
+    ppe_reg_0x54.b.pix_src = layer_init_struct->src;
+    ppe_reg_0x54.b.format = layer_init_struct->format;
+    ppe_reg_0x54.b.key_en = layer_init_struct->color_key_en;
+    ppe_reg_0x54.b.line_len = layer_init_struct->line_len;
+    PPE_Shadow_Write(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_PIC_CFG, ppe_reg_0x54.d32);
+
+    PPE_Shadow_Write(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_KEY_COLOR, layer_init_struct->key_color_value);
+
+    PPE_LAYERX_HS_CFG_TypeDef ppe_reg_0x60 = {.d32 = PPE_Shadow_Read(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_HS_CFG)};
+    ppe_reg_0x60.b.hw_index = layer_init_struct->hw_index;
+    ppe_reg_0x60.b.msize_log = layer_init_struct->handshake_msize;
+    ppe_reg_0x60.b.hs_en = layer_init_struct->handshake_en;
+    ppe_reg_0x60.b.polar = layer_init_struct->polarity;
+    ppe_reg_0x60.b.hwhs = layer_init_struct->handshake_mode;
+    PPE_Shadow_Write(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_HS_CFG, ppe_reg_0x60.d32);
+
+    PPE_LAYERX_BUS_CFG_TypeDef ppe_reg_0x5c = {.d32 = PPE_Shadow_Read(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_BUS_CFG)};
+    ppe_reg_0x5c.b.axcache = layer_init_struct->AXCACHE;
+    ppe_reg_0x5c.b.axsize = layer_init_struct->AXSIZE;
+    ppe_reg_0x5c.b.incr = layer_init_struct->INCR;
+    ppe_reg_0x5c.b.max_axlen_log = layer_init_struct->MAX_AXLEN_LOG;
+    ppe_reg_0x5c.b.prior = layer_init_struct->PRIOR;
+    PPE_Shadow_Write(&PPE_LAYER->INPUT_LAYER[cov_layer_id].LAYERx_BUS_CFG, ppe_reg_0x5c.d32);
+
+}
+
+void PPE_InitResultLayer(PPE_ResultLayer_InitTypeDef *layer_init_struct)
+{
+    PPE_Shadow_Write(&PPE_LAYER->RESULT_LAYER.LAYER0_ADDR_L, layer_init_struct->src_addr);
+    PPE_LAYER0_WIN_SIZE_TypeDef ppe_reg_0x0c = {.d32 = PPE_Shadow_Read(&PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE)};
+    ppe_reg_0x0c.b.width = layer_init_struct->width;
+    ppe_reg_0x0c.b.height = layer_init_struct->height;
+    PPE_Shadow_Write(&PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE, ppe_reg_0x0c.d32);
+
+    PPE_LAYER0_PIC_CFG_TypeDef ppe_reg_0x14 = {.d32 = PPE_Shadow_Read(&PPE_LAYER->RESULT_LAYER.LAYER0_PIC_CFG)};
+    ppe_reg_0x14.b.format = layer_init_struct->format;
+    ppe_reg_0x14.b.line_len = layer_init_struct->line_len;
+    PPE_Shadow_Write(&PPE_LAYER->RESULT_LAYER.LAYER0_PIC_CFG, ppe_reg_0x14.d32);
+
+    PPE_LAYER0_HS_CFG_TypeDef ppe_reg_0x20 = {.d32 = PPE_Shadow_Read(&PPE_LAYER->RESULT_LAYER.LAYER0_HS_CFG)};
+    ppe_reg_0x20.b.hw_index = layer_init_struct->hw_index;
+    ppe_reg_0x20.b.msize_log = layer_init_struct->handshake_msize;
+    ppe_reg_0x20.b.hs_en = layer_init_struct->handshake_en;
+    ppe_reg_0x20.b.polar = layer_init_struct->polarity;
+    ppe_reg_0x20.b.hw_hs = layer_init_struct->handshake_mode;
+    PPE_Shadow_Write(&PPE_LAYER->RESULT_LAYER.LAYER0_HS_CFG, ppe_reg_0x20.d32);
+
+    PPE_LAYER0_BUS_CFG_TypeDef ppe_reg_0x1c = {.d32 = PPE_Shadow_Read(&PPE_LAYER->RESULT_LAYER.LAYER0_BUS_CFG)};
+    ppe_reg_0x1c.b.axcache = layer_init_struct->AXCACHE;
+    ppe_reg_0x1c.b.axsize = layer_init_struct->AXSIZE;
+    ppe_reg_0x1c.b.incr = layer_init_struct->INCR;
+    ppe_reg_0x1c.b.max_axlen_log = layer_init_struct->MAX_AXLEN_LOG;
+    ppe_reg_0x1c.b.prior = layer_init_struct->PRIOR;
+    ppe_reg_0x1c.b.byte_swap = layer_init_struct->byte_swap;
+    PPE_Shadow_Write(&PPE_LAYER->RESULT_LAYER.LAYER0_BUS_CFG, ppe_reg_0x1c.d32);
+}
+
+static void PPE_LLI_Init_result_LAYER(PPE_LLI_LAYER *LLI_layer, uint32_t input_layer_num)
+{
+    LLI_layer->LAYER_ADDR                   = PPE_LAYER->RESULT_LAYER.LAYER0_ADDR_L;
+    LLI_layer->LAYER_POS                    = 0;
+    LLI_layer->LAYER_WINSIZE                = PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE;
+    LLI_layer->LAYER_CONST_PIX              = 0;
+}
+
+static void PPE_LLI_Init_Input_LAYER(PPE_LLI_LAYER *LLI_layer, uint32_t input_layer_num)
+{
+    LLI_layer->LAYER_ADDR                   = PPE_LAYER->INPUT_LAYER[input_layer_num - 1].LAYERx_ADDR_L;
+    LLI_layer->LAYER_POS                    = PPE_LAYER->INPUT_LAYER[input_layer_num - 1].LAYERx_POS;
+    LLI_layer->LAYER_WINSIZE                = PPE_LAYER->INPUT_LAYER[input_layer_num -
+                                                                                     1].LAYERx_WIN_SIZE;
+    LLI_layer->LAYER_CONST_PIX              = PPE_LAYER->INPUT_LAYER[input_layer_num -
+                                                                                     1].LAYERx_CONST_PIX;
+}
+
+PPE_ERR PPE_Scale(ppe_buffer_t *image, ppe_buffer_t *buffer, float x_ratio, float y_ratio)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_SCALE);
+    if (buffer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if (image == NULL)
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+    PPE_InputLayer_InitTypeDef PPE_Input_Layer;
+    PPE_ResultLayer_InitTypeDef PPE_Result_Layer;
+    PPE_InitTypeDef PPE_Init_User;
+
+    PPE_InputLayer_StructInit(&PPE_Input_Layer);
+    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
+    PPE_structInit(&PPE_Init_User);
+    if ((image->address % 4) || (buffer->address % 4))
+    {
+        return PPE_ERROR_ADDR_NOT_ALIGNED;
+    }
+    PPE_WaitIdle();
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+
+    PPE_Input_Layer.src_addr                = (uint32_t)image->memory;
+    PPE_Input_Layer.start_x                 = 0;
+    PPE_Input_Layer.start_y                 = 0;
+    PPE_Input_Layer.width                   = image->width;
+    PPE_Input_Layer.height                  = image->height;
+    PPE_Input_Layer.const_ABGR8888_value    = 0XFFFFFFFF;
+    PPE_Input_Layer.format                  = image->format;
+    PPE_Input_Layer.src                     = PPE_LAYER_SRC_FROM_DMA;
+    PPE_Input_Layer.color_key_en            = DISABLE;
+    PPE_Input_Layer.line_len                = ppe_buffer_stride(image);
+    PPE_Input_Layer.key_color_value         = 0x0;
+    PPE_Input_Layer.AXSIZE                  = 2; // 32bit bandwidth;
+    PPE_Input_Layer.INCR                    = PPE_ARBURST_INCR;
+    PPE_Input_Layer.AXCACHE                 = 1;
+    PPE_Input_Layer.MAX_AXLEN_LOG           = PPE_MAX_AXLEN_127;
+    PPE_Input_Layer.PRIOR                   = 0;
+    PPE_Input_Layer.byte_swap               = PPE_NO_SWAP;
+    PPE_Input_Layer.handshake_mode          = PPE_DMA_SW_HANDSHAKE;
+    PPE_Input_Layer.polarity                = PPE_POLARITY_HIGH;
+    PPE_Input_Layer.handshake_en            = DISABLE;
+    PPE_Input_Layer.handshake_msize         = PPE_MSIZE_2;
+    PPE_Input_Layer.hw_index                = 0;
+    PPE_InitInputLayer(1, &PPE_Input_Layer);
+
+    PPE->SCA_RATIO_X = (uint32_t)(65536 / x_ratio); // 65536/ratio_x,ratio = 2
+    PPE->SCA_RATIO_Y = (uint32_t)(65536 / y_ratio);
+    buffer->width   = (uint32_t)PPE_Input_Layer.width * x_ratio;
+    buffer->height  = (uint32_t)PPE_Input_Layer.height * y_ratio;
+
+    PPE_Result_Layer.src_addr               = (uint32_t)buffer->memory;
+    PPE_Result_Layer.width                  = buffer->width;
+    PPE_Result_Layer.height                 = buffer->height;
+    PPE_Result_Layer.format                 = buffer->format;
+    PPE_Result_Layer.line_len               = ppe_buffer_stride(buffer);
+    PPE_Result_Layer.AXSIZE                 = 2;    // 32bit bandwidth
+    PPE_Result_Layer.INCR                   = PPE_ARBURST_INCR;
+    PPE_Result_Layer.AXCACHE                = 1;
+    PPE_Result_Layer.MAX_AXLEN_LOG          = PPE_MAX_AXLEN_127;
+    PPE_Result_Layer.PRIOR                  = 0;
+    PPE_Result_Layer.byte_swap              = PPE_NO_SWAP;
+    PPE_Result_Layer.handshake_mode         = PPE_DMA_SW_HANDSHAKE;
+    PPE_Result_Layer.polarity               = PPE_POLARITY_HIGH;
+    PPE_Result_Layer.handshake_en           = DISABLE;
+    PPE_Result_Layer.handshake_msize        = PPE_MSIZE_2;
+    PPE_Result_Layer.hw_index               = 0;
+    PPE_InitResultLayer(&PPE_Result_Layer);
+
+    PPE_Init_User.function          =   PPE_FUNCTION_SCALE;
+    PPE_Init(&PPE_Init_User);
+
+    PPE_Secure(ENABLE);
+    PPE_Start();
+
+    return PPE_SUCCESS;
+}
+
+void PPE_SetSoftwareThreshold(uint32_t pixels)
+{
+    ppe_sw_threshold = pixels;
+}
+
+uint8_t ppe_get_format_data_len(PPE_PIXEL_FORMAT format)
+{
+    if (((format >= PPE_ABGR8888) && (format <= PPE_RGBX8888))
+        || ((format >= PPE_ABGR8666) && (format <= PPE_RGBX6668)))
+    {
+        return 4;
+    }
+    if (((format >= PPE_ABGR4444) && (format <= PPE_RGBX4444))
+        || ((format >= PPE_ABGR1555) && (format <= PPE_RGBX5551))
+        || ((format >= PPE_BGR565) && (format <= PPE_RGB565)))
+    {
+        return 2;
+    }
+    if (((format >= PPE_ABGR2222) && (format <= PPE_RGBX2222))
+        || ((format >= PPE_A8) && (format <= PPE_X8)))
+    {
+        return 1;
+    }
+    if (((format >= PPE_ABGR8565) && (format <= PPE_RGBX5658))
+        || ((format >= PPE_BGR888) && (format <= PPE_RGB888)))
+    {
+        return 3;
+    }
+    return 0;
+}
+
+PPE_ERR PPE_Scale_Rect(ppe_buffer_t *image, ppe_buffer_t *buffer, float x_ratio, float y_ratio,
+                       ppe_rect_t *rect)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_SCALE);
+    if (buffer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if (image == NULL)
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+    PPE_InputLayer_InitTypeDef PPE_Input_Layer;
+    PPE_ResultLayer_InitTypeDef PPE_Result_Layer;
+    PPE_InitTypeDef PPE_Init_User;
+
+    PPE_InputLayer_StructInit(&PPE_Input_Layer);
+    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
+    PPE_structInit(&PPE_Init_User);
+    if ((image->address % 4) || (buffer->address % 4))
+    {
+        return PPE_ERROR_ADDR_NOT_ALIGNED;
+    }
+    if ((rect == NULL) || (rect->top > rect->bottom) || (rect->left > rect->right)
+        || (rect->right >= image->width) || (rect->bottom >= image->height))
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+    uint8_t format_len = ppe_get_format_data_len(image->format);
+    if (!format_len)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    PPE_WaitIdle();
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+
+    PPE_Input_Layer.src_addr                = (uint32_t)(image->address +
+                                                         (rect->left + ppe_buffer_stride(image) * rect->top) * format_len);
+    PPE_Input_Layer.start_x                 = 0;
+    PPE_Input_Layer.start_y                 = 0;
+    PPE_Input_Layer.width                   = rect->right - rect->left + 1;
+    PPE_Input_Layer.height                  = rect->bottom - rect->top + 1;
+    PPE_Input_Layer.const_ABGR8888_value    = 0XFFFFFFFF;
+    PPE_Input_Layer.format                  = image->format;
+    PPE_Input_Layer.src                     = PPE_LAYER_SRC_FROM_DMA;
+    PPE_Input_Layer.color_key_en            = DISABLE;
+    PPE_Input_Layer.line_len                = ppe_buffer_stride(image);
+    PPE_Input_Layer.key_color_value         = 0x000000;
+    PPE_Input_Layer.AXSIZE                  = 2; // 32bit bandwidth;
+    PPE_Input_Layer.INCR                    = PPE_ARBURST_INCR;
+    PPE_Input_Layer.AXCACHE                 = 1;
+    PPE_Input_Layer.MAX_AXLEN_LOG           = PPE_MAX_AXLEN_127;
+    PPE_Input_Layer.PRIOR                   = 0;
+    PPE_Input_Layer.byte_swap               = PPE_NO_SWAP;
+    PPE_Input_Layer.handshake_mode          = PPE_DMA_SW_HANDSHAKE;
+    PPE_Input_Layer.polarity                = PPE_POLARITY_HIGH;
+    PPE_Input_Layer.handshake_en            = DISABLE;
+    PPE_Input_Layer.handshake_msize         = PPE_MSIZE_2;
+    PPE_Input_Layer.hw_index                = 0;
+    PPE_InitInputLayer(1, &PPE_Input_Layer);
+    PPE->SCA_RATIO_X = (uint32_t)(65536 / x_ratio); // 65536/ratio_x,ratio = 2
+    PPE->SCA_RATIO_Y = (uint32_t)(65536 / y_ratio);
+    buffer->width   = (uint32_t)PPE_Input_Layer.width * x_ratio;
+    buffer->height  = (uint32_t)PPE_Input_Layer.height * y_ratio;
+    if (buffer->height == 0 || buffer->height == 0)
+    {
+        return PPE_SUCCESS_NOT_CHANGE;
+    }
+    PPE_Result_Layer.src_addr               = (uint32_t)buffer->memory;
+    PPE_Result_Layer.width                  = buffer->width;
+    PPE_Result_Layer.height                 = buffer->height;
+    PPE_Result_Layer.format                 = buffer->format;
+    PPE_Result_Layer.line_len               = ppe_buffer_stride(buffer);
+    PPE_Result_Layer.AXSIZE                 = 2;    // 32bit bandwidth
+    PPE_Result_Layer.INCR                   = PPE_ARBURST_INCR;
+    PPE_Result_Layer.AXCACHE                = 1;
+    PPE_Result_Layer.MAX_AXLEN_LOG          = PPE_MAX_AXLEN_127;
+    PPE_Result_Layer.PRIOR                  = 0;
+    PPE_Result_Layer.byte_swap              = PPE_NO_SWAP;
+    PPE_Result_Layer.handshake_mode         = PPE_DMA_SW_HANDSHAKE;
+    PPE_Result_Layer.polarity               = PPE_POLARITY_HIGH;
+    PPE_Result_Layer.handshake_en           = DISABLE;
+    PPE_Result_Layer.handshake_msize        = PPE_MSIZE_2;
+    PPE_Result_Layer.hw_index               = 0;
+    PPE_InitResultLayer(&PPE_Result_Layer);
+
+    PPE_Init_User.function          =   PPE_FUNCTION_SCALE;
+    PPE_Init(&PPE_Init_User);
+
+    PPE_Secure(ENABLE);
+    PPE_Start();
+
+    return PPE_SUCCESS;
 }
 
 PPE_ERR PPE_Scale_Rect_Cover(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
                              float x_ratio, float y_ratio,
                              ppe_rect_t *rect)
 {
-    if (buffer == NULL)
+    PPE_PERF_BEGIN(PPE_PERF_OP_SCALE);
+    if (buffer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if (image == NULL)
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+
+    PPE_InputLayer_InitTypeDef PPE_Input_Layer;
+    PPE_ResultLayer_InitTypeDef PPE_Result_Layer;
+    PPE_InitTypeDef PPE_Init_User;
+
+    PPE_InputLayer_StructInit(&PPE_Input_Layer);
+    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
+    PPE_structInit(&PPE_Init_User);
+    if ((image->address % 4) || (buffer->address % 4))
+    {
+        return PPE_ERROR_ADDR_NOT_ALIGNED;
+    }
+    if ((rect == NULL) || (rect->top > rect->bottom) || (rect->left > rect->right)
+        || (rect->right >= image->width) || (rect->bottom >= image->height))
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+    uint8_t format_len = ppe_get_format_data_len(image->format);
+    if (!format_len)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    PPE_WaitIdle();
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+
+    PPE_Input_Layer.src_addr                = (uint32_t)(image->address +
+                                                         (rect->left + ppe_buffer_stride(image) * rect->top) * format_len);
+    PPE_Input_Layer.start_x                 = 0;
+    PPE_Input_Layer.start_y                 = 0;
+    PPE_Input_Layer.width                   = rect->right - rect->left + 1;
+    PPE_Input_Layer.height                  = rect->bottom - rect->top + 1;
+    PPE_Input_Layer.const_ABGR8888_value    = 0XFFFFFFFF;
+    PPE_Input_Layer.format                  = image->format;
+    PPE_Input_Layer.src                     = PPE_LAYER_SRC_FROM_DMA;
+    PPE_Input_Layer.color_key_en            = DISABLE;
+    PPE_Input_Layer.line_len                = ppe_buffer_stride(image);
+    PPE_Input_Layer.key_color_value         = 0x000000;
+    PPE_Input_Layer.AXSIZE                  = 2; // 32bit bandwidth;
+    PPE_Input_Layer.INCR                    = PPE_ARBURST_INCR;
+    PPE_Input_Layer.AXCACHE                 = 1;
+    PPE_Input_Layer.MAX_AXLEN_LOG           = PPE_MAX_AXLEN_127;
+    PPE_Input_Layer.PRIOR                   = 0;
+    PPE_Input_Layer.byte_swap               = PPE_NO_SWAP;
+    PPE_Input_Layer.handshake_mode          = PPE_DMA_SW_HANDSHAKE;
+    PPE_Input_Layer.polarity                = PPE_POLARITY_HIGH;
+    PPE_Input_Layer.handshake_en            = DISABLE;
+    PPE_Input_Layer.handshake_msize         = PPE_MSIZE_2;
+    PPE_Input_Layer.hw_index                = 0;
+    PPE_InitInputLayer(1, &PPE_Input_Layer);
+    PPE->SCA_RATIO_X = (uint32_t)(65536 / x_ratio); // 65536/ratio_x,ratio = 2
+    PPE->SCA_RATIO_Y = (uint32_t)(65536 / y_ratio);
+    uint32_t width   = (uint32_t)PPE_Input_Layer.width * x_ratio;
+    uint32_t height  = (uint32_t)PPE_Input_Layer.height * y_ratio;
+
+    ppe_rect_t source_rect = {.left = trans->x, .right = trans->x + width - 1, \
+                              .top = trans->y, .bottom = trans->y + height - 1
+                             };
+    /*initial input layer1*/
+    ppe_rect_t target_rect = {.left = 0, .top = 0, .right = buffer->width - 1, .bottom = buffer->height - 1};
+    ppe_rect_t result_rect = {.left = 0, .top = 0, .right = 0, .bottom = 0};
+    if (!ppe_rect_intersect(&result_rect, &target_rect, &source_rect))
+    {
+        return PPE_SUCCESS;
+    }
+
+    if (height == 0 || height == 0)
+    {
+        return PPE_SUCCESS_NOT_CHANGE;
+    }
+    PPE_Result_Layer.src_addr               = (uint32_t)buffer->memory +
+                                              (result_rect.left + result_rect.top * ppe_buffer_stride(buffer)) * ppe_get_format_data_len(buffer->format);
+    PPE_Result_Layer.width                          = result_rect.right - result_rect.left + 1;
+    PPE_Result_Layer.height                         = result_rect.bottom - result_rect.top + 1;;
+    PPE_Result_Layer.line_len               = ppe_buffer_stride(buffer);
+    PPE_Result_Layer.format                 = buffer->format;
+    PPE_Result_Layer.AXSIZE                 = 2;    // 32bit bandwidth
+    PPE_Result_Layer.INCR                   = PPE_ARBURST_INCR;
+    PPE_Result_Layer.AXCACHE                = 1;
+    PPE_Result_Layer.MAX_AXLEN_LOG          = PPE_MAX_AXLEN_127;
+    PPE_Result_Layer.PRIOR                  = 0;
+    PPE_Result_Layer.byte_swap              = PPE_NO_SWAP;
+    PPE_Result_Layer.handshake_mode         = PPE_DMA_SW_HANDSHAKE;
+    PPE_Result_Layer.polarity               = PPE_POLARITY_HIGH;
+    PPE_Result_Layer.handshake_en           = DISABLE;
+    PPE_Result_Layer.handshake_msize        = PPE_MSIZE_2;
+    PPE_Result_Layer.hw_index               = 0;
+    PPE_InitResultLayer(&PPE_Result_Layer);
+
+    PPE_Init_User.function          =   PPE_FUNCTION_SCALE;
+    PPE_Init(&PPE_Init_User);
+
+    PPE_Secure(ENABLE);
+    PPE_Start();
+
+    return PPE_SUCCESS;
+}
+
+/*Q16 source step of dst_len result pixels covering src_len source pixels, floored so that the
+  last result pixel still samples inside the source, src_len is at most 0xFFFF so it fits 32 bit*/
+static uint32_t ppe_scale_step(uint32_t src_len, uint32_t dst_len)
+{
+    return (src_len << 16) / dst_len;
+}
+
+/*size and position of the scaled source inside dst, before any clipping*/
+static void ppe_scale_place(ppe_rect_t *src, ppe_rect_t *dst, PPE_SCALE_MODE mode, ppe_rect_t *place)
+{
+    uint32_t src_w = src->right - src->left + 1;
+    uint32_t src_h = src->bottom - src->top + 1;
+    uint32_t dst_w = dst->right - dst->left + 1;
+    uint32_t dst_h = dst->bottom - dst->top + 1;
+    uint32_t w = dst_w;
+    uint32_t h = dst_h;
+
+    if (mode != PPE_SCALE_STRETCH)
+    {
+        /*width bound when dst is relatively narrower than src*/
+        bool width_bound = ((uint64_t)dst_w * src_h <= (uint64_t)dst_h * src_w);
+        if (mode == PPE_SCALE_FILL)
+        {
+            width_bound = !width_bound;
+        }
+        if (width_bound)
+        {
+            h = (uint32_t)(((uint64_t)src_h * dst_w + src_w / 2) / src_w);
+        }
+        else
+        {
+            w = (uint32_t)(((uint64_t)src_w * dst_h + src_h / 2) / src_h);
+        }
+        w = MAX(w, 1);
+        h = MAX(h, 1);
+    }
+    place->left = dst->left + ((int32_t)dst_w - (int32_t)w) / 2;
+    place->top = dst->top + ((int32_t)dst_h - (int32_t)h) / 2;
+    place->right = place->left + (int32_t)w - 1;
+    place->bottom = place->top + (int32_t)h - 1;
+}
+
+/*scale the band part of place, sampling starts on the source pixel the band's first pixel maps to*/
+static void PPE_Scale_Band(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_rect_t *src,
+                           ppe_rect_t *place, ppe_rect_t *band, uint32_t step_x, uint32_t step_y)
+{
+    PPE_InputLayer_InitTypeDef PPE_Input_Layer;
+    PPE_ResultLayer_InitTypeDef PPE_Result_Layer;
+    PPE_InitTypeDef PPE_Init_User;
+    uint32_t src_x = src->left + (uint32_t)(((uint64_t)(band->left - place->left) * step_x) >> 16);
+    uint32_t src_y = src->top + (uint32_t)(((uint64_t)(band->top - place->top) * step_y) >> 16);
+
+    PPE_InputLayer_StructInit(&PPE_Input_Layer);
+    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
+    PPE_structInit(&PPE_Init_User);
+
+    PPE_WaitIdle();
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+
+    PPE_Input_Layer.src_addr                = (uint32_t)(image->address +
+                                                         (src_x + ppe_buffer_stride(image) * src_y) * ppe_get_format_data_len(image->format));
+    PPE_Input_Layer.start_x                 = 0;
+    PPE_Input_Layer.start_y                 = 0;
+    PPE_Input_Layer.width                   = src->right - src_x + 1;
+    PPE_Input_Layer.height                  = src->bottom - src_y + 1;
+    PPE_Input_Layer.const_ABGR8888_value    = 0XFFFFFFFF;
+    PPE_Input_Layer.format                  = image->format;
+    PPE_Input_Layer.src                     = PPE_LAYER_SRC_FROM_DMA;
+    PPE_Input_Layer.color_key_en            = DISABLE;
+    PPE_Input_Layer.line_len                = ppe_buffer_stride(image);
+    PPE_Input_Layer.key_color_value         = 0x000000;
+    PPE_Input_Layer.AXSIZE                  = 2; // 32bit bandwidth;
+    PPE_Input_Layer.INCR                    = PPE_ARBURST_INCR;
+    PPE_Input_Layer.AXCACHE                 = 1;
+    PPE_Input_Layer.MAX_AXLEN_LOG           = PPE_MAX_AXLEN_127;
+    PPE_Input_Layer.PRIOR                   = 0;
+    PPE_Input_Layer.byte_swap               = PPE_NO_SWAP;
+    PPE_Input_Layer.handshake_mode          = PPE_DMA_SW_HANDSHAKE;
+    PPE_Input_Layer.polarity                = PPE_POLARITY_HIGH;
+    PPE_Input_Layer.handshake_en            = DISABLE;
+    PPE_Input_Layer.handshake_msize         = PPE_MSIZE_2;
+    PPE_Input_Layer.hw_index                = 0;
+    PPE_InitInputLayer(1, &PPE_Input_Layer);
+    PPE->SCA_RATIO_X = step_x;
+    PPE->SCA_RATIO_Y = step_y;
+
+    PPE_Result_Layer.src_addr               = (uint32_t)(buffer->address +
+                                                         (band->left + ppe_buffer_stride(buffer) * band->top) * ppe_get_format_data_len(buffer->format));
+    PPE_Result_Layer.width                  = band->right - band->left + 1;
+    PPE_Result_Layer.height                 = band->bottom - band->top + 1;
+    PPE_Result_Layer.line_len               = ppe_buffer_stride(buffer);
+    PPE_Result_Layer.format                 = buffer->format;
+    PPE_Result_Layer.AXSIZE                 = 2;    // 32bit bandwidth
+    PPE_Result_Layer.INCR                   = PPE_ARBURST_INCR;
+    PPE_Result_Layer.AXCACHE                = 1;
+    PPE_Result_Layer.MAX_AXLEN_LOG          = PPE_MAX_AXLEN_127;
+    PPE_Result_Layer.PRIOR                  = 0;
+    PPE_Result_Layer.byte_swap              = PPE_NO_SWAP;
+    PPE_Result_Layer.handshake_mode         = PPE_DMA_SW_HANDSHAKE;
+    PPE_Result_Layer.polarity               = PPE_POLARITY_HIGH;
+    PPE_Result_Layer.handshake_en           = DISABLE;
+    PPE_Result_Layer.handshake_msize        = PPE_MSIZE_2;
+    PPE_Result_Layer.hw_index               = 0;
+    PPE_InitResultLayer(&PPE_Result_Layer);
+
+    PPE_Init_User.function          =   PPE_FUNCTION_SCALE;
+    PPE_Init(&PPE_Init_User);
+
+    PPE_Secure(ENABLE);
+    PPE_Start();
+}
+
+PPE_ERR PPE_Scale_To_Rect(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_rect_t *src_rect,
+                          ppe_rect_t *dst_rect, PPE_SCALE_MODE mode)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_SCALE);
+    if (buffer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if (image == NULL)
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+    if ((image->address % 4) || (buffer->address % 4))
+    {
+        return PPE_ERROR_ADDR_NOT_ALIGNED;
+    }
+    if (!ppe_get_format_data_len(image->format) || !ppe_get_format_data_len(buffer->format))
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+    if (image->width == 0 || image->height == 0 || buffer->width == 0 || buffer->height == 0)
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+
+    ppe_rect_t src = {.left = 0, .top = 0, .right = image->width - 1, .bottom = image->height - 1};
+    ppe_rect_t target = {.left = 0, .top = 0, .right = buffer->width - 1, .bottom = buffer->height - 1};
+    ppe_rect_t dst = target;
+    if (src_rect != NULL)
+    {
+        if ((src_rect->top > src_rect->bottom) || (src_rect->left > src_rect->right)
+            || (src_rect->left < 0) || (src_rect->top < 0)
+            || (src_rect->right >= image->width) || (src_rect->bottom >= image->height))
+        {
+            return PPE_ERROR_INVALID_PARAM;
+        }
+        src = *src_rect;
+    }
+    if (dst_rect != NULL)
+    {
+        if ((dst_rect->top > dst_rect->bottom) || (dst_rect->left > dst_rect->right))
+        {
+            return PPE_ERROR_INVALID_PARAM;
+        }
+        dst = *dst_rect;
+    }
+    if (mode > PPE_SCALE_FILL)
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+
+    ppe_rect_t place, clip, visible;
+    ppe_scale_place(&src, &dst, mode, &place);
+    if (!ppe_rect_intersect(&clip, &dst, &target) || !ppe_rect_intersect(&visible, &place, &clip))
+    {
+        return PPE_SUCCESS_NOT_CHANGE;
+    }
+    uint32_t step_x = ppe_scale_step(src.right - src.left + 1, place.right - place.left + 1);
+    uint32_t step_y = ppe_scale_step(src.bottom - src.top + 1, place.bottom - place.top + 1);
+
+    for (int32_t y = visible.top; y <= visible.bottom; y += PPE_SCALE_BAND_LINES)
+    {
+        ppe_rect_t band = {.left = visible.left, .top = y, .right = visible.right,
+                           .bottom = MIN(visible.bottom, y + PPE_SCALE_BAND_LINES - 1)
+                          };
+        PPE_Scale_Band(image, buffer, &src, &place, &band, step_x, step_y);
+    }
+
+    return PPE_SUCCESS;
+}
+
+PPE_ERR ppe_convert(ppe_buffer_t *src, ppe_buffer_t *dst, PPE_DITHER_MODE dither)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_CONVERT);
+    if (dst == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if (src == NULL)
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+    if (!ppe_get_format_data_len(src->format) || !ppe_get_format_data_len(dst->format))
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+    if ((src->width == 0) || (src->height == 0) || (dst->width != src->width)
+        || (dst->height != src->height) || (dither > PPE_DITHER_DIFFUSION))
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+
+    bool cpu_capable = ppe_sw_format_supported(src->format) && ppe_sw_format_supported(dst->format);
+    bool aligned = !(src->address % 4) && !(dst->address % 4);
+    uint8_t lost_r = 0;
+    uint8_t lost_g = 0;
+    uint8_t lost_b = 0;
+    if (cpu_capable)
+    {
+        lost_r = ppe_sw_lost_bits(ppe_sw_format[src->format].r, ppe_sw_format[dst->format].r);
+        lost_g = ppe_sw_lost_bits(ppe_sw_format[src->format].g, ppe_sw_format[dst->format].g);
+        lost_b = ppe_sw_lost_bits(ppe_sw_format[src->format].b, ppe_sw_format[dst->format].b);
+        if ((lost_r | lost_g | lost_b) == 0)
+        {
+            dither = PPE_DITHER_NONE;
+        }
+        else if ((dither == PPE_DITHER_DIFFUSION) && (src->width > PPE_CONVERT_LINE_MAX))
+        {
+            dither = PPE_DITHER_ORDERED;
+        }
+    }
+    else
+    {
+        dither = PPE_DITHER_NONE;
+    }
+
+    ppe_rect_t rect = {.left = 0, .top = 0, .right = src->width - 1, .bottom = src->height - 1};
+    if ((dither == PPE_DITHER_NONE) && aligned)
+    {
+        /*PPE truncates the channels the same way, run it as 1:1 scale in bands*/
+        for (int32_t y = 0; y < src->height; y += PPE_CONVERT_BAND_LINES)
+        {
+            ppe_rect_t band = {.left = 0, .top = y, .right = rect.right,
+                               .bottom = MIN(rect.bottom, y + PPE_CONVERT_BAND_LINES - 1)
+                              };
+            PPE_Scale_Band(src, dst, &rect, &rect, &band, 0x10000, 0x10000);
+        }
+        return PPE_SUCCESS;
+    }
+    if (!cpu_capable)
+    {
+        /*unaligned buffers need the CPU, which has no A8/X8 path*/
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    uint8_t src_len = ppe_get_format_data_len(src->format);
+    uint8_t dst_len = ppe_get_format_data_len(dst->format);
+    uint32_t src_pitch = ppe_buffer_stride(src) * src_len;
+    uint32_t dst_pitch = ppe_buffer_stride(dst) * dst_len;
+    const uint8_t *src_line = (const uint8_t *)src->memory;
+    uint8_t *dst_line = (uint8_t *)dst->memory;
+    uint32_t threshold[4][4];
+
+    if (dither == PPE_DITHER_ORDERED)
+    {
+        for (uint8_t i = 0; i < 16; i++)
+        {
+            uint32_t t = ppe_sw_bayer[i >> 2][i & 3];
+            threshold[i >> 2][i & 3] = (((t << lost_b) >> 4) << 16) | (((t << lost_g) >> 4) << 8) |
+                                       ((t << lost_r) >> 4);
+        }
+    }
+    else if (dither == PPE_DITHER_DIFFUSION)
+    {
+        memset(ppe_sw_diffuse, 0, sizeof(ppe_sw_diffuse));
+    }
+
+    PPE_WaitIdle();
+    for (uint32_t y = 0; y < src->height; y++, src_line += src_pitch, dst_line += dst_pitch)
+    {
+        if (dither == PPE_DITHER_DIFFUSION)
+        {
+            ppe_sw_diffuse_line(dst_line, dst->format, src_line, src->format, src->width);
+        }
+        else
+        {
+            ppe_sw_convert_line(dst_line, dst->format, src_line, src->format, src->width,
+                                (dither == PPE_DITHER_ORDERED) ? threshold[y & 3] : NULL);
+        }
+    }
+    return PPE_SUCCESS;
+}
+
+PPE_ERR ppe_convert_list(ppe_convert_item_t *item, uint32_t item_num, PPE_DITHER_MODE dither)
+{
+    if (item == NULL)
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+    for (uint32_t i = 0; i < item_num; i++)
+    {
+        PPE_ERR err = ppe_convert(item[i].src, item[i].dst, dither);
+        if ((err != PPE_SUCCESS) && (err != PPE_SUCCESS_NOT_CHANGE))
+        {
+            return err;
+        }
+    }
+    return PPE_SUCCESS;
+}
+
+PPE_ERR PPE_Clear(ppe_buffer_t *buffer, uint32_t color)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_CLEAR);
+    if (buffer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    /*declaration of input/result layer initialization struct*/
+    PPE_InputLayer_InitTypeDef          PPE_Input_Layer1;
+    PPE_ResultLayer_InitTypeDef         PPE_Result_Layer;
+    PPE_InitTypeDef                     PPE_Init_User;
+
+    PPE_InputLayer_StructInit(&PPE_Input_Layer1);
+    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
+    PPE_structInit(&PPE_Init_User);
+
+    PPE_WaitIdle();
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+
+    /*initial input layer1*/
+    PPE_Input_Layer1.src_addr                       = (uint32_t)NULL;
+    PPE_Input_Layer1.start_x                        = 0;
+    PPE_Input_Layer1.start_y                        = 0;
+    PPE_Input_Layer1.width                          = buffer->width;
+    PPE_Input_Layer1.height                         = buffer->height;
+    PPE_Input_Layer1.const_ABGR8888_value           = color;
+    PPE_Input_Layer1.format                         = PPE_ABGR8888;
+    PPE_Input_Layer1.src                            = PPE_LAYER_SRC_CONST;
+    PPE_Input_Layer1.color_key_en                   = DISABLE;
+    PPE_Input_Layer1.line_len                       = PPE_Input_Layer1.width;
+    PPE_Input_Layer1.key_color_value                = 0;
+    PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
+    PPE_Input_Layer1.INCR                           = PPE_ARBURST_FIX;
+    PPE_Input_Layer1.AXCACHE                        = 1;
+    PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+    PPE_Input_Layer1.PRIOR                          = 0;
+    PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
+    PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+    PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
+    PPE_Input_Layer1.handshake_en                   = DISABLE;
+    PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_2;
+    PPE_Input_Layer1.hw_index                       = 0;
+    PPE_InitInputLayer(1, &PPE_Input_Layer1);
+
+    /*initial result layer*/
+    PPE_Result_Layer.src_addr                   = (uint32_t)buffer->address;
+    PPE_Result_Layer.width                      = buffer->width;
+    PPE_Result_Layer.height                     = buffer->height;
+    PPE_Result_Layer.format                     = buffer->format;
+    PPE_Result_Layer.line_len                   = ppe_buffer_stride(buffer);
+    PPE_Result_Layer.AXSIZE                     = 2;    // 32bit bandwidth
+    PPE_Result_Layer.INCR                       = PPE_ARBURST_INCR;
+    PPE_Result_Layer.AXCACHE                    = 1;
+    PPE_Result_Layer.MAX_AXLEN_LOG              = PPE_MAX_AXLEN_127;
+    PPE_Result_Layer.PRIOR                      = 0;
+    PPE_Result_Layer.byte_swap                  = PPE_NO_SWAP;
+    PPE_Result_Layer.handshake_mode             = PPE_DMA_SW_HANDSHAKE;
+    PPE_Result_Layer.polarity                   = PPE_POLARITY_HIGH;
+    PPE_Result_Layer.handshake_en               = DISABLE;
+    PPE_Result_Layer.handshake_msize            = PPE_MSIZE_2;
+    PPE_Result_Layer.hw_index                   = 0;
+    PPE_InitResultLayer(&PPE_Result_Layer);
+
+
+    /*initial PPE global*/
+    PPE_Init_User.function   = PPE_FUNCTION_ALPHA_BLEND;
+    PPE_Init_User.blend_layer_num = 1;
+    PPE_Init(&PPE_Init_User);
+
+    PPE_Secure(ENABLE);  /*secure for all channel*/
+
+    /*enable PPE*/
+    PPE_Start();
+
+    return PPE_SUCCESS;
+}
+
+
+PPE_ERR PPE_Clear_Rect(ppe_buffer_t *buffer, ppe_rect_t *rect, uint32_t color)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_CLEAR);
+    /*declaration of input/result layer initialization struct*/
+    PPE_InputLayer_InitTypeDef      PPE_Input_Layer1;
+    PPE_InputLayer_InitTypeDef      PPE_Input_Layer2;
+    PPE_ResultLayer_InitTypeDef     PPE_Result_Layer;
+    PPE_InitTypeDef                 PPE_Init_User;
+
+    PPE_InputLayer_StructInit(&PPE_Input_Layer1);
+    PPE_InputLayer_StructInit(&PPE_Input_Layer2);
+    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
+    PPE_structInit(&PPE_Init_User);
+    if (buffer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if ((rect == NULL) || (rect->top > rect->bottom) || (rect->left > rect->right))
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+    uint8_t format_len = ppe_get_format_data_len(buffer->format);
+    if (format_len == 0)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    ppe_rect_t buffer_rect = {.left = 0, .right = buffer->width - 1, .top = 0, .bottom = buffer->height - 1};
+    ppe_rect_t transfer_rect;
+    if (!ppe_rect_intersect(&transfer_rect, &buffer_rect, rect))
+    {
+        return PPE_SUCCESS;
+    }
+
+    PPE_WaitIdle();
+    if (ppe_sw_accept(&transfer_rect) && ppe_sw_format_supported(buffer->format))
+    {
+        ppe_sw_clear_rect(buffer, &transfer_rect, color);
+        return PPE_SUCCESS;
+    }
+    /*initial input layer2*/
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+
+    PPE_Input_Layer2.src_addr                =  NULL;
+    PPE_Input_Layer2.width                          = transfer_rect.right - transfer_rect.left + 1;
+    PPE_Input_Layer2.height                         = transfer_rect.bottom - transfer_rect.top + 1;
+    if (buffer->global_alpha_en)
+    {
+        uint32_t mix_color = (((color >> 24) * buffer->global_alpha / 255) << 24) + (color & 0xFFFFFF);
+        PPE_Input_Layer2.const_ABGR8888_value           =  mix_color;
+    }
+    else
+    {
+        PPE_Input_Layer2.const_ABGR8888_value           = color;
+    }
+    PPE_Input_Layer2.color_key_en                   = DISABLE;
+    PPE_Input_Layer2.key_color_value                = 0;
+    PPE_Input_Layer2.format                         = PPE_ARGB8888;
+    PPE_Input_Layer2.src                            = PPE_LAYER_SRC_CONST;
+    PPE_Input_Layer2.line_len                       = transfer_rect.right - transfer_rect.left + 1;
+    PPE_Input_Layer2.AXSIZE                         = 2;// 32bit bandwidth;
+    PPE_Input_Layer2.INCR                           = PPE_ARBURST_FIX;
+    PPE_Input_Layer2.AXCACHE                        = 2;
+    PPE_Input_Layer2.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_15;
+    PPE_Input_Layer2.PRIOR                          = 0;
+    PPE_Input_Layer2.byte_swap                      = PPE_NO_SWAP;
+    PPE_Input_Layer2.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+    PPE_Input_Layer2.polarity                       = PPE_POLARITY_HIGH;
+    PPE_Input_Layer2.handshake_en                   = DISABLE;
+    PPE_Input_Layer2.handshake_msize                = PPE_MSIZE_2;
+    PPE_Input_Layer2.hw_index                       = 0;
+    if ((PPE_Input_Layer2.const_ABGR8888_value >> 24) < 0xFF)
+    {
+        /*initial input layer1*/
+        PPE_InitInputLayer(2, &PPE_Input_Layer2);
+        PPE_Input_Layer1.start_x                        = 0;
+        PPE_Input_Layer1.start_y                        = 0;
+        PPE_Input_Layer1.width                          = transfer_rect.right - transfer_rect.left + 1;
+        PPE_Input_Layer1.height                         = transfer_rect.bottom - transfer_rect.top + 1;
+        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory +
+                                                          (transfer_rect.left + transfer_rect.top * ppe_buffer_stride(buffer)) * ppe_get_format_data_len(buffer->format);
+        PPE_Input_Layer1.const_ABGR8888_value           = 0XFF000000;
+        PPE_Input_Layer1.format                         = buffer->format;
+        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_FROM_DMA;
+        PPE_Input_Layer1.color_key_en                   = DISABLE;
+        PPE_Input_Layer1.line_len                       = ppe_buffer_stride(buffer);
+        PPE_Input_Layer1.key_color_value                = buffer->color_key_value;
+        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
+        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
+        PPE_Input_Layer1.AXCACHE                        = 1;
+        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_15;
+        PPE_Input_Layer1.PRIOR                          = 0;
+        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
+        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
+        PPE_Input_Layer1.handshake_en                   = DISABLE;
+        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_2;
+        PPE_Input_Layer1.hw_index                       = 0;
+        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+        PPE_Init_User.blend_layer_num                   = 2;
+    }
+    else
+    {
+        memcpy(&PPE_Input_Layer1, &PPE_Input_Layer2, sizeof(PPE_InputLayer_InitTypeDef));
+        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+        PPE_Init_User.blend_layer_num                   = 1;
+    }
+
+    /*initial result layer*/
+    PPE_Result_Layer.width                          = transfer_rect.right - transfer_rect.left + 1;
+    PPE_Result_Layer.height                         = transfer_rect.bottom - transfer_rect.top + 1;
+    PPE_Result_Layer.src_addr                       = (uint32_t)buffer->memory +
+                                                      (transfer_rect.left + transfer_rect.top * ppe_buffer_stride(buffer)) * ppe_get_format_data_len(buffer->format);
+    PPE_Result_Layer.format                         = buffer->format;
+    PPE_Result_Layer.line_len                       = ppe_buffer_stride(buffer);
+    PPE_Result_Layer.AXSIZE                         = 2;// 32bit bandwidth
+    PPE_Result_Layer.INCR                           = PPE_ARBURST_INCR;
+    PPE_Result_Layer.AXCACHE                        = 1;
+    PPE_Result_Layer.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_15;
+    PPE_Result_Layer.PRIOR                          = 0;
+    PPE_Result_Layer.byte_swap                      = PPE_NO_SWAP;
+    PPE_Result_Layer.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+    PPE_Result_Layer.polarity                       = PPE_POLARITY_HIGH;
+    PPE_Result_Layer.handshake_en                   = DISABLE;
+    PPE_Result_Layer.handshake_msize                = PPE_MSIZE_2;
+    PPE_Result_Layer.hw_index                       = 0;
+    PPE_InitResultLayer(&PPE_Result_Layer);
+
+    /*initial PPE global*/
+    PPE_Init_User.function                          =   PPE_FUNCTION_ALPHA_BLEND;
+    PPE_Init(&PPE_Init_User);
+
+
+    PPE_Secure(ENABLE);  /*secure for all channel*/
+
+    /*enable PPE*/
+    PPE_Start();
+    return PPE_SUCCESS;
+}
+
+#define WINDOW      1
+PPE_ERR PPE_blend(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
+                  PPE_BLEND_MODE blend_mode)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLEND);
+    if (buffer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if (image == NULL)
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+    if ((trans->x < -(image->width - 1)) || (trans->x >= (buffer->width - 1)) \
+        || (trans->y < -(image->height - 1)) || (trans->y >= (buffer->height - 1)))
+    {
+        return PPE_ERROR_OUT_OF_RANGE;
+    }
+    uint8_t format_len = ppe_get_format_data_len(image->format);
+    if (format_len == 0)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    PPE_WaitIdle();
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+    /*declaration of input/result layer initialization struct*/
+    PPE_InputLayer_InitTypeDef      PPE_Input_Layer1;
+    PPE_InputLayer_InitTypeDef      PPE_Input_Layer2;
+    PPE_ResultLayer_InitTypeDef     PPE_Result_Layer;
+    PPE_InitTypeDef                 PPE_Init_User;
+
+    PPE_InputLayer_StructInit(&PPE_Input_Layer1);
+    PPE_InputLayer_StructInit(&PPE_Input_Layer2);
+    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
+    PPE_structInit(&PPE_Init_User);
+
+    ppe_rect_t source_rect = {.left = 0, .right = image->width - 1, \
+                              .top = 0, .bottom = image->height - 1
+                             };
+    /*initial input layer1*/
+    ppe_rect_t target_rect = {.left = trans->x, .top = trans->y};
+#if WINDOW
+    PPE_Input_Layer2.start_x = 0;
+    PPE_Input_Layer2.start_y = 0;
+#else
+    PPE_Input_Layer2.start_x = trans->x;
+    PPE_Input_Layer2.start_y = trans->y;
+#endif
+    if (trans->x < 0)
+    {
+        source_rect.left = -trans->x;
+        target_rect.left = 0;
+#if !WINDOW
+        PPE_Input_Layer2.start_x = 0;
+#endif
+    }
+    if ((trans->x + image->width) > buffer->width)
+    {
+        source_rect.right = buffer->width - trans->x - 1;
+    }
+    if (trans->y < 0)
+    {
+        source_rect.top = -trans->y;
+        target_rect.top = 0;
+#if !WINDOW
+        PPE_Input_Layer2.start_y = 0;
+#endif
+    }
+    if ((trans->y + image->height) > buffer->height)
+    {
+        source_rect.bottom = buffer->height - trans->y - 1;
+    }
+#if WINDOW
+    PPE_Input_Layer2.src_addr                       = (uint32_t)image->memory +
+                                                      (source_rect.left + ppe_buffer_stride(image) * source_rect.top) * format_len;
+    PPE_Input_Layer2.width                          = source_rect.right - source_rect.left + 1;
+    PPE_Input_Layer2.height                         = source_rect.bottom - source_rect.top + 1;
+#else
+    PPE_Input_Layer2.src_addr                       = (uint32_t)image->memory;
+    PPE_Input_Layer2.width                          = image->width;
+    PPE_Input_Layer2.height                         = image->height;
+#endif
+    if (image->global_alpha_en)
+    {
+        PPE_Input_Layer2.const_ABGR8888_value           = image->global_alpha << 24;
+    }
+    else
+    {
+        PPE_Input_Layer2.const_ABGR8888_value           = 0xFFFFFFFF;
+    }
+    PPE_Input_Layer2.format                         = image->format;
+    PPE_Input_Layer2.src                            = PPE_LAYER_SRC_FROM_DMA;
+    if (image->color_key_en)
+    {
+        PPE_Input_Layer2.color_key_en                   = ENABLE;
+        PPE_Input_Layer2.key_color_value                = image->color_key_value;
+    }
+    else
+    {
+        PPE_Input_Layer2.color_key_en                   = DISABLE;
+        PPE_Input_Layer2.key_color_value                = 0;
+    }
+    PPE_Input_Layer2.line_len                       = ppe_buffer_stride(image);
+    PPE_Input_Layer2.AXSIZE                         = 2;// 32bit bandwidth;
+    PPE_Input_Layer2.INCR                           = PPE_ARBURST_INCR;
+    PPE_Input_Layer2.AXCACHE                        = 1;
+    PPE_Input_Layer2.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+    PPE_Input_Layer2.PRIOR                          = 0;
+    PPE_Input_Layer2.byte_swap                      = PPE_NO_SWAP;
+    PPE_Input_Layer2.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+    PPE_Input_Layer2.polarity                       = PPE_POLARITY_HIGH;
+    PPE_Input_Layer2.handshake_en                   = DISABLE;
+    PPE_Input_Layer2.handshake_msize                = PPE_MSIZE_1024;
+    PPE_Input_Layer2.hw_index                       = 0;
+    PPE_InitInputLayer(2, &PPE_Input_Layer2);
+
+    if (blend_mode == PPE_BYPASS_MODE)
+    {
+        /*initial input layer2*/
+        PPE_Input_Layer1.start_x                        = 0;
+        PPE_Input_Layer1.start_y                        = 0;
+#if WINDOW
+        PPE_Input_Layer1.src_addr                       = NULL;
+        PPE_Input_Layer1.width                          = source_rect.right - source_rect.left + 1;
+        PPE_Input_Layer1.height                         = source_rect.bottom - source_rect.top + 1;
+#else
+        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory;
+        PPE_Input_Layer1.width                          = buffer->width;
+        PPE_Input_Layer1.height                         = buffer->height;
+#endif
+        PPE_Input_Layer1.const_ABGR8888_value           = 0;
+        PPE_Input_Layer1.format                         = buffer->format;
+        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_CONST;
+        PPE_Input_Layer1.color_key_en                   = DISABLE;
+        PPE_Input_Layer1.line_len                       = ppe_buffer_stride(buffer);
+        PPE_Input_Layer1.color_key_en                   = DISABLE;
+        PPE_Input_Layer1.key_color_value                = 0;
+        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
+        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
+        PPE_Input_Layer1.AXCACHE                        = 1;
+        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+        PPE_Input_Layer1.PRIOR                          = 0;
+        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
+        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
+        PPE_Input_Layer1.handshake_en                   = DISABLE;
+        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_1024;
+        PPE_Input_Layer1.hw_index                       = 0;
+        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+    }
+    else
+    {
+        /*initial input layer2*/
+        PPE_Input_Layer1.start_x                        = 0;
+        PPE_Input_Layer1.start_y                        = 0;
+#if WINDOW
+        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory +
+                                                          (target_rect.left + target_rect.top * ppe_buffer_stride(buffer)) * ppe_get_format_data_len(buffer->format);
+        PPE_Input_Layer1.width                          = source_rect.right - source_rect.left + 1;
+        PPE_Input_Layer1.height                         = source_rect.bottom - source_rect.top + 1;
+#else
+        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory;
+        PPE_Input_Layer1.width                          = buffer->width;
+        PPE_Input_Layer1.height                         = buffer->height;
+#endif
+        PPE_Input_Layer1.const_ABGR8888_value           = 0XFFAABBCC;
+        PPE_Input_Layer1.format                         = buffer->format;
+        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_FROM_DMA;
+        PPE_Input_Layer1.color_key_en                   = DISABLE;
+        PPE_Input_Layer1.line_len                       = ppe_buffer_stride(buffer);
+        PPE_Input_Layer1.key_color_value                = buffer->color_key_value;
+        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
+        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
+        PPE_Input_Layer1.AXCACHE                        = 1;
+        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+        PPE_Input_Layer1.PRIOR                          = 0;
+        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
+        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
+        PPE_Input_Layer1.handshake_en                   = DISABLE;
+        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_1024;
+        PPE_Input_Layer1.hw_index                       = 0;
+        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+    }
+
+    /*initial result layer*/
+    PPE_Result_Layer.src_addr                       = (uint32_t)buffer->memory +
+                                                      (target_rect.left + target_rect.top * ppe_buffer_stride(buffer)) * ppe_get_format_data_len(buffer->format);
+    PPE_Result_Layer.width                          = source_rect.right - source_rect.left + 1;
+    PPE_Result_Layer.height                         = source_rect.bottom - source_rect.top + 1;
+    PPE_Result_Layer.format                         = buffer->format;
+    PPE_Result_Layer.line_len                       = ppe_buffer_stride(buffer);
+    PPE_Result_Layer.AXSIZE                         = 2;// 32bit bandwidth
+    PPE_Result_Layer.INCR                           = PPE_ARBURST_INCR;
+    PPE_Result_Layer.AXCACHE                        = 1;
+    PPE_Result_Layer.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+    PPE_Result_Layer.PRIOR                          = 0;
+    PPE_Result_Layer.byte_swap                      = PPE_NO_SWAP;
+    PPE_Result_Layer.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+    PPE_Result_Layer.polarity                       = PPE_POLARITY_HIGH;
+    PPE_Result_Layer.handshake_en                   = DISABLE;
+    PPE_Result_Layer.handshake_msize                = PPE_MSIZE_1024;
+    PPE_Result_Layer.hw_index                       = 0;
+    PPE_InitResultLayer(&PPE_Result_Layer);
+
+    /*initial PPE global*/
+    PPE_Init_User.function                          = PPE_FUNCTION_ALPHA_BLEND;
+    PPE_Init_User.blend_layer_num                   = 2;
+    PPE_Init(&PPE_Init_User);
+    PPE_Secure(ENABLE);  /*secure for all channel*/
+    /*enable PPE*/
+    PPE_Start();
+    return PPE_SUCCESS;
+}
+
+PPE_ERR PPE_Blit_Orient(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
+                        PPE_ORIENT orient, PPE_BLEND_MODE blend_mode)
+{
+    if (buffer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if (image == NULL)
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+    if ((trans == NULL) || (orient > PPE_FLIP_V))
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+    if (orient == PPE_ROTATE_0)
+    {
+        return PPE_blend(image, buffer, trans, blend_mode);
+    }
+    if (!ppe_sw_format_supported(image->format) || !ppe_sw_format_supported(buffer->format))
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    bool swap = (orient == PPE_ROTATE_90) || (orient == PPE_ROTATE_270);
+    ppe_rect_t placed = {.left = trans->x, .top = trans->y,
+                         .right = trans->x + (swap ? image->height : image->width) - 1,
+                         .bottom = trans->y + (swap ? image->width : image->height) - 1
+                        };
+    ppe_rect_t buffer_rect = {.left = 0, .right = buffer->width - 1, .top = 0, .bottom = buffer->height - 1};
+    ppe_rect_t area;
+    if (!ppe_rect_intersect(&area, &buffer_rect, &placed))
+    {
+        return PPE_SUCCESS;
+    }
+
+    /*PPE has no transform stage, the CPU writes buffer, so a running job must finish first*/
+    PPE_WaitIdle();
+    ppe_sw_blit_orient(image, buffer, trans, &area, orient, blend_mode);
+    return PPE_SUCCESS;
+}
+
+PPE_ERR PPE_blend_rect(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
+                       ppe_rect_t *rect, PPE_BLEND_MODE blend_mode)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLEND);
+    /*declaration of input/result layer initialization struct*/
+    PPE_InputLayer_InitTypeDef      PPE_Input_Layer1;
+    PPE_InputLayer_InitTypeDef      PPE_Input_Layer2;
+    PPE_ResultLayer_InitTypeDef     PPE_Result_Layer;
+    PPE_InitTypeDef                 PPE_Init_User;
+
+    PPE_InputLayer_StructInit(&PPE_Input_Layer1);
+    PPE_InputLayer_StructInit(&PPE_Input_Layer2);
+    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
+    PPE_structInit(&PPE_Init_User);
+    if (buffer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if (image == NULL)
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+    if ((image->address % 4) || (buffer->address % 4))
+    {
+        return PPE_ERROR_ADDR_NOT_ALIGNED;
+    }
+    uint8_t format_len = ppe_get_format_data_len(image->format);
+    if (format_len == 0)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    ppe_rect_t source_rect = {.left = trans->x, .top = trans->y, .right = trans->x + image->width - 1, .bottom = trans->y + image->height - 1};
+    ppe_rect_t blend_area;
+    if (!ppe_rect_intersect(&blend_area, &source_rect, rect))
+    {
+        return PPE_SUCCESS;
+    }
+    source_rect.left = blend_area.x1 - trans->x;
+    source_rect.top = blend_area.y1 - trans->y;
+    source_rect.right = blend_area.x2 - trans->x;
+    source_rect.bottom = blend_area.y2 - trans->y;
+
+    PPE_WaitIdle();
+    /*bypass with global or per pixel alpha leaves PPE's own scaled output, keep it on PPE*/
+    if (ppe_sw_accept(&blend_area) && ppe_sw_format_supported(image->format)
+        && ppe_sw_format_supported(buffer->format)
+        && ((blend_mode != PPE_BYPASS_MODE) ||
+            (!image->global_alpha_en && (ppe_sw_format[image->format].a.bits == 0))))
+    {
+        ppe_sw_blend_rect(image, buffer, &source_rect, &blend_area, blend_mode);
+        return PPE_SUCCESS;
+    }
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+
+    /*initial input layer2*/
+    PPE_Input_Layer2.start_x = 0;
+    PPE_Input_Layer2.start_y = 0;
+    PPE_Input_Layer2.src_addr                = (uint32_t)image->memory +
+                                               (source_rect.left + ppe_buffer_stride(image) * source_rect.top) * format_len;
+    PPE_Input_Layer2.width                          = source_rect.right - source_rect.left + 1;
+    PPE_Input_Layer2.height                         = source_rect.bottom - source_rect.top + 1;
+    if (image->global_alpha_en)
+    {
+        PPE_Input_Layer2.const_ABGR8888_value           = image->global_alpha << 24;
+    }
+    else
+    {
+        PPE_Input_Layer2.const_ABGR8888_value           = 0xFFFFFFFF;
+    }
+    PPE_Input_Layer2.format                         = image->format;
+    PPE_Input_Layer2.src                            = PPE_LAYER_SRC_FROM_DMA;
+    if (image->color_key_en)
+    {
+        PPE_Input_Layer2.color_key_en                   = ENABLE;
+        PPE_Input_Layer2.key_color_value                = image->color_key_value;
+    }
+    else
+    {
+        PPE_Input_Layer2.color_key_en                   = DISABLE;
+        PPE_Input_Layer2.key_color_value                = 0;
+    }
+    PPE_Input_Layer2.line_len                       = ppe_buffer_stride(image);
+    PPE_Input_Layer2.AXSIZE                         = 2;// 32bit bandwidth;
+    PPE_Input_Layer2.INCR                           = PPE_ARBURST_INCR;
+    PPE_Input_Layer2.AXCACHE                        = 1;
+    PPE_Input_Layer2.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+    PPE_Input_Layer2.PRIOR                          = 0;
+    PPE_Input_Layer2.byte_swap                      = PPE_NO_SWAP;
+    PPE_Input_Layer2.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+    PPE_Input_Layer2.polarity                       = PPE_POLARITY_HIGH;
+    PPE_Input_Layer2.handshake_en                   = DISABLE;
+    PPE_Input_Layer2.handshake_msize                = PPE_MSIZE_2;
+    PPE_Input_Layer2.hw_index                       = 0;
+    PPE_InitInputLayer(2, &PPE_Input_Layer2);
+
+
+    if (blend_mode == PPE_BYPASS_MODE)
+    {
+        /*initial input layer1*/
+        PPE_Input_Layer1.start_x                        = 0;
+        PPE_Input_Layer1.start_y                        = 0;
+        PPE_Input_Layer1.src_addr                       = NULL;
+        PPE_Input_Layer1.width                          = blend_area.right - blend_area.left + 1;
+        PPE_Input_Layer1.height                         = blend_area.bottom - blend_area.top + 1;
+        PPE_Input_Layer1.const_ABGR8888_value           = 0;
+        PPE_Input_Layer1.format                         = buffer->format;
+        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_CONST;
+        PPE_Input_Layer1.color_key_en                   = DISABLE;
+        PPE_Input_Layer1.line_len                       = ppe_buffer_stride(buffer);
+        PPE_Input_Layer1.color_key_en                   = DISABLE;
+        PPE_Input_Layer1.key_color_value                = 0;
+        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
+        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
+        PPE_Input_Layer1.AXCACHE                        = 1;
+        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+        PPE_Input_Layer1.PRIOR                          = 0;
+        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
+        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
+        PPE_Input_Layer1.handshake_en                   = DISABLE;
+        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_1024;
+        PPE_Input_Layer1.hw_index                       = 0;
+        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+    }
+    /*initial input layer1*/
+    else
+    {
+        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory +
+                                                          (blend_area.left + blend_area.top * ppe_buffer_stride(buffer)) * ppe_get_format_data_len(buffer->format);
+        PPE_Input_Layer1.start_x                        = 0;
+        PPE_Input_Layer1.start_y                        = 0;
+        PPE_Input_Layer1.width                          = blend_area.right - blend_area.left + 1;
+        PPE_Input_Layer1.height                         = blend_area.bottom - blend_area.top + 1;
+        PPE_Input_Layer1.const_ABGR8888_value           = 0XFFFFFFFF;
+        PPE_Input_Layer1.format                         = buffer->format;
+        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_FROM_DMA;
+        PPE_Input_Layer1.color_key_en                   = DISABLE;
+        PPE_Input_Layer1.line_len                       = ppe_buffer_stride(buffer);
+        PPE_Input_Layer1.key_color_value                = buffer->color_key_value;
+        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
+        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
+        PPE_Input_Layer1.AXCACHE                        = 1;
+        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+        PPE_Input_Layer1.PRIOR                          = 0;
+        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
+        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
+        PPE_Input_Layer1.handshake_en                   = DISABLE;
+        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_2;
+        PPE_Input_Layer1.hw_index                       = 0;
+        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+    }
+
+    /*initial result layer*/
+    PPE_Result_Layer.src_addr                       = (uint32_t)buffer->memory +
+                                                      (blend_area.left + blend_area.top * ppe_buffer_stride(buffer)) * ppe_get_format_data_len(buffer->format);
+    PPE_Result_Layer.width                          = blend_area.right - blend_area.left + 1;
+    PPE_Result_Layer.height                         = blend_area.bottom - blend_area.top + 1;
+    PPE_Result_Layer.format                         = buffer->format;
+    PPE_Result_Layer.line_len                       = ppe_buffer_stride(buffer);
+    PPE_Result_Layer.AXSIZE                         = 2;// 32bit bandwidth
+    PPE_Result_Layer.INCR                           = PPE_ARBURST_INCR;
+    PPE_Result_Layer.AXCACHE                        = 1;
+    PPE_Result_Layer.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+    PPE_Result_Layer.PRIOR                          = 0;
+    PPE_Result_Layer.byte_swap                      = PPE_NO_SWAP;
+    PPE_Result_Layer.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+    PPE_Result_Layer.polarity                       = PPE_POLARITY_HIGH;
+    PPE_Result_Layer.handshake_en                   = DISABLE;
+    PPE_Result_Layer.handshake_msize                = PPE_MSIZE_2;
+    PPE_Result_Layer.hw_index                       = 0;
+    PPE_InitResultLayer(&PPE_Result_Layer);
+
+    /*initial PPE global*/
+    PPE_Init_User.function                          =   PPE_FUNCTION_ALPHA_BLEND;
+    PPE_Init_User.blend_layer_num                   = 2;
+    PPE_Init(&PPE_Init_User);
+
+    PPE_Secure(ENABLE);  /*secure for all channel*/
+
+    /*enable PPE*/
+    PPE_Start();
+
+    return PPE_SUCCESS;
+}
+
+/* program input slot id with the part of layer that lands on output */
+static PPE_ERR PPE_Multi_InitLayer(uint8_t id, ppe_layer_t *layer, ppe_layer_t *output)
+{
+    PPE_InputLayer_InitTypeDef      PPE_Input_Layer;
+    ppe_rect_t target_rect;
+
+    if (!ppe_layer_target_rect(layer, output, &target_rect))
     {
-        return PPE_ERROR_NULL_TARGET;
+        return PPE_SUCCESS_NOT_CHANGE;
     }
-    if (image == NULL)
+    PPE_InputLayer_StructInit(&PPE_Input_Layer);
+
+    /* the part of layer->rect (or the whole buffer) that lands on target_rect */
+    ppe_rect_t source_rect;
+    source_rect.left = target_rect.left - layer->trans.x;
+    source_rect.top = target_rect.top - layer->trans.y;
+    if (layer->rect)
     {
-        return PPE_ERROR_NULL_SOURCE;
+        source_rect.left += layer->rect->left;
+        source_rect.top += layer->rect->top;
     }
+    source_rect.right = source_rect.left + target_rect.right - target_rect.left;
+    source_rect.bottom = source_rect.top + target_rect.bottom - target_rect.top;
 
-    PPE_InputLayer_InitTypeDef PPE_Input_Layer;
-    PPE_ResultLayer_InitTypeDef PPE_Result_Layer;
-    PPE_InitTypeDef PPE_Init_User;
+    PPE_Input_Layer.start_x = target_rect.left;
+    PPE_Input_Layer.start_y = target_rect.top;
+    uint8_t format_len = ppe_get_format_data_len(layer->buffer.format);
+    if (format_len == 0)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
 
-    PPE_InputLayer_StructInit(&PPE_Input_Layer);
-    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
-    PPE_structInit(&PPE_Init_User);
-    if ((image->address % 4) || (buffer->address % 4))
+    PPE_Input_Layer.src_addr                        = (uint32_t)layer->buffer.memory +
+                                                      (source_rect.left + ppe_buffer_stride(&layer->buffer) * source_rect.top) * format_len;
+    PPE_Input_Layer.width                           = source_rect.right - source_rect.left + 1;
+    PPE_Input_Layer.height                          = source_rect.bottom - source_rect.top + 1;
+    if (layer->buffer.global_alpha_en)
     {
-        return PPE_ERROR_ADDR_NOT_ALIGNED;
+        PPE_Input_Layer.const_ABGR8888_value            = layer->buffer.global_alpha << 24;
     }
-    if ((rect == NULL) || (rect->top > rect->bottom) || (rect->left > rect->right)
-        || (rect->right >= image->width) || (rect->bottom >= image->height))
+    else
     {
-        return PPE_ERROR_INVALID_PARAM;
+        PPE_Input_Layer.const_ABGR8888_value            = 0xFFFFFFFF;
     }
-    uint8_t format_len = ppe_get_format_data_len(image->format);
-    if (!format_len)
+    PPE_Input_Layer.format                          = layer->buffer.format;
+    PPE_Input_Layer.src                             = PPE_LAYER_SRC_FROM_DMA;
+    if (layer->buffer.color_key_en)
     {
-        return PPE_ERROR_UNKNOWN_FORMAT;
+        PPE_Input_Layer.color_key_en                    = ENABLE;
+        PPE_Input_Layer.key_color_value                 = layer->buffer.color_key_value;
     }
+    else
+    {
+        PPE_Input_Layer.color_key_en                    = DISABLE;
+        PPE_Input_Layer.key_color_value                 = 0;
+    }
+    PPE_Input_Layer.line_len                        = ppe_buffer_stride(&layer->buffer);
+    PPE_Input_Layer.AXSIZE                          = 2;// 32bit bandwidth;
+    PPE_Input_Layer.INCR                            = PPE_ARBURST_INCR;
+    PPE_Input_Layer.AXCACHE                         = 1;
+    PPE_Input_Layer.MAX_AXLEN_LOG                   = PPE_MAX_AXLEN_127;
+    PPE_Input_Layer.PRIOR                           = 0;
+    PPE_Input_Layer.byte_swap                       = PPE_NO_SWAP;
+    PPE_Input_Layer.handshake_mode                  = PPE_DMA_SW_HANDSHAKE;
+    PPE_Input_Layer.polarity                        = PPE_POLARITY_HIGH;
+    PPE_Input_Layer.handshake_en                    = DISABLE;
+    PPE_Input_Layer.handshake_msize                 = PPE_MSIZE_1024;
+    PPE_Input_Layer.hw_index                        = 0;
+    PPE_InitInputLayer(id, &PPE_Input_Layer);
+    return PPE_SUCCESS;
+}
 
-    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+/* layer pixels replace whatever lies below them */
+static bool ppe_layer_opaque(ppe_layer_t *layer)
+{
+    ppe_buffer_t *buffer = &layer->buffer;
 
-    PPE_Input_Layer.src_addr                = (uint32_t)(image->address +
-                                                         (rect->left + image->width * rect->top) * format_len);
-    PPE_Input_Layer.start_x                 = 0;
-    PPE_Input_Layer.start_y                 = 0;
-    PPE_Input_Layer.width                   = rect->right - rect->left + 1;
-    PPE_Input_Layer.height                  = rect->bottom - rect->top + 1;
-    PPE_Input_Layer.const_ABGR8888_value    = 0XFFFFFFFF;
-    PPE_Input_Layer.format                  = image->format;
-    PPE_Input_Layer.src                     = PPE_LAYER_SRC_FROM_DMA;
-    PPE_Input_Layer.color_key_en            = DISABLE;
-    PPE_Input_Layer.line_len                = image->width;
-    PPE_Input_Layer.key_color_value         = 0x000000;
-    PPE_Input_Layer.AXSIZE                  = 2; // 32bit bandwidth;
-    PPE_Input_Layer.INCR                    = PPE_ARBURST_INCR;
-    PPE_Input_Layer.AXCACHE                 = 1;
-    PPE_Input_Layer.MAX_AXLEN_LOG           = PPE_MAX_AXLEN_127;
-    PPE_Input_Layer.PRIOR                   = 0;
-    PPE_Input_Layer.byte_swap               = PPE_NO_SWAP;
-    PPE_Input_Layer.handshake_mode          = PPE_DMA_SW_HANDSHAKE;
-    PPE_Input_Layer.polarity                = PPE_POLARITY_HIGH;
-    PPE_Input_Layer.handshake_en            = DISABLE;
-    PPE_Input_Layer.handshake_msize         = PPE_MSIZE_2;
-    PPE_Input_Layer.hw_index                = 0;
-    PPE_InitInputLayer(1, &PPE_Input_Layer);
-    PPE->SCA_RATIO_X = (uint32_t)(65536 / x_ratio); // 65536/ratio_x,ratio = 2
-    PPE->SCA_RATIO_Y = (uint32_t)(65536 / y_ratio);
-    uint32_t width   = (uint32_t)PPE_Input_Layer.width * x_ratio;
-    uint32_t height  = (uint32_t)PPE_Input_Layer.height * y_ratio;
+    if (buffer->color_key_en || (buffer->global_alpha_en && (buffer->global_alpha != 0xFF)))
+    {
+        return false;
+    }
+    return ppe_sw_format_supported(buffer->format) && (ppe_sw_format[buffer->format].a.bits == 0);
+}
 
-    ppe_rect_t source_rect = {.left = trans->x, .right = trans->x + width - 1, \
-                              .top = trans->y, .bottom = trans->y + height - 1
-                             };
-    /*initial input layer1*/
-    ppe_rect_t target_rect = {.left = 0, .top = 0, .right = buffer->width - 1, .bottom = buffer->height - 1};
-    ppe_rect_t result_rect = {.left = 0, .top = 0, .right = 0, .bottom = 0};
-    if (!ppe_rect_intersect(&result_rect, &target_rect, &source_rect))
+/* remove cut from rect where the rest stays a rectangle, false when cut covers all of rect */
+static bool ppe_rect_subtract(ppe_rect_t *rect, ppe_rect_t *cut)
+{
+    bool cover_x = (cut->left <= rect->left) && (cut->right >= rect->right);
+    bool cover_y = (cut->top <= rect->top) && (cut->bottom >= rect->bottom);
+
+    if ((cut->left > rect->right) || (cut->right < rect->left) || (cut->top > rect->bottom) ||
+        (cut->bottom < rect->top))
     {
-        return PPE_SUCCESS;
+        return true;
+    }
+    if (cover_x && cover_y)
+    {
+        return false;
+    }
+    if (cover_y)
+    {
+        if (cut->left <= rect->left)
+        {
+            rect->left = cut->right + 1;
+        }
+        else if (cut->right >= rect->right)
+        {
+            rect->right = cut->left - 1;
+        }
     }
+    else if (cover_x)
+    {
+        if (cut->top <= rect->top)
+        {
+            rect->top = cut->bottom + 1;
+        }
+        else if (cut->bottom >= rect->bottom)
+        {
+            rect->bottom = cut->top - 1;
+        }
+    }
+    return true;
+}
 
-    if (height == 0 || height == 0)
+/* part of output where input[index] can still be seen through the layers above it, false if it
+   is hidden or misses output */
+static bool ppe_layer_cull(ppe_layer_t **input, uint8_t index, uint8_t input_num, ppe_layer_t *output,
+                           ppe_rect_t *visible)
+{
+    if (!ppe_layer_target_rect(input[index], output, visible))
     {
-        return PPE_SUCCESS_NOT_CHANGE;
+        return false;
     }
-    PPE_Result_Layer.src_addr               = (uint32_t)buffer->memory +
-                                              (result_rect.left + result_rect.top * buffer->width) * ppe_get_format_data_len(buffer->format);
-    PPE_Result_Layer.width                          = result_rect.right - result_rect.left + 1;
-    PPE_Result_Layer.height                         = result_rect.bottom - result_rect.top + 1;;
-    PPE_Result_Layer.line_len               = buffer->width;
-    PPE_Result_Layer.format                 = buffer->format;
-    PPE_Result_Layer.AXSIZE                 = 2;    // 32bit bandwidth
-    PPE_Result_Layer.INCR                   = PPE_ARBURST_INCR;
-    PPE_Result_Layer.AXCACHE                = 1;
-    PPE_Result_Layer.MAX_AXLEN_LOG          = PPE_MAX_AXLEN_127;
-    PPE_Result_Layer.PRIOR                  = 0;
-    PPE_Result_Layer.byte_swap              = PPE_NO_SWAP;
-    PPE_Result_Layer.handshake_mode         = PPE_DMA_SW_HANDSHAKE;
-    PPE_Result_Layer.polarity               = PPE_POLARITY_HIGH;
-    PPE_Result_Layer.handshake_en           = DISABLE;
-    PPE_Result_Layer.handshake_msize        = PPE_MSIZE_2;
-    PPE_Result_Layer.hw_index               = 0;
-    PPE_InitResultLayer(&PPE_Result_Layer);
+    for (uint8_t j = index + 1; j < input_num; j++)
+    {
+        ppe_rect_t cover;
+        if ((input[j] == NULL) || !ppe_layer_opaque(input[j]) ||
+            !ppe_layer_target_rect(input[j], output, &cover))
+        {
+            continue;
+        }
+        if (!ppe_rect_subtract(visible, &cover))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
-    PPE_Init_User.function          =   PPE_FUNCTION_SCALE;
-    PPE_Init(&PPE_Init_User);
+/* blend input[0] (bottom) to input[input_num - 1] into output in one job, layers that miss
+   output are skipped and the rest are packed into consecutive slots */
+static PPE_ERR PPE_Multi_Run(ppe_layer_t **input, uint8_t input_num, ppe_layer_t *output)
+{
+    PPE_ResultLayer_InitTypeDef     PPE_Result_Layer;
+    PPE_InitTypeDef                 PPE_Init_User;
 
-    PPE_Secure(ENABLE);
-    PPE_Cmd(ENABLE);
-    while (PPE->GLB_CTL & BIT0);
+    PPE_WaitIdle();
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
+    PPE_structInit(&PPE_Init_User);
+
+    PPE_Init_User.blend_layer_num = 0;
+    for (uint8_t i = 0; i < input_num; i++)
+    {
+        if (input[i] == NULL)
+        {
+            continue;
+        }
+        ppe_layer_t *layer = input[i];
+#if PPE_OCCLUSION_CULL_EN
+        ppe_layer_t sub;
+        ppe_rect_t target;
+        ppe_rect_t visible;
+        if (!ppe_layer_cull(input, i, input_num, output, &visible))
+        {
+            continue;
+        }
+        ppe_layer_target_rect(layer, output, &target);
+        if (memcmp(&target, &visible, sizeof(ppe_rect_t)) != 0)
+        {
+            /*partly covered, only fetch the part that shows*/
+            PPE_ERR err = PPE_Damage_ClipLayer(layer, &visible, &sub);
+            if (err != PPE_SUCCESS)
+            {
+                return err;
+            }
+            sub.trans.x += visible.left;
+            sub.trans.y += visible.top;
+            layer = &sub;
+        }
+#endif
+        PPE_ERR err = PPE_Multi_InitLayer(PPE_Init_User.blend_layer_num + 1, layer, output);
+        if (err == PPE_SUCCESS)
+        {
+            PPE_Init_User.blend_layer_num++;
+        }
+        else if (err != PPE_SUCCESS_NOT_CHANGE)
+        {
+            return err;
+        }
+    }
+
+    /*initial result layer*/
+    PPE_Result_Layer.src_addr                       = (uint32_t)output->buffer.memory;
+    PPE_Result_Layer.width                          = output->buffer.width;
+    PPE_Result_Layer.height                         = output->buffer.height;
+    PPE_Result_Layer.format                         = output->buffer.format;
+    PPE_Result_Layer.line_len                       = ppe_buffer_stride(&output->buffer);
+    PPE_Result_Layer.AXSIZE                         = 2;// 32bit bandwidth
+    PPE_Result_Layer.INCR                           = PPE_ARBURST_INCR;
+    PPE_Result_Layer.AXCACHE                        = 1;
+    PPE_Result_Layer.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
+    PPE_Result_Layer.PRIOR                          = 0;
+    PPE_Result_Layer.byte_swap                      = PPE_NO_SWAP;
+    PPE_Result_Layer.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
+    PPE_Result_Layer.polarity                       = PPE_POLARITY_HIGH;
+    PPE_Result_Layer.handshake_en                   = DISABLE;
+    PPE_Result_Layer.handshake_msize                = PPE_MSIZE_1024;
+    PPE_Result_Layer.hw_index                       = 0;
+    PPE_InitResultLayer(&PPE_Result_Layer);
 
+    /*initial PPE global*/
+    PPE_Init_User.function                          =   PPE_FUNCTION_ALPHA_BLEND;
+    PPE_Init(&PPE_Init_User);
+    PPE_Secure(ENABLE);  /*secure for all channel*/
+    /*enable PPE*/
+    PPE_Start();
     return PPE_SUCCESS;
 }
 
-PPE_ERR PPE_Clear(ppe_buffer_t *buffer, uint32_t color)
+PPE_ERR PPE_blend_multi(ppe_input_list_t list)
 {
-    if (buffer == NULL)
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLEND_MULTI);
+    if (list.output_layer == NULL)
     {
         return PPE_ERROR_NULL_TARGET;
     }
-    /*declaration of input/result layer initialization struct*/
-    PPE_InputLayer_InitTypeDef          PPE_Input_Layer1;
-    PPE_ResultLayer_InitTypeDef         PPE_Result_Layer;
-    PPE_InitTypeDef                     PPE_Init_User;
 
-    PPE_InputLayer_StructInit(&PPE_Input_Layer1);
-    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
-    PPE_structInit(&PPE_Init_User);
+    ppe_layer_t *input[4] = {list.input_layer1, list.input_layer2, list.input_layer3, list.input_layer4};
+    return PPE_Multi_Run(input, 4, list.output_layer);
+}
 
-    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+bool PPE_JobPoll(ppe_job_t job)
+{
+    if (job == PPE_JOB_INVALID)
+    {
+        return true;
+    }
+    PPE_JobService();
+    return ((int32_t)(ppe_job_done - job) >= 0);
+}
 
-    /*initial input layer1*/
-    PPE_Input_Layer1.src_addr                       = (uint32_t)NULL;
-    PPE_Input_Layer1.start_x                        = 0;
-    PPE_Input_Layer1.start_y                        = 0;
-    PPE_Input_Layer1.width                          = buffer->width;
-    PPE_Input_Layer1.height                         = buffer->height;
-    PPE_Input_Layer1.const_ABGR8888_value           = color;
-    PPE_Input_Layer1.format                         = PPE_ABGR8888;
-    PPE_Input_Layer1.src                            = PPE_LAYER_SRC_CONST;
-    PPE_Input_Layer1.color_key_en                   = DISABLE;
-    PPE_Input_Layer1.line_len                       = PPE_Input_Layer1.width;
-    PPE_Input_Layer1.key_color_value                = 0;
-    PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
-    PPE_Input_Layer1.INCR                           = PPE_ARBURST_FIX;
-    PPE_Input_Layer1.AXCACHE                        = 1;
-    PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-    PPE_Input_Layer1.PRIOR                          = 0;
-    PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
-    PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-    PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
-    PPE_Input_Layer1.handshake_en                   = DISABLE;
-    PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_2;
-    PPE_Input_Layer1.hw_index                       = 0;
-    PPE_InitInputLayer(1, &PPE_Input_Layer1);
+void PPE_JobWait(ppe_job_t job)
+{
+    while (!PPE_JobPoll(job));
+}
 
-    /*initial result layer*/
-    PPE_Result_Layer.src_addr                   = (uint32_t)buffer->address;
-    PPE_Result_Layer.width                      = buffer->width;
-    PPE_Result_Layer.height                     = buffer->height;
-    PPE_Result_Layer.format                     = buffer->format;
-    PPE_Result_Layer.line_len                   = PPE_Result_Layer.width;
-    PPE_Result_Layer.AXSIZE                     = 2;    // 32bit bandwidth
-    PPE_Result_Layer.INCR                       = PPE_ARBURST_INCR;
-    PPE_Result_Layer.AXCACHE                    = 1;
-    PPE_Result_Layer.MAX_AXLEN_LOG              = PPE_MAX_AXLEN_127;
-    PPE_Result_Layer.PRIOR                      = 0;
-    PPE_Result_Layer.byte_swap                  = PPE_NO_SWAP;
-    PPE_Result_Layer.handshake_mode             = PPE_DMA_SW_HANDSHAKE;
-    PPE_Result_Layer.polarity                   = PPE_POLARITY_HIGH;
-    PPE_Result_Layer.handshake_en               = DISABLE;
-    PPE_Result_Layer.handshake_msize            = PPE_MSIZE_2;
-    PPE_Result_Layer.hw_index                   = 0;
-    PPE_InitResultLayer(&PPE_Result_Layer);
+void PPE_JobIRQHandler(void)
+{
+    if (PPE_GetINTStatus(PPE_ALL_OVER_INT) == SET)
+    {
+        PPE_JobFinish();
+    }
+}
 
+PPE_ERR PPE_Scale_Async(ppe_buffer_t *image, ppe_buffer_t *buffer, float x_ratio, float y_ratio,
+                        ppe_job_callback_t callback, void *user_data, ppe_job_t *job)
+{
+    PPE_JobBegin(callback, user_data);
+    return PPE_JobEnd(PPE_Scale(image, buffer, x_ratio, y_ratio), job);
+}
 
-    /*initial PPE global*/
-    PPE_Init_User.function   = PPE_FUNCTION_ALPHA_BLEND;
-    PPE_Init_User.blend_layer_num = 1;
-    PPE_Init(&PPE_Init_User);
+PPE_ERR PPE_Scale_Rect_Async(ppe_buffer_t *image, ppe_buffer_t *buffer, float x_ratio,
+                             float y_ratio, ppe_rect_t *rect,
+                             ppe_job_callback_t callback, void *user_data, ppe_job_t *job)
+{
+    PPE_JobBegin(callback, user_data);
+    return PPE_JobEnd(PPE_Scale_Rect(image, buffer, x_ratio, y_ratio, rect), job);
+}
 
-    PPE_Secure(ENABLE);  /*secure for all channel*/
+PPE_ERR PPE_Clear_Async(ppe_buffer_t *buffer, uint32_t color,
+                        ppe_job_callback_t callback, void *user_data, ppe_job_t *job)
+{
+    PPE_JobBegin(callback, user_data);
+    return PPE_JobEnd(PPE_Clear(buffer, color), job);
+}
 
-    /*enable PPE*/
-    PPE_Cmd(ENABLE);
-    while (PPE->GLB_CTL & BIT0);
+PPE_ERR PPE_Clear_Rect_Async(ppe_buffer_t *buffer, ppe_rect_t *rect, uint32_t color,
+                             ppe_job_callback_t callback, void *user_data, ppe_job_t *job)
+{
+    PPE_JobBegin(callback, user_data);
+    return PPE_JobEnd(PPE_Clear_Rect(buffer, rect, color), job);
+}
 
-    return PPE_SUCCESS;
+PPE_ERR PPE_blend_Async(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
+                        PPE_BLEND_MODE blend_mode,
+                        ppe_job_callback_t callback, void *user_data, ppe_job_t *job)
+{
+    PPE_JobBegin(callback, user_data);
+    return PPE_JobEnd(PPE_blend(image, buffer, trans, blend_mode), job);
 }
 
+PPE_ERR PPE_blend_rect_Async(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
+                             ppe_rect_t *rect, PPE_BLEND_MODE blend_mode,
+                             ppe_job_callback_t callback, void *user_data, ppe_job_t *job)
+{
+    PPE_JobBegin(callback, user_data);
+    return PPE_JobEnd(PPE_blend_rect(image, buffer, trans, rect, blend_mode), job);
+}
 
-PPE_ERR PPE_Clear_Rect(ppe_buffer_t *buffer, ppe_rect_t *rect, uint32_t color)
+PPE_ERR PPE_blend_multi_Async(ppe_input_list_t list,
+                              ppe_job_callback_t callback, void *user_data, ppe_job_t *job)
 {
-    /*declaration of input/result layer initialization struct*/
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer1;
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer2;
-    PPE_ResultLayer_InitTypeDef     PPE_Result_Layer;
-    PPE_InitTypeDef                 PPE_Init_User;
+    PPE_JobBegin(callback, user_data);
+    return PPE_JobEnd(PPE_blend_multi(list), job);
+}
 
-    PPE_InputLayer_StructInit(&PPE_Input_Layer1);
-    PPE_InputLayer_StructInit(&PPE_Input_Layer2);
-    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
-    PPE_structInit(&PPE_Init_User);
-    if (buffer == NULL)
+static ppe_cmd_t *PPE_CmdList_Alloc(ppe_cmdlist_t *list)
+{
+    if (list->cmd_num >= list->cmd_max)
     {
-        return PPE_ERROR_NULL_TARGET;
+        return NULL;
     }
-    if ((rect == NULL) || (rect->top > rect->bottom) || (rect->left > rect->right))
+    ppe_cmd_t *cmd = &list->cmd[list->cmd_num++];
+    memset(cmd, 0, sizeof(ppe_cmd_t));
+    return cmd;
+}
+
+static void PPE_CmdList_SetResultLayer(ppe_cmd_t *cmd, uint32_t addr, uint16_t width,
+                                       uint16_t height, PPE_PIXEL_FORMAT format, uint16_t line_len)
+{
+    PPE_LAYER0_WIN_SIZE_TypeDef win_size = {.d32 = 0};
+    win_size.b.width = width;
+    win_size.b.height = height;
+
+    PPE_LAYER0_PIC_CFG_TypeDef pic_cfg = {.d32 = 0};
+    pic_cfg.b.format = format;
+
+    cmd->node.result_layer.LAYER_ADDR       = addr;
+    cmd->node.result_layer.LAYER_POS        = 0;
+    cmd->node.result_layer.LAYER_WINSIZE    = win_size.d32;
+    cmd->node.result_layer.LAYER_CONST_PIX  = 0;
+    cmd->cfg.result_pic_cfg                 = pic_cfg.d32;
+    cmd->line_len[0]                        = line_len;
+}
+
+static void PPE_CmdList_SetInputLayer(ppe_cmd_t *cmd, uint8_t id, uint32_t addr, uint16_t width,
+                                      uint16_t height, uint32_t const_pix, PPE_PIXEL_SOURCE src,
+                                      PPE_PIXEL_FORMAT format, uint16_t line_len)
+{
+    PPE_LAYERX_WIN_SIZE_TypeDef win_size = {.d32 = 0};
+    win_size.b.width = width;
+    win_size.b.height = height;
+
+    PPE_LAYERX_PIC_CFG_TypeDef pic_cfg = {.d32 = 0};
+    pic_cfg.b.pix_src = src;
+    pic_cfg.b.format = format;
+
+    cmd->node.input_layer[id - 1].LAYER_ADDR        = addr;
+    cmd->node.input_layer[id - 1].LAYER_POS         = 0;
+    cmd->node.input_layer[id - 1].LAYER_WINSIZE     = win_size.d32;
+    cmd->node.input_layer[id - 1].LAYER_CONST_PIX   = const_pix;
+    cmd->cfg.input_pic_cfg[id - 1]                  = pic_cfg.d32;
+    cmd->line_len[id]                               = line_len;
+}
+
+static void PPE_CmdList_SetFunction(ppe_cmd_t *cmd, uint32_t function, uint32_t blend_layer_num)
+{
+    PPE_FUNC_CFG_TypeDef func_cfg = {.d32 = 0};
+    func_cfg.b.func_sel = function;
+    func_cfg.b.blend_lay = blend_layer_num;
+    cmd->cfg.func_cfg = func_cfg.d32;
+}
+
+/*line length of layer id of cmd if the layer walks more than one line in memory, otherwise 0*/
+static uint16_t PPE_CmdList_LineLen(ppe_cmd_t *cmd, uint8_t id)
+{
+    if (id == 0)
     {
-        return PPE_ERROR_INVALID_PARAM;
+        PPE_LAYER0_WIN_SIZE_TypeDef win_size = {.d32 = cmd->node.result_layer.LAYER_WINSIZE};
+        return (win_size.b.height > 1) ? cmd->line_len[0] : 0;
     }
-    uint8_t format_len = ppe_get_format_data_len(buffer->format);
-    if (format_len == 0)
+    PPE_LAYERX_PIC_CFG_TypeDef pic_cfg = {.d32 = cmd->cfg.input_pic_cfg[id - 1]};
+    PPE_LAYERX_WIN_SIZE_TypeDef win_size = {.d32 = cmd->node.input_layer[id - 1].LAYER_WINSIZE};
+    if ((pic_cfg.b.pix_src == PPE_LAYER_SRC_CONST) || (win_size.b.height <= 1))
     {
-        return PPE_ERROR_UNKNOWN_FORMAT;
+        return 0;
     }
+    return cmd->line_len[id];
+}
 
-    ppe_rect_t buffer_rect = {.left = 0, .right = buffer->width - 1, .top = 0, .bottom = buffer->height - 1};
-    ppe_rect_t transfer_rect;
-    if (!ppe_rect_intersect(&transfer_rect, &buffer_rect, rect))
+/*a command joins the run if the registers it cannot reload match, line_len is taken from the
+  first command that needs it, and later commands only break the run if they need another one*/
+static bool PPE_CmdList_JoinRun(ppe_cmd_t *cmd, ppe_cmd_cfg_t *cfg, uint16_t line_len[3])
+{
+    if (memcmp(&cmd->cfg, cfg, sizeof(ppe_cmd_cfg_t)) != 0)
     {
-        return PPE_SUCCESS;
+        return false;
     }
-
-    /*initial input layer2*/
-    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
-
-    PPE_Input_Layer2.src_addr                =  NULL;
-    PPE_Input_Layer2.width                          = transfer_rect.right - transfer_rect.left + 1;
-    PPE_Input_Layer2.height                         = transfer_rect.bottom - transfer_rect.top + 1;
-    if (buffer->global_alpha_en)
+    for (uint8_t id = 0; id < 3; id++)
     {
-        uint32_t mix_color = (((color >> 24) * buffer->global_alpha / 255) << 24) + (color & 0xFFFFFF);
-        PPE_Input_Layer2.const_ABGR8888_value           =  mix_color;
+        uint16_t len = PPE_CmdList_LineLen(cmd, id);
+        if ((len != 0) && (line_len[id] != 0) && (len != line_len[id]))
+        {
+            return false;
+        }
     }
-    else
+    for (uint8_t id = 0; id < 3; id++)
     {
-        PPE_Input_Layer2.const_ABGR8888_value           = color;
+        if (line_len[id] == 0)
+        {
+            line_len[id] = PPE_CmdList_LineLen(cmd, id);
+        }
     }
-    PPE_Input_Layer2.color_key_en                   = DISABLE;
-    PPE_Input_Layer2.key_color_value                = 0;
-    PPE_Input_Layer2.format                         = PPE_ARGB8888;
-    PPE_Input_Layer2.src                            = PPE_LAYER_SRC_CONST;
-    PPE_Input_Layer2.line_len                       = transfer_rect.right - transfer_rect.left + 1;
-    PPE_Input_Layer2.AXSIZE                         = 2;// 32bit bandwidth;
-    PPE_Input_Layer2.INCR                           = PPE_ARBURST_FIX;
-    PPE_Input_Layer2.AXCACHE                        = 2;
-    PPE_Input_Layer2.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_15;
-    PPE_Input_Layer2.PRIOR                          = 0;
-    PPE_Input_Layer2.byte_swap                      = PPE_NO_SWAP;
-    PPE_Input_Layer2.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-    PPE_Input_Layer2.polarity                       = PPE_POLARITY_HIGH;
-    PPE_Input_Layer2.handshake_en                   = DISABLE;
-    PPE_Input_Layer2.handshake_msize                = PPE_MSIZE_2;
-    PPE_Input_Layer2.hw_index                       = 0;
-    if ((PPE_Input_Layer2.const_ABGR8888_value >> 24) < 0xFF)
+    return true;
+}
+
+static void PPE_CmdList_LoadRun(ppe_cmdlist_t *list)
+{
+    ppe_cmd_t *first = &list->cmd[list->run_start];
+    uint16_t line_len[3] = {0};
+    uint16_t end = list->run_start + 1;
+    PPE_CmdList_JoinRun(first, &first->cfg, line_len);
+    while ((end < list->cmd_num) && PPE_CmdList_JoinRun(&list->cmd[end], &first->cfg, line_len))
     {
-        /*initial input layer1*/
-        PPE_InitInputLayer(2, &PPE_Input_Layer2);
-        PPE_Input_Layer1.start_x                        = 0;
-        PPE_Input_Layer1.start_y                        = 0;
-        PPE_Input_Layer1.width                          = transfer_rect.right - transfer_rect.left + 1;
-        PPE_Input_Layer1.height                         = transfer_rect.bottom - transfer_rect.top + 1;
-        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory +
-                                                          (transfer_rect.left + transfer_rect.top * buffer->width) * ppe_get_format_data_len(buffer->format);
-        PPE_Input_Layer1.const_ABGR8888_value           = 0XFF000000;
-        PPE_Input_Layer1.format                         = buffer->format;
-        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_FROM_DMA;
-        PPE_Input_Layer1.color_key_en                   = DISABLE;
-        PPE_Input_Layer1.line_len                       = buffer->width;
-        PPE_Input_Layer1.key_color_value                = buffer->color_key_value;
-        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
-        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
-        PPE_Input_Layer1.AXCACHE                        = 1;
-        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_15;
-        PPE_Input_Layer1.PRIOR                          = 0;
-        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
-        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
-        PPE_Input_Layer1.handshake_en                   = DISABLE;
-        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_2;
-        PPE_Input_Layer1.hw_index                       = 0;
-        PPE_InitInputLayer(1, &PPE_Input_Layer1);
-        PPE_Init_User.blend_layer_num                   = 2;
+        end++;
     }
-    else
+    for (uint8_t id = 0; id < 3; id++)
     {
-        memcpy(&PPE_Input_Layer1, &PPE_Input_Layer2, sizeof(PPE_InputLayer_InitTypeDef));
-        PPE_InitInputLayer(1, &PPE_Input_Layer1);
-        PPE_Init_User.blend_layer_num                   = 1;
+        if (line_len[id] == 0)
+        {
+            line_len[id] = first->line_len[id];
+        }
     }
+    for (uint16_t i = list->run_start; i < end - 1; i++)
+    {
+        list->cmd[i].node.LLP = (uint32_t)&list->cmd[i + 1].node;
+    }
+    list->cmd[end - 1].node.LLP = 0;
 
-    /*initial result layer*/
-    PPE_Result_Layer.width                          = transfer_rect.right - transfer_rect.left + 1;
-    PPE_Result_Layer.height                         = transfer_rect.bottom - transfer_rect.top + 1;
-    PPE_Result_Layer.src_addr                       = (uint32_t)buffer->memory +
-                                                      (transfer_rect.left + transfer_rect.top * buffer->width) * ppe_get_format_data_len(buffer->format);
-    PPE_Result_Layer.format                         = buffer->format;
-    PPE_Result_Layer.line_len                       = buffer->width;
-    PPE_Result_Layer.AXSIZE                         = 2;// 32bit bandwidth
-    PPE_Result_Layer.INCR                           = PPE_ARBURST_INCR;
-    PPE_Result_Layer.AXCACHE                        = 1;
-    PPE_Result_Layer.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_15;
-    PPE_Result_Layer.PRIOR                          = 0;
-    PPE_Result_Layer.byte_swap                      = PPE_NO_SWAP;
-    PPE_Result_Layer.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-    PPE_Result_Layer.polarity                       = PPE_POLARITY_HIGH;
-    PPE_Result_Layer.handshake_en                   = DISABLE;
-    PPE_Result_Layer.handshake_msize                = PPE_MSIZE_2;
-    PPE_Result_Layer.hw_index                       = 0;
-    PPE_InitResultLayer(&PPE_Result_Layer);
+    /*first command of the run is programmed directly, the rest are fetched by PPE*/
+    PPE_LAYER->RESULT_LAYER.LAYER0_ADDR_L = first->node.result_layer.LAYER_ADDR;
+    PPE_LAYER->RESULT_LAYER.LAYER0_WIN_SIZE = first->node.result_layer.LAYER_WINSIZE;
+    PPE_LAYER0_PIC_CFG_TypeDef result_pic_cfg = {.d32 = first->cfg.result_pic_cfg};
+    result_pic_cfg.b.line_len = line_len[0];
+    PPE_LAYER->RESULT_LAYER.LAYER0_PIC_CFG = result_pic_cfg.d32;
 
-    /*initial PPE global*/
-    PPE_Init_User.function                          =   PPE_FUNCTION_ALPHA_BLEND;
-    PPE_Init(&PPE_Init_User);
+    PPE_LAYER0_BUS_CFG_TypeDef ppe_reg_0x1c = {.d32 = PPE_LAYER->RESULT_LAYER.LAYER0_BUS_CFG};
+    ppe_reg_0x1c.b.axsize = 2;  // 32bit bandwidth
+    ppe_reg_0x1c.b.incr = PPE_ARBURST_INCR;
+    ppe_reg_0x1c.b.axcache = 1;
+    ppe_reg_0x1c.b.max_axlen_log = PPE_MAX_AXLEN_127;
+    ppe_reg_0x1c.b.prior = 0;
+    ppe_reg_0x1c.b.byte_swap = PPE_NO_SWAP;
+    PPE_LAYER->RESULT_LAYER.LAYER0_BUS_CFG = ppe_reg_0x1c.d32;
+
+    PPE_LAYER0_HS_CFG_TypeDef ppe_reg_0x20 = {.d32 = PPE_LAYER->RESULT_LAYER.LAYER0_HS_CFG};
+    ppe_reg_0x20.b.hs_en = DISABLE;
+    PPE_LAYER->RESULT_LAYER.LAYER0_HS_CFG = ppe_reg_0x20.d32;
+
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        PPE_LAYER->INPUT_LAYER[i].LAYERx_ADDR_L = first->node.input_layer[i].LAYER_ADDR;
+        PPE_LAYER->INPUT_LAYER[i].LAYERx_POS = first->node.input_layer[i].LAYER_POS;
+        PPE_LAYER->INPUT_LAYER[i].LAYERx_WIN_SIZE = first->node.input_layer[i].LAYER_WINSIZE;
+        PPE_LAYER->INPUT_LAYER[i].LAYERx_CONST_PIX = first->node.input_layer[i].LAYER_CONST_PIX;
+        PPE_LAYERX_PIC_CFG_TypeDef input_pic_cfg = {.d32 = first->cfg.input_pic_cfg[i]};
+        input_pic_cfg.b.line_len = line_len[i + 1];
+        PPE_LAYER->INPUT_LAYER[i].LAYERx_PIC_CFG = input_pic_cfg.d32;
+        PPE_LAYER->INPUT_LAYER[i].LAYERx_KEY_COLOR = first->cfg.key_color;
+
+        PPE_LAYERX_BUS_CFG_TypeDef ppe_reg_0x5c = {.d32 = PPE_LAYER->INPUT_LAYER[i].LAYERx_BUS_CFG};
+        ppe_reg_0x5c.b.axsize = 2;  // 32bit bandwidth
+        ppe_reg_0x5c.b.incr = PPE_ARBURST_INCR;
+        ppe_reg_0x5c.b.axcache = 1;
+        ppe_reg_0x5c.b.max_axlen_log = PPE_MAX_AXLEN_127;
+        ppe_reg_0x5c.b.prior = 0;
+        PPE_LAYER->INPUT_LAYER[i].LAYERx_BUS_CFG = ppe_reg_0x5c.d32;
+
+        PPE_LAYERX_HS_CFG_TypeDef ppe_reg_0x60 = {.d32 = PPE_LAYER->INPUT_LAYER[i].LAYERx_HS_CFG};
+        ppe_reg_0x60.b.hs_en = DISABLE;
+        PPE_LAYER->INPUT_LAYER[i].LAYERx_HS_CFG = ppe_reg_0x60.d32;
+    }
 
+    PPE->FUNC_CFG = first->cfg.func_cfg;
+    PPE->SCA_RATIO_X = first->cfg.sca_ratio_x;
+    PPE->SCA_RATIO_Y = first->cfg.sca_ratio_y;
+
+    /*bit0 is result layer, bit n is input layer n*/
+    PPE_LL_CFG_TypeDef ppe_reg_0x40c = {.d32 = PPE->LL_CFG};
+    ppe_reg_0x40c.b.layer_ll_en = (end - list->run_start > 1) ? 0x7 : 0;
+    PPE->LL_CFG = ppe_reg_0x40c.d32;
+    PPE->LLP = first->node.LLP;
 
     PPE_Secure(ENABLE);  /*secure for all channel*/
 
-    /*enable PPE*/
-    PPE_Cmd(ENABLE);
-    while (PPE->GLB_CTL & BIT0);
-    return PPE_SUCCESS;
+    /*registers above were written behind the shadow, and PPE reloads them from the list*/
+    PPE_RegShadow_Invalidate();
+    list->run_start = end;
+    list->run_num++;
 }
 
-#define WINDOW      1
-PPE_ERR PPE_blend(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
-                  PPE_BLEND_MODE blend_mode)
+static void PPE_CmdList_Finish(void)
+{
+    PPE_LL_CFG_TypeDef ppe_reg_0x40c = {.d32 = PPE->LL_CFG};
+    ppe_reg_0x40c.b.layer_ll_en = 0;
+    PPE->LL_CFG = ppe_reg_0x40c.d32;
+    PPE->LLP = 0;
+    PPE_RegShadow_Invalidate();
+}
+
+void PPE_CmdList_Init(ppe_cmdlist_t *list, ppe_cmd_t *cmd, uint16_t cmd_max)
+{
+    list->cmd = cmd;
+    list->cmd_max = cmd_max;
+    list->cmd_num = 0;
+    list->run_start = 0;
+    list->run_num = 0;
+}
+
+void PPE_CmdList_Reset(ppe_cmdlist_t *list)
+{
+    list->cmd_num = 0;
+    list->run_start = 0;
+    list->run_num = 0;
+}
+
+PPE_ERR PPE_CmdList_Scale(ppe_cmdlist_t *list, ppe_buffer_t *image, ppe_buffer_t *buffer,
+                          float x_ratio, float y_ratio)
 {
     if (buffer == NULL)
     {
@@ -881,222 +3042,93 @@ PPE_ERR PPE_blend(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *tr
     {
         return PPE_ERROR_NULL_SOURCE;
     }
-    if ((trans->x < -(image->width - 1)) || (trans->x >= (buffer->width - 1)) \
-        || (trans->y < -(image->height - 1)) || (trans->y >= (buffer->height - 1)))
+    if ((list == NULL) || (x_ratio <= 0) || (y_ratio <= 0))
     {
-        return PPE_ERROR_OUT_OF_RANGE;
+        return PPE_ERROR_INVALID_PARAM;
     }
-    uint8_t format_len = ppe_get_format_data_len(image->format);
-    if (format_len == 0)
+    if ((image->address % 4) || (buffer->address % 4))
     {
-        return PPE_ERROR_UNKNOWN_FORMAT;
+        return PPE_ERROR_ADDR_NOT_ALIGNED;
+    }
+    ppe_cmd_t *cmd = PPE_CmdList_Alloc(list);
+    if (cmd == NULL)
+    {
+        return PPE_ERROR_LIST_FULL;
     }
 
-    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
-    /*declaration of input/result layer initialization struct*/
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer1;
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer2;
-    PPE_ResultLayer_InitTypeDef     PPE_Result_Layer;
-    PPE_InitTypeDef                 PPE_Init_User;
+    buffer->width   = (uint32_t)image->width * x_ratio;
+    buffer->height  = (uint32_t)image->height * y_ratio;
 
-    PPE_InputLayer_StructInit(&PPE_Input_Layer1);
-    PPE_InputLayer_StructInit(&PPE_Input_Layer2);
-    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
-    PPE_structInit(&PPE_Init_User);
+    PPE_CmdList_SetInputLayer(cmd, 1, (uint32_t)image->memory, image->width, image->height,
+                              0xFFFFFFFF, PPE_LAYER_SRC_FROM_DMA, image->format, ppe_buffer_stride(image));
+    PPE_CmdList_SetResultLayer(cmd, (uint32_t)buffer->memory, buffer->width, buffer->height,
+                               buffer->format, ppe_buffer_stride(buffer));
+    PPE_CmdList_SetFunction(cmd, PPE_FUNCTION_SCALE, 0);
+    cmd->cfg.sca_ratio_x = (uint32_t)(65536 / x_ratio);
+    cmd->cfg.sca_ratio_y = (uint32_t)(65536 / y_ratio);
 
-    ppe_rect_t source_rect = {.left = 0, .right = image->width - 1, \
-                              .top = 0, .bottom = image->height - 1
-                             };
-    /*initial input layer1*/
-    ppe_rect_t target_rect = {.left = trans->x, .top = trans->y};
-#if WINDOW
-    PPE_Input_Layer2.start_x = 0;
-    PPE_Input_Layer2.start_y = 0;
-#else
-    PPE_Input_Layer2.start_x = trans->x;
-    PPE_Input_Layer2.start_y = trans->y;
-#endif
-    if (trans->x < 0)
-    {
-        source_rect.left = -trans->x;
-        target_rect.left = 0;
-#if !WINDOW
-        PPE_Input_Layer2.start_x = 0;
-#endif
-    }
-    if ((trans->x + image->width) > buffer->width)
-    {
-        source_rect.right = buffer->width - trans->x - 1;
-    }
-    if (trans->y < 0)
+    return PPE_SUCCESS;
+}
+
+PPE_ERR PPE_CmdList_Clear_Rect(ppe_cmdlist_t *list, ppe_buffer_t *buffer, ppe_rect_t *rect,
+                               uint32_t color)
+{
+    if (buffer == NULL)
     {
-        source_rect.top = -trans->y;
-        target_rect.top = 0;
-#if !WINDOW
-        PPE_Input_Layer2.start_y = 0;
-#endif
+        return PPE_ERROR_NULL_TARGET;
     }
-    if ((trans->y + image->height) > buffer->height)
+    if ((list == NULL) || (rect == NULL) || (rect->top > rect->bottom) || (rect->left > rect->right))
     {
-        source_rect.bottom = buffer->height - trans->y - 1;
+        return PPE_ERROR_INVALID_PARAM;
     }
-#if WINDOW
-    PPE_Input_Layer2.src_addr                       = (uint32_t)image->memory +
-                                                      (source_rect.left + image->width * source_rect.top) * format_len;
-    PPE_Input_Layer2.width                          = source_rect.right - source_rect.left + 1;
-    PPE_Input_Layer2.height                         = source_rect.bottom - source_rect.top + 1;
-#else
-    PPE_Input_Layer2.src_addr                       = (uint32_t)image->memory;
-    PPE_Input_Layer2.width                          = image->width;
-    PPE_Input_Layer2.height                         = image->height;
-#endif
-    if (image->global_alpha_en)
+    uint8_t format_len = ppe_get_format_data_len(buffer->format);
+    if (format_len == 0)
     {
-        PPE_Input_Layer2.const_ABGR8888_value           = image->global_alpha << 24;
+        return PPE_ERROR_UNKNOWN_FORMAT;
     }
-    else
+
+    ppe_rect_t buffer_rect = {.left = 0, .right = buffer->width - 1, .top = 0, .bottom = buffer->height - 1};
+    ppe_rect_t transfer_rect;
+    if (!ppe_rect_intersect(&transfer_rect, &buffer_rect, rect))
     {
-        PPE_Input_Layer2.const_ABGR8888_value           = 0xFFFFFFFF;
-    }
-    PPE_Input_Layer2.format                         = image->format;
-    PPE_Input_Layer2.src                            = PPE_LAYER_SRC_FROM_DMA;
-    if (image->color_key_en)
+        return PPE_SUCCESS;
+    }
+    ppe_cmd_t *cmd = PPE_CmdList_Alloc(list);
+    if (cmd == NULL)
     {
-        PPE_Input_Layer2.color_key_en                   = ENABLE;
-        PPE_Input_Layer2.key_color_value                = image->color_key_value;
+        return PPE_ERROR_LIST_FULL;
     }
-    else
+
+    uint16_t width = transfer_rect.right - transfer_rect.left + 1;
+    uint16_t height = transfer_rect.bottom - transfer_rect.top + 1;
+    uint32_t addr = (uint32_t)buffer->memory +
+                    (transfer_rect.left + transfer_rect.top * ppe_buffer_stride(buffer)) * format_len;
+    if (buffer->global_alpha_en)
     {
-        PPE_Input_Layer2.color_key_en                   = DISABLE;
-        PPE_Input_Layer2.key_color_value                = 0;
+        color = (((color >> 24) * buffer->global_alpha / 255) << 24) + (color & 0xFFFFFF);
     }
-    PPE_Input_Layer2.line_len                       = image->width;
-    PPE_Input_Layer2.AXSIZE                         = 2;// 32bit bandwidth;
-    PPE_Input_Layer2.INCR                           = PPE_ARBURST_INCR;
-    PPE_Input_Layer2.AXCACHE                        = 1;
-    PPE_Input_Layer2.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-    PPE_Input_Layer2.PRIOR                          = 0;
-    PPE_Input_Layer2.byte_swap                      = PPE_NO_SWAP;
-    PPE_Input_Layer2.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-    PPE_Input_Layer2.polarity                       = PPE_POLARITY_HIGH;
-    PPE_Input_Layer2.handshake_en                   = DISABLE;
-    PPE_Input_Layer2.handshake_msize                = PPE_MSIZE_1024;
-    PPE_Input_Layer2.hw_index                       = 0;
-    PPE_InitInputLayer(2, &PPE_Input_Layer2);
 
-    if (blend_mode == PPE_BYPASS_MODE)
+    PPE_CmdList_SetInputLayer(cmd, 2, 0, width, height, color, PPE_LAYER_SRC_CONST,
+                              PPE_ARGB8888, ppe_buffer_stride(buffer));
+    if ((color >> 24) < 0xFF)
     {
-        /*initial input layer2*/
-        PPE_Input_Layer1.start_x                        = 0;
-        PPE_Input_Layer1.start_y                        = 0;
-#if WINDOW
-        PPE_Input_Layer1.src_addr                       = NULL;
-        PPE_Input_Layer1.width                          = source_rect.right - source_rect.left + 1;
-        PPE_Input_Layer1.height                         = source_rect.bottom - source_rect.top + 1;
-#else
-        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory;
-        PPE_Input_Layer1.width                          = buffer->width;
-        PPE_Input_Layer1.height                         = buffer->height;
-#endif
-        PPE_Input_Layer1.const_ABGR8888_value           = 0;
-        PPE_Input_Layer1.format                         = buffer->format;
-        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_CONST;
-        PPE_Input_Layer1.color_key_en                   = DISABLE;
-        PPE_Input_Layer1.line_len                       = buffer->width;
-        PPE_Input_Layer1.color_key_en                   = DISABLE;
-        PPE_Input_Layer1.key_color_value                = 0;
-        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
-        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
-        PPE_Input_Layer1.AXCACHE                        = 1;
-        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-        PPE_Input_Layer1.PRIOR                          = 0;
-        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
-        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
-        PPE_Input_Layer1.handshake_en                   = DISABLE;
-        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_1024;
-        PPE_Input_Layer1.hw_index                       = 0;
-        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+        PPE_CmdList_SetInputLayer(cmd, 1, addr, width, height, 0xFF000000, PPE_LAYER_SRC_FROM_DMA,
+                                  buffer->format, ppe_buffer_stride(buffer));
     }
     else
     {
-        /*initial input layer2*/
-        PPE_Input_Layer1.start_x                        = 0;
-        PPE_Input_Layer1.start_y                        = 0;
-#if WINDOW
-        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory +
-                                                          (target_rect.left + target_rect.top * buffer->width) * ppe_get_format_data_len(buffer->format);
-        PPE_Input_Layer1.width                          = source_rect.right - source_rect.left + 1;
-        PPE_Input_Layer1.height                         = source_rect.bottom - source_rect.top + 1;
-#else
-        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory;
-        PPE_Input_Layer1.width                          = buffer->width;
-        PPE_Input_Layer1.height                         = buffer->height;
-#endif
-        PPE_Input_Layer1.const_ABGR8888_value           = 0XFFAABBCC;
-        PPE_Input_Layer1.format                         = buffer->format;
-        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_FROM_DMA;
-        PPE_Input_Layer1.color_key_en                   = DISABLE;
-        PPE_Input_Layer1.line_len                       = buffer->width;
-        PPE_Input_Layer1.key_color_value                = buffer->color_key_value;
-        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
-        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
-        PPE_Input_Layer1.AXCACHE                        = 1;
-        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-        PPE_Input_Layer1.PRIOR                          = 0;
-        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
-        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
-        PPE_Input_Layer1.handshake_en                   = DISABLE;
-        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_1024;
-        PPE_Input_Layer1.hw_index                       = 0;
-        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+        PPE_CmdList_SetInputLayer(cmd, 1, 0, width, height, 0, PPE_LAYER_SRC_CONST,
+                                  buffer->format, ppe_buffer_stride(buffer));
     }
+    PPE_CmdList_SetResultLayer(cmd, addr, width, height, buffer->format, ppe_buffer_stride(buffer));
+    PPE_CmdList_SetFunction(cmd, PPE_FUNCTION_ALPHA_BLEND, 2);
 
-    /*initial result layer*/
-    PPE_Result_Layer.src_addr                       = (uint32_t)buffer->memory +
-                                                      (target_rect.left + target_rect.top * buffer->width) * ppe_get_format_data_len(buffer->format);
-    PPE_Result_Layer.width                          = source_rect.right - source_rect.left + 1;
-    PPE_Result_Layer.height                         = source_rect.bottom - source_rect.top + 1;
-    PPE_Result_Layer.format                         = buffer->format;
-    PPE_Result_Layer.line_len                       = buffer->width;
-    PPE_Result_Layer.AXSIZE                         = 2;// 32bit bandwidth
-    PPE_Result_Layer.INCR                           = PPE_ARBURST_INCR;
-    PPE_Result_Layer.AXCACHE                        = 1;
-    PPE_Result_Layer.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-    PPE_Result_Layer.PRIOR                          = 0;
-    PPE_Result_Layer.byte_swap                      = PPE_NO_SWAP;
-    PPE_Result_Layer.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-    PPE_Result_Layer.polarity                       = PPE_POLARITY_HIGH;
-    PPE_Result_Layer.handshake_en                   = DISABLE;
-    PPE_Result_Layer.handshake_msize                = PPE_MSIZE_1024;
-    PPE_Result_Layer.hw_index                       = 0;
-    PPE_InitResultLayer(&PPE_Result_Layer);
-
-    /*initial PPE global*/
-    PPE_Init_User.function                          = PPE_FUNCTION_ALPHA_BLEND;
-    PPE_Init_User.blend_layer_num                   = 2;
-    PPE_Init(&PPE_Init_User);
-    PPE_Secure(ENABLE);  /*secure for all channel*/
-    /*enable PPE*/
-    PPE_Cmd(ENABLE);
-    while (PPE->GLB_CTL & BIT0);
     return PPE_SUCCESS;
 }
 
-PPE_ERR PPE_blend_rect(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_t *trans,
-                       ppe_rect_t *rect, PPE_BLEND_MODE blend_mode)
+PPE_ERR PPE_CmdList_blend_rect(ppe_cmdlist_t *list, ppe_buffer_t *image, ppe_buffer_t *buffer,
+                               ppe_translate_t *trans, ppe_rect_t *rect, PPE_BLEND_MODE blend_mode)
 {
-    /*declaration of input/result layer initialization struct*/
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer1;
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer2;
-    PPE_ResultLayer_InitTypeDef     PPE_Result_Layer;
-    PPE_InitTypeDef                 PPE_Init_User;
-
-    PPE_InputLayer_StructInit(&PPE_Input_Layer1);
-    PPE_InputLayer_StructInit(&PPE_Input_Layer2);
-    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
-    PPE_structInit(&PPE_Init_User);
     if (buffer == NULL)
     {
         return PPE_ERROR_NULL_TARGET;
@@ -1105,588 +3137,603 @@ PPE_ERR PPE_blend_rect(ppe_buffer_t *image, ppe_buffer_t *buffer, ppe_translate_
     {
         return PPE_ERROR_NULL_SOURCE;
     }
+    if ((list == NULL) || (trans == NULL) || (rect == NULL))
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
     if ((image->address % 4) || (buffer->address % 4))
     {
         return PPE_ERROR_ADDR_NOT_ALIGNED;
     }
     uint8_t format_len = ppe_get_format_data_len(image->format);
-    if (format_len == 0)
+    uint8_t buffer_format_len = ppe_get_format_data_len(buffer->format);
+    if ((format_len == 0) || (buffer_format_len == 0))
     {
         return PPE_ERROR_UNKNOWN_FORMAT;
     }
 
     ppe_rect_t source_rect = {.left = trans->x, .top = trans->y, .right = trans->x + image->width - 1, .bottom = trans->y + image->height - 1};
+    ppe_rect_t buffer_rect = {.left = 0, .right = buffer->width - 1, .top = 0, .bottom = buffer->height - 1};
     ppe_rect_t blend_area;
-    if (!ppe_rect_intersect(&blend_area, &source_rect, rect))
+    if (!ppe_rect_intersect(&blend_area, &source_rect, rect) ||
+        !ppe_rect_intersect(&blend_area, &blend_area, &buffer_rect))
     {
         return PPE_SUCCESS;
     }
-    source_rect.left = blend_area.x1 - trans->x;
-    source_rect.top = blend_area.y1 - trans->y;
-    source_rect.right = blend_area.x2 - trans->x;
-    source_rect.bottom = blend_area.y2 - trans->y;
-
-    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
-
-    /*initial input layer2*/
-    PPE_Input_Layer2.start_x = 0;
-    PPE_Input_Layer2.start_y = 0;
-    PPE_Input_Layer2.src_addr                = (uint32_t)image->memory +
-                                               (source_rect.left + image->width * source_rect.top) * format_len;
-    PPE_Input_Layer2.width                          = source_rect.right - source_rect.left + 1;
-    PPE_Input_Layer2.height                         = source_rect.bottom - source_rect.top + 1;
-    if (image->global_alpha_en)
+    ppe_cmd_t *cmd = PPE_CmdList_Alloc(list);
+    if (cmd == NULL)
     {
-        PPE_Input_Layer2.const_ABGR8888_value           = image->global_alpha << 24;
+        return PPE_ERROR_LIST_FULL;
     }
-    else
+
+    uint16_t width = blend_area.right - blend_area.left + 1;
+    uint16_t height = blend_area.bottom - blend_area.top + 1;
+    uint32_t src_addr = (uint32_t)image->memory +
+                        ((blend_area.left - trans->x) + ppe_buffer_stride(image) * (blend_area.top - trans->y)) * format_len;
+    uint32_t dst_addr = (uint32_t)buffer->memory +
+                        (blend_area.left + blend_area.top * ppe_buffer_stride(buffer)) * buffer_format_len;
+
+    PPE_CmdList_SetInputLayer(cmd, 2, src_addr, width, height,
+                              image->global_alpha_en ? ((uint32_t)image->global_alpha << 24) : 0xFFFFFFFF,
+                              PPE_LAYER_SRC_FROM_DMA, image->format, ppe_buffer_stride(image));
+    if (image->color_key_en)
     {
-        PPE_Input_Layer2.const_ABGR8888_value           = 0xFFFFFFFF;
+        PPE_LAYERX_PIC_CFG_TypeDef pic_cfg = {.d32 = cmd->cfg.input_pic_cfg[1]};
+        pic_cfg.b.key_en = ENABLE;
+        cmd->cfg.input_pic_cfg[1] = pic_cfg.d32;
+        cmd->cfg.key_color = image->color_key_value;
     }
-    PPE_Input_Layer2.format                         = image->format;
-    PPE_Input_Layer2.src                            = PPE_LAYER_SRC_FROM_DMA;
-    if (image->color_key_en)
+    if (blend_mode == PPE_BYPASS_MODE)
     {
-        PPE_Input_Layer2.color_key_en                   = ENABLE;
-        PPE_Input_Layer2.key_color_value                = image->color_key_value;
+        PPE_CmdList_SetInputLayer(cmd, 1, 0, width, height, 0, PPE_LAYER_SRC_CONST,
+                                  buffer->format, ppe_buffer_stride(buffer));
     }
     else
     {
-        PPE_Input_Layer2.color_key_en                   = DISABLE;
-        PPE_Input_Layer2.key_color_value                = 0;
+        PPE_CmdList_SetInputLayer(cmd, 1, dst_addr, width, height, 0xFFFFFFFF,
+                                  PPE_LAYER_SRC_FROM_DMA, buffer->format, ppe_buffer_stride(buffer));
     }
-    PPE_Input_Layer2.line_len                       = image->width;
-    PPE_Input_Layer2.AXSIZE                         = 2;// 32bit bandwidth;
-    PPE_Input_Layer2.INCR                           = PPE_ARBURST_INCR;
-    PPE_Input_Layer2.AXCACHE                        = 1;
-    PPE_Input_Layer2.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-    PPE_Input_Layer2.PRIOR                          = 0;
-    PPE_Input_Layer2.byte_swap                      = PPE_NO_SWAP;
-    PPE_Input_Layer2.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-    PPE_Input_Layer2.polarity                       = PPE_POLARITY_HIGH;
-    PPE_Input_Layer2.handshake_en                   = DISABLE;
-    PPE_Input_Layer2.handshake_msize                = PPE_MSIZE_2;
-    PPE_Input_Layer2.hw_index                       = 0;
-    PPE_InitInputLayer(2, &PPE_Input_Layer2);
+    PPE_CmdList_SetResultLayer(cmd, dst_addr, width, height, buffer->format, ppe_buffer_stride(buffer));
+    PPE_CmdList_SetFunction(cmd, PPE_FUNCTION_ALPHA_BLEND, 2);
 
+    return PPE_SUCCESS;
+}
 
-    if (blend_mode == PPE_BYPASS_MODE)
+PPE_ERR PPE_CmdList_blend(ppe_cmdlist_t *list, ppe_buffer_t *image, ppe_buffer_t *buffer,
+                          ppe_translate_t *trans, PPE_BLEND_MODE blend_mode)
+{
+    if (buffer == NULL)
     {
-        /*initial input layer1*/
-        PPE_Input_Layer1.start_x                        = 0;
-        PPE_Input_Layer1.start_y                        = 0;
-        PPE_Input_Layer1.src_addr                       = NULL;
-        PPE_Input_Layer1.width                          = blend_area.right - blend_area.left + 1;
-        PPE_Input_Layer1.height                         = blend_area.bottom - blend_area.top + 1;
-        PPE_Input_Layer1.const_ABGR8888_value           = 0;
-        PPE_Input_Layer1.format                         = buffer->format;
-        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_CONST;
-        PPE_Input_Layer1.color_key_en                   = DISABLE;
-        PPE_Input_Layer1.line_len                       = buffer->width;
-        PPE_Input_Layer1.color_key_en                   = DISABLE;
-        PPE_Input_Layer1.key_color_value                = 0;
-        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
-        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
-        PPE_Input_Layer1.AXCACHE                        = 1;
-        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-        PPE_Input_Layer1.PRIOR                          = 0;
-        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
-        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
-        PPE_Input_Layer1.handshake_en                   = DISABLE;
-        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_1024;
-        PPE_Input_Layer1.hw_index                       = 0;
-        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+        return PPE_ERROR_NULL_TARGET;
     }
-    /*initial input layer1*/
-    else
+    ppe_rect_t buffer_rect = {.left = 0, .right = buffer->width - 1, .top = 0, .bottom = buffer->height - 1};
+    return PPE_CmdList_blend_rect(list, image, buffer, trans, &buffer_rect, blend_mode);
+}
+
+PPE_ERR PPE_CmdList_Submit(ppe_cmdlist_t *list)
+{
+    if (list == NULL)
     {
-        PPE_Input_Layer1.src_addr                       = (uint32_t)buffer->memory +
-                                                          (blend_area.left + blend_area.top * buffer->width) * ppe_get_format_data_len(buffer->format);
-        PPE_Input_Layer1.start_x                        = 0;
-        PPE_Input_Layer1.start_y                        = 0;
-        PPE_Input_Layer1.width                          = blend_area.right - blend_area.left + 1;
-        PPE_Input_Layer1.height                         = blend_area.bottom - blend_area.top + 1;
-        PPE_Input_Layer1.const_ABGR8888_value           = 0XFFFFFFFF;
-        PPE_Input_Layer1.format                         = buffer->format;
-        PPE_Input_Layer1.src                            = PPE_LAYER_SRC_FROM_DMA;
-        PPE_Input_Layer1.color_key_en                   = DISABLE;
-        PPE_Input_Layer1.line_len                       = buffer->width;
-        PPE_Input_Layer1.key_color_value                = buffer->color_key_value;
-        PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
-        PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
-        PPE_Input_Layer1.AXCACHE                        = 1;
-        PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-        PPE_Input_Layer1.PRIOR                          = 0;
-        PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
-        PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-        PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
-        PPE_Input_Layer1.handshake_en                   = DISABLE;
-        PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_2;
-        PPE_Input_Layer1.hw_index                       = 0;
-        PPE_InitInputLayer(1, &PPE_Input_Layer1);
+        return PPE_ERROR_INVALID_PARAM;
     }
+    PPE_PERF_BEGIN(PPE_PERF_OP_CMDLIST);
+    PPE_WaitIdle();
+    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
 
-    /*initial result layer*/
-    PPE_Result_Layer.src_addr                       = (uint32_t)buffer->memory +
-                                                      (blend_area.left + blend_area.top * buffer->width) * ppe_get_format_data_len(buffer->format);
-    PPE_Result_Layer.width                          = blend_area.right - blend_area.left + 1;
-    PPE_Result_Layer.height                         = blend_area.bottom - blend_area.top + 1;
-    PPE_Result_Layer.format                         = buffer->format;
-    PPE_Result_Layer.line_len                       = buffer->width;
-    PPE_Result_Layer.AXSIZE                         = 2;// 32bit bandwidth
-    PPE_Result_Layer.INCR                           = PPE_ARBURST_INCR;
-    PPE_Result_Layer.AXCACHE                        = 1;
-    PPE_Result_Layer.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-    PPE_Result_Layer.PRIOR                          = 0;
-    PPE_Result_Layer.byte_swap                      = PPE_NO_SWAP;
-    PPE_Result_Layer.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-    PPE_Result_Layer.polarity                       = PPE_POLARITY_HIGH;
-    PPE_Result_Layer.handshake_en                   = DISABLE;
-    PPE_Result_Layer.handshake_msize                = PPE_MSIZE_2;
-    PPE_Result_Layer.hw_index                       = 0;
-    PPE_InitResultLayer(&PPE_Result_Layer);
-
-    /*initial PPE global*/
-    PPE_Init_User.function                          =   PPE_FUNCTION_ALPHA_BLEND;
-    PPE_Init_User.blend_layer_num                   = 2;
-    PPE_Init(&PPE_Init_User);
+    list->run_start = 0;
+    list->run_num = 0;
+    while (list->run_start < list->cmd_num)
+    {
+        PPE_CmdList_LoadRun(list);
+        PPE_Cmd(ENABLE);
+        while (PPE->GLB_CTL & BIT0);
+        PPE_PERF_DONE();
+    }
+    PPE_CmdList_Finish();
 
-    PPE_Secure(ENABLE);  /*secure for all channel*/
+    return PPE_SUCCESS;
+}
 
-    /*enable PPE*/
-    PPE_Cmd(ENABLE);
-    while (PPE->GLB_CTL & BIT0);
+PPE_ERR PPE_CmdList_Submit_Async(ppe_cmdlist_t *list, ppe_job_callback_t callback,
+                                 void *user_data, ppe_job_t *job)
+{
+    if (list == NULL)
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+    PPE_PERF_BEGIN(PPE_PERF_OP_CMDLIST);
+    PPE_JobBegin(callback, user_data);
+    list->run_start = 0;
+    list->run_num = 0;
+    if (list->cmd_num != 0)
+    {
+        RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
+        ppe_job_cmdlist = list;
+        PPE_CmdList_LoadRun(list);
+        PPE_Start();
+    }
+    return PPE_JobEnd(PPE_SUCCESS, job);
+}
 
-    return PPE_SUCCESS;
+/*grow rect by add when both have the same rows or columns and touch, so the union is exact*/
+static bool ppe_rect_join(ppe_rect_t *rect, ppe_rect_t *add)
+{
+    if ((rect->top == add->top) && (rect->bottom == add->bottom) &&
+        ((add->left == rect->right + 1) || (rect->left == add->right + 1)))
+    {
+        rect->left = MIN(rect->left, add->left);
+        rect->right = MAX(rect->right, add->right);
+        return true;
+    }
+    if ((rect->left == add->left) && (rect->right == add->right) &&
+        ((add->top == rect->bottom + 1) || (rect->top == add->bottom + 1)))
+    {
+        rect->top = MIN(rect->top, add->top);
+        rect->bottom = MAX(rect->bottom, add->bottom);
+        return true;
+    }
+    return false;
 }
 
-PPE_ERR PPE_blend_multi(ppe_input_list_t list)
+PPE_ERR PPE_Clear_Rect_List(ppe_cmdlist_t *list, ppe_buffer_t *buffer, ppe_fill_t *fill,
+                            uint32_t fill_num)
 {
-    /*declaration of input/result layer initialization struct*/
-    if (list.output_layer == NULL)
+    PPE_PERF_BEGIN(PPE_PERF_OP_CLEAR);
+    if (buffer == NULL)
     {
         return PPE_ERROR_NULL_TARGET;
     }
+    if ((list == NULL) || ((fill == NULL) && (fill_num != 0)))
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+    if (ppe_get_format_data_len(buffer->format) == 0)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
 
-    RCC_PeriphClockCmd(APBPeriph_PPE, APBPeriph_PPE_CLOCK, ENABLE);
-    /*declaration of input/result layer initialization struct*/
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer1;
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer2;
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer3;
-    PPE_InputLayer_InitTypeDef      PPE_Input_Layer4;
-    PPE_ResultLayer_InitTypeDef     PPE_Result_Layer;
-    PPE_InitTypeDef                 PPE_Init_User;
-
-    PPE_InputLayer_StructInit(&PPE_Input_Layer1);
-    PPE_InputLayer_StructInit(&PPE_Input_Layer2);
-    PPE_ResultLayer_StructInit(&PPE_Result_Layer);
-    PPE_structInit(&PPE_Init_User);
-
-    PPE_Init_User.blend_layer_num = 0;
-
-    if (list.input_layer1 != NULL)
+    /*merge a fill into an earlier one of the same color unless a fill in between covers it,
+      painting it earlier must not change the result*/
+    uint32_t num = 0;
+    for (uint32_t i = 0; i < fill_num; i++)
     {
-        if ((list.input_layer1->trans.x >= -(list.input_layer1->buffer.width - 1)) && \
-            (list.input_layer1->trans.x < (list.output_layer->buffer.width - 1)) && \
-            (list.input_layer1->trans.y >= -(list.input_layer1->buffer.height - 1)) && \
-            (list.input_layer1->trans.y < (list.output_layer->buffer.height - 1)))
+        ppe_rect_t *rect = &fill[i].rect;
+        if ((rect->top > rect->bottom) || (rect->left > rect->right))
+        {
+            return PPE_ERROR_INVALID_PARAM;
+        }
+        bool merged = false;
+        for (uint32_t j = num; j-- > 0;)
         {
-            ppe_rect_t source_rect;
-            if (list.input_layer1->rect)
+            ppe_rect_t overlap;
+            if ((fill[j].color == fill[i].color) && ppe_rect_join(&fill[j].rect, rect))
             {
-                source_rect.left = list.input_layer1->rect->left;
-                source_rect.right = list.input_layer1->rect->right;
-                source_rect.top = list.input_layer1->rect->top;
-                source_rect.bottom = list.input_layer1->rect->bottom;
+                merged = true;
+                break;
             }
-            else
+            if (ppe_rect_intersect(&overlap, &fill[j].rect, rect))
             {
-                source_rect.left = 0;
-                source_rect.right = list.input_layer1->buffer.width - 1;
-                source_rect.top = 0;
-                source_rect.bottom = list.input_layer1->buffer.height - 1;
+                break;
             }
+        }
+        if (!merged)
+        {
+            fill[num++] = fill[i];
+        }
+    }
 
-            PPE_Input_Layer1.start_x = list.input_layer1->trans.x;
-            PPE_Input_Layer1.start_y = list.input_layer1->trans.y;
+    PPE_WaitIdle();
+    PPE_CmdList_Reset(list);
+    ppe_rect_t buffer_rect = {.left = 0, .right = buffer->width - 1, .top = 0, .bottom = buffer->height - 1};
+    bool sw_format = ppe_sw_format_supported(buffer->format);
+    uint32_t hw_start = 0;
+    for (uint32_t i = 0; i < num; i++)
+    {
+        ppe_rect_t transfer_rect;
+        if (!ppe_rect_intersect(&transfer_rect, &buffer_rect, &fill[i].rect))
+        {
+            continue;
+        }
+        /*a CPU fill lands before the queued PPE fills, so it must not overlap any fill since
+          the last submit*/
+        bool sw = sw_format && ppe_sw_accept(&transfer_rect);
+        for (uint32_t j = hw_start; sw && (list->cmd_num != 0) && (j < i); j++)
+        {
+            ppe_rect_t overlap;
+            sw = !ppe_rect_intersect(&overlap, &fill[j].rect, &transfer_rect);
+        }
+        if (sw)
+        {
+            ppe_sw_clear_rect(buffer, &transfer_rect, fill[i].color);
+            continue;
+        }
+        PPE_ERR err = PPE_CmdList_Clear_Rect(list, buffer, &transfer_rect, fill[i].color);
+        if (err == PPE_ERROR_LIST_FULL)
+        {
+            PPE_CmdList_Submit(list);
+            PPE_CmdList_Reset(list);
+            hw_start = i;
+            err = PPE_CmdList_Clear_Rect(list, buffer, &transfer_rect, fill[i].color);
+        }
+        if (err != PPE_SUCCESS)
+        {
+            return err;
+        }
+    }
+    if (list->cmd_num != 0)
+    {
+        return PPE_CmdList_Submit(list);
+    }
+    return PPE_SUCCESS;
+}
 
-            if (list.input_layer1->trans.x < 0)
-            {
-                source_rect.left = -list.input_layer1->trans.x;
-                PPE_Input_Layer1.start_x = 0;
-            }
-            if ((list.input_layer1->trans.x + list.input_layer1->buffer.width) >
-                list.output_layer->buffer.width)
-            {
-                source_rect.right = list.output_layer->buffer.width - list.input_layer1->trans.x - 1;
-            }
-            if (list.input_layer1->trans.y < 0)
-            {
-                source_rect.top = -list.input_layer1->trans.y;
-                PPE_Input_Layer1.start_y = 0;
-            }
-            if ((list.input_layer1->trans.y + list.input_layer1->buffer.height) >
-                list.output_layer->buffer.height)
-            {
-                source_rect.bottom = list.output_layer->buffer.height - list.input_layer1->trans.y - 1;
-            }
-            uint8_t format_len = ppe_get_format_data_len(list.input_layer1->buffer.format);
-            if (format_len == 0)
-            {
-                return PPE_ERROR_UNKNOWN_FORMAT;
-            }
+static uint32_t ppe_rect_area(ppe_rect_t *rect)
+{
+    return (uint32_t)(rect->right - rect->left + 1) * (uint32_t)(rect->bottom - rect->top + 1);
+}
 
-            PPE_Input_Layer1.src_addr                       = (uint32_t)list.input_layer1->buffer.memory +
-                                                              (source_rect.left + list.input_layer1->buffer.width * source_rect.top) * format_len;
-            PPE_Input_Layer1.width                          = source_rect.right - source_rect.left + 1;
-            PPE_Input_Layer1.height                         = source_rect.bottom - source_rect.top + 1;
-            if (list.input_layer1->buffer.global_alpha_en)
-            {
-                PPE_Input_Layer1.const_ABGR8888_value           = list.input_layer1->buffer.global_alpha << 24;
-            }
-            else
-            {
-                PPE_Input_Layer1.const_ABGR8888_value           = 0xFFFFFFFF;
-            }
-            PPE_Input_Layer1.format                         = list.input_layer1->buffer.format;
-            PPE_Input_Layer1.src                            = PPE_LAYER_SRC_FROM_DMA;
-            if (list.input_layer1->buffer.color_key_en)
-            {
-                PPE_Input_Layer1.color_key_en                   = ENABLE;
-                PPE_Input_Layer1.key_color_value                = list.input_layer1->buffer.color_key_value;
-            }
-            else
-            {
-                PPE_Input_Layer1.color_key_en                   = DISABLE;
-                PPE_Input_Layer1.key_color_value                = 0;
-            }
-            PPE_Input_Layer1.line_len                       = list.input_layer1->buffer.width;
-            PPE_Input_Layer1.AXSIZE                         = 2;// 32bit bandwidth;
-            PPE_Input_Layer1.INCR                           = PPE_ARBURST_INCR;
-            PPE_Input_Layer1.AXCACHE                        = 1;
-            PPE_Input_Layer1.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-            PPE_Input_Layer1.PRIOR                          = 0;
-            PPE_Input_Layer1.byte_swap                      = PPE_NO_SWAP;
-            PPE_Input_Layer1.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-            PPE_Input_Layer1.polarity                       = PPE_POLARITY_HIGH;
-            PPE_Input_Layer1.handshake_en                   = DISABLE;
-            PPE_Input_Layer1.handshake_msize                = PPE_MSIZE_1024;
-            PPE_Input_Layer1.hw_index                       = 0;
+static void ppe_rect_union(ppe_rect_t *result_rect, ppe_rect_t *rect1, ppe_rect_t *rect2)
+{
+    result_rect->left = MIN(rect1->left, rect2->left);
+    result_rect->top = MIN(rect1->top, rect2->top);
+    result_rect->right = MAX(rect1->right, rect2->right);
+    result_rect->bottom = MAX(rect1->bottom, rect2->bottom);
+}
 
-            PPE_Init_User.blend_layer_num++;
-            PPE_InitInputLayer(1, &PPE_Input_Layer1);
-        }
-    }
+/* pixels covered by the union of rect1 and rect2 that neither of them covers */
+static uint32_t ppe_rect_union_waste(ppe_rect_t *rect1, ppe_rect_t *rect2)
+{
+    ppe_rect_t union_rect;
+    ppe_rect_t overlap;
+    uint32_t covered = ppe_rect_area(rect1) + ppe_rect_area(rect2);
 
-    if (list.input_layer2 != NULL)
+    if (ppe_rect_intersect(&overlap, rect1, rect2))
     {
-        if ((list.input_layer2->trans.x >= -(list.input_layer2->buffer.width - 1)) && \
-            (list.input_layer2->trans.x < (list.output_layer->buffer.width - 1)) && \
-            (list.input_layer2->trans.y >= -(list.input_layer2->buffer.height - 1)) && \
-            (list.input_layer2->trans.y < (list.output_layer->buffer.height - 1)))
-        {
-            ppe_rect_t source_rect;
-            if (list.input_layer2->rect)
-            {
-                source_rect.left = list.input_layer2->rect->left;
-                source_rect.right = list.input_layer2->rect->right;
-                source_rect.top = list.input_layer2->rect->top;
-                source_rect.bottom = list.input_layer2->rect->bottom;
-            }
-            else
-            {
-                source_rect.left = 0;
-                source_rect.right = list.input_layer2->buffer.width - 1;
-                source_rect.top = 0;
-                source_rect.bottom = list.input_layer2->buffer.height - 1;
-            }
+        covered -= ppe_rect_area(&overlap);
+    }
+    ppe_rect_union(&union_rect, rect1, rect2);
+    return ppe_rect_area(&union_rect) - covered;
+}
 
-            PPE_Input_Layer2.start_x = list.input_layer2->trans.x;
-            PPE_Input_Layer2.start_y = list.input_layer2->trans.y;
+void PPE_Damage_Init(ppe_damage_t *damage, uint16_t width, uint16_t height)
+{
+    damage->width = width;
+    damage->height = height;
+    damage->rect_num = 0;
+}
 
-            if (list.input_layer2->trans.x < 0)
-            {
-                source_rect.left = -list.input_layer2->trans.x;
-                PPE_Input_Layer2.start_x = 0;
-            }
-            if ((list.input_layer2->trans.x + list.input_layer2->buffer.width) >
-                list.output_layer->buffer.width)
-            {
-                source_rect.right = list.output_layer->buffer.width - list.input_layer2->trans.x - 1;
-            }
-            if (list.input_layer2->trans.y < 0)
-            {
-                source_rect.top = -list.input_layer2->trans.y;
-                PPE_Input_Layer2.start_y = 0;
-            }
-            if ((list.input_layer2->trans.y + list.input_layer2->buffer.height) >
-                list.output_layer->buffer.height)
-            {
-                source_rect.bottom = list.output_layer->buffer.height - list.input_layer2->trans.y - 1;
-            }
-            uint8_t format_len = ppe_get_format_data_len(list.input_layer2->buffer.format);
-            if (format_len == 0)
-            {
-                return PPE_ERROR_UNKNOWN_FORMAT;
-            }
+void PPE_Damage_Reset(ppe_damage_t *damage)
+{
+    damage->rect_num = 0;
+}
 
-            PPE_Input_Layer2.src_addr                       = (uint32_t)list.input_layer2->buffer.memory +
-                                                              (source_rect.left + list.input_layer2->buffer.width * source_rect.top) * format_len;
-            PPE_Input_Layer2.width                          = source_rect.right - source_rect.left + 1;
-            PPE_Input_Layer2.height                         = source_rect.bottom - source_rect.top + 1;
-            if (list.input_layer2->buffer.global_alpha_en)
-            {
-                PPE_Input_Layer2.const_ABGR8888_value           = list.input_layer2->buffer.global_alpha << 24;
-            }
-            else
-            {
-                PPE_Input_Layer2.const_ABGR8888_value           = 0xFFFFFFFF;
-            }
-            PPE_Input_Layer2.format                         = list.input_layer2->buffer.format;
-            PPE_Input_Layer2.src                            = PPE_LAYER_SRC_FROM_DMA;
-            if (list.input_layer2->buffer.color_key_en)
-            {
-                PPE_Input_Layer2.color_key_en                   = ENABLE;
-                PPE_Input_Layer2.key_color_value                = list.input_layer2->buffer.color_key_value;
-            }
-            else
-            {
-                PPE_Input_Layer2.color_key_en                   = DISABLE;
-                PPE_Input_Layer2.key_color_value                = 0;
-            }
-            PPE_Input_Layer2.line_len                       = list.input_layer2->buffer.width;
-            PPE_Input_Layer2.AXSIZE                         = 2;// 32bit bandwidth;
-            PPE_Input_Layer2.INCR                           = PPE_ARBURST_INCR;
-            PPE_Input_Layer2.AXCACHE                        = 1;
-            PPE_Input_Layer2.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-            PPE_Input_Layer2.PRIOR                          = 0;
-            PPE_Input_Layer2.byte_swap                      = PPE_NO_SWAP;
-            PPE_Input_Layer2.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-            PPE_Input_Layer2.polarity                       = PPE_POLARITY_HIGH;
-            PPE_Input_Layer2.handshake_en                   = DISABLE;
-            PPE_Input_Layer2.handshake_msize                = PPE_MSIZE_1024;
-            PPE_Input_Layer2.hw_index                       = 0;
+void PPE_Damage_Add(ppe_damage_t *damage, ppe_rect_t *rect)
+{
+    ppe_rect_t screen = {.left = 0, .top = 0, .right = damage->width - 1, .bottom = damage->height - 1};
+    ppe_rect_t new_rect;
 
-            PPE_Init_User.blend_layer_num++;
-            PPE_InitInputLayer(2, &PPE_Input_Layer2);
-        }
+    if ((rect->right < rect->left) || (rect->bottom < rect->top) ||
+        !ppe_rect_intersect(&new_rect, rect, &screen))
+    {
+        return;
     }
 
-    if (list.input_layer3 != NULL)
+    /* every merge removes one recorded rect, so this ends after at most rect_num rounds */
+    while (damage->rect_num != 0)
     {
-        if ((list.input_layer3->trans.x >= -(list.input_layer3->buffer.width - 1)) && \
-            (list.input_layer3->trans.x < (list.output_layer->buffer.width - 1)) && \
-            (list.input_layer3->trans.y >= -(list.input_layer3->buffer.height - 1)) && \
-            (list.input_layer3->trans.y < (list.output_layer->buffer.height - 1)))
+        uint8_t best = 0;
+        uint32_t best_waste = UINT32_MAX;
+        for (uint8_t i = 0; i < damage->rect_num; i++)
         {
-            ppe_rect_t source_rect;
-            if (list.input_layer3->rect)
-            {
-                source_rect.left = list.input_layer3->rect->left;
-                source_rect.right = list.input_layer3->rect->right;
-                source_rect.top = list.input_layer3->rect->top;
-                source_rect.bottom = list.input_layer3->rect->bottom;
-            }
-            else
+            uint32_t waste = ppe_rect_union_waste(&damage->rect[i], &new_rect);
+            if (waste < best_waste)
             {
-                source_rect.left = 0;
-                source_rect.right = list.input_layer3->buffer.width - 1;
-                source_rect.top = 0;
-                source_rect.bottom = list.input_layer3->buffer.height - 1;
+                best = i;
+                best_waste = waste;
             }
+        }
+        if ((best_waste >= PPE_DAMAGE_MERGE_PIXELS) && (damage->rect_num < PPE_DAMAGE_RECT_MAX))
+        {
+            break;
+        }
+        ppe_rect_union(&new_rect, &new_rect, &damage->rect[best]);
+        damage->rect_num--;
+        damage->rect[best] = damage->rect[damage->rect_num];
+    }
+    damage->rect[damage->rect_num++] = new_rect;
+}
 
-            PPE_Input_Layer3.start_x = list.input_layer3->trans.x;
-            PPE_Input_Layer3.start_y = list.input_layer3->trans.y;
+uint32_t PPE_Damage_Area(ppe_damage_t *damage)
+{
+    uint32_t area = 0;
+    for (uint8_t i = 0; i < damage->rect_num; i++)
+    {
+        area += ppe_rect_area(&damage->rect[i]);
+    }
+    return area;
+}
 
-            if (list.input_layer3->trans.x < 0)
-            {
-                source_rect.left = -list.input_layer3->trans.x;
-                PPE_Input_Layer3.start_x = 0;
-            }
-            if ((list.input_layer3->trans.x + list.input_layer3->buffer.width) >
-                list.output_layer->buffer.width)
-            {
-                source_rect.right = list.output_layer->buffer.width - list.input_layer3->trans.x - 1;
-            }
-            if (list.input_layer3->trans.y < 0)
-            {
-                source_rect.top = -list.input_layer3->trans.y;
-                PPE_Input_Layer3.start_y = 0;
-            }
-            if ((list.input_layer3->trans.y + list.input_layer3->buffer.height) >
-                list.output_layer->buffer.height)
-            {
-                source_rect.bottom = list.output_layer->buffer.height - list.input_layer3->trans.y - 1;
-            }
-            uint8_t format_len = ppe_get_format_data_len(list.input_layer3->buffer.format);
-            if (format_len == 0)
-            {
-                return PPE_ERROR_UNKNOWN_FORMAT;
-            }
+/* narrow layer down to the pixels it draws inside area, positioned relative to area */
+static PPE_ERR PPE_Damage_ClipLayer(ppe_layer_t *layer, ppe_rect_t *area, ppe_layer_t *sub)
+{
+    ppe_rect_t source_rect;
+    ppe_rect_t target_rect;
+    ppe_rect_t result_rect;
 
-            PPE_Input_Layer3.src_addr                       = (uint32_t)list.input_layer3->buffer.memory +
-                                                              (source_rect.left + list.input_layer3->buffer.width * source_rect.top) * format_len;
-            PPE_Input_Layer3.width                          = source_rect.right - source_rect.left + 1;
-            PPE_Input_Layer3.height                         = source_rect.bottom - source_rect.top + 1;
-            if (list.input_layer3->buffer.global_alpha_en)
-            {
-                PPE_Input_Layer3.const_ABGR8888_value           = list.input_layer3->buffer.global_alpha << 24;
-            }
-            else
+    if (layer->rect)
+    {
+        source_rect = *layer->rect;
+    }
+    else
+    {
+        source_rect.left = 0;
+        source_rect.top = 0;
+        source_rect.right = layer->buffer.width - 1;
+        source_rect.bottom = layer->buffer.height - 1;
+    }
+    target_rect.left = layer->trans.x;
+    target_rect.top = layer->trans.y;
+    target_rect.right = layer->trans.x + source_rect.right - source_rect.left;
+    target_rect.bottom = layer->trans.y + source_rect.bottom - source_rect.top;
+    if (!ppe_rect_intersect(&result_rect, &target_rect, area))
+    {
+        return PPE_SUCCESS_NOT_CHANGE;
+    }
+    uint8_t format_len = ppe_get_format_data_len(layer->buffer.format);
+    if (format_len == 0)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    uint32_t stride = ppe_buffer_stride(&layer->buffer);
+    uint32_t offset = (source_rect.left + result_rect.left - target_rect.left) +
+                      (source_rect.top + result_rect.top - target_rect.top) * stride;
+    memcpy(sub, layer, sizeof(ppe_layer_t));
+    sub->buffer.memory = (uint32_t *)((uint32_t)layer->buffer.memory + offset * format_len);
+    sub->buffer.address = (uint32_t)sub->buffer.memory;
+    sub->buffer.width = result_rect.right - result_rect.left + 1;
+    sub->buffer.height = result_rect.bottom - result_rect.top + 1;
+    sub->buffer.stride = stride;
+    sub->rect = NULL;
+    sub->trans.x = result_rect.left - area->left;
+    sub->trans.y = result_rect.top - area->top;
+    return PPE_SUCCESS;
+}
+
+PPE_ERR PPE_Damage_Compose(ppe_damage_t *damage, ppe_input_list_t list)
+{
+    if (damage == NULL)
+    {
+        return PPE_ERROR_INVALID_PARAM;
+    }
+    if (list.output_layer == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    uint8_t format_len = ppe_get_format_data_len(list.output_layer->buffer.format);
+    if (format_len == 0)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    ppe_layer_t *input[4] = {list.input_layer1, list.input_layer2, list.input_layer3, list.input_layer4};
+    ppe_layer_t sub_input[4];
+    ppe_layer_t sub_output;
+    uint32_t stride = ppe_buffer_stride(&list.output_layer->buffer);
+
+    for (uint8_t i = 0; i < damage->rect_num; i++)
+    {
+        ppe_rect_t *area = &damage->rect[i];
+        ppe_layer_t *sub_list[4] = {NULL, NULL, NULL, NULL};
+        bool draw = false;
+
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            if (input[j] == NULL)
             {
-                PPE_Input_Layer3.const_ABGR8888_value           = 0xFFFFFFFF;
+                continue;
             }
-            PPE_Input_Layer3.format                         = list.input_layer3->buffer.format;
-            PPE_Input_Layer3.src                            = PPE_LAYER_SRC_FROM_DMA;
-            if (list.input_layer3->buffer.color_key_en)
+            PPE_ERR err = PPE_Damage_ClipLayer(input[j], area, &sub_input[j]);
+            if (err == PPE_SUCCESS)
             {
-                PPE_Input_Layer3.color_key_en                   = ENABLE;
-                PPE_Input_Layer3.key_color_value                = list.input_layer3->buffer.color_key_value;
+                sub_list[j] = &sub_input[j];
+                draw = true;
             }
-            else
+            else if (err != PPE_SUCCESS_NOT_CHANGE)
             {
-                PPE_Input_Layer3.color_key_en                   = DISABLE;
-                PPE_Input_Layer3.key_color_value                = 0;
+                return err;
             }
-            PPE_Input_Layer3.line_len                       = list.input_layer3->buffer.width;
-            PPE_Input_Layer3.AXSIZE                         = 2;// 32bit bandwidth;
-            PPE_Input_Layer3.INCR                           = PPE_ARBURST_INCR;
-            PPE_Input_Layer3.AXCACHE                        = 1;
-            PPE_Input_Layer3.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-            PPE_Input_Layer3.PRIOR                          = 0;
-            PPE_Input_Layer3.byte_swap                      = PPE_NO_SWAP;
-            PPE_Input_Layer3.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-            PPE_Input_Layer3.polarity                       = PPE_POLARITY_HIGH;
-            PPE_Input_Layer3.handshake_en                   = DISABLE;
-            PPE_Input_Layer3.handshake_msize                = PPE_MSIZE_1024;
-            PPE_Input_Layer3.hw_index                       = 0;
+        }
+        if (!draw)
+        {
+            continue;
+        }
 
-            PPE_Init_User.blend_layer_num++;
-            PPE_InitInputLayer(3, &PPE_Input_Layer3);
+        memcpy(&sub_output, list.output_layer, sizeof(ppe_layer_t));
+        sub_output.buffer.memory = (uint32_t *)((uint32_t)list.output_layer->buffer.memory +
+                                                (area->left + area->top * stride) * format_len);
+        sub_output.buffer.address = (uint32_t)sub_output.buffer.memory;
+        sub_output.buffer.width = area->right - area->left + 1;
+        sub_output.buffer.height = area->bottom - area->top + 1;
+        sub_output.buffer.stride = stride;
+
+        ppe_input_list_t sub = {sub_list[0], sub_list[1], sub_list[2], sub_list[3], &sub_output};
+        PPE_ERR err = PPE_blend_multi(sub);
+        if (err != PPE_SUCCESS)
+        {
+            return err;
         }
     }
+    damage->rect_num = 0;
+    return PPE_SUCCESS;
+}
+
+/* area of output covered by layer, false when the layer misses output */
+static bool ppe_layer_target_rect(ppe_layer_t *layer, ppe_layer_t *output, ppe_rect_t *rect)
+{
+    ppe_rect_t output_rect = {.left = 0, .top = 0, .right = output->buffer.width - 1, .bottom = output->buffer.height - 1};
+    ppe_rect_t target_rect;
+
+    target_rect.left = layer->trans.x;
+    target_rect.top = layer->trans.y;
+    if (layer->rect)
+    {
+        target_rect.right = layer->trans.x + layer->rect->right - layer->rect->left;
+        target_rect.bottom = layer->trans.y + layer->rect->bottom - layer->rect->top;
+    }
+    else
+    {
+        target_rect.right = layer->trans.x + layer->buffer.width - 1;
+        target_rect.bottom = layer->trans.y + layer->buffer.height - 1;
+    }
+    return ppe_rect_intersect(rect, &target_rect, &output_rect);
+}
+
+PPE_ERR PPE_blend_layers(ppe_layer_t *layers, uint32_t layer_num, ppe_layer_t *output)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLEND_MULTI);
+    if (output == NULL)
+    {
+        return PPE_ERROR_NULL_TARGET;
+    }
+    if ((layers == NULL) && (layer_num != 0))
+    {
+        return PPE_ERROR_NULL_SOURCE;
+    }
+    if (ppe_get_format_data_len(output->buffer.format) == 0)
+    {
+        return PPE_ERROR_UNKNOWN_FORMAT;
+    }
+
+    ppe_layer_t *input[PPE_INPUT_LAYER_MAX];
+    uint32_t next = MIN(layer_num, PPE_INPUT_LAYER_MAX);
+    for (uint32_t i = 0; i < next; i++)
+    {
+        input[i] = &layers[i];
+    }
+    PPE_ERR err = PPE_Multi_Run(input, next, output);
+    if (err != PPE_SUCCESS)
+    {
+        return err;
+    }
+
+    /*each later pass reads the frame back as its bottom layer, only inside the bounding box of
+      the layers it draws. A layer may be drawn ahead of earlier layers it does not overlap, which
+      keeps the boxes small without adding passes*/
+    ppe_layer_t frame;
+    ppe_layer_t sub[PPE_INPUT_LAYER_MAX];
+    ppe_rect_t target[PPE_BLEND_LOOKAHEAD];
+    uint32_t drawn = 0;     /*bit i set once layers[next + i] is drawn*/
+
+    memcpy(&frame, output, sizeof(ppe_layer_t));
+    frame.rect = NULL;
+    frame.trans.x = 0;
+    frame.trans.y = 0;
+    frame.buffer.color_key_en = false;
+    frame.buffer.global_alpha_en = false;
 
-    if (list.input_layer4 != NULL)
+    while (next < layer_num)
     {
-        if ((list.input_layer4->trans.x >= -(list.input_layer4->buffer.width - 1)) && \
-            (list.input_layer4->trans.x < (list.output_layer->buffer.width - 1)) && \
-            (list.input_layer4->trans.y >= -(list.input_layer4->buffer.height - 1)) && \
-            (list.input_layer4->trans.y < (list.output_layer->buffer.height - 1)))
+        uint32_t window = MIN(layer_num - next, PPE_BLEND_LOOKAHEAD);
+        uint32_t pass = 0;
+        uint8_t num = 0;
+        ppe_rect_t area;
+
+        for (uint32_t i = 0; i < window; i++)
         {
-            ppe_rect_t source_rect;
-            if (list.input_layer4->rect)
-            {
-                source_rect.left = list.input_layer4->rect->left;
-                source_rect.right = list.input_layer4->rect->right;
-                source_rect.top = list.input_layer4->rect->top;
-                source_rect.bottom = list.input_layer4->rect->bottom;
-            }
-            else
+            if (!(drawn & BIT(i)) && !ppe_layer_target_rect(&layers[next + i], output, &target[i]))
             {
-                source_rect.left = 0;
-                source_rect.right = list.input_layer4->buffer.width - 1;
-                source_rect.top = 0;
-                source_rect.bottom = list.input_layer4->buffer.height - 1;
+                drawn |= BIT(i);
             }
+        }
 
-            PPE_Input_Layer4.start_x = list.input_layer4->trans.x;
-            PPE_Input_Layer4.start_y = list.input_layer4->trans.y;
+        while (num < PPE_INPUT_LAYER_MAX - 1)
+        {
+            uint32_t best = window;
+            uint32_t best_cost = 0xFFFFFFFF;
 
-            if (list.input_layer4->trans.x < 0)
-            {
-                source_rect.left = -list.input_layer4->trans.x;
-                PPE_Input_Layer4.start_x = 0;
-            }
-            if ((list.input_layer4->trans.x + list.input_layer4->buffer.width) >
-                list.output_layer->buffer.width)
+            for (uint32_t j = 0; j < window; j++)
             {
-                source_rect.right = list.output_layer->buffer.width - list.input_layer4->trans.x - 1;
+                if ((drawn | pass) & BIT(j))
+                {
+                    continue;
+                }
+                bool ready = true;
+                for (uint32_t i = 0; (i < j) && ready; i++)
+                {
+                    ppe_rect_t overlap;
+                    if (!((drawn | pass) & BIT(i)) && ppe_rect_intersect(&overlap, &target[i], &target[j]))
+                    {
+                        ready = false;
+                    }
+                }
+                if (!ready)
+                {
+                    continue;
+                }
+                if (num == 0)
+                {
+                    best = j;
+                    break;
+                }
+                ppe_rect_t grown;
+                ppe_rect_union(&grown, &area, &target[j]);
+                uint32_t cost = ppe_rect_area(&grown) - ppe_rect_area(&area);
+                if (cost < best_cost)
+                {
+                    best = j;
+                    best_cost = cost;
+                }
             }
-            if (list.input_layer4->trans.y < 0)
+            if (best == window)
             {
-                source_rect.top = -list.input_layer4->trans.y;
-                PPE_Input_Layer4.start_y = 0;
+                break;
             }
-            if ((list.input_layer4->trans.y + list.input_layer4->buffer.height) >
-                list.output_layer->buffer.height)
+            if (num == 0)
             {
-                source_rect.bottom = list.output_layer->buffer.height - list.input_layer4->trans.y - 1;
-            }
-            uint8_t format_len = ppe_get_format_data_len(list.input_layer4->buffer.format);
-            if (format_len == 0)
-            {
-                return PPE_ERROR_UNKNOWN_FORMAT;
-            }
-
-            PPE_Input_Layer4.src_addr                       = (uint32_t)list.input_layer4->buffer.memory +
-                                                              (source_rect.left + list.input_layer4->buffer.width * source_rect.top) * format_len;
-            PPE_Input_Layer4.width                          = source_rect.right - source_rect.left + 1;
-            PPE_Input_Layer4.height                         = source_rect.bottom - source_rect.top + 1;
-            if (list.input_layer4->buffer.global_alpha_en)
-            {
-                PPE_Input_Layer4.const_ABGR8888_value           = list.input_layer4->buffer.global_alpha << 24;
+                area = target[best];
             }
             else
             {
-                PPE_Input_Layer4.const_ABGR8888_value           = 0xFFFFFFFF;
+                ppe_rect_union(&area, &area, &target[best]);
             }
-            PPE_Input_Layer4.format                         = list.input_layer4->buffer.format;
-            PPE_Input_Layer4.src                            = PPE_LAYER_SRC_FROM_DMA;
-            if (list.input_layer4->buffer.color_key_en)
+            pass |= BIT(best);
+            num++;
+        }
+
+        if (num != 0)
+        {
+            uint8_t input_num = 1;
+            PPE_Damage_ClipLayer(&frame, &area, &sub[0]);
+            input[0] = &sub[0];
+            for (uint32_t j = 0; j < window; j++)
             {
-                PPE_Input_Layer4.color_key_en                   = ENABLE;
-                PPE_Input_Layer4.key_color_value                = list.input_layer4->buffer.color_key_value;
+                if (!(pass & BIT(j)))
+                {
+                    continue;
+                }
+                err = PPE_Damage_ClipLayer(&layers[next + j], &area, &sub[input_num]);
+                if (err != PPE_SUCCESS)
+                {
+                    return err;
+                }
+                input[input_num] = &sub[input_num];
+                input_num++;
             }
-            else
+            err = PPE_Multi_Run(input, input_num, &sub[0]);
+            if (err != PPE_SUCCESS)
             {
-                PPE_Input_Layer4.color_key_en                   = DISABLE;
-                PPE_Input_Layer4.key_color_value                = 0;
+                return err;
             }
-            PPE_Input_Layer4.line_len                       = list.input_layer4->buffer.width;
-            PPE_Input_Layer4.AXSIZE                         = 2;// 32bit bandwidth;
-            PPE_Input_Layer4.INCR                           = PPE_ARBURST_INCR;
-            PPE_Input_Layer4.AXCACHE                        = 1;
-            PPE_Input_Layer4.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-            PPE_Input_Layer4.PRIOR                          = 0;
-            PPE_Input_Layer4.byte_swap                      = PPE_NO_SWAP;
-            PPE_Input_Layer4.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-            PPE_Input_Layer4.polarity                       = PPE_POLARITY_HIGH;
-            PPE_Input_Layer4.handshake_en                   = DISABLE;
-            PPE_Input_Layer4.handshake_msize                = PPE_MSIZE_1024;
-            PPE_Input_Layer4.hw_index                       = 0;
+        }
 
-            PPE_Init_User.blend_layer_num++;
-            PPE_InitInputLayer(4, &PPE_Input_Layer4);
+        drawn |= pass;
+        while ((drawn & BIT0) && (next < layer_num))
+        {
+            drawn >>= 1;
+            next++;
         }
     }
-
-    /*initial result layer*/
-    PPE_Result_Layer.src_addr                       = (uint32_t)list.output_layer->buffer.memory;
-    PPE_Result_Layer.width                          = list.output_layer->buffer.width;
-    PPE_Result_Layer.height                         = list.output_layer->buffer.height;
-    PPE_Result_Layer.format                         = list.output_layer->buffer.format;
-    PPE_Result_Layer.line_len                       = list.output_layer->buffer.width;
-    PPE_Result_Layer.AXSIZE                         = 2;// 32bit bandwidth
-    PPE_Result_Layer.INCR                           = PPE_ARBURST_INCR;
-    PPE_Result_Layer.AXCACHE                        = 1;
-    PPE_Result_Layer.MAX_AXLEN_LOG                  = PPE_MAX_AXLEN_127;
-    PPE_Result_Layer.PRIOR                          = 0;
-    PPE_Result_Layer.byte_swap                      = PPE_NO_SWAP;
-    PPE_Result_Layer.handshake_mode                 = PPE_DMA_SW_HANDSHAKE;
-    PPE_Result_Layer.polarity                       = PPE_POLARITY_HIGH;
-    PPE_Result_Layer.handshake_en                   = DISABLE;
-    PPE_Result_Layer.handshake_msize                = PPE_MSIZE_1024;
-    PPE_Result_Layer.hw_index                       = 0;
-    PPE_InitResultLayer(&PPE_Result_Layer);
-
-    /*initial PPE global*/
-    PPE_Init_User.function                          =   PPE_FUNCTION_ALPHA_BLEND;
-    PPE_Init(&PPE_Init_User);
-    PPE_Secure(ENABLE);  /*secure for all channel*/
-    /*enable PPE*/
-    PPE_Cmd(ENABLE);
-    while (PPE->GLB_CTL & BIT0);
     return PPE_SUCCESS;
 }
 
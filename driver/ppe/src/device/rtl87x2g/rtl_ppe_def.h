@@ -86,6 +86,15 @@ typedef struct
 #define PPE_LAYER               ((PPE_LAYER_TypeDef*)PPE_CFG_REG_BASE)
 #define PPE                     ((PPE_TypeDef*)(PPE_CFG_REG_BASE + 0x400))
 
+#define PPE_INT_ALL_OVER_POS            (0)
+#define PPE_INT_FR_OVER_POS             (1)
+#define PPE_INT_LOAD_OVER_POS           (2)
+#define PPE_INT_LINE_WL_POS             (3)
+#define PPE_INT_SUSP_INAC_POS           (4)
+#define PPE_INT_SECURE_ERR_POS          (5)
+#define PPE_INT_SET_ERR_POS             (6)
+#define PPE_INT_CHN_BUS_ERR_POS         (15)
+
 /*============================================================================*
  *                         PPE Registers and Field Descriptions
  *============================================================================*/
@@ -0,0 +1,590 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+**********************************************************************************************************
+* \file     ppe_simulation.c
+* \brief    Software model of the RTL87x3EU PPE 2.0 datapath.
+* \details  PPE_Simulation_Run is the engine side of PPE_Cmd when PPE_SIM_BACKEND is set, it
+*           reads the job back from the layer registers and renders it with PPE_Simulation.
+*********************************************************************************************************
+*/
+
+/*============================================================================*
+ *                        Header Files
+ *============================================================================*/
+#include "ppe_simulation.h"
+#include "string.h"
+
+/*============================================================================*
+ *                          Private Macros
+ *============================================================================*/
+#define MIN(x, y)               (((x) < (y)) ? (x) : (y))
+#define PPE_SIM_A(c)            (((c) >> 24) & 0xFF)
+#define PPE_SIM_R(c)            (((c) >> 16) & 0xFF)
+#define PPE_SIM_G(c)            (((c) >> 8) & 0xFF)
+#define PPE_SIM_B(c)            ((c) & 0xFF)
+#define PPE_SIM_ARGB(a, r, g, b) (((uint32_t)(a) << 24) | ((uint32_t)(r) << 16) | \
+                                  ((uint32_t)(g) << 8) | (uint32_t)(b))
+
+/*============================================================================*
+ *                          Private Types
+ *============================================================================*/
+typedef enum
+{
+    PPE_SIM_RGB,
+    PPE_SIM_ALPHA,              /* A1-A8, color comes from Const_Pixel */
+    PPE_SIM_OPAQUE,             /* X1-X8, opaque Const_Pixel */
+    PPE_SIM_INDEX,              /* I1-I8, looked up in the CLUT */
+} PPE_SIM_FORMAT_KIND;
+
+typedef struct
+{
+    uint8_t shift;
+    uint8_t bits;
+} ppe_sim_channel_t;
+
+typedef struct
+{
+    uint8_t bpp;
+    uint8_t kind;
+    uint8_t swap;               /* 16 bit pixel stored big endian */
+    ppe_sim_channel_t a;
+    ppe_sim_channel_t r;
+    ppe_sim_channel_t g;
+    ppe_sim_channel_t b;
+} ppe_sim_format_t;
+
+/*============================================================================*
+ *                          Private Variables
+ *============================================================================*/
+/* channel position inside the pixel word, the first letter of the format name is the most
+   significant channel */
+static const ppe_sim_format_t ppe_sim_format[] =
+{
+    [PPE_ABGR8888] = {32, PPE_SIM_RGB, 0, {24, 8}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_ARGB8888] = {32, PPE_SIM_RGB, 0, {24, 8}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_XBGR8888] = {32, PPE_SIM_RGB, 0, {0, 0}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_XRGB8888] = {32, PPE_SIM_RGB, 0, {0, 0}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_BGRA8888] = {32, PPE_SIM_RGB, 0, {0, 8}, {8, 8}, {16, 8}, {24, 8}},
+    [PPE_RGBA8888] = {32, PPE_SIM_RGB, 0, {0, 8}, {24, 8}, {16, 8}, {8, 8}},
+    [PPE_BGRX8888] = {32, PPE_SIM_RGB, 0, {0, 0}, {8, 8}, {16, 8}, {24, 8}},
+    [PPE_RGBX8888] = {32, PPE_SIM_RGB, 0, {0, 0}, {24, 8}, {16, 8}, {8, 8}},
+    [PPE_ABGR4444] = {16, PPE_SIM_RGB, 0, {12, 4}, {0, 4}, {4, 4}, {8, 4}},
+    [PPE_ARGB4444] = {16, PPE_SIM_RGB, 0, {12, 4}, {8, 4}, {4, 4}, {0, 4}},
+    [PPE_XBGR4444] = {16, PPE_SIM_RGB, 0, {0, 0}, {0, 4}, {4, 4}, {8, 4}},
+    [PPE_XRGB4444] = {16, PPE_SIM_RGB, 0, {0, 0}, {8, 4}, {4, 4}, {0, 4}},
+    [PPE_BGRA4444] = {16, PPE_SIM_RGB, 0, {0, 4}, {4, 4}, {8, 4}, {12, 4}},
+    [PPE_RGBA4444] = {16, PPE_SIM_RGB, 0, {0, 4}, {12, 4}, {8, 4}, {4, 4}},
+    [PPE_BGRX4444] = {16, PPE_SIM_RGB, 0, {0, 0}, {4, 4}, {8, 4}, {12, 4}},
+    [PPE_RGBX4444] = {16, PPE_SIM_RGB, 0, {0, 0}, {12, 4}, {8, 4}, {4, 4}},
+    [PPE_ABGR2222] = {8, PPE_SIM_RGB, 0, {6, 2}, {0, 2}, {2, 2}, {4, 2}},
+    [PPE_ARGB2222] = {8, PPE_SIM_RGB, 0, {6, 2}, {4, 2}, {2, 2}, {0, 2}},
+    [PPE_XBGR2222] = {8, PPE_SIM_RGB, 0, {0, 0}, {0, 2}, {2, 2}, {4, 2}},
+    [PPE_XRGB2222] = {8, PPE_SIM_RGB, 0, {0, 0}, {4, 2}, {2, 2}, {0, 2}},
+    [PPE_BGRA2222] = {8, PPE_SIM_RGB, 0, {0, 2}, {2, 2}, {4, 2}, {6, 2}},
+    [PPE_RGBA2222] = {8, PPE_SIM_RGB, 0, {0, 2}, {6, 2}, {4, 2}, {2, 2}},
+    [PPE_BGRX2222] = {8, PPE_SIM_RGB, 0, {0, 0}, {2, 2}, {4, 2}, {6, 2}},
+    [PPE_RGBX2222] = {8, PPE_SIM_RGB, 0, {0, 0}, {6, 2}, {4, 2}, {2, 2}},
+    [PPE_ABGR8565] = {24, PPE_SIM_RGB, 0, {16, 8}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_ARGB8565] = {24, PPE_SIM_RGB, 0, {16, 8}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_XBGR8565] = {24, PPE_SIM_RGB, 0, {0, 0}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_XRGB8565] = {24, PPE_SIM_RGB, 0, {0, 0}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_BGRA5658] = {24, PPE_SIM_RGB, 0, {0, 8}, {8, 5}, {13, 6}, {19, 5}},
+    [PPE_RGBA5658] = {24, PPE_SIM_RGB, 0, {0, 8}, {19, 5}, {13, 6}, {8, 5}},
+    [PPE_BGRX5658] = {24, PPE_SIM_RGB, 0, {0, 0}, {8, 5}, {13, 6}, {19, 5}},
+    [PPE_RGBX5658] = {24, PPE_SIM_RGB, 0, {0, 0}, {19, 5}, {13, 6}, {8, 5}},
+    [PPE_ABGR1555] = {16, PPE_SIM_RGB, 0, {15, 1}, {0, 5}, {5, 5}, {10, 5}},
+    [PPE_ARGB1555] = {16, PPE_SIM_RGB, 0, {15, 1}, {10, 5}, {5, 5}, {0, 5}},
+    [PPE_XBGR1555] = {16, PPE_SIM_RGB, 0, {0, 0}, {0, 5}, {5, 5}, {10, 5}},
+    [PPE_XRGB1555] = {16, PPE_SIM_RGB, 0, {0, 0}, {10, 5}, {5, 5}, {0, 5}},
+    [PPE_BGRA5551] = {16, PPE_SIM_RGB, 0, {0, 1}, {1, 5}, {6, 5}, {11, 5}},
+    [PPE_RGBA5551] = {16, PPE_SIM_RGB, 0, {0, 1}, {11, 5}, {6, 5}, {1, 5}},
+    [PPE_BGRX5551] = {16, PPE_SIM_RGB, 0, {0, 0}, {1, 5}, {6, 5}, {11, 5}},
+    [PPE_RGBX5551] = {16, PPE_SIM_RGB, 0, {0, 0}, {11, 5}, {6, 5}, {1, 5}},
+    [PPE_BGR888] = {24, PPE_SIM_RGB, 0, {0, 0}, {0, 8}, {8, 8}, {16, 8}},
+    [PPE_RGB888] = {24, PPE_SIM_RGB, 0, {0, 0}, {16, 8}, {8, 8}, {0, 8}},
+    [PPE_BGR565] = {16, PPE_SIM_RGB, 0, {0, 0}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_RGB565] = {16, PPE_SIM_RGB, 0, {0, 0}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_A8] = {8, PPE_SIM_ALPHA, 0, {0, 8}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_X8] = {8, PPE_SIM_OPAQUE, 0, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_A4] = {4, PPE_SIM_ALPHA, 0, {0, 4}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_X4] = {4, PPE_SIM_OPAQUE, 0, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_A2] = {2, PPE_SIM_ALPHA, 0, {0, 2}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_X2] = {2, PPE_SIM_OPAQUE, 0, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_A1] = {1, PPE_SIM_ALPHA, 0, {0, 1}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_X1] = {1, PPE_SIM_OPAQUE, 0, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_ABGR8666] = {32, PPE_SIM_RGB, 0, {18, 8}, {0, 6}, {6, 6}, {12, 6}},
+    [PPE_ARGB8666] = {32, PPE_SIM_RGB, 0, {18, 8}, {12, 6}, {6, 6}, {0, 6}},
+    [PPE_XBGR8666] = {32, PPE_SIM_RGB, 0, {0, 0}, {0, 6}, {6, 6}, {12, 6}},
+    [PPE_XRGB8666] = {32, PPE_SIM_RGB, 0, {0, 0}, {12, 6}, {6, 6}, {0, 6}},
+    [PPE_BGRA6668] = {32, PPE_SIM_RGB, 0, {0, 8}, {8, 6}, {14, 6}, {20, 6}},
+    [PPE_RGBA6668] = {32, PPE_SIM_RGB, 0, {0, 8}, {20, 6}, {14, 6}, {8, 6}},
+    [PPE_BGRX6668] = {32, PPE_SIM_RGB, 0, {0, 0}, {8, 6}, {14, 6}, {20, 6}},
+    [PPE_RGBX6668] = {32, PPE_SIM_RGB, 0, {0, 0}, {20, 6}, {14, 6}, {8, 6}},
+    [PPE_BGR565_S] = {16, PPE_SIM_RGB, 1, {0, 0}, {0, 5}, {5, 6}, {11, 5}},
+    [PPE_RGB565_S] = {16, PPE_SIM_RGB, 1, {0, 0}, {11, 5}, {5, 6}, {0, 5}},
+    [PPE_I8] = {8, PPE_SIM_INDEX, 0, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_I4] = {4, PPE_SIM_INDEX, 0, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_I2] = {2, PPE_SIM_INDEX, 0, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+    [PPE_I1] = {1, PPE_SIM_INDEX, 0, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+};
+
+/* CLUT RAM behind the CLUT_INDEX/CLUT_CONT port, filled by PPE_Simulation_Load_CLUT */
+static uint32_t ppe_sim_clut[256];
+
+/*============================================================================*
+ *                          Private Functions
+ *============================================================================*/
+/* x / 255 rounded to nearest for x <= 255 * 255 * 2 */
+static inline uint32_t ppe_sim_div255(uint32_t x)
+{
+    return (x + 128 + ((x + 128) >> 8)) >> 8;
+}
+
+/* widen a channel to 8 bits by repeating its bits, 0x1F -> 0xFF */
+static uint8_t ppe_sim_expand(uint32_t value, uint8_t bits)
+{
+    uint32_t c = value << (8 - bits);
+    for (uint8_t filled = bits; filled < 8; filled *= 2)
+    {
+        c |= c >> filled;
+    }
+    return c & 0xFF;
+}
+
+static uint32_t ppe_sim_field(uint32_t word, ppe_sim_channel_t channel)
+{
+    return (word >> channel.shift) & ((1UL << channel.bits) - 1);
+}
+
+static uint32_t ppe_sim_read(uint32_t addr, uint32_t line_len, uint8_t bpp, uint32_t x, uint32_t y)
+{
+    uint32_t bit = y * line_len + x * bpp;
+    uint8_t *p = PPE_SIM_ADDR(addr) + bit / 8;
+
+    if (bpp < 8)
+    {
+        return (*p >> (bit % 8)) & ((1UL << bpp) - 1);
+    }
+    uint32_t word = 0;
+    for (uint8_t i = 0; i < bpp / 8; i++)
+    {
+        word |= (uint32_t)p[i] << (8 * i);
+    }
+    return word;
+}
+
+static void ppe_sim_write(uint32_t addr, uint32_t line_len, uint8_t bpp, uint32_t x, uint32_t y,
+                          uint32_t word)
+{
+    uint32_t bit = y * line_len + x * bpp;
+    uint8_t *p = PPE_SIM_ADDR(addr) + bit / 8;
+
+    if (bpp < 8)
+    {
+        uint8_t mask = ((1U << bpp) - 1) << (bit % 8);
+        *p = (*p & ~mask) | ((word << (bit % 8)) & mask);
+        return;
+    }
+    for (uint8_t i = 0; i < bpp / 8; i++)
+    {
+        p[i] = (word >> (8 * i)) & 0xFF;
+    }
+}
+
+static bool ppe_sim_color_key(PPE_InputLayer_Init_Typedef *layer, uint32_t *color)
+{
+    PPE_color_key_state key = layer->Color_Key_Enable;
+    uint8_t r = PPE_SIM_R(*color);
+    uint8_t g = PPE_SIM_G(*color);
+    uint8_t b = PPE_SIM_B(*color);
+
+    if (!(key.channel_en.r_en || key.channel_en.g_en || key.channel_en.b_en))
+    {
+        return false;
+    }
+    bool inside = (!key.channel_en.r_en || (r >= layer->Color_Key_MIN_R && r <= layer->Color_Key_MAX_R)) &&
+                  (!key.channel_en.g_en || (g >= layer->Color_Key_MIN_G && g <= layer->Color_Key_MAX_G)) &&
+                  (!key.channel_en.b_en || (b >= layer->Color_Key_MIN_B && b <= layer->Color_Key_MAX_B));
+    if (inside != (layer->Color_Key_Mode == PPE_COLOR_KEY_INSIDE))
+    {
+        return false;
+    }
+
+    uint8_t a = PPE_SIM_A(*color);
+    if (key.channel_en.r_en)
+    {
+        r = layer->Color_Key_Replace_R;
+    }
+    if (key.channel_en.g_en)
+    {
+        g = layer->Color_Key_Replace_G;
+    }
+    if (key.channel_en.b_en)
+    {
+        b = layer->Color_Key_Replace_B;
+    }
+    if (key.channel_en.a_en)
+    {
+        a = layer->Color_Key_Replace_A;
+    }
+    *color = PPE_SIM_ARGB(a, r, g, b);
+    return true;
+}
+
+static uint32_t ppe_sim_fetch(PPE_InputLayer_Init_Typedef *layer, uint32_t x, uint32_t y)
+{
+    uint32_t color = PPE_Simulation_Get_Pixel(layer->Layer_Address, layer->Line_Length,
+                                              layer->Pixel_Color_Format, x, y, layer->Const_Pixel,
+                                              layer->Index_Table);
+    if (layer->Color_Key_Enable.key_enable)
+    {
+        ppe_sim_color_key(layer, &color);
+    }
+    return color;
+}
+
+static uint32_t ppe_sim_bilinear(uint32_t c00, uint32_t c10, uint32_t c01, uint32_t c11,
+                                 uint32_t fx, uint32_t fy)
+{
+    uint32_t w00 = (256 - fx) * (256 - fy);
+    uint32_t w10 = fx * (256 - fy);
+    uint32_t w01 = (256 - fx) * fy;
+    uint32_t w11 = fx * fy;
+    uint32_t color = 0;
+
+    for (uint8_t shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t c = (((c00 >> shift) & 0xFF) * w00 + ((c10 >> shift) & 0xFF) * w10 +
+                      ((c01 >> shift) & 0xFF) * w01 + ((c11 >> shift) & 0xFF) * w11 + 0x8000) >> 16;
+        color |= c << shift;
+    }
+    return color;
+}
+
+/* source pixel of layer seen at result pixel (x, y), false if it falls outside the layer */
+static bool ppe_sim_sample(PPE_InputLayer_Init_Typedef *layer, int32_t x, int32_t y, uint32_t *color)
+{
+    int64_t sx = (int64_t)(int32_t)layer->Transfer_Matrix_E11 * x +
+                 (int64_t)(int32_t)layer->Transfer_Matrix_E12 * y + (int32_t)layer->Transfer_Matrix_E13;
+    int64_t sy = (int64_t)(int32_t)layer->Transfer_Matrix_E21 * x +
+                 (int64_t)(int32_t)layer->Transfer_Matrix_E22 * y + (int32_t)layer->Transfer_Matrix_E23;
+    int64_t sw = (int64_t)(int32_t)layer->Transfer_Matrix_E31 * x +
+                 (int64_t)(int32_t)layer->Transfer_Matrix_E32 * y + (int32_t)layer->Transfer_Matrix_E33;
+
+    if (sw <= 0)
+    {
+        return false;
+    }
+    /* Q16.16 position in the source picture */
+    int64_t u = (sx * 65536) / sw;
+    int64_t v = (sy * 65536) / sw;
+    int32_t iu = (int32_t)(u >> 16);
+    int32_t iv = (int32_t)(v >> 16);
+
+    int32_t x_max = MIN((int32_t)layer->Layer_Window_Xmax, (int32_t)layer->Pic_Width - 1);
+    int32_t y_max = MIN((int32_t)layer->Layer_Window_Ymax, (int32_t)layer->Pic_Height - 1);
+    if ((iu < layer->Layer_Window_Xmin) || (iu > x_max) || (iv < layer->Layer_Window_Ymin) ||
+        (iv > y_max))
+    {
+        return false;
+    }
+
+    if (layer->Pixel_Source == PPE_LAYER_SRC_CONST)
+    {
+        *color = layer->Const_Pixel;
+        return true;
+    }
+    if (layer->Source_Interpolation == PPV2_SRC_BILINEAR)
+    {
+        int32_t iu1 = MIN(iu + 1, x_max);
+        int32_t iv1 = MIN(iv + 1, y_max);
+        *color = ppe_sim_bilinear(ppe_sim_fetch(layer, iu, iv), ppe_sim_fetch(layer, iu1, iv),
+                                  ppe_sim_fetch(layer, iu, iv1), ppe_sim_fetch(layer, iu1, iv1),
+                                  (u >> 8) & 0xFF, (v >> 8) & 0xFF);
+    }
+    else
+    {
+        *color = ppe_sim_fetch(layer, iu, iv);
+    }
+
+    /* Const_Pixel alpha works as the layer opacity */
+    uint32_t a = ppe_sim_div255(PPE_SIM_A(*color) * PPE_SIM_A(layer->Const_Pixel));
+    *color = (*color & 0xFFFFFF) | (a << 24);
+    return true;
+}
+
+static uint8_t ppe_sim_mix(uint32_t s, uint32_t d, uint32_t sa)
+{
+    return ppe_sim_div255(s * sa + d * (255 - sa));
+}
+
+static uint32_t ppe_sim_blend(uint32_t dst, uint32_t src, PPE_BLEND_METHOD method)
+{
+    uint32_t sa = PPE_SIM_A(src);
+    uint32_t da = PPE_SIM_A(dst);
+    uint32_t s[3] = {PPE_SIM_R(src), PPE_SIM_G(src), PPE_SIM_B(src)};
+    uint32_t d[3] = {PPE_SIM_R(dst), PPE_SIM_G(dst), PPE_SIM_B(dst)};
+    uint32_t over_a = sa + ppe_sim_div255(da * (255 - sa));
+    uint32_t c[3];
+    uint32_t a;
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        switch (method)
+        {
+        case PPE_BLEND_PREMULTIPLY:
+            c[i] = ppe_sim_div255(s[i] * sa);
+            break;
+        case PPE_BLEND_SRC_OVER:
+            c[i] = ppe_sim_mix(s[i], d[i], sa);
+            break;
+        case PPE_BLEND_DST_OVER:
+            c[i] = ppe_sim_mix(d[i], s[i], da);
+            break;
+        case PPE_BLEND_DST_IN:
+            c[i] = d[i];
+            break;
+        case PPE_BLEND_MULTIPLY:
+            c[i] = ppe_sim_mix(ppe_sim_div255(s[i] * d[i]), d[i], sa);
+            break;
+        case PPE_BLEND_SCREEN:
+            c[i] = ppe_sim_mix(s[i] + d[i] - ppe_sim_div255(s[i] * d[i]), d[i], sa);
+            break;
+        case PPE_BLEND_ADD:
+            c[i] = MIN(d[i] + ppe_sim_div255(s[i] * sa), 255);
+            break;
+        case PPE_BLEND_SUBSTRACT:
+            c[i] = d[i] - MIN(d[i], ppe_sim_div255(s[i] * sa));
+            break;
+        case PPE_BLEND_SRC:
+        case PPE_BLEND_SRC_IN:
+        case PPE_BLEND_BYPASS:
+        default:
+            c[i] = s[i];
+            break;
+        }
+    }
+
+    switch (method)
+    {
+    case PPE_BLEND_SRC_OVER:
+    case PPE_BLEND_MULTIPLY:
+    case PPE_BLEND_SCREEN:
+        a = over_a;
+        break;
+    case PPE_BLEND_DST_OVER:
+        a = da + ppe_sim_div255(sa * (255 - da));
+        break;
+    case PPE_BLEND_SRC_IN:
+    case PPE_BLEND_DST_IN:
+        a = ppe_sim_div255(sa * da);
+        break;
+    case PPE_BLEND_ADD:
+        a = MIN(sa + da, 255);
+        break;
+    case PPE_BLEND_SUBSTRACT:
+        a = da;
+        break;
+    default:
+        a = sa;
+        break;
+    }
+    return PPE_SIM_ARGB(a, c[0], c[1], c[2]);
+}
+
+static void ppe_sim_load_layer(PPE_Input_Layer_Typedef *reg, PPE_InputLayer_Init_Typedef *layer)
+{
+    PPE_REG_LYRx_PIC_CFG_TypeDef pic_cfg = {.d32 = reg->REG_LYRx_PIC_CFG};
+    PPE_REG_LYRx_WIN_MIN_TypeDef win_min = {.d32 = reg->REG_LYRx_WIN_MIN};
+    PPE_REG_LYRx_WIN_MAX_TypeDef win_max = {.d32 = reg->REG_LYRx_WIN_MAX};
+    PPE_REG_LYRx_LINE_LEN_TypeDef line_len = {.d32 = reg->REG_LYRx_LINE_LEN};
+    PPE_REG_LYRx_PIC_SIZE_TypeDef pic_size = {.d32 = reg->REG_LYRx_PIC_SIZE};
+    PPE_REG_LYRx_KEY_MIN_TypeDef key_min = {.d32 = reg->REG_LYRx_KEY_MIN};
+    PPE_REG_LYRx_KEY_MAX_TypeDef key_max = {.d32 = reg->REG_LYRx_KEY_MAX};
+    PPE_REG_LYRx_KEY_REPLACE_TypeDef key_replace = {.d32 = reg->REG_LYRx_KEY_REPLACE};
+
+    memset(layer, 0, sizeof(*layer));
+    layer->Layer_Address = reg->REG_LYRx_ADDR;
+    layer->Pic_Width = pic_size.b.width;
+    layer->Pic_Height = pic_size.b.height;
+    layer->Line_Length = line_len.b.line_len;
+    layer->Pixel_Source = (PPE_PIXEL_SOURCE)pic_cfg.b.pic_src;
+    layer->Pixel_Color_Format = (PPE_PIXEL_FORMAT)pic_cfg.b.format;
+    layer->Source_Interpolation = (PPE_SRC_INTERPOLATION)pic_cfg.b.interpolation;
+    layer->Blend_Method = (PPE_BLEND_METHOD)pic_cfg.b.abf;
+    layer->Const_Pixel = reg->REG_LYRx_CONST_PIX;
+    layer->Color_Key_Mode = (PPE_COLOR_KEY_MODE)pic_cfg.b.key_mode;
+    layer->Color_Key_Enable.key_enable = pic_cfg.b.key_en;
+    layer->Color_Key_MIN_R = key_min.b.r;
+    layer->Color_Key_MIN_G = key_min.b.g;
+    layer->Color_Key_MIN_B = key_min.b.b;
+    layer->Color_Key_MAX_R = key_max.b.r;
+    layer->Color_Key_MAX_G = key_max.b.g;
+    layer->Color_Key_MAX_B = key_max.b.b;
+    layer->Color_Key_Replace_R = key_replace.b.r;
+    layer->Color_Key_Replace_G = key_replace.b.g;
+    layer->Color_Key_Replace_B = key_replace.b.b;
+    layer->Color_Key_Replace_A = key_replace.b.a;
+    layer->Layer_Window_Xmin = win_min.b.win_x_min;
+    layer->Layer_Window_Ymin = win_min.b.win_y_min;
+    layer->Layer_Window_Xmax = win_max.b.win_x_max;
+    layer->Layer_Window_Ymax = win_max.b.win_y_max;
+    layer->Transfer_Matrix_E11 = reg->REG_LYRx_TRANS_MATRIX_E11;
+    layer->Transfer_Matrix_E12 = reg->REG_LYRx_TRANS_MATRIX_E12;
+    layer->Transfer_Matrix_E13 = reg->REG_LYRx_TRANS_MATRIX_E13;
+    layer->Transfer_Matrix_E21 = reg->REG_LYRx_TRANS_MATRIX_E21;
+    layer->Transfer_Matrix_E22 = reg->REG_LYRx_TRANS_MATRIX_E22;
+    layer->Transfer_Matrix_E23 = reg->REG_LYRx_TRANS_MATRIX_E23;
+    layer->Transfer_Matrix_E31 = reg->REG_LYRx_TRANS_MATRIX_E31;
+    layer->Transfer_Matrix_E32 = reg->REG_LYRx_TRANS_MATRIX_E32;
+    layer->Transfer_Matrix_E33 = reg->REG_LYRx_TRANS_MATRIX_E33;
+    layer->Index_Table = ppe_sim_clut;
+}
+
+/*============================================================================*
+ *                           Public Functions
+ *============================================================================*/
+/* PPE cannot write CLUT formats */
+static bool ppe_sim_format_writable(PPE_PIXEL_FORMAT format)
+{
+    return ((uint32_t)format < sizeof(ppe_sim_format) / sizeof(ppe_sim_format[0])) &&
+           (ppe_sim_format[format].bpp != 0) && (ppe_sim_format[format].kind != PPE_SIM_INDEX);
+}
+
+uint32_t PPE_Simulation_Get_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                  uint32_t x, uint32_t y, uint32_t const_pixel, uint32_t *clut)
+{
+    const ppe_sim_format_t *f = &ppe_sim_format[format];
+    uint32_t word = ppe_sim_read(addr, line_len, f->bpp, x, y);
+
+    switch (f->kind)
+    {
+    case PPE_SIM_ALPHA:
+        return (const_pixel & 0xFFFFFF) | ((uint32_t)ppe_sim_expand(word, f->bpp) << 24);
+    case PPE_SIM_OPAQUE:
+        return const_pixel | 0xFF000000;
+    case PPE_SIM_INDEX:
+        return (clut != NULL) ? clut[word] : 0;
+    default:
+        break;
+    }
+
+    if (f->swap)
+    {
+        word = ((word & 0xFF) << 8) | ((word >> 8) & 0xFF);
+    }
+    uint8_t a = (f->a.bits != 0) ? ppe_sim_expand(ppe_sim_field(word, f->a), f->a.bits) : 0xFF;
+    return PPE_SIM_ARGB(a, ppe_sim_expand(ppe_sim_field(word, f->r), f->r.bits),
+                        ppe_sim_expand(ppe_sim_field(word, f->g), f->g.bits),
+                        ppe_sim_expand(ppe_sim_field(word, f->b), f->b.bits));
+}
+
+PPE_ERR PPE_Simulation_Set_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                 uint32_t x, uint32_t y, uint32_t color)
+{
+    if (!ppe_sim_format_writable(format))
+    {
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+    const ppe_sim_format_t *f = &ppe_sim_format[format];
+    uint32_t word = 0;
+
+    switch (f->kind)
+    {
+    case PPE_SIM_ALPHA:
+        word = PPE_SIM_A(color) >> (8 - f->bpp);
+        break;
+    case PPE_SIM_OPAQUE:
+        break;
+    default:
+        /* narrowing drops the low bits */
+        word = ((PPE_SIM_A(color) >> (8 - f->a.bits)) << f->a.shift) |
+               ((PPE_SIM_R(color) >> (8 - f->r.bits)) << f->r.shift) |
+               ((PPE_SIM_G(color) >> (8 - f->g.bits)) << f->g.shift) |
+               ((PPE_SIM_B(color) >> (8 - f->b.bits)) << f->b.shift);
+        if (f->swap)
+        {
+            word = ((word & 0xFF) << 8) | ((word >> 8) & 0xFF);
+        }
+        break;
+    }
+    ppe_sim_write(addr, line_len, f->bpp, x, y, word);
+    return PPE_SUCCESS;
+}
+
+PPE_ERR PPE_Simulation(PPE_ResultLayer_Init_Typedef *result, PPE_InputLayer_Init_Typedef *input,
+                       uint32_t layer_en)
+{
+    if (!ppe_sim_format_writable(result->Color_Format))
+    {
+        return PPE_ERR_INVALID_PARAMETER;
+    }
+    for (int32_t y = result->Layer_Window_Ymin; y <= result->Layer_Window_Ymax; y++)
+    {
+        for (int32_t x = result->Layer_Window_Xmin; x <= result->Layer_Window_Xmax; x++)
+        {
+            uint32_t color = 0;
+            uint32_t src;
+
+            if ((layer_en & PPE_SIM_LAYER1_EN) && ppe_sim_sample(&input[0], x, y, &src))
+            {
+                /* the driver always runs input layer 1 with PPE_BLEND_SRC */
+                color = src;
+            }
+            if ((layer_en & PPE_SIM_LAYER2_EN) && ppe_sim_sample(&input[1], x, y, &src))
+            {
+                color = ppe_sim_blend(color, src, input[1].Blend_Method);
+            }
+            PPE_Simulation_Set_Pixel(result->Layer_Address, result->Line_Length, result->Color_Format,
+                                     x, y, color);
+        }
+    }
+    return PPE_SUCCESS;
+}
+
+void PPE_Simulation_Load_CLUT(uint32_t *clut, uint16_t size)
+{
+    memcpy(ppe_sim_clut, clut, MIN(size, 256) * sizeof(uint32_t));
+}
+
+void PPE_Simulation_Run(void)
+{
+    PPE_REG_LYR_ENABLE_TypeDef lyr_enable = {.d32 = PPE->REG_LYR_ENABLE};
+    PPE_REG_LYR0_PIC_CFG_TypeDef pic_cfg = {.d32 = PPE_ResultLayer->REG_LYR0_PIC_CFG};
+    PPE_REG_LYR0_WIN_MIN_TypeDef win_min = {.d32 = PPE_ResultLayer->REG_LYR0_WIN_MIN};
+    PPE_REG_LYR0_WIN_MAX_TypeDef win_max = {.d32 = PPE_ResultLayer->REG_LYR0_WIN_MAX};
+    PPE_ResultLayer_Init_Typedef result = {0};
+    PPE_InputLayer_Init_Typedef input[2];
+    uint32_t layer_en = 0;
+
+    result.Layer_Address = PPE_ResultLayer->REG_LYR0_ADDR;
+    result.Line_Length = PPE_ResultLayer->REG_LYR0_LINE_LEN;
+    result.Color_Format = (PPE_PIXEL_FORMAT)pic_cfg.b.format;
+    result.Layer_Window_Xmin = win_min.b.win_x_min;
+    result.Layer_Window_Ymin = win_min.b.win_y_min;
+    result.Layer_Window_Xmax = win_max.b.win_x_max;
+    result.Layer_Window_Ymax = win_max.b.win_y_max;
+    ppe_sim_load_layer(PPE_InputLayer1, &input[0]);
+    ppe_sim_load_layer(PPE_InputLayer2, &input[1]);
+    if (lyr_enable.b.input_lyr_1_en)
+    {
+        layer_en |= PPE_SIM_LAYER1_EN;
+    }
+    if (lyr_enable.b.input_lyr_2_en)
+    {
+        layer_en |= PPE_SIM_LAYER2_EN;
+    }
+    PPE_Simulation(&result, input, layer_en);
+
+    /* job end: the FSM stops and raises the frame and all over interrupts, clears written to
+       INTR_CLR since the last job are applied first as the register file cannot see them */
+    PPE_REG_GLB_STATUS_TypeDef glb_status = {.d32 = PPE->REG_GLB_STATUS};
+    glb_status.b.run_state = 0;
+    PPE->REG_GLB_STATUS = glb_status.d32;
+    volatile uint32_t *intr_raw = (volatile uint32_t *)&PPE->REG_INTR_RAW;
+    *intr_raw = (*intr_raw & ~PPE->REG_INTR_CLR) | BIT0 | BIT1;
+    PPE->REG_INTR_CLR = 0;
+}
+
+/******************* (C) COPYRIGHT 2024 Realtek Semiconductor Corporation *****END OF FILE****/
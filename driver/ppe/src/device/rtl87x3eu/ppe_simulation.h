@@ -0,0 +1,118 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     ppe_simulation.h
+* \brief    Software model of the RTL87x3EU PPE 2.0 datapath.
+* \details  PPE_Simulation takes the same init structs that are programmed into the PPE registers
+*           and renders the result layer on the CPU, so compositions can be checked and profiled
+*           on a host without silicon.
+*           Built with PPE_SIM_BACKEND set, PPE_Cmd(ENABLE) calls PPE_Simulation_Run instead of
+*           starting the engine, so every PPE_* call runs on the model. The model is checked
+*           against PPE_Blit_Inverse_Simulate and the driver's CPU fills, not against silicon.
+*********************************************************************************************************
+*/
+
+/*============================================================================*
+ *               Define to prevent recursive inclusion
+ *============================================================================*/
+#ifndef PPE_SIMULATION_H
+#define PPE_SIMULATION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================*
+ *                        Header Files
+ *============================================================================*/
+#include "rtl_ppe.h"
+
+/*============================================================================*
+ *                         Constants
+ *============================================================================*/
+/* Layer_Address values are 32 bit, a host build that keeps buffers above 4GB
+   can map them to real pointers by redefining this */
+#ifndef PPE_SIM_ADDR
+#define PPE_SIM_ADDR(addr)      ((uint8_t *)(uintptr_t)(addr))
+#endif
+
+/* bit in layer_en that enables input[i] */
+#define PPE_SIM_LAYER1_EN       BIT0
+#define PPE_SIM_LAYER2_EN       BIT1
+
+/*============================================================================*
+ *                         Functions
+ *============================================================================*/
+/**
+ * \brief  Render the result window the way PPE does for the given layer setup
+ * \note   Pixel (x, y) of the result window is mapped through the Transfer_Matrix_Exx of each
+ *         enabled input layer. The Q16.16 source position is truncated, or sampled 2x2 when
+ *         Source_Interpolation is bilinear. The color key is applied, Const_Pixel alpha scales
+ *         the pixel, and the layers are blended in order (input[0] first) with Blend_Method
+ *         onto a transparent background. The result is then packed into Color_Format.
+ *         Line_Length is in bits, as PPE_Blit_Inverse programs it. Sub-byte pixels are packed
+ *         from the least significant bit, and I1-I8 pixels are looked up in Index_Table.
+ * \param[in] result        result layer setup, Layer_Address is written.
+ * \param[in] input         array of two input layer setups.
+ * \param[in] layer_en      PPE_SIM_LAYER1_EN and/or PPE_SIM_LAYER2_EN.
+ * \return operation result
+ * \retval PPE_SUCCESS                 Operation success.
+ * \retval PPE_ERR_INVALID_PARAMETER   Color_Format cannot be written, e.g. I1-I8.
+ */
+PPE_ERR PPE_Simulation(PPE_ResultLayer_Init_Typedef *result, PPE_InputLayer_Init_Typedef *input,
+                       uint32_t layer_en);
+
+/**
+ * \brief  Read one pixel of a buffer as ARGB8888
+ * \param[in] addr          buffer address.
+ * \param[in] line_len      line length in bits.
+ * \param[in] format        pixel format, A/X formats take RGB from const_pixel.
+ * \param[in] x             column.
+ * \param[in] y             row.
+ * \param[in] const_pixel   ARGB8888 constant color of the layer.
+ * \param[in] clut          ARGB8888 table for I1-I8 formats.
+ * \return pixel in ARGB8888
+ */
+uint32_t PPE_Simulation_Get_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                  uint32_t x, uint32_t y, uint32_t const_pixel, uint32_t *clut);
+
+/**
+ * \brief  Write one ARGB8888 pixel to a buffer
+ * \param[in] addr          buffer address.
+ * \param[in] line_len      line length in bits.
+ * \param[in] format        pixel format, I1-I8 are not supported as output.
+ * \param[in] x             column.
+ * \param[in] y             row.
+ * \param[in] color         pixel in ARGB8888.
+ * \return operation result
+ * \retval PPE_SUCCESS                 Operation success.
+ * \retval PPE_ERR_INVALID_PARAMETER   format cannot be written, e.g. I1-I8.
+ */
+PPE_ERR PPE_Simulation_Set_Pixel(uint32_t addr, uint32_t line_len, PPE_PIXEL_FORMAT format,
+                                 uint32_t x, uint32_t y, uint32_t color);
+
+/**
+ * \brief  Copy a palette into the model's CLUT RAM
+ * \note   Stands in for the CLUT_INDEX/CLUT_CONT writes of PPE_CLUT_Load, which a register file
+ *         without the auto increment cannot capture.
+ * \param[in] clut          ARGB8888 entries.
+ * \param[in] size          number of entries, at most 256 are kept.
+ */
+void PPE_Simulation_Load_CLUT(uint32_t *clut, uint16_t size);
+
+/**
+ * \brief  Run the job programmed in the PPE registers on the model
+ * \note   Reads the result layer and the enabled input layers back from the registers, renders
+ *         them with PPE_Simulation and leaves REG_GLB_STATUS and REG_INTR_RAW as the engine does
+ *         when the frame is over. I1-I8 layers are looked up in the CLUT RAM.
+ */
+void PPE_Simulation_Run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PPE_SIMULATION_H */
+
+/******************* (C) COPYRIGHT 2024 Realtek Semiconductor Corporation *****END OF FILE****/
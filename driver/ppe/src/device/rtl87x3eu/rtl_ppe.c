@@ -15,8 +15,13 @@
  *                        Header Files
  *============================================================================*/
 #include "rtl_ppe.h"
+#if PPE_PERF_EN
+#include "stdio.h"
+#endif
 #include "string.h"
 #include "math.h"
+#include "rtl_ppe_quad.h"
+#include "rtl_ppe_orient.h"
 #include "ppe_simulation.h"
 #include "trace.h"
 
@@ -25,23 +30,216 @@
  *============================================================================*/
 #define USE_PPE_MAT     1
 #define ABS(x)               (((x) < 0)    ? -(x) :  (x))
+#define MIN(x, y)            (((x) < (y)) ? (x) : (y))
 #define EPS                  1.1920929e-7f
+#ifndef PPE_BLIT_TILE_MIN_SIZE
+#define PPE_BLIT_TILE_MIN_SIZE 32
+#endif
+#ifndef PPE_MATRIX_CACHE_NUM
+#define PPE_MATRIX_CACHE_NUM 4
+#endif
+#ifndef PPE_REG_SHADOW_EN
+#define PPE_REG_SHADOW_EN       1
+#endif
+#ifndef PPE_CLUT_BATCH_LOOKAHEAD
+#define PPE_CLUT_BATCH_LOOKAHEAD 16     /* jobs searched for one sharing the resident palette, at most 32 */
+#endif
+#ifndef PPE_MASK_SW_PIXELS
+#define PPE_MASK_SW_PIXELS      256     /* opaque PPE_Mask_List fills up to this area are CPU stores */
+#endif
+#ifndef PPE_MASK_LIST_BATCH
+#define PPE_MASK_LIST_BATCH     16      /* fills PPE_Mask_List merges at a time, on the stack */
+#endif
+
+/*job timing counters, timestamps come from the DWT cycle counter unless the platform provides
+  another free running 32 bit counter as PPE_PERF_TIMESTAMP()*/
+#include "rtl_ppe_perf.h"
+#if PPE_PERF_EN
+#define PPE_PERF_BEGIN(op)      PPE_Perf_Begin(op)
+#define PPE_PERF_START()        PPE_Perf_Start()
+#define PPE_PERF_DONE()         PPE_Perf_Done()
+#else
+#define PPE_PERF_BEGIN(op)
+#define PPE_PERF_START()
+#define PPE_PERF_DONE()
+#endif
 
 /*============================================================================*
  *                          Private Variables
  *============================================================================*/
 typedef struct
 {
-    float p[3];
-} ppe_pox_t;
+    ppe_matrix_t key;
+    ppe_matrix_fixed_t value;
+    bool inverse;
+    bool valid;
+} ppe_matrix_cache_t;
+
+static ppe_matrix_cache_t ppe_matrix_cache[PPE_MATRIX_CACHE_NUM];
+static uint8_t ppe_matrix_cache_next = 0;
+
+/*layer registers are mirrored in blocks of 0x80 bytes starting at PPE_Result_Layer_BASE, a word is only
+  trusted after it was read or written through the shadow*/
+#if PPE_REG_SHADOW_EN
+#define PPE_SHADOW_LAYER_SHIFT  7
+#define PPE_SHADOW_LAYER_WORDS  32
+#define PPE_SHADOW_LAYER_NUM    3
+
+static uint32_t ppe_shadow[PPE_SHADOW_LAYER_NUM][PPE_SHADOW_LAYER_WORDS];
+static uint32_t ppe_shadow_valid[PPE_SHADOW_LAYER_NUM];
+#endif
+static ppe_reg_stat_t ppe_reg_stat;
+
+#if PPE_PERF_EN
+static ppe_perf_stat_t ppe_perf;
+static PPE_PERF_OP ppe_perf_op = PPE_PERF_OP_OTHER;
+static uint32_t ppe_perf_mark = 0;      /* API entry or end of the previous job */
+static bool ppe_perf_running = false;
+static PPE_PERF_OP ppe_perf_job_op;
+static uint32_t ppe_perf_job_start;
+static uint32_t ppe_perf_job_setup;
+static uint32_t ppe_perf_job_pixels;
+static uint32_t ppe_perf_job_read;
+static uint32_t ppe_perf_job_write;
+#endif
+
+/* palette held by the PPE CLUT, identified by content hash and entry count */
+static uint32_t ppe_clut_hash = 0;
+static uint16_t ppe_clut_size = 0;
+static bool ppe_clut_valid = false;
+static ppe_clut_stat_t ppe_clut_stat;
 
 /*============================================================================*
  *                          Private Functions
  *============================================================================*/
 static bool inv_matrix2complement(ppe_matrix_t *matrix, uint32_t *comp);
 static bool ppe_get_block_size(ppe_matrix_t *matrix, uint8_t pixel_size, uint16_t* block_width, uint16_t* block_height);
+static void pos_transfer(ppe_matrix_t *matrix, ppe_pox_t *pox);
 static uint32_t* INDEX_CLUT = NULL;
 
+static uint32_t PPE_Shadow_Read(volatile uint32_t *reg)
+{
+#if PPE_REG_SHADOW_EN
+    uint32_t offset = (uint32_t)reg - PPE_Result_Layer_BASE;
+    uint32_t layer = offset >> PPE_SHADOW_LAYER_SHIFT;
+    uint32_t word = (offset & ((1UL << PPE_SHADOW_LAYER_SHIFT) - 1)) >> 2;
+
+    if (!(ppe_shadow_valid[layer] & (1UL << word)))
+    {
+        ppe_shadow[layer][word] = *reg;
+        ppe_shadow_valid[layer] |= (1UL << word);
+    }
+    return ppe_shadow[layer][word];
+#else
+    return *reg;
+#endif
+}
+
+static void PPE_Shadow_Write(volatile uint32_t *reg, uint32_t value)
+{
+#if PPE_REG_SHADOW_EN
+    uint32_t offset = (uint32_t)reg - PPE_Result_Layer_BASE;
+    uint32_t layer = offset >> PPE_SHADOW_LAYER_SHIFT;
+    uint32_t word = (offset & ((1UL << PPE_SHADOW_LAYER_SHIFT) - 1)) >> 2;
+
+    if ((ppe_shadow_valid[layer] & (1UL << word)) && (ppe_shadow[layer][word] == value))
+    {
+        ppe_reg_stat.skip_cnt++;
+        return;
+    }
+    ppe_shadow[layer][word] = value;
+    ppe_shadow_valid[layer] |= (1UL << word);
+#endif
+    *reg = value;
+    ppe_reg_stat.write_cnt++;
+}
+
+#if PPE_PERF_EN
+static void PPE_Perf_Begin(PPE_PERF_OP op)
+{
+    ppe_perf.op[op].call_cnt++;
+    ppe_perf_op = op;
+    ppe_perf_mark = PPE_PERF_TIMESTAMP();
+}
+
+/*pixels and bytes of the job about to start, taken from the layers it was programmed with. A
+  transformed input is assumed to be read once per result pixel at most*/
+static void PPE_Perf_Traffic(void)
+{
+    PPE_REG_LYR_ENABLE_TypeDef ppe_reg_lyr_enable_0x04 = {.d32 = PPE->REG_LYR_ENABLE};
+    PPE_REG_LYR0_PIC_CFG_TypeDef ppe_reg_lyr0_pic_cfg_0x80 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_PIC_CFG)};
+    PPE_REG_LYR0_WIN_MIN_TypeDef ppe_reg_lyr0_win_min_0x88 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_WIN_MIN)};
+    PPE_REG_LYR0_WIN_MAX_TypeDef ppe_reg_lyr0_win_max_0x8c = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_WIN_MAX)};
+    PPE_Input_Layer_Typedef *input_layer[PPE_MAX_INPUTLAYER] = {PPE_InputLayer1, PPE_InputLayer2};
+    bool input_en[PPE_MAX_INPUTLAYER] = {ppe_reg_lyr_enable_0x04.b.input_lyr_1_en, ppe_reg_lyr_enable_0x04.b.input_lyr_2_en};
+
+    ppe_perf_job_pixels = (ppe_reg_lyr0_win_max_0x8c.b.win_x_max - ppe_reg_lyr0_win_min_0x88.b.win_x_min + 1) *
+                          (ppe_reg_lyr0_win_max_0x8c.b.win_y_max - ppe_reg_lyr0_win_min_0x88.b.win_y_min + 1);
+    ppe_perf_job_write = ppe_perf_job_pixels * PPE_Get_Pixel_Size((PPE_PIXEL_FORMAT)ppe_reg_lyr0_pic_cfg_0x80.b.format) /
+                         PPE_BYTE_SIZE;
+    ppe_perf_job_read = 0;
+    for (uint8_t i = 0; i < PPE_MAX_INPUTLAYER; i++)
+    {
+        PPE_REG_LYRx_PIC_CFG_TypeDef ppe_reg_lyrx_pic_cfg_t = {.d32 = PPE_Shadow_Read(&input_layer[i]->REG_LYRx_PIC_CFG)};
+        if (!input_en[i] || (ppe_reg_lyrx_pic_cfg_t.b.pic_src != PPE_LAYER_SRC_FROM_DMA))
+        {
+            continue;
+        }
+        PPE_REG_LYRx_WIN_MIN_TypeDef ppe_reg_lyrx_win_min_t = {.d32 = PPE_Shadow_Read(&input_layer[i]->REG_LYRx_WIN_MIN)};
+        PPE_REG_LYRx_WIN_MAX_TypeDef ppe_reg_lyrx_win_max_t = {.d32 = PPE_Shadow_Read(&input_layer[i]->REG_LYRx_WIN_MAX)};
+        uint32_t pixels = (ppe_reg_lyrx_win_max_t.b.win_x_max - ppe_reg_lyrx_win_min_t.b.win_x_min + 1) *
+                          (ppe_reg_lyrx_win_max_t.b.win_y_max - ppe_reg_lyrx_win_min_t.b.win_y_min + 1);
+        ppe_perf_job_read += MIN(pixels, ppe_perf_job_pixels) *
+                             PPE_Get_Pixel_Size((PPE_PIXEL_FORMAT)ppe_reg_lyrx_pic_cfg_t.b.format) / PPE_BYTE_SIZE;
+    }
+}
+
+static void PPE_Perf_Done(void)
+{
+    uint32_t now = PPE_PERF_TIMESTAMP();
+    ppe_perf_op_t *op = &ppe_perf.op[ppe_perf_job_op];
+    uint32_t latency;
+
+    if (!ppe_perf_running)
+    {
+        return;
+    }
+    ppe_perf_running = false;
+    ppe_perf_mark = now;
+    latency = ppe_perf_job_setup + (now - ppe_perf_job_start);
+
+    op->job_cnt++;
+    op->setup_time += ppe_perf_job_setup;
+    op->exec_time += now - ppe_perf_job_start;
+    if ((op->job_cnt == 1) || (latency < op->latency_min))
+    {
+        op->latency_min = latency;
+    }
+    if (latency > op->latency_max)
+    {
+        op->latency_max = latency;
+    }
+    op->pixels += ppe_perf_job_pixels;
+    op->read_bytes += ppe_perf_job_read;
+    op->write_bytes += ppe_perf_job_write;
+    op->hist[ppe_perf_bin(latency)]++;
+}
+
+static void PPE_Perf_Start(void)
+{
+    if (ppe_perf_running)
+    {
+        /*nobody waited for the previous job, PPE only takes a new one after it ended*/
+        PPE_Perf_Done();
+    }
+    PPE_Perf_Traffic();
+    ppe_perf_job_op = ppe_perf_op;
+    ppe_perf_running = true;
+    ppe_perf_job_start = PPE_PERF_TIMESTAMP();
+    ppe_perf_job_setup = ppe_perf_job_start - ppe_perf_mark;
+}
+#endif
+
 /*============================================================================*
  *                           Public Functions
  *============================================================================*/
@@ -57,6 +255,55 @@ void ppe_matrix_inverse(ppe_matrix_t *matrix);
 void ppe_mat_multiply(ppe_matrix_t *matrix, ppe_matrix_t *mult);
 #endif
 
+void PPE_RegShadow_Invalidate(void)
+{
+#if PPE_REG_SHADOW_EN
+    memset(ppe_shadow_valid, 0, sizeof(ppe_shadow_valid));
+#endif
+}
+
+void PPE_RegShadow_GetStat(ppe_reg_stat_t *stat)
+{
+    *stat = ppe_reg_stat;
+}
+
+void PPE_RegShadow_ClearStat(void)
+{
+    ppe_reg_stat.write_cnt = 0;
+    ppe_reg_stat.skip_cnt = 0;
+}
+
+#if PPE_PERF_EN
+void PPE_Perf_GetStat(ppe_perf_stat_t *stat)
+{
+    *stat = ppe_perf;
+}
+
+void PPE_Perf_ClearStat(void)
+{
+    PPE_PERF_TIMESTAMP_INIT();
+    memset(&ppe_perf, 0, sizeof(ppe_perf));
+    ppe_perf_running = false;
+}
+
+uint32_t PPE_Perf_Percentile(ppe_perf_op_t *op, uint8_t percent)
+{
+    return ppe_perf_percentile(op, percent);
+}
+
+uint32_t PPE_Perf_Dump(char *buf, uint32_t size)
+{
+    static const char *const op_name[PPE_PERF_OP_NUM] =
+    {
+    "other",
+    "blit",
+    "mask",
+    };
+
+    return ppe_perf_dump(&ppe_perf, op_name, buf, size);
+}
+#endif
+
 void PPE_CLK_ENABLE_IN_DLPS(FunctionalState NewState)
 {
     if (NewState != ENABLE)
@@ -89,6 +336,10 @@ void PPE_CLK_ENABLE(FunctionalState NewState)
         reg_value = *(uint32_t *)(0x40000210UL);
         reg_value &= ~(BIT24);
         *(uint32_t *)(0x40000210UL) = reg_value;
+
+        /*layer registers and CLUT are lost with the function*/
+        PPE_RegShadow_Invalidate();
+        PPE_CLUT_Invalidate();
     }
     else
     {
@@ -115,7 +366,14 @@ void PPE_Cmd(FunctionalState NewState)
     }
     else
     {
+        PPE_PERF_START();
+#if PPE_SIM_BACKEND
+        /* the model has finished the job when it returns, run_state is left at 0 */
+        PPE_Simulation_Run();
+        return;
+#else
         ppe_reg_glb_status_0x00.b.run_state = 0x1;
+#endif
     }
 
     PPE->REG_GLB_STATUS = ppe_reg_glb_status_0x00.d32;
@@ -123,20 +381,20 @@ void PPE_Cmd(FunctionalState NewState)
 
 void PPE_ResultLayer_Init(PPE_ResultLayer_Init_Typedef *PPE_ResultLyaer_Init_Struct)
 {
-    PPE_REG_LYR0_ADDR_TypeDef ppe_reg_lyr0_addr_0x98 = {.d32 = PPE_ResultLayer->REG_LYR0_ADDR};
+    PPE_REG_LYR0_ADDR_TypeDef ppe_reg_lyr0_addr_0x98 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_ADDR)};
     ppe_reg_lyr0_addr_0x98.b.addr                = PPE_ResultLyaer_Init_Struct->Layer_Address;
-    PPE_ResultLayer->REG_LYR0_ADDR               = ppe_reg_lyr0_addr_0x98.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_ADDR, ppe_reg_lyr0_addr_0x98.d32);
 
 
-    PPE_REG_LYR0_PIC_CFG_TypeDef  ppe_reg_lyr0_pic_cfg_0x80 = {.d32 = PPE_ResultLayer->REG_LYR0_PIC_CFG};
+    PPE_REG_LYR0_PIC_CFG_TypeDef  ppe_reg_lyr0_pic_cfg_0x80 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_PIC_CFG)};
     ppe_reg_lyr0_pic_cfg_0x80.b.format                  = PPE_ResultLyaer_Init_Struct->Color_Format;
-    PPE_ResultLayer->REG_LYR0_PIC_CFG                   = ppe_reg_lyr0_pic_cfg_0x80.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_PIC_CFG, ppe_reg_lyr0_pic_cfg_0x80.d32);
 
-    PPE_REG_LYR0_BUS_CFG_TypeDef ppe_reg_lyr0_bus_cfg_0x90 = {.d32 = PPE_ResultLayer->REG_LYR0_BUS_CFG};
+    PPE_REG_LYR0_BUS_CFG_TypeDef ppe_reg_lyr0_bus_cfg_0x90 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_BUS_CFG)};
     ppe_reg_lyr0_bus_cfg_0x90.b.incr                   = PPE_ResultLyaer_Init_Struct->LayerBus_Inc;
     ppe_reg_lyr0_bus_cfg_0x90.b.axsize                 = 0x2;
     ppe_reg_lyr0_bus_cfg_0x90.b.max_awlen_log          = 0x7;
-    PPE_ResultLayer->REG_LYR0_BUS_CFG                  = ppe_reg_lyr0_bus_cfg_0x90.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_BUS_CFG, ppe_reg_lyr0_bus_cfg_0x90.d32);
 
     PPE_REG_RELOAD_CFG_TypeDef ppe_reg_ld_cfg_0x08  = {.d32 = PPE->REG_RELOAD_CFG};
     ppe_reg_ld_cfg_0x08.b.input_lyr_1_reload_en  =  0;
@@ -148,24 +406,24 @@ void PPE_ResultLayer_Init(PPE_ResultLayer_Init_Typedef *PPE_ResultLyaer_Init_Str
     ppe_reg_ll_cfg_0x0c.b.input_lyr_2_ll_en = 0;
     PPE->REG_LL_CFG                        = ppe_reg_ll_cfg_0x0c.d32;
     
-    PPE_REG_LYR0_WIN_MIN_TypeDef ppe_reg_lyr0_win_min_0x88 = {.d32 = PPE_ResultLayer->REG_LYR0_WIN_MIN};
+    PPE_REG_LYR0_WIN_MIN_TypeDef ppe_reg_lyr0_win_min_0x88 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_WIN_MIN)};
     ppe_reg_lyr0_win_min_0x88.b.win_x_min = PPE_ResultLyaer_Init_Struct->Layer_Window_Xmin;
     ppe_reg_lyr0_win_min_0x88.b.win_y_min = PPE_ResultLyaer_Init_Struct->Layer_Window_Ymin;
-    PPE_ResultLayer->REG_LYR0_WIN_MIN = ppe_reg_lyr0_win_min_0x88.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_WIN_MIN, ppe_reg_lyr0_win_min_0x88.d32);
     
-    PPE_REG_LYR0_WIN_MAX_TypeDef ppe_reg_lyr0_win_max_0x8c = {.d32 = PPE_ResultLayer->REG_LYR0_WIN_MAX};
+    PPE_REG_LYR0_WIN_MAX_TypeDef ppe_reg_lyr0_win_max_0x8c = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_WIN_MAX)};
     ppe_reg_lyr0_win_max_0x8c.b.win_x_max = PPE_ResultLyaer_Init_Struct->Layer_Window_Xmax;
     ppe_reg_lyr0_win_max_0x8c.b.win_y_max = PPE_ResultLyaer_Init_Struct->Layer_Window_Ymax;
-    PPE_ResultLayer->REG_LYR0_WIN_MAX = ppe_reg_lyr0_win_max_0x8c.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_WIN_MAX, ppe_reg_lyr0_win_max_0x8c.d32);
     
-    PPE_REG_LYR0_LINE_LEN_TypeDef ppe_reg_lyr0_line_len_0xa0 = {.d32 = PPE_ResultLayer->REG_LYR0_LINE_LEN};
+    PPE_REG_LYR0_LINE_LEN_TypeDef ppe_reg_lyr0_line_len_0xa0 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_LINE_LEN)};
     ppe_reg_lyr0_line_len_0xa0.b.line_len = PPE_ResultLyaer_Init_Struct->Line_Length;
-    PPE_ResultLayer->REG_LYR0_LINE_LEN = ppe_reg_lyr0_line_len_0xa0.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_LINE_LEN, ppe_reg_lyr0_line_len_0xa0.d32);
     
-    PPE_REG_LYR0_BLK_SIZE_TypeDef ppe_reg_lyr0_line_len_0xa4 = {.d32 = PPE_ResultLayer->REG_LYR0_BLK_SIZE};
+    PPE_REG_LYR0_BLK_SIZE_TypeDef ppe_reg_lyr0_line_len_0xa4 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_BLK_SIZE)};
     ppe_reg_lyr0_line_len_0xa4.b.width = PPE_ResultLyaer_Init_Struct->Block_Width;
     ppe_reg_lyr0_line_len_0xa4.b.height = PPE_ResultLyaer_Init_Struct->Block_Height;
-    PPE_ResultLayer->REG_LYR0_BLK_SIZE = ppe_reg_lyr0_line_len_0xa4.d32;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_BLK_SIZE, ppe_reg_lyr0_line_len_0xa4.d32);
 }
 
 void PPE_InputLayer_Init(PPE_INPUT_LAYER_INDEX intput_layer_index, \
@@ -189,7 +447,7 @@ void PPE_InputLayer_Init(PPE_INPUT_LAYER_INDEX intput_layer_index, \
             break;
     }
 
-    PPE_REG_LYRx_PIC_CFG_TypeDef ppe_reg_lyrx_pic_cfg_t     = {.d32 = input_layer->REG_LYRx_PIC_CFG};
+    PPE_REG_LYRx_PIC_CFG_TypeDef ppe_reg_lyrx_pic_cfg_t     = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_PIC_CFG)};
     ppe_reg_lyrx_pic_cfg_t.b.format      =       PPE_InputLayer_Init_Struct->Pixel_Color_Format;
     ppe_reg_lyrx_pic_cfg_t.b.pic_src                    = PPE_InputLayer_Init_Struct->Pixel_Source;
     ppe_reg_lyrx_pic_cfg_t.b.interpolation = PPE_InputLayer_Init_Struct->Source_Interpolation;
@@ -203,23 +461,23 @@ void PPE_InputLayer_Init(PPE_INPUT_LAYER_INDEX intput_layer_index, \
     }
     ppe_reg_lyrx_pic_cfg_t.b.key_mode  = PPE_InputLayer_Init_Struct->Color_Key_Mode;
     ppe_reg_lyrx_pic_cfg_t.b.key_en = PPE_InputLayer_Init_Struct->Color_Key_Enable.key_enable;
-    input_layer->REG_LYRx_PIC_CFG                         = ppe_reg_lyrx_pic_cfg_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_PIC_CFG, ppe_reg_lyrx_pic_cfg_t.d32);
     
-    PPE_REG_LYRx_CONST_PIX_TypeDef ppe_reg_lyrx_const_pix_t = {.d32 = input_layer->REG_LYRx_CONST_PIX};
+    PPE_REG_LYRx_CONST_PIX_TypeDef ppe_reg_lyrx_const_pix_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_CONST_PIX)};
     ppe_reg_lyrx_const_pix_t.b.const_pixel =  PPE_InputLayer_Init_Struct->Const_Pixel;
-    input_layer->REG_LYRx_CONST_PIX                         = ppe_reg_lyrx_const_pix_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_CONST_PIX, ppe_reg_lyrx_const_pix_t.d32);
     
-    PPE_REG_LYRx_WIN_MIN_TypeDef ppe_reg_lyrx_win_min_t = {.d32 = input_layer->REG_LYRx_WIN_MIN};
+    PPE_REG_LYRx_WIN_MIN_TypeDef ppe_reg_lyrx_win_min_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_WIN_MIN)};
     ppe_reg_lyrx_win_min_t.b.win_x_min              = PPE_InputLayer_Init_Struct->Layer_Window_Xmin;
     ppe_reg_lyrx_win_min_t.b.win_y_min              = PPE_InputLayer_Init_Struct->Layer_Window_Ymin;
-    input_layer->REG_LYRx_WIN_MIN                     = ppe_reg_lyrx_win_min_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_WIN_MIN, ppe_reg_lyrx_win_min_t.d32);
 
-    PPE_REG_LYRx_WIN_MAX_TypeDef ppe_reg_lyrx_win_max_t = {.d32 = input_layer->REG_LYRx_WIN_MAX};
+    PPE_REG_LYRx_WIN_MAX_TypeDef ppe_reg_lyrx_win_max_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_WIN_MAX)};
     ppe_reg_lyrx_win_max_t.b.win_x_max              = PPE_InputLayer_Init_Struct->Layer_Window_Xmax;
     ppe_reg_lyrx_win_max_t.b.win_y_max              = PPE_InputLayer_Init_Struct->Layer_Window_Ymax;
-    input_layer->REG_LYRx_WIN_MAX                     = ppe_reg_lyrx_win_max_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_WIN_MAX, ppe_reg_lyrx_win_max_t.d32);
     
-    PPE_REG_LYRx_BUS_CFG_TypeDef ppe_reg_lyrx_bus_cfg_t = {.d32 = input_layer->REG_LYRx_BUS_CFG};
+    PPE_REG_LYRx_BUS_CFG_TypeDef ppe_reg_lyrx_bus_cfg_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_BUS_CFG)};
     ppe_reg_lyrx_bus_cfg_t.b.incr                   = PPE_InputLayer_Init_Struct->LayerBus_Inc;
     //PPE_InputLayer_Init_Struct->Cache_Enable = false;
     if(PPE_InputLayer_Init_Struct->Cache_Enable)
@@ -230,58 +488,49 @@ void PPE_InputLayer_Init(PPE_INPUT_LAYER_INDEX intput_layer_index, \
     {
         ppe_reg_lyrx_bus_cfg_t.b.arcache = 0x00;
     }
-    input_layer->REG_LYRx_BUS_CFG                     = ppe_reg_lyrx_bus_cfg_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_BUS_CFG, ppe_reg_lyrx_bus_cfg_t.d32);
     
-    PPE_REG_LYRx_ADDR_TypeDef ppe_reg_lyrx_addr_t = {.d32 = input_layer->REG_LYRx_ADDR};
+    PPE_REG_LYRx_ADDR_TypeDef ppe_reg_lyrx_addr_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_ADDR)};
     ppe_reg_lyrx_addr_t.b.addr                = PPE_InputLayer_Init_Struct->Layer_Address;
-    input_layer->REG_LYRx_ADDR                  = ppe_reg_lyrx_addr_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_ADDR, ppe_reg_lyrx_addr_t.d32);
     
-    PPE_REG_LYRx_LINE_LEN_TypeDef ppe_reg_lyrx_line_len_t = {.d32 = input_layer->REG_LYRx_LINE_LEN};
+    PPE_REG_LYRx_LINE_LEN_TypeDef ppe_reg_lyrx_line_len_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_LINE_LEN)};
     ppe_reg_lyrx_line_len_t.b.line_len = PPE_InputLayer_Init_Struct->Line_Length;
-    input_layer->REG_LYRx_LINE_LEN = ppe_reg_lyrx_line_len_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_LINE_LEN, ppe_reg_lyrx_line_len_t.d32);
 
-    PPE_REG_LYRx_PIC_SIZE_TypeDef ppe_reg_lyrx_pic_size_t = {.d32 = input_layer->REG_LYRx_PIC_SIZE};
+    PPE_REG_LYRx_PIC_SIZE_TypeDef ppe_reg_lyrx_pic_size_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_PIC_SIZE)};
     ppe_reg_lyrx_pic_size_t.b.width               = PPE_InputLayer_Init_Struct->Pic_Width;
     ppe_reg_lyrx_pic_size_t.b.height              = PPE_InputLayer_Init_Struct->Pic_Height;
-    input_layer->REG_LYRx_PIC_SIZE                      = ppe_reg_lyrx_pic_size_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_PIC_SIZE, ppe_reg_lyrx_pic_size_t.d32);
 
-    PPE_REG_LYRx_KEY_MIN_TypeDef ppe_reg_lyrx_key_min_t = {.d32 = input_layer->REG_LYRx_KEY_MIN};
+    PPE_REG_LYRx_KEY_MIN_TypeDef ppe_reg_lyrx_key_min_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_KEY_MIN)};
     ppe_reg_lyrx_key_min_t.b.r          =  PPE_InputLayer_Init_Struct->Color_Key_MIN_R;
     ppe_reg_lyrx_key_min_t.b.g          =  PPE_InputLayer_Init_Struct->Color_Key_MIN_G;
     ppe_reg_lyrx_key_min_t.b.b          =  PPE_InputLayer_Init_Struct->Color_Key_MIN_B;
-    input_layer->REG_LYRx_KEY_MIN                     = ppe_reg_lyrx_key_min_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_KEY_MIN, ppe_reg_lyrx_key_min_t.d32);
 
-    PPE_REG_LYRx_KEY_MAX_TypeDef ppe_reg_lyrx_key_max_t = {.d32 = input_layer->REG_LYRx_KEY_MAX};
+    PPE_REG_LYRx_KEY_MAX_TypeDef ppe_reg_lyrx_key_max_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_KEY_MAX)};
     ppe_reg_lyrx_key_max_t.b.r          = PPE_InputLayer_Init_Struct->Color_Key_MAX_R;
     ppe_reg_lyrx_key_max_t.b.g          = PPE_InputLayer_Init_Struct->Color_Key_MAX_G;
     ppe_reg_lyrx_key_max_t.b.b          = PPE_InputLayer_Init_Struct->Color_Key_MAX_B;
-    input_layer->REG_LYRx_KEY_MAX                     = ppe_reg_lyrx_key_max_t.d32;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_KEY_MAX, ppe_reg_lyrx_key_max_t.d32);
     
-    PPE_REG_LYRx_KEY_REPLACE_TypeDef ppe_reg_lyrx_key_replace_t = {.d32 = input_layer->REG_LYRx_KEY_REPLACE};
+    PPE_REG_LYRx_KEY_REPLACE_TypeDef ppe_reg_lyrx_key_replace_t = {.d32 = PPE_Shadow_Read(&input_layer->REG_LYRx_KEY_REPLACE)};
     ppe_reg_lyrx_key_replace_t.b.a = PPE_InputLayer_Init_Struct->Color_Key_Replace_A;
     ppe_reg_lyrx_key_replace_t.b.b = PPE_InputLayer_Init_Struct->Color_Key_Replace_B;
     ppe_reg_lyrx_key_replace_t.b.g = PPE_InputLayer_Init_Struct->Color_Key_Replace_G;
     ppe_reg_lyrx_key_replace_t.b.r = PPE_InputLayer_Init_Struct->Color_Key_Replace_R;
-    input_layer->REG_LYRx_KEY_REPLACE = ppe_reg_lyrx_key_replace_t.d32;
-
-    input_layer->REG_LYRx_TRANS_MATRIX_E11            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E11;
-    input_layer->REG_LYRx_TRANS_MATRIX_E12            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E12;
-    input_layer->REG_LYRx_TRANS_MATRIX_E13            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E13;
-    input_layer->REG_LYRx_TRANS_MATRIX_E21            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E21;
-    input_layer->REG_LYRx_TRANS_MATRIX_E22            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E22;
-    input_layer->REG_LYRx_TRANS_MATRIX_E23            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E23;
-    input_layer->REG_LYRx_TRANS_MATRIX_E31            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E31;
-    input_layer->REG_LYRx_TRANS_MATRIX_E32            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E32;
-    input_layer->REG_LYRx_TRANS_MATRIX_E33            =
-        PPE_InputLayer_Init_Struct->Transfer_Matrix_E33;
+    PPE_Shadow_Write(&input_layer->REG_LYRx_KEY_REPLACE, ppe_reg_lyrx_key_replace_t.d32);
+
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E11, PPE_InputLayer_Init_Struct->Transfer_Matrix_E11);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E12, PPE_InputLayer_Init_Struct->Transfer_Matrix_E12);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E13, PPE_InputLayer_Init_Struct->Transfer_Matrix_E13);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E21, PPE_InputLayer_Init_Struct->Transfer_Matrix_E21);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E22, PPE_InputLayer_Init_Struct->Transfer_Matrix_E22);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E23, PPE_InputLayer_Init_Struct->Transfer_Matrix_E23);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E31, PPE_InputLayer_Init_Struct->Transfer_Matrix_E31);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E32, PPE_InputLayer_Init_Struct->Transfer_Matrix_E32);
+    PPE_Shadow_Write(&input_layer->REG_LYRx_TRANS_MATRIX_E33, PPE_InputLayer_Init_Struct->Transfer_Matrix_E33);
 }
 
 
@@ -467,6 +716,7 @@ uint8_t PPE_Get_Pixel_Size(PPE_PIXEL_FORMAT format)
 void PPE_Finish(void)
 {
     while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+    PPE_PERF_DONE();
 }
 
 PPE_ERR PPE_buffer_init(ppe_buffer_t *buffer)
@@ -494,50 +744,108 @@ PPE_ERR PPE_set_color_key(ppe_buffer_t *image, PPE_color_key_config *config)
 
 
 #include "trace.h"
-PPE_ERR PPE_Blit_Inverse(ppe_buffer_t *dst, ppe_buffer_t *src, uint8_t *output, ppe_matrix_t *inverse,
-                             ppe_rect_t *rect, PPE_BLEND_METHOD method)
+/* advance tile to the next tile_w x tile_h tile of area in row order, tile.w == 0 starts over */
+static bool ppe_blit_next_tile(ppe_rect_t *area, uint16_t tile_w, uint16_t tile_h, ppe_rect_t *tile)
 {
-    if (dst->address == NULL)
-    {
-        return PPE_ERR_NULL_TARGET;
-    }
-    if (src->address == NULL)
-    {
-        return PPE_ERR_NULL_SOURCE;
-    }
-    if ((src->win_x_max <= src->win_x_min) || (src->win_y_max <= src->win_y_min))
+    if (tile->w == 0)
     {
-        return PPE_ERR_INVALID_RANGE;
+        tile->x = area->x;
+        tile->y = area->y;
     }
-    if (rect != NULL)
+    else
     {
-        if (rect->h == 0 || rect->w == 0)
+        tile->x += tile_w;
+        if (tile->x >= area->x + (int)area->w)
         {
-            return PPE_SUCCESS;
+            tile->x = area->x;
+            tile->y += tile_h;
         }
     }
-    if (inverse == NULL)
-    {
-        return PPE_ERR_INVALID_MATRIX;
-    }
-    uint32_t comp[9];
-    if (!check_inverse(inverse))
+    if (tile->y >= area->y + (int)area->h)
     {
-        return PPE_ERR_INVALID_MATRIX;
+        return false;
     }
-    else
+    tile->w = MIN(tile_w, area->x + area->w - tile->x);
+    tile->h = MIN(tile_h, area->y + area->h - tile->y);
+    return true;
+}
+
+/* whether the source footprint of tile under inverse touches window */
+static bool ppe_tile_hit_source(ppe_matrix_t *inverse, ppe_rect_t *tile, ppe_rect_t *window)
+{
+    float corner[4][2] = {{tile->x, tile->y}, {tile->x + tile->w, tile->y},
+        {tile->x, tile->y + tile->h}, {tile->x + tile->w, tile->y + tile->h}
+    };
+    float x_min = 0.0f, x_max = 0.0f, y_min = 0.0f, y_max = 0.0f;
+
+    for (int i = 0; i < 4; i++)
     {
-        if (!inv_matrix2complement(inverse, comp))
+        ppe_pox_t pox = {{corner[i][0], corner[i][1], 1.0f}};
+        float w = inverse->m[2][0] * pox.p[0] + inverse->m[2][1] * pox.p[1] + inverse->m[2][2];
+        if (w <= EPS)
         {
-            return PPE_SUCCESS;
+            /* crosses the horizon of a perspective transform, keep it */
+            return true;
+        }
+        pos_transfer(inverse, &pox);
+        if (i == 0 || pox.p[0] < x_min)
+        {
+            x_min = pox.p[0];
+        }
+        if (i == 0 || pox.p[0] > x_max)
+        {
+            x_max = pox.p[0];
+        }
+        if (i == 0 || pox.p[1] < y_min)
+        {
+            y_min = pox.p[1];
+        }
+        if (i == 0 || pox.p[1] > y_max)
+        {
+            y_max = pox.p[1];
         }
     }
+    /* one pixel margin for bilinear sampling */
+    return !((x_max < window->x - 1) || (x_min > window->x + (int)window->w) ||
+             (y_max < window->y - 1) || (y_min > window->y + (int)window->h));
+}
 
-    if (src->opacity == 0)
+static void ppe_blit_set_tile(ppe_rect_t *tile, PPE_ResultLayer_Init_Typedef *result, bool blend)
+{
+    PPE_REG_LYR0_WIN_MIN_TypeDef ppe_reg_lyr0_win_min_0x88 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_WIN_MIN)};
+    ppe_reg_lyr0_win_min_0x88.b.win_x_min = tile->x;
+    ppe_reg_lyr0_win_min_0x88.b.win_y_min = tile->y;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_WIN_MIN, ppe_reg_lyr0_win_min_0x88.d32);
+
+    PPE_REG_LYR0_WIN_MAX_TypeDef ppe_reg_lyr0_win_max_0x8c = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_WIN_MAX)};
+    ppe_reg_lyr0_win_max_0x8c.b.win_x_max = tile->x + tile->w - 1;
+    ppe_reg_lyr0_win_max_0x8c.b.win_y_max = tile->y + tile->h - 1;
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_WIN_MAX, ppe_reg_lyr0_win_max_0x8c.d32);
+
+    PPE_REG_LYR0_BLK_SIZE_TypeDef ppe_reg_lyr0_blk_size_0xa4 = {.d32 = PPE_Shadow_Read(&PPE_ResultLayer->REG_LYR0_BLK_SIZE)};
+    ppe_reg_lyr0_blk_size_0xa4.b.width = MIN(result->Block_Width, tile->w);
+    ppe_reg_lyr0_blk_size_0xa4.b.height = MIN(result->Block_Height, tile->h);
+    PPE_Shadow_Write(&PPE_ResultLayer->REG_LYR0_BLK_SIZE, ppe_reg_lyr0_blk_size_0xa4.d32);
+
+    if (blend)
     {
-        return PPE_SUCCESS;
+        PPE_REG_LYRx_WIN_MIN_TypeDef ppe_reg_lyrx_win_min_t = {.d32 = PPE_Shadow_Read(&PPE_InputLayer1->REG_LYRx_WIN_MIN)};
+        ppe_reg_lyrx_win_min_t.b.win_x_min = tile->x;
+        ppe_reg_lyrx_win_min_t.b.win_y_min = tile->y;
+        PPE_Shadow_Write(&PPE_InputLayer1->REG_LYRx_WIN_MIN, ppe_reg_lyrx_win_min_t.d32);
+
+        PPE_REG_LYRx_WIN_MAX_TypeDef ppe_reg_lyrx_win_max_t = {.d32 = PPE_Shadow_Read(&PPE_InputLayer1->REG_LYRx_WIN_MAX)};
+        ppe_reg_lyrx_win_max_t.b.win_x_max = tile->x + tile->w - 1;
+        ppe_reg_lyrx_win_max_t.b.win_y_max = tile->y + tile->h - 1;
+        PPE_Shadow_Write(&PPE_InputLayer1->REG_LYRx_WIN_MAX, ppe_reg_lyrx_win_max_t.d32);
     }
+}
 
+/* layer setup of a transformed blit of src onto dst through comp, result keeps the result layer
+   settings for the tiles */
+static void ppe_blit_setup(ppe_buffer_t *dst, ppe_buffer_t *src, uint8_t *output, uint32_t *comp,
+                           ppe_rect_t *rect, PPE_BLEND_METHOD method, PPE_ResultLayer_Init_Typedef *result)
+{
     uint32_t color = 0;
     if (src->format >= PPE_A8 && src->format <= PPE_X1)
     {
@@ -677,175 +985,76 @@ PPE_ERR PPE_Blit_Inverse(ppe_buffer_t *dst, ppe_buffer_t *src, uint8_t *output,
         PPE_InputLayer_enable(PPE_INPUT_1, DISABLE);
     }
 
-    PPE_ResultLayer_Init_Typedef PPE_ResultLayer0_Init;
-    PPE_ResultLayer_StructInit(&PPE_ResultLayer0_Init);
+    PPE_ResultLayer_StructInit(result);
     if(output == NULL)
     {
-        PPE_ResultLayer0_Init.Layer_Address                   = dst->address;
+        result->Layer_Address                                 = dst->address;
     }
     else
     {
-        PPE_ResultLayer0_Init.Layer_Address                   = (uint32_t)output;
+        result->Layer_Address                                 = (uint32_t)output;
     }
     if(rect == NULL)
     {
-        PPE_ResultLayer0_Init.Layer_Window_Xmin               = 0;
-        PPE_ResultLayer0_Init.Layer_Window_Xmax               = dst->width - 1;
-        PPE_ResultLayer0_Init.Layer_Window_Ymin               = 0;
-        PPE_ResultLayer0_Init.Layer_Window_Ymax               = dst->height - 1;
+        result->Layer_Window_Xmin                             = 0;
+        result->Layer_Window_Xmax                             = dst->width - 1;
+        result->Layer_Window_Ymin                             = 0;
+        result->Layer_Window_Ymax                             = dst->height - 1;
     }
     else
     {
-        PPE_ResultLayer0_Init.Layer_Window_Xmin               = rect->x;
-        PPE_ResultLayer0_Init.Layer_Window_Xmax               = rect->x + rect->w - 1;
-        PPE_ResultLayer0_Init.Layer_Window_Ymin               = rect->y;
-        PPE_ResultLayer0_Init.Layer_Window_Ymax               = rect->y + rect->h - 1;
+        result->Layer_Window_Xmin                             = rect->x;
+        result->Layer_Window_Xmax                             = rect->x + rect->w - 1;
+        result->Layer_Window_Ymin                             = rect->y;
+        result->Layer_Window_Ymax                             = rect->y + rect->h - 1;
     }
-    PPE_ResultLayer0_Init.Line_Length                     = dst->stride * PPE_Get_Pixel_Size(dst->format);
-    PPE_ResultLayer0_Init.Color_Format                    = dst->format;
-    PPE_ResultLayer0_Init.LayerBus_Inc                    = PPE_AWBURST_INC;
+    result->Line_Length                                   = dst->stride * PPE_Get_Pixel_Size(dst->format);
+    result->Color_Format                                  = dst->format;
+    result->LayerBus_Inc                                  = PPE_AWBURST_INC;
 
-    if (PPE_ResultLayer0_Init.Block_Width > PPE_ResultLayer0_Init.Layer_Window_Xmax - PPE_ResultLayer0_Init.Layer_Window_Xmin + 1)
-    {
-        PPE_ResultLayer0_Init.Block_Width = PPE_ResultLayer0_Init.Layer_Window_Xmax - PPE_ResultLayer0_Init.Layer_Window_Xmin + 1;
-    }
-    if (PPE_ResultLayer0_Init.Block_Height > PPE_ResultLayer0_Init.Layer_Window_Ymax - PPE_ResultLayer0_Init.Layer_Window_Ymin + 1)
-    {
-        PPE_ResultLayer0_Init.Block_Height = PPE_ResultLayer0_Init.Layer_Window_Ymax - PPE_ResultLayer0_Init.Layer_Window_Ymin + 1;
-    }
-//    for(int i = 5; i >= 0; i--)
-//    {
-//        DIRECT_LOG("table width %d", 1, block_width[i]);
-//        if(PPE_ResultLayer0_Init.Block_Width >= block_width[i])
-//        {
-//            PPE_ResultLayer0_Init.Block_Width = block_width[i];
-//            //DIRECT_LOG("change width %d", 1, PPE_ResultLayer0_Init.Block_Width);
-//            break;
-//        }
-//    }
-//    PPE_ResultLayer0_Init.Block_Width = 1;
-//    PPE_ResultLayer0_Init.Block_Height = 1;
-//    PPE_Clear_Interrupt(PPE_DIV0_ERR_INT);
-//    PPE_Mask_Interrupt(PPE_DIV0_ERR_INT, ENABLE);
-//    PPE_Mask_All_Interrupt(ENABLE);
-    extern uint32_t sys_timestamp_get_from_hw_timer_us(void);
-    uint32_t time1, time2;
-    *(uint32_t*)(PPE_REG_BASE + 0x838) = 1;
-    *(uint32_t*)(PPE_REG_BASE + 0x938) = 1;
-    *(uint32_t*)(PPE_REG_BASE + 0xA38) = 1;
-    *(uint32_t*)(PPE_REG_BASE + 0xB38) = 1;
-    
-//    DBG_DIRECT("0x234 0x%08x, 0x210 0x%08x", *(uint32_t *)(0x40000234UL),  *(uint32_t *)(0x40000210UL));
-//    
-//    uint32_t* data = (uint32_t*)PPE;
-//    for(int i = 0; i < 0x80; i++)
-//    {
-//        DBG_DIRECT("offset %08x = 0x%08x", i * 4, data[i]);
-//    }
-//    uint16_t block_width[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
-//    uint16_t block_height[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
-//    for (int i = 0; i < 6; i++)
-//    {
-//        for(int j = 0; j < 6; j++)
-//        {
-//            if(block_width[i] * block_height[j] * PPE_Get_Pixel_Size(dst->format) / PPE_BYTE_SIZE > 4096)
-//            {
-//                continue;
-//            }
-            if(PPE_Get_Pixel_Size(src->format) == 16)
-            {                
-                PPE_ResultLayer0_Init.Block_Width = 32; //block_width[i];
-                PPE_ResultLayer0_Init.Block_Height = 32; //block_height[j];
-            }
-            else if(PPE_Get_Pixel_Size(src->format) == 24)
-            {
-                if(PPE_Get_Pixel_Size(dst->format) == 16)
-                {
-                    PPE_ResultLayer0_Init.Block_Width = 16;
-                    PPE_ResultLayer0_Init.Block_Height = 24;
-                }
-                else
-                {
-                    PPE_ResultLayer0_Init.Block_Width = 12;
-                    PPE_ResultLayer0_Init.Block_Height = 24;
-                }
-            }
-            else if(PPE_Get_Pixel_Size(src->format) == 32)
-            {
-                if(PPE_Get_Pixel_Size(dst->format) == 16)
-                {
-                    PPE_ResultLayer0_Init.Block_Width = 16;
-                    PPE_ResultLayer0_Init.Block_Height = 24;
-                }
-                else
-                {
-                    PPE_ResultLayer0_Init.Block_Width = 16;
-                    PPE_ResultLayer0_Init.Block_Height = 16;
-                }
-            }
-            else if(PPE_Get_Pixel_Size(src->format) <= 8)
-            {
-                PPE_ResultLayer0_Init.Block_Width = 64;
-                PPE_ResultLayer0_Init.Block_Height = 64;
-            }
-            PPE_ResultLayer_Init(&PPE_ResultLayer0_Init);
-//            uint32_t* PPE_REG = (uint32_t*)PPE;
-//            for(int i = 0; i < sizeof(PPE_Typedef) / 4; i++)
-//            {
-//                DBG_DIRECT("GLOBAL 0x%04x, value: 0x%08x", i * 4, *(PPE_REG + i));
-//            }
-//            uint32_t* PPE_RESULT_REG = (uint32_t*)PPE_ResultLayer;
-//            for(int i = 0; i < sizeof(PPE_ResultLayer_Typedef) / 4; i++)
-//            {
-//                DBG_DIRECT("RESULT 0x%04x, value: 0x%08x", i * 4, *(PPE_RESULT_REG + i));
-//            }
-//            
-//            uint32_t* PPE_LAYER1_REG = (uint32_t*)PPE_InputLayer1;
-//            for(int i = 0; i < sizeof(PPE_Input_Layer_Typedef) / 4; i++)
-//            {
-//                DBG_DIRECT("LAYER1 0x%04x, value: 0x%08x", i * 4, *(PPE_LAYER1_REG + i));
-//            }
-//            uint32_t* PPE_LAYER2_REG = (uint32_t*)PPE_InputLayer2;
-//            for(int i = 0; i < sizeof(PPE_Input_Layer_Typedef) / 4; i++)
-//            {
-//                DBG_DIRECT("LAYER2 0x%04x, value: 0x%08x", i * 4, *(PPE_LAYER2_REG + i));
-//            }
-            time1 = sys_timestamp_get_from_hw_timer_us();
-            PPE_Cmd(ENABLE);
-            while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state)
-            {
-            }
-            time2 = sys_timestamp_get_from_hw_timer_us();
-            DBG_DIRECT("duration %d block width %d, height %d", (time2 - time1) / 40, PPE_ResultLayer0_Init.Block_Width, PPE_ResultLayer0_Init.Block_Height);
-            
-            uint32_t G1_cache_cnt = *(uint32_t*)(PPE_REG_BASE + 0x810);
-            uint32_t G2_cache_cnt = *(uint32_t*)(PPE_REG_BASE + 0x910);
-            uint32_t G3_cache_cnt = *(uint32_t*)(PPE_REG_BASE + 0xA10);
-            uint32_t G4_cache_cnt = *(uint32_t*)(PPE_REG_BASE + 0xB10);
-            
-            uint32_t G1_hit_cnt = *(uint32_t*)(PPE_REG_BASE + 0x814);
-            uint32_t G2_hit_cnt = *(uint32_t*)(PPE_REG_BASE + 0x914);
-            uint32_t G3_hit_cnt = *(uint32_t*)(PPE_REG_BASE + 0xA14);
-            uint32_t G4_hit_cnt = *(uint32_t*)(PPE_REG_BASE + 0xB14);
-            
-            DBG_DIRECT("cache G1 %d, G2 %d, G3 %d, G4 %d, total %d", G1_cache_cnt, G2_cache_cnt, G3_cache_cnt, G4_cache_cnt, \
-                                    G1_cache_cnt + G2_cache_cnt + G3_cache_cnt + G4_cache_cnt);
-//            DBG_DIRECT("hit G1 %d, G2 %d, G3 %d, G4 %d, total %d", G1_hit_cnt, G2_hit_cnt, G3_hit_cnt, G4_hit_cnt, \
-//                                    G1_hit_cnt + G2_hit_cnt + G3_hit_cnt + G4_hit_cnt);
-            DBG_DIRECT("cache from psram %d", (G1_cache_cnt + G2_cache_cnt + G3_cache_cnt + G4_cache_cnt) - (G1_hit_cnt + G2_hit_cnt + G3_hit_cnt + G4_hit_cnt));
-            *(uint32_t*)(PPE_REG_BASE + 0x80C) = 0xFFFFFFFF;
-            *(uint32_t*)(PPE_REG_BASE + 0x90C) = 0xFFFFFFFF;
-            *(uint32_t*)(PPE_REG_BASE + 0xA0C) = 0xFFFFFFFF;
-            *(uint32_t*)(PPE_REG_BASE + 0xB0C) = 0xFFFFFFFF;
-            
-//        }
-//    }
-    return PPE_SUCCESS;
+    if (PPE_Get_Pixel_Size(src->format) == 16)
+    {
+        result->Block_Width = 32;
+        result->Block_Height = 32;
+    }
+    else if (PPE_Get_Pixel_Size(src->format) == 24)
+    {
+        if (PPE_Get_Pixel_Size(dst->format) == 16)
+        {
+            result->Block_Width = 16;
+            result->Block_Height = 24;
+        }
+        else
+        {
+            result->Block_Width = 12;
+            result->Block_Height = 24;
+        }
+    }
+    else if (PPE_Get_Pixel_Size(src->format) == 32)
+    {
+        if (PPE_Get_Pixel_Size(dst->format) == 16)
+        {
+            result->Block_Width = 16;
+            result->Block_Height = 24;
+        }
+        else
+        {
+            result->Block_Width = 16;
+            result->Block_Height = 16;
+        }
+    }
+    else if (PPE_Get_Pixel_Size(src->format) <= 8)
+    {
+        result->Block_Width = 64;
+        result->Block_Height = 64;
+    }
+    PPE_ResultLayer_Init(result);
 }
 
-PPE_ERR PPE_Blit_Inverse_Simulate(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_matrix_t *matrix, ppe_matrix_t *inverse,
+PPE_ERR PPE_Blit_Inverse(ppe_buffer_t *dst, ppe_buffer_t *src, uint8_t *output, ppe_matrix_t *inverse,
                              ppe_rect_t *rect, PPE_BLEND_METHOD method)
 {
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLIT);
     if (dst->address == NULL)
     {
         return PPE_ERR_NULL_TARGET;
@@ -869,71 +1078,268 @@ PPE_ERR PPE_Blit_Inverse_Simulate(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_matr
     {
         return PPE_ERR_INVALID_MATRIX;
     }
+    ppe_matrix_fixed_t matrix;
     uint32_t comp[9];
-    if (!check_inverse(inverse))
+    if (!check_inverse(inverse) || !ppe_matrix_cache_get(inverse, false, &matrix))
     {
         return PPE_ERR_INVALID_MATRIX;
     }
-    else
+    ppe_fixed_matrix2complement(&matrix, comp);
+
+    if (src->opacity == 0)
     {
-        if (!inv_matrix2complement(inverse, comp))
+        return PPE_SUCCESS;
+    }
+
+    PPE_ResultLayer_Init_Typedef PPE_ResultLayer0_Init;
+    ppe_blit_setup(dst, src, output, comp, rect, method, &PPE_ResultLayer0_Init);
+
+    /* split the result window into tiles whose source footprint is about one
+       ppe_get_block_size block, so each run reads a compact part of src */
+    ppe_rect_t area = {.x = PPE_ResultLayer0_Init.Layer_Window_Xmin, .y = PPE_ResultLayer0_Init.Layer_Window_Ymin,
+                       .w = PPE_ResultLayer0_Init.Layer_Window_Xmax - PPE_ResultLayer0_Init.Layer_Window_Xmin + 1,
+                       .h = PPE_ResultLayer0_Init.Layer_Window_Ymax - PPE_ResultLayer0_Init.Layer_Window_Ymin + 1
+                      };
+    uint16_t tile_w = area.w;
+    uint16_t tile_h = area.h;
+    ppe_matrix_t forward;
+    memcpy(&forward, inverse, sizeof(ppe_matrix_t));
+    ppe_matrix_inverse(&forward);
+    if (ppe_get_block_size(&forward, PPE_Get_Pixel_Size(src->format), &tile_w, &tile_h))
+    {
+        while (tile_w < PPE_BLIT_TILE_MIN_SIZE)
         {
-            return PPE_SUCCESS;
+            tile_w *= 2;
+        }
+        while (tile_h < PPE_BLIT_TILE_MIN_SIZE)
+        {
+            tile_h *= 2;
         }
     }
-
-    if (src->opacity == 0)
+    tile_w = MIN(tile_w, area.w);
+    tile_h = MIN(tile_h, area.h);
+
+    /* a tile that samples nothing from src only leaves dst as it is, which is
+       what an in-place blend would have written anyway */
+    bool cull = (output == NULL) && (method != PPE_BLEND_BYPASS);
+    ppe_rect_t src_window = {.x = src->win_x_min, .y = src->win_y_min,
+                             .w = MIN(src->win_x_max, src->width - 1) - src->win_x_min + 1,
+                             .h = MIN(src->win_y_max, src->height - 1) - src->win_y_min + 1
+                            };
+    ppe_rect_t tile = {.x = area.x, .y = area.y, .w = 0, .h = 0};
+    bool running = false;
+
+    /* culled tiles are further narrowed to the columns the transformed src window covers, so a
+       rotated image does not run the empty corners of its bounding rect */
+    ppe_pox_t quad[4];
+    bool trim = cull && ppe_get_quad(&forward, &src_window, quad);
+
+    while (ppe_blit_next_tile(&area, tile_w, tile_h, &tile))
+    {
+        /* find the next tile while the previous one is still running */
+        ppe_rect_t job = tile;
+        if (trim)
+        {
+            if (!ppe_blit_band_span(quad, &tile, &job))
+            {
+                continue;
+            }
+        }
+        else if (cull && !ppe_tile_hit_source(inverse, &tile, &src_window))
+        {
+            continue;
+        }
+        if (running)
+        {
+            while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+            PPE_PERF_DONE();
+        }
+        ppe_blit_set_tile(&job, &PPE_ResultLayer0_Init, method != PPE_BLEND_BYPASS);
+        PPE_Cmd(ENABLE);
+        running = true;
+    }
+    if (running)
     {
-        return PPE_SUCCESS;
+        while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+        PPE_PERF_DONE();
     }
+    return PPE_SUCCESS;
+}
 
-    uint32_t color = 0;
-    if (src->format >= PPE_A8 && src->format <= PPE_X1)
+PPE_ERR PPE_Blit_Orient(ppe_buffer_t *dst, ppe_buffer_t *src, int32_t x, int32_t y,
+                        PPE_ORIENT orient, PPE_BLEND_METHOD method)
+{
+    PPE_PERF_BEGIN(PPE_PERF_OP_BLIT);
+    if (dst->address == NULL)
     {
-        color = (src->const_color & 0xFFFFFF) + ((((src->const_color >> 24) & 0xFF) * src->opacity / 0xFF) << 24);
+        return PPE_ERR_NULL_TARGET;
     }
-    else
+    if (src->address == NULL)
     {
-        color = ((src->opacity & 0xFF) * ((src->const_color & 0xFF000000) >> 24) / 0xFF << 24) + \
-                    (src->const_color & 0xFFFFFF);
+        return PPE_ERR_NULL_SOURCE;
     }
-
-    PPE_CLK_ENABLE(ENABLE);
-    PPE_REG_GLB_STATUS_TypeDef     ppe_reg_blg_status_0x00;
-    PPE_REG_LYR_ENABLE_TypeDef     ppe_reg_lyr_enable_0x04;
-
-
-    /*PPE Global initialization*/
-
-    /*input layer 2 initilization*/
-    PPE_InputLayer_enable(PPE_INPUT_2, ENABLE);           // logic enable of layer
-    PPE_InputLayer_Init_Typedef PPE_input_layer2_init = {.Color_Key_Enable.key_enable = 0};
-    PPE_InputLayer_StructInit(PPE_INPUT_2, &PPE_input_layer2_init);
-    PPE_input_layer2_init.Layer_Address                   = (uint32_t)src->address;
-    PPE_input_layer2_init.Pic_Height                      = (uint32_t)src->height;
-    PPE_input_layer2_init.Pic_Width                       = (uint32_t)src->width;
-    PPE_input_layer2_init.Line_Length                     = PPE_input_layer2_init.Pic_Width *
-                                                              PPE_Get_Pixel_Size(src->format);
-    PPE_input_layer2_init.Pixel_Source                = PPE_LAYER_SRC_FROM_DMA;
-    PPE_input_layer2_init.Const_Pixel                 = color;
-    PPE_input_layer2_init.Pixel_Color_Format              = src->format;
-    if(PPE_input_layer2_init.Pixel_Color_Format >= PPE_I8 && PPE_input_layer2_init.Pixel_Color_Format <= PPE_I1)
+    if ((src->win_x_max <= src->win_x_min) || (src->win_y_max <= src->win_y_min))
     {
-        PPE_input_layer2_init.Index_Table = INDEX_CLUT;
+        return PPE_ERR_INVALID_RANGE;
     }
-    PPE_input_layer2_init.Blend_Method = method;
-    if (src->high_quality)
+    if (orient > PPE_FLIP_V)
     {
-        PPE_input_layer2_init.Source_Interpolation                = PPV2_SRC_BILINEAR;
+        return PPE_ERR_INVALID_PARAMETER;
     }
-    else
+    if (src->opacity == 0)
     {
-        PPE_input_layer2_init.Source_Interpolation                = PPV2_SRC_NEAREST_NEIGHBOUR;
+        return PPE_SUCCESS;
     }
-    PPE_input_layer2_init.Color_Key_Enable.key_enable     = src->color_key_config.key_enable.key_enable;
-    if (PPE_input_layer2_init.Color_Key_Enable.key_enable)
+
+    bool swap = (orient == PPE_ROTATE_90) || (orient == PPE_ROTATE_270);
+    int32_t x_max = MIN(x + (swap ? src->height : src->width), dst->width);
+    int32_t y_max = MIN(y + (swap ? src->width : src->height), dst->height);
+    ppe_rect_t area = {.x = (x < 0) ? 0 : x, .y = (y < 0) ? 0 : y};
+    if ((x_max <= area.x) || (y_max <= area.y))
     {
-        PPE_input_layer2_init.Color_Key_Mode                  = src->color_key_config.key_mode;
+        return PPE_SUCCESS;
+    }
+    area.w = x_max - area.x;
+    area.h = y_max - area.y;
+
+    uint32_t comp[9];
+    ppe_orient_get_comp(orient, src, -x, -y, comp);
+
+    PPE_ResultLayer_Init_Typedef PPE_ResultLayer0_Init;
+    ppe_blit_setup(dst, src, NULL, comp, &area, method, &PPE_ResultLayer0_Init);
+
+    /* a tile reads one source block, turned by 90 degrees when the axes swap */
+    uint16_t block_w = area.w;
+    uint16_t block_h = area.h;
+    ppe_matrix_t identity;
+    ppe_get_identity(&identity);
+    if (ppe_get_block_size(&identity, PPE_Get_Pixel_Size(src->format), &block_w, &block_h))
+    {
+        while (block_w < PPE_BLIT_TILE_MIN_SIZE)
+        {
+            block_w *= 2;
+        }
+        while (block_h < PPE_BLIT_TILE_MIN_SIZE)
+        {
+            block_h *= 2;
+        }
+    }
+    uint16_t tile_w = MIN(swap ? block_h : block_w, area.w);
+    uint16_t tile_h = MIN(swap ? block_w : block_h, area.h);
+
+    /* the placed image covers area, so no tile can miss the source */
+    ppe_rect_t tile = {.x = area.x, .y = area.y, .w = 0, .h = 0};
+    bool running = false;
+    while (ppe_blit_next_tile(&area, tile_w, tile_h, &tile))
+    {
+        if (running)
+        {
+            while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+            PPE_PERF_DONE();
+        }
+        ppe_blit_set_tile(&tile, &PPE_ResultLayer0_Init, method != PPE_BLEND_BYPASS);
+        PPE_Cmd(ENABLE);
+        running = true;
+    }
+    if (running)
+    {
+        while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+        PPE_PERF_DONE();
+    }
+    return PPE_SUCCESS;
+}
+
+PPE_ERR PPE_Blit_Inverse_Simulate(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_matrix_t *matrix, ppe_matrix_t *inverse,
+                             ppe_rect_t *rect, PPE_BLEND_METHOD method)
+{
+    if (dst->address == NULL)
+    {
+        return PPE_ERR_NULL_TARGET;
+    }
+    if (src->address == NULL)
+    {
+        return PPE_ERR_NULL_SOURCE;
+    }
+    if ((src->win_x_max <= src->win_x_min) || (src->win_y_max <= src->win_y_min))
+    {
+        return PPE_ERR_INVALID_RANGE;
+    }
+    if (rect != NULL)
+    {
+        if (rect->h == 0 || rect->w == 0)
+        {
+            return PPE_SUCCESS;
+        }
+    }
+    if (inverse == NULL)
+    {
+        return PPE_ERR_INVALID_MATRIX;
+    }
+    uint32_t comp[9];
+    if (!check_inverse(inverse))
+    {
+        return PPE_ERR_INVALID_MATRIX;
+    }
+    else
+    {
+        if (!inv_matrix2complement(inverse, comp))
+        {
+            return PPE_SUCCESS;
+        }
+    }
+
+    if (src->opacity == 0)
+    {
+        return PPE_SUCCESS;
+    }
+
+    uint32_t color = 0;
+    if (src->format >= PPE_A8 && src->format <= PPE_X1)
+    {
+        color = (src->const_color & 0xFFFFFF) + ((((src->const_color >> 24) & 0xFF) * src->opacity / 0xFF) << 24);
+    }
+    else
+    {
+        color = ((src->opacity & 0xFF) * ((src->const_color & 0xFF000000) >> 24) / 0xFF << 24) + \
+                    (src->const_color & 0xFFFFFF);
+    }
+
+    PPE_CLK_ENABLE(ENABLE);
+    PPE_REG_GLB_STATUS_TypeDef     ppe_reg_blg_status_0x00;
+    PPE_REG_LYR_ENABLE_TypeDef     ppe_reg_lyr_enable_0x04;
+
+
+    /*PPE Global initialization*/
+
+    /*input layer 2 initilization*/
+    PPE_InputLayer_enable(PPE_INPUT_2, ENABLE);           // logic enable of layer
+    PPE_InputLayer_Init_Typedef PPE_input_layer2_init = {.Color_Key_Enable.key_enable = 0};
+    PPE_InputLayer_StructInit(PPE_INPUT_2, &PPE_input_layer2_init);
+    PPE_input_layer2_init.Layer_Address                   = (uint32_t)src->address;
+    PPE_input_layer2_init.Pic_Height                      = (uint32_t)src->height;
+    PPE_input_layer2_init.Pic_Width                       = (uint32_t)src->width;
+    PPE_input_layer2_init.Line_Length                     = PPE_input_layer2_init.Pic_Width *
+                                                              PPE_Get_Pixel_Size(src->format);
+    PPE_input_layer2_init.Pixel_Source                = PPE_LAYER_SRC_FROM_DMA;
+    PPE_input_layer2_init.Const_Pixel                 = color;
+    PPE_input_layer2_init.Pixel_Color_Format              = src->format;
+    if(PPE_input_layer2_init.Pixel_Color_Format >= PPE_I8 && PPE_input_layer2_init.Pixel_Color_Format <= PPE_I1)
+    {
+        PPE_input_layer2_init.Index_Table = INDEX_CLUT;
+    }
+    PPE_input_layer2_init.Blend_Method = method;
+    if (src->high_quality)
+    {
+        PPE_input_layer2_init.Source_Interpolation                = PPV2_SRC_BILINEAR;
+    }
+    else
+    {
+        PPE_input_layer2_init.Source_Interpolation                = PPV2_SRC_NEAREST_NEIGHBOUR;
+    }
+    PPE_input_layer2_init.Color_Key_Enable.key_enable     = src->color_key_config.key_enable.key_enable;
+    if (PPE_input_layer2_init.Color_Key_Enable.key_enable)
+    {
+        PPE_input_layer2_init.Color_Key_Mode                  = src->color_key_config.key_mode;
         PPE_input_layer2_init.Color_Key_MAX_B = src->color_key_config.key_range.B_max;
         PPE_input_layer2_init.Color_Key_MAX_G = src->color_key_config.key_range.G_max;
         PPE_input_layer2_init.Color_Key_MAX_R = src->color_key_config.key_range.R_max;
@@ -1091,12 +1497,12 @@ PPE_ERR PPE_Blit_Inverse_Simulate(ppe_buffer_t *dst, ppe_buffer_t *src, ppe_matr
     PPE_InputLayer_Init_Typedef in_list[2];
     memcpy(&in_list[0], &PPE_input_layer1_init, sizeof(PPE_InputLayer_Init_Typedef));
     memcpy(&in_list[1], &PPE_input_layer2_init, sizeof(PPE_InputLayer_Init_Typedef));
-    PPE_Simulation(&PPE_ResultLayer0_Init, in_list, layer_en);
-    return PPE_SUCCESS;
+    return PPE_Simulation(&PPE_ResultLayer0_Init, in_list, layer_en);
 }
 
 PPE_ERR PPE_Mask(ppe_buffer_t *dst, uint32_t color, ppe_rect_t *rect)
 {
+    PPE_PERF_BEGIN(PPE_PERF_OP_MASK);
     if (dst->address == NULL)
     {
         return PPE_ERR_NULL_TARGET;
@@ -1154,8 +1560,7 @@ PPE_ERR PPE_Mask(ppe_buffer_t *dst, uint32_t color, ppe_rect_t *rect)
                                                                   (rect->y * dst->width + rect->x) * PPE_Get_Pixel_Size(dst->format) / PPE_BYTE_SIZE;
         PPE_input_layer1_init.Pic_Height                      = (uint32_t)rect->h;
         PPE_input_layer1_init.Pic_Width                       = (uint32_t)rect->w;
-        PPE_input_layer1_init.Line_Length                     = dst->width * PPE_Get_Pixel_Size(
-                                                                      dst->format) / PPE_BYTE_SIZE;
+        PPE_input_layer1_init.Line_Length                     = dst->width * PPE_Get_Pixel_Size(dst->format);
         PPE_input_layer1_init.Pixel_Source                    = PPE_LAYER_SRC_FROM_DMA;
         PPE_input_layer1_init.Pixel_Color_Format              = dst->format;
         PPE_input_layer1_init.Const_Pixel                     = 0xFFFFFFFF;
@@ -1184,8 +1589,7 @@ PPE_ERR PPE_Mask(ppe_buffer_t *dst, uint32_t color, ppe_rect_t *rect)
         PPE_input_layer1_init.Layer_Address                   = NULL;
         PPE_input_layer1_init.Pic_Height                      = (uint32_t)rect->h;
         PPE_input_layer1_init.Pic_Width                       = (uint32_t)rect->w;
-        PPE_input_layer1_init.Line_Length                     = dst->width * PPE_Get_Pixel_Size(
-                                                                      dst->format) / PPE_BYTE_SIZE;
+        PPE_input_layer1_init.Line_Length                     = dst->width * PPE_Get_Pixel_Size(dst->format);
         PPE_input_layer1_init.Pixel_Source                    = PPE_LAYER_SRC_CONST;
         PPE_input_layer1_init.Pixel_Color_Format              = dst->format;
         PPE_input_layer1_init.Const_Pixel                     = 0x0;
@@ -1212,25 +1616,395 @@ PPE_ERR PPE_Mask(ppe_buffer_t *dst, uint32_t color, ppe_rect_t *rect)
     PPE_ResultLayer_StructInit(&PPE_ResultLayer0_Init);
     PPE_ResultLayer0_Init.Layer_Address                   = dst->address +
                                                               (rect->y * dst->width + rect->x) * PPE_Get_Pixel_Size(dst->format) / PPE_BYTE_SIZE;
-    PPE_ResultLayer0_Init.Line_Length                     = dst->width * PPE_Get_Pixel_Size(
-                                                                  dst->format) / PPE_BYTE_SIZE;
+    PPE_ResultLayer0_Init.Layer_Window_Xmin               = 0;
+    PPE_ResultLayer0_Init.Layer_Window_Xmax               = rect->w - 1;
+    PPE_ResultLayer0_Init.Layer_Window_Ymin               = 0;
+    PPE_ResultLayer0_Init.Layer_Window_Ymax               = rect->h - 1;
+    PPE_ResultLayer0_Init.Line_Length                     = dst->width * PPE_Get_Pixel_Size(dst->format);
     PPE_ResultLayer0_Init.Color_Format                    = dst->format;
     PPE_ResultLayer0_Init.LayerBus_Inc                    = PPE_AWBURST_INC;
     PPE_ResultLayer_Init(&PPE_ResultLayer0_Init);
 
     PPE_Cmd(ENABLE);
     while (((PPE_REG_GLB_STATUS_TypeDef)PPE->REG_GLB_STATUS).b.run_state);
+    PPE_PERF_DONE();
+    return PPE_SUCCESS;
+}
+
+/* grow rect by add when both have the same rows or columns and touch, so the union is exact */
+static bool ppe_rect_join(ppe_rect_t *rect, ppe_rect_t *add)
+{
+    if ((rect->y == add->y) && (rect->h == add->h))
+    {
+        if ((add->x == rect->x + (int)rect->w) || (rect->x == add->x + (int)add->w))
+        {
+            rect->x = (rect->x < add->x) ? rect->x : add->x;
+            rect->w += add->w;
+            return true;
+        }
+    }
+    if ((rect->x == add->x) && (rect->w == add->w))
+    {
+        if ((add->y == rect->y + (int)rect->h) || (rect->y == add->y + (int)add->h))
+        {
+            rect->y = (rect->y < add->y) ? rect->y : add->y;
+            rect->h += add->h;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ppe_rect_overlap(ppe_rect_t *a, ppe_rect_t *b)
+{
+    return (a->x < b->x + (int)b->w) && (b->x < a->x + (int)a->w) &&
+           (a->y < b->y + (int)b->h) && (b->y < a->y + (int)a->h);
+}
+
+/* opaque fill of a small rect inside dst with 32-bit CPU stores, false leaves it to PPE */
+static bool ppe_mask_sw(ppe_buffer_t *dst, uint32_t color, ppe_rect_t *rect)
+{
+    uint32_t word;
+    if (((color >> 24) != 0xFF) || (rect->w * rect->h > PPE_MASK_SW_PIXELS))
+    {
+        return false;
+    }
+    if ((rect->x < 0) || (rect->y < 0) || (rect->x + rect->w > dst->width) ||
+        (rect->y + rect->h > dst->height))
+    {
+        return false;
+    }
+    if ((dst->format == PPE_ARGB8888) || (dst->format == PPE_XRGB8888))
+    {
+        word = color;
+    }
+    else if (dst->format == PPE_RGB565)
+    {
+        word = ((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) | ((color >> 3) & 0x001F);
+        word |= word << 16;
+    }
+    else
+    {
+        return false;
+    }
+
+    uint8_t len = PPE_Get_Pixel_Size(dst->format) / PPE_BYTE_SIZE;
+    uint32_t pitch = dst->width * len;
+    uint8_t *line = (uint8_t *)dst->address + rect->y * pitch + rect->x * len;
+    for (uint32_t y = 0; y < rect->h; y++, line += pitch)
+    {
+        uint8_t *p = line;
+        uint32_t count = rect->w;
+        if ((len == 2) && ((uint32_t)p & 2))
+        {
+            *(uint16_t *)p = (uint16_t)word;
+            p += 2;
+            count--;
+        }
+        uint32_t *w = (uint32_t *)p;
+        for (uint32_t i = (count * len) >> 2; i != 0; i--)
+        {
+            *w++ = word;
+        }
+        if ((len == 2) && (count & 1))
+        {
+            *(uint16_t *)w = (uint16_t)word;
+        }
+    }
+    return true;
+}
+
+static PPE_ERR ppe_mask_batch(ppe_buffer_t *dst, ppe_fill_t *fill, uint16_t num)
+{
+    for (uint16_t i = 0; i < num; i++)
+    {
+        if (!ppe_mask_sw(dst, fill[i].color, &fill[i].rect))
+        {
+            PPE_ERR err = PPE_Mask(dst, fill[i].color, &fill[i].rect);
+            if (err != PPE_SUCCESS)
+            {
+                return err;
+            }
+        }
+    }
     return PPE_SUCCESS;
 }
 
+PPE_ERR PPE_Mask_List(ppe_buffer_t *dst, ppe_fill_t *fill, uint16_t fill_num)
+{
+    ppe_fill_t batch[PPE_MASK_LIST_BATCH];
+    uint16_t num = 0;
+
+    if (dst->address == NULL)
+    {
+        return PPE_ERR_NULL_TARGET;
+    }
+    if ((fill == NULL) && (fill_num != 0))
+    {
+        return PPE_ERR_NULL_SOURCE;
+    }
+
+    /* CPU stores must not race a job that is still running */
+    PPE_Finish();
+    for (uint16_t i = 0; i < fill_num; i++)
+    {
+        bool merged = false;
+        if ((fill[i].rect.w == 0) || (fill[i].rect.h == 0))
+        {
+            continue;
+        }
+        /* merge a fill into an earlier one of the same color unless a fill in between covers it,
+           painting it earlier must not change the result */
+        for (uint16_t j = num; j-- > 0;)
+        {
+            if ((batch[j].color == fill[i].color) && ppe_rect_join(&batch[j].rect, &fill[i].rect))
+            {
+                merged = true;
+                break;
+            }
+            if (ppe_rect_overlap(&batch[j].rect, &fill[i].rect))
+            {
+                break;
+            }
+        }
+        if (merged)
+        {
+            continue;
+        }
+        if (num == PPE_MASK_LIST_BATCH)
+        {
+            PPE_ERR err = ppe_mask_batch(dst, batch, num);
+            if (err != PPE_SUCCESS)
+            {
+                return err;
+            }
+            num = 0;
+        }
+        batch[num++] = fill[i];
+    }
+    return ppe_mask_batch(dst, batch, num);
+}
+
 void PPE_Register_CLUT(uint32_t* clut, uint16_t size)
 {
+    ppe_clut_t palette;
+
+    PPE_CLUT_Init(&palette, clut, size);
+    PPE_CLUT_Load(&palette);
+}
+
+uint32_t PPE_CLUT_Hash(uint32_t *clut, uint16_t size)
+{
+    /* FNV-1a over the entries, the entry count is folded in so a palette and its prefix differ */
+    uint32_t hash = 0x811C9DC5UL ^ size;
+
+    for (uint16_t i = 0; i < size; i++)
+    {
+        uint32_t word = clut[i];
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            hash ^= (word & 0xFF);
+            hash *= 0x01000193UL;
+            word >>= 8;
+        }
+    }
+    return hash;
+}
+
+void PPE_CLUT_Init(ppe_clut_t *palette, uint32_t *clut, uint16_t size)
+{
+    palette->clut = clut;
+    palette->size = size;
+    palette->hash = PPE_CLUT_Hash(clut, size);
+}
+
+bool PPE_CLUT_Load(ppe_clut_t *palette)
+{
+    INDEX_CLUT = palette->clut;
+    if (ppe_clut_valid && ppe_clut_hash == palette->hash && ppe_clut_size == palette->size)
+    {
+        ppe_clut_stat.skip_cnt++;
+        return false;
+    }
+
     PPE->CLUT_INDEX = 0;
-    for(int i = 0; i < size; i++)
+    for (uint16_t i = 0; i < palette->size; i++)
+    {
+        PPE->CLUT_CONT = palette->clut[i];
+    }
+#if PPE_SIM_BACKEND
+    PPE_Simulation_Load_CLUT(palette->clut, palette->size);
+#endif
+    ppe_clut_hash = palette->hash;
+    ppe_clut_size = palette->size;
+    ppe_clut_valid = true;
+    ppe_clut_stat.load_cnt++;
+    ppe_clut_stat.word_cnt += palette->size;
+    return true;
+}
+
+void PPE_CLUT_Invalidate(void)
+{
+    ppe_clut_valid = false;
+}
+
+void PPE_CLUT_GetStat(ppe_clut_stat_t *stat)
+{
+    *stat = ppe_clut_stat;
+}
+
+void PPE_CLUT_ClearStat(void)
+{
+    ppe_clut_stat.load_cnt = 0;
+    ppe_clut_stat.skip_cnt = 0;
+    ppe_clut_stat.word_cnt = 0;
+}
+
+static bool ppe_clut_resident(ppe_clut_t *palette)
+{
+    if (palette == NULL)
+    {
+        return true;
+    }
+    return ppe_clut_valid && ppe_clut_hash == palette->hash && ppe_clut_size == palette->size;
+}
+
+static void ppe_blit_job_area(ppe_blit_job_t *job, ppe_rect_t *area)
+{
+    ppe_buffer_t *src = job->src;
+    ppe_buffer_t *dst = job->dst;
+    ppe_rect_t src_rect = {src->win_x_min, src->win_y_min,
+                           src->win_x_max - src->win_x_min, src->win_y_max - src->win_y_min
+                          };
+    ppe_matrix_fixed_t fixed;
+    ppe_matrix_t matrix;
+
+    area->x = 0;
+    area->y = 0;
+    area->w = dst->width;
+    area->h = dst->height;
+    if (job->inverse != NULL && ppe_matrix_cache_get(job->inverse, true, &fixed))
+    {
+        ppe_fixed_to_matrix(&fixed, &matrix);
+        if (!ppe_get_area(area, &src_rect, &matrix, dst))
+        {
+            area->w = 0;
+            area->h = 0;
+            return;
+        }
+        /* sampling may reach one pixel past the mapped corners */
+        area->x -= 1;
+        area->y -= 1;
+        area->w += 2;
+        area->h += 2;
+    }
+    if (job->rect != NULL)
+    {
+        int x1 = area->x > job->rect->x ? area->x : job->rect->x;
+        int y1 = area->y > job->rect->y ? area->y : job->rect->y;
+        int x2 = MIN(area->x + (int)area->w, job->rect->x + (int)job->rect->w);
+        int y2 = MIN(area->y + (int)area->h, job->rect->y + (int)job->rect->h);
+        area->x = x1;
+        area->y = y1;
+        area->w = (x2 > x1) ? (x2 - x1) : 0;
+        area->h = (y2 > y1) ? (y2 - y1) : 0;
+    }
+}
+
+static bool ppe_blit_job_conflict(ppe_blit_job_t *first, ppe_rect_t *first_area,
+                                  ppe_blit_job_t *later, ppe_rect_t *later_area)
+{
+    /* a job reading a buffer another one writes keeps its order whatever the areas */
+    if (later->src->address == first->dst->address || first->src->address == later->dst->address)
+    {
+        return true;
+    }
+    if (later->dst->address != first->dst->address)
+    {
+        return false;
+    }
+    if (first_area->w == 0 || first_area->h == 0 || later_area->w == 0 || later_area->h == 0)
     {
-        PPE->CLUT_CONT = clut[i];
+        return false;
+    }
+    return (first_area->x < later_area->x + (int)later_area->w) &&
+           (later_area->x < first_area->x + (int)first_area->w) &&
+           (first_area->y < later_area->y + (int)later_area->h) &&
+           (later_area->y < first_area->y + (int)first_area->h);
+}
+
+PPE_ERR PPE_Blit_Batch(ppe_blit_job_t *job, uint16_t job_num)
+{
+    ppe_rect_t area[PPE_CLUT_BATCH_LOOKAHEAD];
+    uint32_t drawn = 0;
+    uint16_t base = 0;
+
+    if (job == NULL)
+    {
+        return PPE_ERR_NULL_SOURCE;
+    }
+    for (uint16_t i = 0; i < job_num && i < PPE_CLUT_BATCH_LOOKAHEAD; i++)
+    {
+        ppe_blit_job_area(&job[i], &area[i]);
+    }
+
+    while (base < job_num)
+    {
+        uint16_t window = MIN(job_num - base, PPE_CLUT_BATCH_LOOKAHEAD);
+        uint16_t pick = 0;
+
+        /* the oldest pending job is always ready, take a later one only when it saves a palette load */
+        if (!ppe_clut_resident(job[base].clut))
+        {
+            for (uint16_t j = 1; j < window; j++)
+            {
+                bool ready = true;
+
+                if ((drawn & (1UL << j)) || !ppe_clut_resident(job[base + j].clut))
+                {
+                    continue;
+                }
+                for (uint16_t i = 0; i < j && ready; i++)
+                {
+                    if (!(drawn & (1UL << i)) &&
+                        ppe_blit_job_conflict(&job[base + i], &area[i], &job[base + j], &area[j]))
+                    {
+                        ready = false;
+                    }
+                }
+                if (ready)
+                {
+                    pick = j;
+                    break;
+                }
+            }
+        }
+
+        ppe_blit_job_t *cur = &job[base + pick];
+        if (cur->clut != NULL)
+        {
+            PPE_CLUT_Load(cur->clut);
+        }
+        PPE_ERR err = PPE_Blit_Inverse(cur->dst, cur->src, NULL, cur->inverse, cur->rect, cur->method);
+        if (err != PPE_SUCCESS)
+        {
+            return err;
+        }
+        drawn |= (1UL << pick);
+
+        /* slide the window past the finished head */
+        while (drawn & 1UL)
+        {
+            drawn >>= 1;
+            memmove(&area[0], &area[1], sizeof(area[0]) * (PPE_CLUT_BATCH_LOOKAHEAD - 1));
+            base++;
+            if (base + PPE_CLUT_BATCH_LOOKAHEAD - 1 < job_num)
+            {
+                ppe_blit_job_area(&job[base + PPE_CLUT_BATCH_LOOKAHEAD - 1], &area[PPE_CLUT_BATCH_LOOKAHEAD - 1]);
+            }
+        }
     }
-    INDEX_CLUT = clut;
+    return PPE_SUCCESS;
 }
 
 void ppe_get_identity(ppe_matrix_t *matrix)
@@ -1559,6 +2333,240 @@ bool inv_matrix2complement(ppe_matrix_t *matrix, uint32_t *comp)
     return true;
 }
 
+static inline ppe_fixed_t ppe_fixed_mul(ppe_fixed_t a, ppe_fixed_t b)
+{
+    return (ppe_fixed_t)(((int64_t)a * b) >> 16);
+}
+
+/* num / den in Q16.16, num and den must have the same scale; false when den is lost to the
+   range reduction or the quotient does not fit */
+static bool ppe_fixed_div64(int64_t num, int64_t den, ppe_fixed_t *result)
+{
+    if (den < 0)
+    {
+        num = -num;
+        den = -den;
+    }
+    while ((den >= ((int64_t)1 << 46)) || (num >= ((int64_t)1 << 46)) || (num <= -((int64_t)1 << 46)))
+    {
+        num >>= 1;
+        den >>= 1;
+    }
+    if (den == 0)
+    {
+        return false;
+    }
+    int64_t quotient = (num * 65536) / den;
+    if ((quotient > INT32_MAX) || (quotient < INT32_MIN))
+    {
+        return false;
+    }
+    *result = (ppe_fixed_t)quotient;
+    return true;
+}
+
+/* value in Q16.16 rounded to nearest, false when it does not fit */
+static bool ppe_fixed_from_double(double value, ppe_fixed_t *result)
+{
+    double scaled = floor(value * 65536.0 + 0.5);
+    if (!(scaled < 2147483648.0) || !(scaled >= -2147483648.0))
+    {
+        return false;
+    }
+    *result = (ppe_fixed_t)scaled;
+    return true;
+}
+
+void ppe_fixed_get_identity(ppe_matrix_fixed_t *matrix)
+{
+    memset(matrix, 0, sizeof(ppe_matrix_fixed_t));
+    matrix->m[0][0] = PPE_FIXED_ONE;
+    matrix->m[1][1] = PPE_FIXED_ONE;
+    matrix->m[2][2] = PPE_FIXED_ONE;
+}
+
+void ppe_matrix_to_fixed(ppe_matrix_t *matrix, ppe_matrix_fixed_t *fixed)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            fixed->m[i][j] = (ppe_fixed_t)(matrix->m[i][j] * 65536);
+        }
+    }
+}
+
+void ppe_fixed_to_matrix(ppe_matrix_fixed_t *fixed, ppe_matrix_t *matrix)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            matrix->m[i][j] = fixed->m[i][j] / 65536.0f;
+        }
+    }
+}
+
+void ppe_fixed_mat_multiply(ppe_matrix_fixed_t *matrix, ppe_matrix_fixed_t *mult)
+{
+    ppe_matrix_fixed_t m;
+    memcpy(&m, matrix, sizeof(ppe_matrix_fixed_t));
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            int64_t sum = (int64_t)m.m[row][0] * mult->m[0][col] + \
+                          (int64_t)m.m[row][1] * mult->m[1][col] + \
+                          (int64_t)m.m[row][2] * mult->m[2][col];
+            matrix->m[row][col] = (ppe_fixed_t)(sum >> 16);
+        }
+    }
+}
+
+void ppe_fixed_translate(ppe_fixed_t x, ppe_fixed_t y, ppe_matrix_fixed_t *matrix)
+{
+    /* M * T only changes the third column */
+    for (int row = 0; row < 3; row++)
+    {
+        matrix->m[row][2] += ppe_fixed_mul(matrix->m[row][0], x) + ppe_fixed_mul(matrix->m[row][1], y);
+    }
+}
+
+void ppe_fixed_scale(ppe_fixed_t scale_x, ppe_fixed_t scale_y, ppe_matrix_fixed_t *matrix)
+{
+    for (int row = 0; row < 3; row++)
+    {
+        matrix->m[row][0] = ppe_fixed_mul(matrix->m[row][0], scale_x);
+        matrix->m[row][1] = ppe_fixed_mul(matrix->m[row][1], scale_y);
+    }
+}
+
+void ppe_fixed_rotate(int16_t degrees, ppe_matrix_fixed_t *matrix)
+{
+    ppe_fixed_t cos_angle = ((int32_t)ppe_fix_cos(degrees) * 65536) / 32767;
+    ppe_fixed_t sin_angle = ((int32_t)ppe_fix_sin(degrees) * 65536) / 32767;
+    ppe_matrix_fixed_t r = { { {cos_angle, -sin_angle, 0},
+            {sin_angle, cos_angle, 0},
+            {0, 0, PPE_FIXED_ONE}
+        }
+    };
+
+    ppe_fixed_mat_multiply(matrix, &r);
+}
+
+bool ppe_fixed_matrix_inverse(ppe_matrix_fixed_t *matrix)
+{
+    int64_t m00 = matrix->m[0][0], m01 = matrix->m[0][1], m02 = matrix->m[0][2];
+    int64_t m10 = matrix->m[1][0], m11 = matrix->m[1][1], m12 = matrix->m[1][2];
+    int64_t m20 = matrix->m[2][0], m21 = matrix->m[2][1], m22 = matrix->m[2][2];
+
+    /* adjugate in Q32.32 */
+    int64_t c00 = m11 * m22 - m12 * m21;
+    int64_t c10 = -(m22 * m10 - m12 * m20);
+    int64_t c20 = m10 * m21 - m20 * m11;
+    int64_t c01 = -(m01 * m22 - m02 * m21);
+    int64_t c11 = m22 * m00 - m20 * m02;
+    int64_t c21 = -(m00 * m21 - m20 * m01);
+    int64_t c02 = m01 * m12 - m11 * m02;
+    int64_t c12 = -(m00 * m12 - m02 * m10);
+    int64_t c22 = m00 * m11 - m01 * m10;
+
+    int64_t detal = m00 * (c00 >> 16) + m01 * (c10 >> 16) + m02 * (c20 >> 16);
+    if (detal == 0)
+    {
+        return false;
+    }
+
+    ppe_matrix_fixed_t inv;
+    if (!ppe_fixed_div64(c00, detal, &inv.m[0][0]) || !ppe_fixed_div64(c10, detal, &inv.m[1][0]) ||
+        !ppe_fixed_div64(c20, detal, &inv.m[2][0]) || !ppe_fixed_div64(c01, detal, &inv.m[0][1]) ||
+        !ppe_fixed_div64(c11, detal, &inv.m[1][1]) || !ppe_fixed_div64(c21, detal, &inv.m[2][1]) ||
+        !ppe_fixed_div64(c02, detal, &inv.m[0][2]) || !ppe_fixed_div64(c12, detal, &inv.m[1][2]) ||
+        !ppe_fixed_div64(c22, detal, &inv.m[2][2]))
+    {
+        return false;
+    }
+    memcpy(matrix, &inv, sizeof(ppe_matrix_fixed_t));
+    return true;
+}
+
+bool ppe_matrix_inverse_fixed(ppe_matrix_t *matrix, ppe_matrix_fixed_t *fixed)
+{
+    double m00 = matrix->m[0][0], m01 = matrix->m[0][1], m02 = matrix->m[0][2];
+    double m10 = matrix->m[1][0], m11 = matrix->m[1][1], m12 = matrix->m[1][2];
+    double m20 = matrix->m[2][0], m21 = matrix->m[2][1], m22 = matrix->m[2][2];
+
+    double adj[3][3] =
+    {
+        {m11 * m22 - m12 * m21, -(m01 * m22 - m02 * m21), m01 * m12 - m11 * m02},
+        {-(m22 * m10 - m12 * m20), m22 * m00 - m20 * m02, -(m00 * m12 - m02 * m10)},
+        {m10 * m21 - m20 * m11, -(m00 * m21 - m20 * m01), m00 * m11 - m01 * m10},
+    };
+    double detal = m00 * adj[0][0] + m01 * adj[1][0] + m02 * adj[2][0];
+    if (detal == 0)
+    {
+        return false;
+    }
+
+    ppe_matrix_fixed_t inv;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            if (!ppe_fixed_from_double(adj[i][j] / detal, &inv.m[i][j]))
+            {
+                return false;
+            }
+        }
+    }
+    memcpy(fixed, &inv, sizeof(ppe_matrix_fixed_t));
+    return true;
+}
+
+void ppe_fixed_matrix2complement(ppe_matrix_fixed_t *matrix, uint32_t *comp)
+{
+    /* Transfer_Matrix_Exx take Q16.16 in two's complement */
+    memcpy(comp, matrix->m, 9 * sizeof(uint32_t));
+}
+
+bool ppe_matrix_cache_get(ppe_matrix_t *matrix, bool inverse, ppe_matrix_fixed_t *result)
+{
+    for (uint8_t i = 0; i < PPE_MATRIX_CACHE_NUM; i++)
+    {
+        ppe_matrix_cache_t *entry = &ppe_matrix_cache[i];
+        if (entry->valid && (entry->inverse == inverse) &&
+            (memcmp(&entry->key, matrix, sizeof(ppe_matrix_t)) == 0))
+        {
+            memcpy(result, &entry->value, sizeof(ppe_matrix_fixed_t));
+            return true;
+        }
+    }
+
+    /* the inverse is taken from the float matrix, rounding the forward matrix to Q16.16 first
+       moves the perspective terms */
+    ppe_matrix_fixed_t value;
+    if (inverse)
+    {
+        if (!ppe_matrix_inverse_fixed(matrix, &value))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        ppe_matrix_to_fixed(matrix, &value);
+    }
+
+    ppe_matrix_cache_t *entry = &ppe_matrix_cache[ppe_matrix_cache_next];
+    ppe_matrix_cache_next = (ppe_matrix_cache_next + 1) % PPE_MATRIX_CACHE_NUM;
+    memcpy(&entry->key, matrix, sizeof(ppe_matrix_t));
+    memcpy(&entry->value, &value, sizeof(ppe_matrix_fixed_t));
+    entry->inverse = inverse;
+    entry->valid = true;
+    memcpy(result, &value, sizeof(ppe_matrix_fixed_t));
+    return true;
+}
+
 static void pos_transfer(ppe_matrix_t *matrix, ppe_pox_t *pox)
 {
     float m_row0, m_row1, m_row2;
@@ -0,0 +1,58 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     rtl_ppe_orient.h
+* \brief    Exact 90 degree rotation and flip coefficients for PPE_Blit_Orient
+* \details  Shared by the RTL8773E and RTL87x3EU drivers, included after rtl_ppe.h for PPE_ORIENT,
+*           ppe_buffer_t and PPE_FIXED_ONE.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#ifndef RTL_PPE_ORIENT_H
+#define RTL_PPE_ORIENT_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* source of placed pixel (u, v) is (a * u + b * v, d * u + e * v) as {a, b, d, e}, counted from
+   the last column or row of the image when a coefficient along it is negative */
+static const int8_t ppe_orient_axis[][4] =
+{
+    [PPE_ROTATE_0]      = {1, 0, 0, 1},
+    [PPE_ROTATE_90]     = {0, 1, -1, 0},
+    [PPE_ROTATE_180]    = {-1, 0, 0, -1},
+    [PPE_ROTATE_270]    = {0, -1, 1, 0},
+    [PPE_FLIP_H]        = {-1, 0, 0, 1},
+    [PPE_FLIP_V]        = {1, 0, 0, -1},
+};
+
+/* coefficients mapping pixel (u, v) of the placed image to the source, the integer entries land
+   every sample exactly on a source pixel */
+static void ppe_orient_get_comp(PPE_ORIENT orient, ppe_buffer_t *image, int32_t u, int32_t v,
+                                uint32_t *comp)
+{
+    const int8_t *axis = ppe_orient_axis[orient];
+    int32_t first_x = ((axis[0] < 0) || (axis[1] < 0)) ? (image->width - 1) : 0;
+    int32_t first_y = ((axis[2] < 0) || (axis[3] < 0)) ? (image->height - 1) : 0;
+
+    comp[0] = (uint32_t)(axis[0] * PPE_FIXED_ONE);
+    comp[1] = (uint32_t)(axis[1] * PPE_FIXED_ONE);
+    comp[2] = (uint32_t)((first_x + axis[0] * u + axis[1] * v) * PPE_FIXED_ONE);
+    comp[3] = (uint32_t)(axis[2] * PPE_FIXED_ONE);
+    comp[4] = (uint32_t)(axis[3] * PPE_FIXED_ONE);
+    comp[5] = (uint32_t)((first_y + axis[2] * u + axis[3] * v) * PPE_FIXED_ONE);
+    comp[6] = 0;
+    comp[7] = 0;
+    comp[8] = (uint32_t)PPE_FIXED_ONE;
+}
+
+#ifdef  __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RTL_PPE_ORIENT_H */
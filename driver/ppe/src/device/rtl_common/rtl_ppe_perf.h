@@ -0,0 +1,140 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     rtl_ppe_perf.h
+* \brief    PPE_PERF_EN timestamp source and latency statistics shared by the PPE drivers
+* \details  Included by rtl_ppe.c after rtl_ppe.h, which brings in the CMSIS core header and
+*           ppe_perf_stat_t.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#ifndef RTL_PPE_PERF_H
+#define RTL_PPE_PERF_H
+
+#include "stdio.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if PPE_PERF_EN
+#ifndef PPE_PERF_TIMESTAMP
+/*DWT cycle counter, CMSIS 6 renamed CoreDebug to DCB*/
+#define PPE_PERF_TIMESTAMP()    (DWT->CYCCNT)
+#if defined(DCB)
+#define PPE_PERF_TIMESTAMP_INIT()   do { DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk; \
+                                         DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while (0)
+#else
+#define PPE_PERF_TIMESTAMP_INIT()   do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+                                         DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while (0)
+#endif
+#endif /* PPE_PERF_TIMESTAMP */
+
+/*a platform PPE_PERF_TIMESTAMP() is expected to be running already*/
+#ifndef PPE_PERF_TIMESTAMP_INIT
+#define PPE_PERF_TIMESTAMP_INIT()
+#endif
+
+/*two bins per power of two, bin 2n holds [2^n, 1.5 * 2^n) and bin 2n + 1 holds [1.5 * 2^n, 2^(n+1))*/
+static uint8_t ppe_perf_bin(uint32_t ticks)
+{
+    uint8_t msb = 0;
+
+    if (ticks < 2)
+    {
+        return ticks;
+    }
+    for (uint32_t rest = ticks >> 1; rest != 0; rest >>= 1)
+    {
+        msb++;
+    }
+    return (msb << 1) | ((ticks >> (msb - 1)) & 1);
+}
+
+static uint32_t ppe_perf_bin_max(uint8_t bin)
+{
+    uint8_t msb = bin >> 1;
+
+    if (bin < 2)
+    {
+        return bin;
+    }
+    return ((2UL | (bin & 1)) << (msb - 1)) + (1UL << (msb - 1)) - 1;
+}
+
+/*upper edge of the histogram bin holding the percentile, capped by the largest latency seen*/
+static uint32_t ppe_perf_percentile(ppe_perf_op_t *op, uint8_t percent)
+{
+    uint32_t target = ((uint64_t)op->job_cnt * percent + 99) / 100;
+    uint32_t count = 0;
+
+    if ((op->job_cnt == 0) || (percent == 0))
+    {
+        return op->latency_min;
+    }
+    for (uint8_t bin = 0; bin < PPE_PERF_HIST_BINS; bin++)
+    {
+        count += op->hist[bin];
+        if (count >= target)
+        {
+            uint32_t bin_max = ppe_perf_bin_max(bin);
+            return (bin_max < op->latency_max) ? bin_max : op->latency_max;
+        }
+    }
+    return op->latency_max;
+}
+
+/*one line per operation that was called, op_name holds the driver's PPE_PERF_OP_NUM names*/
+static uint32_t ppe_perf_dump(ppe_perf_stat_t *perf, const char *const *op_name, char *buf,
+                              uint32_t size)
+{
+    uint32_t len = 0;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    buf[0] = '\0';
+    for (uint8_t i = 0; i < PPE_PERF_OP_NUM; i++)
+    {
+        ppe_perf_op_t *op = &perf->op[i];
+        uint32_t job_cnt = op->job_cnt ? op->job_cnt : 1;
+        int n;
+
+        if (op->call_cnt == 0)
+        {
+            continue;
+        }
+        n = snprintf(buf + len, size - len,
+                     "%-11s call %lu job %lu lat %lu/%lu/%lu/%lu setup %lu exec %lu rd %luK wr %luK px %luK\n",
+                     op_name[i], (unsigned long)op->call_cnt, (unsigned long)op->job_cnt,
+                     (unsigned long)op->latency_min,
+                     (unsigned long)((op->setup_time + op->exec_time) / job_cnt),
+                     (unsigned long)ppe_perf_percentile(op, 99), (unsigned long)op->latency_max,
+                     (unsigned long)(op->setup_time / job_cnt), (unsigned long)(op->exec_time / job_cnt),
+                     (unsigned long)(op->read_bytes >> 10), (unsigned long)(op->write_bytes >> 10),
+                     (unsigned long)(op->pixels >> 10));
+        if (n < 0)
+        {
+            break;
+        }
+        if ((uint32_t)n >= size - len)
+        {
+            len = size - 1;
+            break;
+        }
+        len += n;
+    }
+    return len;
+}
+#endif /* PPE_PERF_EN */
+
+#ifdef  __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RTL_PPE_PERF_H */
@@ -0,0 +1,128 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     rtl_ppe_quad.h
+* \brief    Footprint of a transformed rect, used to skip the empty parts of PPE_blit_transform jobs
+* \details  Shared by the RTL8773E and RTL87x3EU drivers, included after rtl_ppe.h for ppe_rect_t
+*           and ppe_matrix_t.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#ifndef RTL_PPE_QUAD_H
+#define RTL_PPE_QUAD_H
+
+#include "float.h"
+#include "math.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* homogeneous point */
+typedef struct
+{
+    float p[3];
+} ppe_pox_t;
+
+/* source_rect corners under matrix in polygon order, false if one is behind the horizon of a
+   perspective transform */
+static bool ppe_get_quad(ppe_matrix_t *matrix, ppe_rect_t *source_rect, ppe_pox_t *quad)
+{
+    float corner[4][2] = {{source_rect->x, source_rect->y}, {source_rect->x + source_rect->w, source_rect->y},
+        {source_rect->x + source_rect->w, source_rect->y + source_rect->h}, {source_rect->x, source_rect->y + source_rect->h}
+    };
+
+    for (int i = 0; i < 4; i++)
+    {
+        float w = matrix->m[2][0] * corner[i][0] + matrix->m[2][1] * corner[i][1] + matrix->m[2][2];
+        if (w <= FLT_EPSILON)
+        {
+            return false;
+        }
+        quad[i].p[0] = (matrix->m[0][0] * corner[i][0] + matrix->m[0][1] * corner[i][1] + matrix->m[0][2]) / w;
+        quad[i].p[1] = (matrix->m[1][0] * corner[i][0] + matrix->m[1][1] * corner[i][1] + matrix->m[1][2]) / w;
+        quad[i].p[2] = 1.0f;
+    }
+    return true;
+}
+
+/* x extent of quad between lines y0 and y1, false if the quad does not reach them */
+static bool ppe_quad_span(ppe_pox_t *quad, float y0, float y1, float *x_min, float *x_max)
+{
+    bool hit = false;
+
+    for (int i = 0; i < 4; i++)
+    {
+        ppe_pox_t *a = &quad[i];
+        ppe_pox_t *b = &quad[(i + 1) & 3];
+        float x[2] = {a->p[0], b->p[0]};
+
+        if (((a->p[1] < y0) && (b->p[1] < y0)) || ((a->p[1] > y1) && (b->p[1] > y1)))
+        {
+            continue;
+        }
+        if (a->p[1] != b->p[1])
+        {
+            /* the part of the edge inside the band ends where it crosses y0 and y1 */
+            float t[2] = {(y0 - a->p[1]) / (b->p[1] - a->p[1]), (y1 - a->p[1]) / (b->p[1] - a->p[1])};
+            for (int k = 0; k < 2; k++)
+            {
+                t[k] = (t[k] < 0.0f) ? 0.0f : ((t[k] > 1.0f) ? 1.0f : t[k]);
+                x[k] = a->p[0] + (b->p[0] - a->p[0]) * t[k];
+            }
+        }
+        for (int k = 0; k < 2; k++)
+        {
+            if (!hit || (x[k] < *x_min))
+            {
+                *x_min = x[k];
+            }
+            if (!hit || (x[k] > *x_max))
+            {
+                *x_max = x[k];
+            }
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+/* narrow band to the columns of area the quad covers in its lines, with one pixel margin for
+   bilinear sampling */
+static bool ppe_blit_band_span(ppe_pox_t *quad, ppe_rect_t *area, ppe_rect_t *band)
+{
+    float x_min, x_max;
+    int32_t left, right;
+
+    if (!ppe_quad_span(quad, band->y - 1.0f, band->y + band->h + 1.0f, &x_min, &x_max))
+    {
+        return false;
+    }
+    left = (int32_t)floorf(x_min) - 1;
+    right = (int32_t)ceilf(x_max) + 1;
+    if (left < area->x)
+    {
+        left = area->x;
+    }
+    if (right > area->x + (int32_t)area->w)
+    {
+        right = area->x + area->w;
+    }
+    if (left >= right)
+    {
+        return false;
+    }
+    band->x = left;
+    band->w = right - left;
+    return true;
+}
+
+#ifdef  __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RTL_PPE_QUAD_H */
@@ -0,0 +1,153 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     bench_ppe_sw.c
+* \brief    Finds the rect size where the RTL87x2G CPU kernels stop beating a PPE job.
+* \details  usage: bench_ppe_sw [ppe_mpix_per_s] [ppe_start_us] [cpu_scale]
+*           CPU kernel time and the driver's PPE programming time are measured on the host as the
+*           best of BENCH_REPEAT runs and multiplied by cpu_scale, the target's slowdown against the
+*           host. The engine itself is modelled as ppe_start_us plus pixels at ppe_mpix_per_s. Take all three from the board
+*           (PPE_PERF_EN) and set PPE_SW_THRESHOLD_PIXELS to the reported crossover.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rtl_ppe.h"
+#include "host_ppe.h"
+
+#define BENCH_SIDE_MAX      64
+#define BENCH_REPEAT        50
+
+typedef enum
+{
+    BENCH_CLEAR,
+    BENCH_SRC_OVER_565,
+    BENCH_SRC_OVER_8888,
+    BENCH_BYPASS_OPAQUE,
+} bench_op;
+
+static const char *bench_op_name[] = {"clear argb8888", "src-over argb8888 -> rgb565",
+                                      "src-over argb8888 -> argb8888", "bypass xrgb8888 -> argb8888"
+                                     };
+static uint32_t src_pixels[BENCH_SIDE_MAX * BENCH_SIDE_MAX];
+static uint32_t dst_pixels[BENCH_SIDE_MAX * BENCH_SIDE_MAX];
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void setup_buffer(ppe_buffer_t *buffer, uint32_t *pixels, PPE_PIXEL_FORMAT format)
+{
+    buffer->memory = pixels;
+    buffer->address = (uint32_t)(uintptr_t)pixels;
+    buffer->format = format;
+    buffer->color_key_en = false;
+    buffer->global_alpha_en = false;
+    buffer->width = BENCH_SIDE_MAX;
+    buffer->height = BENCH_SIDE_MAX;
+    buffer->stride = 0;
+}
+
+/* one run of op on a side x side rect, returns the time until the call returned */
+static double bench_run(bench_op op, uint32_t side, bool async)
+{
+    ppe_buffer_t image, target;
+    ppe_translate_t trans = {0, 0};
+    ppe_rect_t rect = {.left = 0, .top = 0, .right = side - 1, .bottom = side - 1};
+    ppe_job_t job = PPE_JOB_INVALID;
+    PPE_ERR err;
+    double start;
+
+    setup_buffer(&image, src_pixels, (op == BENCH_BYPASS_OPAQUE) ? PPE_XRGB8888 : PPE_ARGB8888);
+    setup_buffer(&target, dst_pixels, (op == BENCH_SRC_OVER_565) ? PPE_RGB565 : PPE_ARGB8888);
+    start = now_us();
+    if (op == BENCH_CLEAR)
+    {
+        err = async ? PPE_Clear_Rect_Async(&target, &rect, 0xFF336699, NULL, NULL, &job) :
+              PPE_Clear_Rect(&target, &rect, 0xFF336699);
+    }
+    else
+    {
+        PPE_BLEND_MODE mode = (op == BENCH_BYPASS_OPAQUE) ? PPE_BYPASS_MODE : PPE_SRC_OVER_MODE;
+        err = async ? PPE_blend_rect_Async(&image, &target, &trans, &rect, mode, NULL, NULL, &job) :
+              PPE_blend_rect(&image, &target, &trans, &rect, mode);
+    }
+    double elapsed = now_us() - start;
+    PPE_JobWait(job);
+    if ((err != PPE_SUCCESS) && (err != PPE_SUCCESS_NOT_CHANGE))
+    {
+        printf("%s failed with %d\n", bench_op_name[op], err);
+        exit(1);
+    }
+    return elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t sides[] = {2, 4, 6, 8, 12, 16, 24, 32, 48, 64};
+    double ppe_mpix = (argc > 1) ? atof(argv[1]) : 100.0;
+    double ppe_start_us = (argc > 2) ? atof(argv[2]) : 2.0;
+    double cpu_scale = (argc > 3) ? atof(argv[3]) : 1.0;
+
+    if (!host_ppe_start(PPE_JobIRQHandler))
+    {
+        printf("cannot map the PPE register window\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < BENCH_SIDE_MAX * BENCH_SIDE_MAX; i++)
+    {
+        src_pixels[i] = (i * 0x01030507U) | ((i & 1) ? 0xFF000000 : 0x80000000);
+    }
+    printf("PPE model: %.1f MPix/s, %.2f us start, CPU scale %.2f\n", ppe_mpix, ppe_start_us,
+           cpu_scale);
+    for (bench_op op = BENCH_CLEAR; op <= BENCH_BYPASS_OPAQUE; op++)
+    {
+        uint32_t crossover = 0;
+        printf("\n%s\n%6s %8s %10s %10s\n", bench_op_name[op], "side", "pixels", "cpu us", "ppe us");
+        for (uint32_t s = 0; s < sizeof(sides) / sizeof(sides[0]); s++)
+        {
+            uint32_t pixels = sides[s] * sides[s];
+            double cpu = 1e9, setup = 1e9;
+            PPE_SetSoftwareThreshold(0xFFFFFFFF);
+            for (uint32_t r = 0; r < BENCH_REPEAT; r++)
+            {
+                double t = bench_run(op, sides[s], false);
+                cpu = (t < cpu) ? t : cpu;
+            }
+            PPE_SetSoftwareThreshold(0);
+            for (uint32_t r = 0; r < BENCH_REPEAT; r++)
+            {
+                double t = bench_run(op, sides[s], true);
+                setup = (t < setup) ? t : setup;
+            }
+            cpu = cpu * cpu_scale;
+            double ppe = setup * cpu_scale + ppe_start_us + pixels / ppe_mpix;
+            printf("%6u %8u %10.2f %10.2f\n", sides[s], pixels, cpu, ppe);
+            if ((crossover == 0) && (cpu > ppe))
+            {
+                crossover = pixels;
+            }
+        }
+        if (crossover != 0)
+        {
+            printf("PPE wins from %u pixels\n", crossover);
+        }
+        else
+        {
+            printf("CPU wins up to %u pixels\n", BENCH_SIDE_MAX * BENCH_SIDE_MAX);
+        }
+    }
+    PPE_SetSoftwareThreshold(PPE_SW_THRESHOLD_PIXELS);
+    host_ppe_stop();
+    return 0;
+}
@@ -0,0 +1,8 @@
+/* Host stand-in: peripheral windows are mapped by host_regs_init() at these addresses. */
+#ifndef ADDRESS_MAP_H
+#define ADDRESS_MAP_H
+
+#define PPE_CFG_REG_BASE    0x40040000UL
+#define IDU_REG_BASE        0x40050000UL
+
+#endif /* ADDRESS_MAP_H */
@@ -0,0 +1,100 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     host_ppe.c
+* \brief    Register-level stand-in for the RTL87x2G PPE block.
+* \details  INTR_CLR is write one to clear and INTR_ST is INTR_RAW without the INTR_MASK bits.
+*           A run is seen on one poll and finished on the next, so a clear written before the
+*           start is always applied before the run raises its interrupt.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include "rtl_ppe.h"
+#include "host_regs.h"
+#include "host_ppe.h"
+
+static pthread_t host_ppe_thread;
+static volatile bool host_ppe_running;
+static volatile bool host_ppe_held;
+static void (*volatile host_ppe_irq)(void);
+static volatile uint32_t host_ppe_run_count;
+
+static void host_ppe_update_status(void)
+{
+    PPE->INTR_RAW &= ~PPE->INTR_CLR;
+    PPE->INTR_CLR = 0;
+    PPE->INTR_ST = PPE->INTR_RAW & ~PPE->INTR_MASK;
+}
+
+static void *host_ppe_engine(void *arg)
+{
+    bool busy = false;
+    (void)arg;
+    while (host_ppe_running)
+    {
+        host_irq_enter();
+        host_ppe_update_status();
+        if (busy && !host_ppe_held)
+        {
+            busy = false;
+            host_ppe_run_count++;
+            PPE->INTR_RAW |= PPE_ALL_OVER_INT | PPE_FR_OVER_INT;
+            PPE->GLB_CTL &= ~BIT0;
+            host_ppe_update_status();
+        }
+        else if (!busy && (PPE->GLB_CTL & BIT0))
+        {
+            busy = true;
+        }
+        if ((PPE->INTR_ST != 0) && (host_ppe_irq != NULL))
+        {
+            host_ppe_irq();
+            host_ppe_update_status();
+        }
+        host_irq_exit();
+        sched_yield();
+    }
+    return NULL;
+}
+
+bool host_ppe_start(void (*irq_handler)(void))
+{
+    static bool mapped;
+    if (!mapped && !host_regs_map(PPE_CFG_REG_BASE, 0x1000))
+    {
+        return false;
+    }
+    mapped = true;
+    PPE->INTR_MASK = ~0U;
+    host_ppe_irq = irq_handler;
+    host_ppe_held = false;
+    host_ppe_running = true;
+    return pthread_create(&host_ppe_thread, NULL, host_ppe_engine, NULL) == 0;
+}
+
+void host_ppe_stop(void)
+{
+    host_ppe_running = false;
+    pthread_join(host_ppe_thread, NULL);
+}
+
+void host_ppe_hold(bool hold)
+{
+    host_ppe_held = hold;
+}
+
+void host_ppe_set_irq(void (*irq_handler)(void))
+{
+    host_ppe_irq = irq_handler;
+}
+
+uint32_t host_ppe_runs(void)
+{
+    return host_ppe_run_count;
+}
@@ -0,0 +1,31 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     host_ppe.h
+* \brief    Register-level stand-in for the RTL87x2G PPE block.
+* \details  A thread plays the engine: a run started through GLB_CTL ends one poll later by
+*           clearing GLB_CTL bit 0 and raising PPE_ALL_OVER_INT, which is delivered to the
+*           registered handler when unmasked. No pixels are produced.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#ifndef HOST_PPE_H
+#define HOST_PPE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* map the PPE window and start the engine, irq_handler NULL leaves the interrupt unwired */
+bool host_ppe_start(void (*irq_handler)(void));
+void host_ppe_stop(void);
+
+/* while held, started runs do not finish */
+void host_ppe_hold(bool hold);
+void host_ppe_set_irq(void (*irq_handler)(void));
+uint32_t host_ppe_runs(void);
+
+#endif /* HOST_PPE_H */
@@ -0,0 +1,68 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     host_regs.c
+* \brief    Register windows and interrupt masking for running driver code on a Linux host.
+* \details  PRIMASK is a recursive lock shared with the simulated interrupt context, so code that
+*           masks interrupts never overlaps a handler, as on the MCU.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sys/mman.h>
+#include "host_regs.h"
+
+static pthread_mutex_t host_irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread uint32_t host_primask;
+
+bool host_regs_map(uint32_t base, uint32_t size)
+{
+    void *p = mmap((void *)(uintptr_t)base, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    return p == (void *)(uintptr_t)base;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return host_primask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+    if (primask && !host_primask)
+    {
+        pthread_mutex_lock(&host_irq_lock);
+    }
+    else if (!primask && host_primask)
+    {
+        pthread_mutex_unlock(&host_irq_lock);
+    }
+    host_primask = primask ? 1 : 0;
+}
+
+void __disable_irq(void)
+{
+    __set_PRIMASK(1);
+}
+
+void __enable_irq(void)
+{
+    __set_PRIMASK(0);
+}
+
+void host_irq_enter(void)
+{
+    pthread_mutex_lock(&host_irq_lock);
+    host_primask = 1;
+}
+
+void host_irq_exit(void)
+{
+    host_primask = 0;
+    pthread_mutex_unlock(&host_irq_lock);
+}
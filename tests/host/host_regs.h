@@ -0,0 +1,34 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     host_regs.h
+* \brief    Register windows and interrupt masking for running driver code on a Linux host.
+* \details  Tests are linked without PIE, so static buffers and mapped windows sit below 4 GB
+*           and survive the driver's uint32_t address casts.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#ifndef HOST_REGS_H
+#define HOST_REGS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* map [base, base + size) as zeroed memory so the driver's register pointers work */
+bool host_regs_map(uint32_t base, uint32_t size);
+
+/* PRIMASK: while a thread holds it, host_irq_enter() blocks */
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+
+/* bracket a simulated interrupt handler */
+void host_irq_enter(void);
+void host_irq_exit(void);
+
+#endif /* HOST_REGS_H */
@@ -0,0 +1,5 @@
+/* Host stand-in: the PPE driver only needs the header to exist. */
+#ifndef OS_SYNC_H
+#define OS_SYNC_H
+
+#endif /* OS_SYNC_H */
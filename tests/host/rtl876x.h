@@ -0,0 +1,7 @@
+/* Host stand-in for the RTL8773E/RTL87x3EU device header: bit macros and CMSIS types. */
+#ifndef RTL876X_H
+#define RTL876X_H
+
+#include "utils/rtl_utils.h"
+
+#endif /* RTL876X_H */
@@ -0,0 +1,7 @@
+/* Host stand-in: PRIMASK comes from host_regs.h through utils/rtl_utils.h. */
+#ifndef RTL_NVIC_H
+#define RTL_NVIC_H
+
+#include "utils/rtl_utils.h"
+
+#endif /* RTL_NVIC_H */
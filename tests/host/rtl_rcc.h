@@ -0,0 +1,14 @@
+/* Host stand-in: clocks are always on. */
+#ifndef RTL_RCC_H
+#define RTL_RCC_H
+
+#define APBPeriph_PPE               0
+#define APBPeriph_PPE_CLOCK         0
+#define APBPeriph_IDU               0
+#define APBPeriph_IDU_CLOCK         0
+#define APBPeriph_GDMA              0
+#define APBPeriph_GDMA_CLOCK        0
+
+#define RCC_PeriphClockCmd(periph, clock, state)    ((void)0)
+
+#endif /* RTL_RCC_H */
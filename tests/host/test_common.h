@@ -0,0 +1,41 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_common.h
+* \brief    Minimal check macros shared by the host tests.
+* \details
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <stdio.h>
+
+static int test_failures;
+
+#define CHECK(cond)                                                                 \
+    do                                                                              \
+    {                                                                               \
+        if (!(cond))                                                                \
+        {                                                                           \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);         \
+            test_failures++;                                                        \
+        }                                                                           \
+    } while (0)
+
+#define RUN_TEST(fn)                                                                \
+    do                                                                              \
+    {                                                                               \
+        int before = test_failures;                                                 \
+        fn();                                                                       \
+        printf("%-48s %s\n", #fn, (test_failures == before) ? "ok" : "FAILED");     \
+    } while (0)
+
+#define TEST_RESULT()       ((test_failures == 0) ? 0 : 1)
+
+#endif /* TEST_COMMON_H */
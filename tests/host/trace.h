@@ -0,0 +1,5 @@
+/* Host stand-in: the PPE driver only needs the header to exist. */
+#ifndef TRACE_H
+#define TRACE_H
+
+#endif /* TRACE_H */
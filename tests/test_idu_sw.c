@@ -0,0 +1,169 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_idu_sw.c
+* \brief    IDU_Decode_SW on hand-built RLE and FastLZ files.
+* \details  Vectors are written byte by byte from the file layout, not by tools/idu_encoder,
+*           so the decoder is not only checked against the encoder's own reading of it.
+*           Line payloads are zero padded to 4 bytes as the encoder writes them.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include <string.h>
+#include "rtl_idu.h"
+#include "test_common.h"
+
+#define FILE_BYTES          256
+
+typedef struct
+{
+    const uint8_t *data;
+    uint32_t len;
+} line_t;
+
+static uint32_t file_words[FILE_BYTES / 4];
+
+/* RGB565 file of the given lines, each payload padded to a word */
+static uint8_t *make_file(uint8_t algorithm, uint8_t feature_1, uint32_t width,
+                          const line_t *lines, uint32_t height)
+{
+    uint8_t *file = (uint8_t *)file_words;
+    IDU_file_header *header = (IDU_file_header *)file;
+    uint32_t *offset = (uint32_t *)(file + sizeof(IDU_file_header));
+    uint32_t pos = sizeof(IDU_file_header) + (height + 1) * 4;
+
+    memset(file_words, 0, sizeof(file_words));
+    header->algorithm_type.algorithm = algorithm;
+    header->algorithm_type.feature_1 = feature_1;
+    header->algorithm_type.pixel_bytes = IDU_PIXEL_16BIT;
+    header->raw_pic_width = width;
+    header->raw_pic_height = height;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        offset[y] = pos;
+        memcpy(file + pos, lines[y].data, lines[y].len);
+        pos = (pos + lines[y].len + 3) & ~3u;
+    }
+    offset[height] = pos;
+    return file;
+}
+
+/* 4x2: {3 x 0x1234, 0xABCD}, {4 x 0x00FF} with 1 byte run counts */
+static uint8_t *rle_file(void)
+{
+    static const uint8_t line0[] = {0x03, 0x34, 0x12, 0x01, 0xCD, 0xAB};
+    static const uint8_t line1[] = {0x04, 0xFF, 0x00};
+    static const line_t lines[] = {{line0, sizeof(line0)}, {line1, sizeof(line1)}};
+    return make_file(IDU_ALGO_RLE, IDU_RLE_1BYTE_LEN, 4, lines, 2);
+}
+
+/* 4x2: {0x2211 x 4} as two literals and a 6 byte match, {0x0201, 0x0403, 0x0605, 0x0807} as literals */
+static uint8_t *fastlz_file(void)
+{
+    static const uint8_t line0[] = {0x01, 0x11, 0x22, 0x80, 0x01};
+    static const uint8_t line1[] = {0x07, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+    static const line_t lines[] = {{line0, sizeof(line0)}, {line1, sizeof(line1)}};
+    return make_file(IDU_ALGO_FASTLZ, 0, 4, lines, 2);
+}
+
+static void test_rle_full(void)
+{
+    static const uint16_t expect[8] = {0x1234, 0x1234, 0x1234, 0xABCD, 0x00FF, 0x00FF, 0x00FF, 0x00FF};
+    uint16_t out[8] = {0};
+    CHECK(IDU_Decode_SW(rle_file(), NULL, (uint8_t *)out, 0) == IDU_SUCCESS);
+    CHECK(memcmp(out, expect, sizeof(expect)) == 0);
+}
+
+static void test_rle_two_byte_runs(void)
+{
+    static const uint8_t line0[] = {0x02, 0x01, 0x34, 0x12};
+    static const line_t lines[] = {{line0, sizeof(line0)}};
+    uint8_t *file = make_file(IDU_ALGO_RLE, IDU_RLE_2BYTE_LEN, 258, lines, 1);
+    static uint16_t out[258];
+    IDU_decode_range range = {0, 0, 250, 257};
+    CHECK(IDU_Decode_SW(file, &range, (uint8_t *)out, 0) == IDU_SUCCESS);
+    for (int i = 0; i < 8; i++)
+    {
+        CHECK(out[i] == 0x1234);
+    }
+}
+
+static void test_rle_window_at_stride(void)
+{
+    uint16_t out[2][3];
+    IDU_decode_range range = {0, 1, 2, 3};
+    memset(out, 0x5A, sizeof(out));
+    CHECK(IDU_Decode_SW(rle_file(), &range, (uint8_t *)out, sizeof(out[0])) == IDU_SUCCESS);
+    CHECK((out[0][0] == 0x1234) && (out[0][1] == 0xABCD) && (out[0][2] == 0x5A5A));
+    CHECK((out[1][0] == 0x00FF) && (out[1][1] == 0x00FF) && (out[1][2] == 0x5A5A));
+}
+
+static void test_fastlz_full(void)
+{
+    static const uint16_t expect[8] = {0x2211, 0x2211, 0x2211, 0x2211, 0x0201, 0x0403, 0x0605, 0x0807};
+    uint16_t out[8] = {0};
+    CHECK(IDU_Decode_SW(fastlz_file(), NULL, (uint8_t *)out, 0) == IDU_SUCCESS);
+    CHECK(memcmp(out, expect, sizeof(expect)) == 0);
+}
+
+static void test_fastlz_window(void)
+{
+    uint16_t out[2] = {0};
+    IDU_decode_range range = {1, 1, 1, 2};
+    CHECK(IDU_Decode_SW(fastlz_file(), &range, (uint8_t *)out, 0) == IDU_SUCCESS);
+    CHECK((out[0] == 0x0403) && (out[1] == 0x0605));
+}
+
+static void test_corrupt_lines_fail(void)
+{
+    static const uint8_t zero_run[] = {0x00, 0x34, 0x12};
+    static const uint8_t short_rle[] = {0x03, 0x34, 0x12};
+    static const uint8_t far_match[] = {0x01, 0x11, 0x22, 0x80, 0x05};
+    static const line_t rle0[] = {{zero_run, sizeof(zero_run)}};
+    static const line_t rle1[] = {{short_rle, sizeof(short_rle)}};
+    static const line_t lz[] = {{far_match, sizeof(far_match)}};
+    uint16_t out[4];
+    CHECK(IDU_Decode_SW(make_file(IDU_ALGO_RLE, IDU_RLE_1BYTE_LEN, 4, rle0, 1), NULL,
+                        (uint8_t *)out, 0) == IDU_ERROR_DECODE_FAIL);
+    CHECK(IDU_Decode_SW(make_file(IDU_ALGO_RLE, IDU_RLE_1BYTE_LEN, 4, rle1, 1), NULL,
+                        (uint8_t *)out, 0) == IDU_ERROR_DECODE_FAIL);
+    CHECK(IDU_Decode_SW(make_file(IDU_ALGO_FASTLZ, 0, 4, lz, 1), NULL,
+                        (uint8_t *)out, 0) == IDU_ERROR_DECODE_FAIL);
+}
+
+static void test_bad_range(void)
+{
+    uint16_t out[8];
+    IDU_decode_range start = {2, 2, 0, 0};
+    IDU_decode_range order = {1, 0, 0, 0};
+    IDU_decode_range end = {0, 0, 0, 4};
+    CHECK(IDU_Decode_SW(rle_file(), &start, (uint8_t *)out, 0) == IDU_ERROR_START_EXCEED_BOUNDARY);
+    CHECK(IDU_Decode_SW(rle_file(), &order, (uint8_t *)out, 0) == IDU_ERROR_START_LARGER_THAN_END);
+    CHECK(IDU_Decode_SW(rle_file(), &end, (uint8_t *)out, 0) == IDU_ERROR_END_EXCEED_BOUNDARY);
+}
+
+static void test_yuv_needs_experimental(void)
+{
+    static const uint8_t line0[] = {0x80, 0x80, 0x80};
+    static const line_t lines[] = {{line0, sizeof(line0)}};
+    uint16_t out[1];
+    CHECK(IDU_Decode_SW(make_file(IDU_ALGO_YUV_BLUR, IDU_YUV_TYPE_444, 1, lines, 1), NULL,
+                        (uint8_t *)out, 0) == IDU_ERROR_INVALID_PARAM);
+}
+
+int main(void)
+{
+    RUN_TEST(test_rle_full);
+    RUN_TEST(test_rle_two_byte_runs);
+    RUN_TEST(test_rle_window_at_stride);
+    RUN_TEST(test_fastlz_full);
+    RUN_TEST(test_fastlz_window);
+    RUN_TEST(test_corrupt_lines_fail);
+    RUN_TEST(test_bad_range);
+    RUN_TEST(test_yuv_needs_experimental);
+    return TEST_RESULT();
+}
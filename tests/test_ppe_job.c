@@ -0,0 +1,156 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_ppe_job.c
+* \brief    RTL87x2G asynchronous PPE jobs against the register-level stand-in.
+* \details
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include <string.h>
+#include "rtl_ppe.h"
+#include "host_ppe.h"
+#include "test_common.h"
+
+static uint32_t frame[64 * 64];
+static ppe_buffer_t target;
+static volatile uint32_t callback_count;
+static volatile ppe_job_t callback_job;
+
+static void job_done(ppe_job_t job, void *user_data)
+{
+    callback_job = job;
+    callback_count += (uint32_t)(uintptr_t)user_data;
+}
+
+static void setup(void)
+{
+    memset(&target, 0, sizeof(target));
+    target.memory = frame;
+    target.address = (uint32_t)(uintptr_t)frame;
+    target.format = PPE_ARGB8888;
+    target.width = 64;
+    target.height = 64;
+    callback_count = 0;
+    callback_job = PPE_JOB_INVALID;
+}
+
+static void test_async_returns_before_the_engine_finishes(void)
+{
+    ppe_job_t job = PPE_JOB_INVALID;
+    setup();
+    host_ppe_hold(true);
+    CHECK(PPE_Clear_Async(&target, 0xFF00FF00, job_done, (void *)1, &job) == PPE_SUCCESS);
+    CHECK(job != PPE_JOB_INVALID);
+    CHECK(!PPE_JobPoll(job));
+    CHECK(callback_count == 0);
+    host_ppe_hold(false);
+    PPE_JobWait(job);
+    CHECK(PPE_JobPoll(job));
+    CHECK(callback_count == 1);
+    CHECK(callback_job == job);
+}
+
+static void test_blocking_call_waits_for_the_async_job(void)
+{
+    ppe_job_t job = PPE_JOB_INVALID;
+    uint32_t runs;
+    setup();
+    host_ppe_hold(true);
+    CHECK(PPE_Clear_Async(&target, 0xFF0000FF, job_done, (void *)1, &job) == PPE_SUCCESS);
+    runs = host_ppe_runs();
+    host_ppe_hold(false);
+    CHECK(PPE_Clear(&target, 0xFFFFFFFF) == PPE_SUCCESS);
+    CHECK(PPE_JobPoll(job));
+    CHECK(callback_count == 1);
+    CHECK(host_ppe_runs() == runs + 2);
+}
+
+static void test_jobs_finish_in_order(void)
+{
+    ppe_job_t first = PPE_JOB_INVALID, second = PPE_JOB_INVALID;
+    setup();
+    CHECK(PPE_Clear_Async(&target, 0xFF000000, job_done, (void *)1, &first) == PPE_SUCCESS);
+    CHECK(PPE_Clear_Async(&target, 0xFF000000, job_done, (void *)1, &second) == PPE_SUCCESS);
+    CHECK((int32_t)(second - first) > 0);
+    PPE_JobWait(second);
+    CHECK(PPE_JobPoll(first));
+    CHECK(callback_count == 2);
+    CHECK(callback_job == second);
+}
+
+static void test_failed_submission_retires_without_callback(void)
+{
+    ppe_job_t job = PPE_JOB_INVALID;
+    setup();
+    CHECK(PPE_Clear_Async(NULL, 0, job_done, (void *)1, &job) == PPE_ERROR_NULL_TARGET);
+    CHECK(PPE_JobPoll(job));
+    CHECK(PPE_JobPoll(PPE_JOB_INVALID));
+    CHECK(callback_count == 0);
+}
+
+static void icon(ppe_buffer_t *image, uint32_t *pixels, uint32_t width, uint32_t height)
+{
+    memset(image, 0, sizeof(*image));
+    image->memory = pixels;
+    image->address = (uint32_t)(uintptr_t)pixels;
+    image->format = PPE_ARGB8888;
+    image->width = width;
+    image->height = height;
+}
+
+static void test_cmdlist_splits_runs_only_on_used_line_length(void)
+{
+    static uint32_t pixels[4][8 * 4];
+    static ppe_cmd_t cmd[8];
+    ppe_cmdlist_t list;
+    ppe_buffer_t line4, line8, box4, box8;
+    ppe_translate_t trans = {.x = 0, .y = 0};
+    uint32_t runs;
+    setup();
+    icon(&line4, pixels[0], 4, 1);
+    icon(&line8, pixels[1], 8, 1);
+    icon(&box4, pixels[2], 4, 4);
+    icon(&box8, pixels[3], 8, 4);
+    PPE_CmdList_Init(&list, cmd, 8);
+
+    /*single line icons leave the source line length free, box4 then fixes it for the run*/
+    CHECK(PPE_CmdList_blend(&list, &line4, &target, &trans, PPE_SRC_OVER_MODE) == PPE_SUCCESS);
+    CHECK(PPE_CmdList_blend(&list, &line8, &target, &trans, PPE_SRC_OVER_MODE) == PPE_SUCCESS);
+    CHECK(PPE_CmdList_blend(&list, &box4, &target, &trans, PPE_SRC_OVER_MODE) == PPE_SUCCESS);
+    CHECK(PPE_CmdList_blend(&list, &line8, &target, &trans, PPE_SRC_OVER_MODE) == PPE_SUCCESS);
+    CHECK(PPE_CmdList_blend(&list, &box8, &target, &trans, PPE_SRC_OVER_MODE) == PPE_SUCCESS);
+    runs = host_ppe_runs();
+    CHECK(PPE_CmdList_Submit(&list) == PPE_SUCCESS);
+    CHECK(list.run_num == 2);
+    CHECK(host_ppe_runs() == runs + 2);
+    CHECK((PPE_LAYER->INPUT_LAYER[1].LAYERx_PIC_CFG >> 16) == 8);
+    CHECK((PPE_LAYER->RESULT_LAYER.LAYER0_PIC_CFG >> 16) == 64);
+}
+
+int main(void)
+{
+    if (!host_ppe_start(PPE_JobIRQHandler))
+    {
+        printf("cannot map the PPE register window\n");
+        return 1;
+    }
+    RUN_TEST(test_async_returns_before_the_engine_finishes);
+    RUN_TEST(test_blocking_call_waits_for_the_async_job);
+    RUN_TEST(test_jobs_finish_in_order);
+    RUN_TEST(test_failed_submission_retires_without_callback);
+    RUN_TEST(test_cmdlist_splits_runs_only_on_used_line_length);
+
+    /*same sequences with PPE_JobIRQHandler left unwired, waits must not hang*/
+    host_ppe_set_irq(NULL);
+    RUN_TEST(test_async_returns_before_the_engine_finishes);
+    RUN_TEST(test_blocking_call_waits_for_the_async_job);
+    RUN_TEST(test_jobs_finish_in_order);
+    RUN_TEST(test_failed_submission_retires_without_callback);
+    host_ppe_stop();
+    return TEST_RESULT();
+}
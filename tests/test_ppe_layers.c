@@ -0,0 +1,106 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_ppe_layers.c
+* \brief    RTL87x2G multi-layer blending, checked on the input layer registers it programs.
+* \details
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include <string.h>
+#include "rtl_ppe.h"
+#include "rtl_ppe_def.h"
+#include "host_ppe.h"
+#include "test_common.h"
+
+static uint32_t layer_pixels[4 * 4];
+static uint32_t output_pixels[4 * 4];
+
+static void setup_layer(ppe_layer_t *layer, uint32_t *pixels)
+{
+    memset(layer, 0, sizeof(ppe_layer_t));
+    layer->buffer.memory = pixels;
+    layer->buffer.address = (uint32_t)(uintptr_t)pixels;
+    layer->buffer.format = PPE_ARGB8888;
+    layer->buffer.width = 4;
+    layer->buffer.height = 4;
+}
+
+/* input layer 1 as programmed by the last job */
+static void read_layer1(uint32_t *addr, PPE_LAYERX_POS_TypeDef *pos, PPE_LAYERX_WIN_SIZE_TypeDef *size)
+{
+    *addr = PPE_LAYER->INPUT_LAYER[0].LAYERx_ADDR_L;
+    pos->d32 = PPE_LAYER->INPUT_LAYER[0].LAYERx_POS;
+    size->d32 = PPE_LAYER->INPUT_LAYER[0].LAYERx_WIN_SIZE;
+}
+
+static void test_rect_clipped_at_top_left(void)
+{
+    ppe_layer_t layer, output;
+    ppe_rect_t rect = {.left = 1, .top = 1, .right = 3, .bottom = 3};
+    PPE_LAYERX_POS_TypeDef pos;
+    PPE_LAYERX_WIN_SIZE_TypeDef size;
+    uint32_t addr;
+    setup_layer(&layer, layer_pixels);
+    setup_layer(&output, output_pixels);
+    layer.rect = &rect;
+    layer.trans.x = -1;
+    layer.trans.y = -1;
+    CHECK(PPE_blend_layers(&layer, 1, &output) == PPE_SUCCESS);
+    read_layer1(&addr, &pos, &size);
+    CHECK(addr == (uint32_t)(uintptr_t)&layer_pixels[2 * 4 + 2]);
+    CHECK((pos.b.start_x == 0) && (pos.b.start_y == 0));
+    CHECK((size.b.width == 2) && (size.b.height == 2));
+}
+
+static void test_rect_clipped_at_bottom_right(void)
+{
+    ppe_layer_t layer, output;
+    ppe_rect_t rect = {.left = 2, .top = 0, .right = 3, .bottom = 3};
+    PPE_LAYERX_POS_TypeDef pos;
+    PPE_LAYERX_WIN_SIZE_TypeDef size;
+    uint32_t addr;
+    setup_layer(&layer, layer_pixels);
+    setup_layer(&output, output_pixels);
+    layer.rect = &rect;
+    layer.trans.x = 3;
+    layer.trans.y = 1;
+    CHECK(PPE_blend_layers(&layer, 1, &output) == PPE_SUCCESS);
+    read_layer1(&addr, &pos, &size);
+    CHECK(addr == (uint32_t)(uintptr_t)&layer_pixels[2]);
+    CHECK((pos.b.start_x == 3) && (pos.b.start_y == 1));
+    CHECK((size.b.width == 1) && (size.b.height == 3));
+}
+
+static void test_rect_outside_output_is_skipped(void)
+{
+    ppe_layer_t layer, output;
+    ppe_rect_t rect = {.left = 2, .top = 2, .right = 3, .bottom = 3};
+    setup_layer(&layer, layer_pixels);
+    setup_layer(&output, output_pixels);
+    layer.rect = &rect;
+    /* the whole buffer would still reach the output, the rect does not */
+    layer.trans.x = -2;
+    layer.trans.y = 0;
+    CHECK(PPE_blend_layers(&layer, 1, &output) == PPE_SUCCESS);
+    PPE_FUNC_CFG_TypeDef func_cfg = {.d32 = PPE->FUNC_CFG};
+    CHECK(func_cfg.b.blend_lay == 0);
+}
+
+int main(void)
+{
+    if (!host_ppe_start(PPE_JobIRQHandler))
+    {
+        printf("cannot map the PPE register window\n");
+        return 1;
+    }
+    RUN_TEST(test_rect_clipped_at_top_left);
+    RUN_TEST(test_rect_clipped_at_bottom_right);
+    RUN_TEST(test_rect_outside_output_is_skipped);
+    host_ppe_stop();
+    return TEST_RESULT();
+}
@@ -0,0 +1,160 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_ppe_mask_list.c
+* \brief    PPE_Mask_List of the RTL8773E and RTL87x3EU drivers.
+* \details  Built once against each driver. The engine stand-in only finishes each run and logs
+*           the result layer address of it, fills done by PPE are not painted.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include "rtl_ppe.h"
+#include "host_regs.h"
+#include "test_common.h"
+
+#define FB_WIDTH            64
+#define FB_HEIGHT           32
+#define JOB_LOG_MAX         64
+#define SYS_REG_BASE        0x40000000UL    /* PPE_CLK_ENABLE writes the clock gates here */
+
+static uint32_t fb[FB_WIDTH * FB_HEIGHT];
+static volatile bool engine_running;
+static volatile uint32_t job_num;
+static uint32_t job_addr[JOB_LOG_MAX];
+
+static void *engine(void *arg)
+{
+    (void)arg;
+    while (engine_running)
+    {
+        uint32_t status = PPE->REG_GLB_STATUS;
+        if (status & 0x3)
+        {
+            if (job_num < JOB_LOG_MAX)
+            {
+                job_addr[job_num] = PPE_ResultLayer->REG_LYR0_ADDR;
+            }
+            job_num++;
+            PPE->REG_GLB_STATUS = status & ~0x3U;
+        }
+        sched_yield();
+    }
+    return NULL;
+}
+
+static void setup_dst(ppe_buffer_t *dst)
+{
+    memset(dst, 0, sizeof(ppe_buffer_t));
+    dst->address = (uint32_t)(uintptr_t)fb;
+    dst->width = FB_WIDTH;
+    dst->height = FB_HEIGHT;
+    dst->format = PPE_ARGB8888;
+    dst->opacity = 0xFF;
+    memset(fb, 0, sizeof(fb));
+    job_num = 0;
+}
+
+static ppe_fill_t make_fill(int x, int y, uint32_t w, uint32_t h, uint32_t color)
+{
+    ppe_fill_t fill = {.rect = {.x = x, .y = y, .w = w, .h = h}, .color = color};
+    return fill;
+}
+
+static uint32_t fb_addr(int x, int y)
+{
+    return (uint32_t)(uintptr_t)&fb[y * FB_WIDTH + x];
+}
+
+static void test_small_opaque_fills_are_cpu_stores(void)
+{
+    ppe_buffer_t dst;
+    ppe_fill_t fill[2] = {make_fill(0, 0, 4, 4, 0xFFFF0000), make_fill(4, 0, 4, 4, 0xFFFF0000)};
+    ppe_fill_t copy[2];
+    setup_dst(&dst);
+    memcpy(copy, fill, sizeof(fill));
+    CHECK(PPE_Mask_List(&dst, fill, 2) == PPE_SUCCESS);
+    CHECK(job_num == 0);
+    CHECK((fb[0] == 0xFFFF0000) && (fb[7] == 0xFFFF0000) && (fb[3 * FB_WIDTH + 7] == 0xFFFF0000));
+    CHECK((fb[8] == 0) && (fb[4 * FB_WIDTH] == 0));
+    CHECK(memcmp(copy, fill, sizeof(fill)) == 0);
+}
+
+static void test_adjacent_fills_merge_into_one_job(void)
+{
+    ppe_buffer_t dst;
+    ppe_fill_t fill[2] = {make_fill(0, 0, 20, 20, 0xFF00FF00), make_fill(20, 0, 20, 20, 0xFF00FF00)};
+    ppe_fill_t copy[2];
+    setup_dst(&dst);
+    memcpy(copy, fill, sizeof(fill));
+    CHECK(PPE_Mask_List(&dst, fill, 2) == PPE_SUCCESS);
+    CHECK(job_num == 1);
+    CHECK(job_addr[0] == fb_addr(0, 0));
+    CHECK(memcmp(copy, fill, sizeof(fill)) == 0);
+}
+
+static void test_overlap_in_between_blocks_merge(void)
+{
+    ppe_buffer_t dst;
+    ppe_fill_t fill[3] = {make_fill(0, 0, 20, 20, 0xFF00FF00), make_fill(10, 0, 20, 20, 0xFF0000FF),
+                          make_fill(20, 0, 20, 20, 0xFF00FF00)
+                         };
+    setup_dst(&dst);
+    CHECK(PPE_Mask_List(&dst, fill, 3) == PPE_SUCCESS);
+    CHECK(job_num == 3);
+    CHECK((job_addr[0] == fb_addr(0, 0)) && (job_addr[1] == fb_addr(10, 0)) &&
+          (job_addr[2] == fb_addr(20, 0)));
+}
+
+static void test_more_fills_than_one_batch(void)
+{
+    ppe_buffer_t dst;
+    ppe_fill_t fill[40];
+    setup_dst(&dst);
+    for (int i = 0; i < 40; i++)
+    {
+        fill[i] = make_fill(i, 0, 20, 20, (i & 1) ? 0xFF0000FF : 0xFF00FF00);
+    }
+    CHECK(PPE_Mask_List(&dst, fill, 40) == PPE_SUCCESS);
+    CHECK(job_num == 40);
+    for (int i = 0; i < 40; i++)
+    {
+        CHECK(job_addr[i] == fb_addr(i, 0));
+    }
+}
+
+static void test_translucent_fill_stays_on_ppe(void)
+{
+    ppe_buffer_t dst;
+    ppe_fill_t fill = make_fill(0, 0, 4, 4, 0x80FF0000);
+    setup_dst(&dst);
+    CHECK(PPE_Mask_List(&dst, &fill, 1) == PPE_SUCCESS);
+    CHECK(job_num == 1);
+    CHECK(fb[0] == 0);
+}
+
+int main(void)
+{
+    pthread_t thread;
+    if (!host_regs_map(SYS_REG_BASE, 0x1000) || !host_regs_map(PPE_REG_BASE, 0x1000))
+    {
+        printf("cannot map the register windows\n");
+        return 1;
+    }
+    engine_running = true;
+    pthread_create(&thread, NULL, engine, NULL);
+    RUN_TEST(test_small_opaque_fills_are_cpu_stores);
+    RUN_TEST(test_adjacent_fills_merge_into_one_job);
+    RUN_TEST(test_overlap_in_between_blocks_merge);
+    RUN_TEST(test_more_fills_than_one_batch);
+    RUN_TEST(test_translucent_fill_stays_on_ppe);
+    engine_running = false;
+    pthread_join(thread, NULL);
+    return TEST_RESULT();
+}
@@ -0,0 +1,115 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_ppe_orient.c
+* \brief    PPE_Blit_Orient coefficients shared by the RTL8773E and RTL87x3EU drivers.
+* \details  Built once against each driver's rtl_ppe.h.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include <string.h>
+#include "rtl_ppe.h"
+#include "rtl_ppe_orient.h"
+#include "test_common.h"
+
+#define IMAGE_W             3
+#define IMAGE_H             2
+
+/* source pixel of placed pixel (u, v) for a IMAGE_W x IMAGE_H image, written out per orientation */
+static void expected_source(PPE_ORIENT orient, int32_t u, int32_t v, int32_t *x, int32_t *y)
+{
+    switch (orient)
+    {
+    case PPE_ROTATE_90:
+        *x = v;
+        *y = IMAGE_H - 1 - u;
+        break;
+    case PPE_ROTATE_180:
+        *x = IMAGE_W - 1 - u;
+        *y = IMAGE_H - 1 - v;
+        break;
+    case PPE_ROTATE_270:
+        *x = IMAGE_W - 1 - v;
+        *y = u;
+        break;
+    case PPE_FLIP_H:
+        *x = IMAGE_W - 1 - u;
+        *y = v;
+        break;
+    case PPE_FLIP_V:
+        *x = u;
+        *y = IMAGE_H - 1 - v;
+        break;
+    default:
+        *x = u;
+        *y = v;
+        break;
+    }
+}
+
+/* pixel (i, j) of the drawn rect through the Q16.16 coefficients */
+static void apply(uint32_t *comp, int32_t i, int32_t j, int32_t *x, int32_t *y)
+{
+    int32_t sx = (int32_t)comp[0] * i + (int32_t)comp[1] * j + (int32_t)comp[2];
+    int32_t sy = (int32_t)comp[3] * i + (int32_t)comp[4] * j + (int32_t)comp[5];
+    *x = sx / (int32_t)PPE_FIXED_ONE;
+    *y = sy / (int32_t)PPE_FIXED_ONE;
+    CHECK((sx % (int32_t)PPE_FIXED_ONE == 0) && (sy % (int32_t)PPE_FIXED_ONE == 0));
+}
+
+static void check_orient(PPE_ORIENT orient, int32_t u0, int32_t v0)
+{
+    ppe_buffer_t image;
+    uint32_t comp[9];
+    bool swap = (orient == PPE_ROTATE_90) || (orient == PPE_ROTATE_270);
+    int32_t placed_w = swap ? IMAGE_H : IMAGE_W;
+    int32_t placed_h = swap ? IMAGE_W : IMAGE_H;
+
+    memset(&image, 0, sizeof(image));
+    image.width = IMAGE_W;
+    image.height = IMAGE_H;
+    ppe_orient_get_comp(orient, &image, u0, v0, comp);
+    CHECK((comp[6] == 0) && (comp[7] == 0) && (comp[8] == (uint32_t)PPE_FIXED_ONE));
+    for (int32_t v = v0; v < placed_h; v++)
+    {
+        for (int32_t u = u0; u < placed_w; u++)
+        {
+            int32_t x, y, ex, ey;
+            apply(comp, u - u0, v - v0, &x, &y);
+            expected_source(orient, u, v, &ex, &ey);
+            if ((x != ex) || (y != ey))
+            {
+                printf("orient %d (%d, %d): got (%d, %d), want (%d, %d)\n", orient, u, v, x, y, ex, ey);
+                test_failures++;
+            }
+        }
+    }
+}
+
+static void test_every_orient_from_origin(void)
+{
+    for (PPE_ORIENT orient = PPE_ROTATE_0; orient <= PPE_FLIP_V; orient++)
+    {
+        check_orient(orient, 0, 0);
+    }
+}
+
+static void test_every_orient_clipped(void)
+{
+    /* the first placed pixels fall off the target, drawing starts at (1, 1) */
+    for (PPE_ORIENT orient = PPE_ROTATE_0; orient <= PPE_FLIP_V; orient++)
+    {
+        check_orient(orient, 1, 1);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_every_orient_from_origin);
+    RUN_TEST(test_every_orient_clipped);
+    return TEST_RESULT();
+}
@@ -0,0 +1,147 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_ppe_quad.c
+* \brief    Transformed rect footprint helpers shared by the RTL8773E and RTL87x3EU drivers.
+* \details  Built once against each driver's rtl_ppe.h.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include "rtl_ppe.h"
+#include "rtl_ppe_quad.h"
+#include "test_common.h"
+
+#define NEAR(a, b)          (fabsf((a) - (b)) < 1e-4f)
+
+static ppe_matrix_t identity = {.m = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
+
+/* (5, 0) (10, 5) (5, 10) (0, 5) */
+static void diamond(ppe_pox_t *quad)
+{
+    static const float corner[4][2] = {{5, 0}, {10, 5}, {5, 10}, {0, 5}};
+    for (int i = 0; i < 4; i++)
+    {
+        quad[i].p[0] = corner[i][0];
+        quad[i].p[1] = corner[i][1];
+        quad[i].p[2] = 1.0f;
+    }
+}
+
+static void test_quad_of_translated_rect(void)
+{
+    ppe_matrix_t matrix = identity;
+    ppe_rect_t rect = {.x = 2, .y = 3, .w = 4, .h = 5};
+    ppe_pox_t quad[4];
+    matrix.m[0][2] = 10;
+    CHECK(ppe_get_quad(&matrix, &rect, quad));
+    CHECK(NEAR(quad[0].p[0], 12) && NEAR(quad[0].p[1], 3));
+    CHECK(NEAR(quad[1].p[0], 16) && NEAR(quad[1].p[1], 3));
+    CHECK(NEAR(quad[2].p[0], 16) && NEAR(quad[2].p[1], 8));
+    CHECK(NEAR(quad[3].p[0], 12) && NEAR(quad[3].p[1], 8));
+}
+
+static void test_quad_divides_by_w(void)
+{
+    ppe_matrix_t matrix = identity;
+    ppe_rect_t rect = {.x = 0, .y = 0, .w = 4, .h = 4};
+    ppe_pox_t quad[4];
+    matrix.m[2][2] = 2;
+    CHECK(ppe_get_quad(&matrix, &rect, quad));
+    CHECK(NEAR(quad[2].p[0], 2) && NEAR(quad[2].p[1], 2));
+}
+
+static void test_quad_behind_horizon(void)
+{
+    ppe_matrix_t matrix = identity;
+    ppe_rect_t rect = {.x = 0, .y = 0, .w = 4, .h = 4};
+    ppe_pox_t quad[4];
+    /* w = 1 - y / 2 reaches 0 on the bottom edge */
+    matrix.m[2][1] = -0.5f;
+    CHECK(!ppe_get_quad(&matrix, &rect, quad));
+}
+
+static void test_span_of_band(void)
+{
+    ppe_pox_t quad[4];
+    float x_min, x_max;
+    diamond(quad);
+    CHECK(ppe_quad_span(quad, 0, 1, &x_min, &x_max));
+    CHECK(NEAR(x_min, 4) && NEAR(x_max, 6));
+    CHECK(ppe_quad_span(quad, 4, 6, &x_min, &x_max));
+    CHECK(NEAR(x_min, 0) && NEAR(x_max, 10));
+    CHECK(!ppe_quad_span(quad, 11, 12, &x_min, &x_max));
+}
+
+static void test_band_narrowed_with_margin(void)
+{
+    ppe_pox_t quad[4];
+    ppe_rect_t area = {.x = 0, .y = 0, .w = 20, .h = 20};
+    ppe_rect_t band = {.x = 0, .y = 0, .w = 20, .h = 1};
+    diamond(quad);
+    /* lines -1 to 2 cover x 3 to 7, one more column on each side */
+    CHECK(ppe_blit_band_span(quad, &area, &band));
+    CHECK((band.x == 2) && (band.w == 6));
+}
+
+static void test_band_clipped_to_area(void)
+{
+    ppe_pox_t quad[4];
+    ppe_rect_t area = {.x = 4, .y = 0, .w = 2, .h = 20};
+    ppe_rect_t band = {.x = 4, .y = 0, .w = 2, .h = 1};
+    diamond(quad);
+    CHECK(ppe_blit_band_span(quad, &area, &band));
+    CHECK((band.x == 4) && (band.w == 2));
+    area.x = 12;
+    band.x = 12;
+    CHECK(!ppe_blit_band_span(quad, &area, &band));
+    band.y = 15;
+    area.x = 0;
+    CHECK(!ppe_blit_band_span(quad, &area, &band));
+}
+
+/* trapezoid with perspective terms that Q16.16 rounding of the forward matrix would move */
+static void test_cached_inverse_rounds_once(void)
+{
+    ppe_point4_t src = {{0, 0}, {299, 0}, {299, 299}, {0, 299}};
+    ppe_point4_t dst = {{40, 0}, {260, 0}, {299, 299}, {0, 299}};
+    ppe_matrix_t matrix;
+    ppe_matrix_t inverse;
+    ppe_matrix_fixed_t fixed;
+    CHECK(ppe_get_transform_matrix(src, dst, &matrix) == 0);
+    inverse = matrix;
+    ppe_matrix_inverse(&inverse);
+    CHECK(ppe_matrix_cache_get(&matrix, true, &fixed));
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            /* within one LSB plus the float reference's own error */
+            CHECK(fabs(fixed.m[i][j] - inverse.m[i][j] * 65536.0) <= 1.0 + fabs(inverse.m[i][j]) * 4);
+        }
+    }
+}
+
+static void test_singular_matrix_has_no_inverse(void)
+{
+    ppe_matrix_t matrix = {.m = {{1, 2, 0}, {2, 4, 0}, {0, 0, 1}}};
+    ppe_matrix_fixed_t fixed;
+    CHECK(!ppe_matrix_cache_get(&matrix, true, &fixed));
+    CHECK(!ppe_matrix_inverse_fixed(&matrix, &fixed));
+}
+
+int main(void)
+{
+    RUN_TEST(test_quad_of_translated_rect);
+    RUN_TEST(test_quad_divides_by_w);
+    RUN_TEST(test_quad_behind_horizon);
+    RUN_TEST(test_span_of_band);
+    RUN_TEST(test_band_narrowed_with_margin);
+    RUN_TEST(test_band_clipped_to_area);
+    RUN_TEST(test_cached_inverse_rounds_once);
+    RUN_TEST(test_singular_matrix_has_no_inverse);
+    return TEST_RESULT();
+}
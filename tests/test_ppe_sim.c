@@ -0,0 +1,168 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_ppe_sim.c
+* \brief    PPE model as the PPE_Cmd backend of the RTL8773E and RTL87x3EU drivers.
+* \details  Built once against each driver with PPE_SIM_BACKEND set, so every job is rendered by
+*           ppe_simulation.c. Fills are held against the CPU stores PPE_Mask_List does for small
+*           opaque rects, copies against the source pixels.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include <string.h>
+#include "rtl_ppe.h"
+#include "host_regs.h"
+#include "test_common.h"
+
+#define FB_WIDTH            16
+#define FB_HEIGHT           12
+#define IMAGE_WIDTH         5
+#define IMAGE_HEIGHT        3
+#define SYS_REG_BASE        0x40000000UL    /* PPE_CLK_ENABLE writes the clock gates here */
+
+/* RTL87x3EU sizes pixels in bits and takes a PPE_BLEND_METHOD */
+#ifdef PPE_BYTE_SIZE
+#define PIXEL_BYTES(format) (PPE_Get_Pixel_Size(format) / PPE_BYTE_SIZE)
+#define BLIT_SRC_OVER       PPE_BLEND_SRC_OVER
+#else
+#define PIXEL_BYTES(format) PPE_Get_Pixel_Size(format)
+#define BLIT_SRC_OVER       PPE_SRC_OVER_MODE
+#endif
+
+static uint32_t init_fb[FB_WIDTH * FB_HEIGHT];
+static uint32_t cpu_fb[FB_WIDTH * FB_HEIGHT];
+static uint32_t sim_fb[FB_WIDTH * FB_HEIGHT];
+static uint32_t image[IMAGE_WIDTH * IMAGE_HEIGHT];
+
+static void fill_random(uint32_t *pixels, uint32_t num, uint32_t seed)
+{
+    for (uint32_t i = 0; i < num; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        pixels[i] = seed ^ (seed >> 16);
+    }
+}
+
+static void setup_buffer(ppe_buffer_t *buffer, uint32_t *pixels, uint32_t width, uint32_t height,
+                         PPE_PIXEL_FORMAT format)
+{
+    memset(buffer, 0, sizeof(ppe_buffer_t));
+    buffer->address = (uint32_t)(uintptr_t)pixels;
+    buffer->width = width;
+    buffer->height = height;
+#ifdef PPE_BYTE_SIZE
+    buffer->stride = width;
+#endif
+    buffer->format = format;
+    buffer->opacity = 0xFF;
+    buffer->win_x_max = width;
+    buffer->win_y_max = height;
+}
+
+/* PPE_Mask_List stores fills up to PPE_MASK_SW_PIXELS itself, PPE_Mask always programs a job */
+static void check_mask(PPE_PIXEL_FORMAT format, ppe_rect_t rect, uint32_t color)
+{
+    ppe_buffer_t cpu, sim;
+    ppe_fill_t fill = {.rect = rect, .color = color};
+
+    memcpy(cpu_fb, init_fb, sizeof(init_fb));
+    memcpy(sim_fb, init_fb, sizeof(init_fb));
+    setup_buffer(&cpu, cpu_fb, FB_WIDTH, FB_HEIGHT, format);
+    setup_buffer(&sim, sim_fb, FB_WIDTH, FB_HEIGHT, format);
+
+    CHECK(PPE_Mask_List(&cpu, &fill, 1) == PPE_SUCCESS);
+    CHECK(PPE_Mask(&sim, color, &rect) == PPE_SUCCESS);
+    CHECK(memcmp(cpu_fb, init_fb, sizeof(init_fb)) != 0);
+    CHECK(memcmp(cpu_fb, sim_fb, sizeof(sim_fb)) == 0);
+}
+
+static void test_mask_matches_cpu_fill(void)
+{
+    ppe_rect_t rect = {.x = 3, .y = 2, .w = 7, .h = 5};
+    ppe_rect_t corner = {.x = 0, .y = FB_HEIGHT - 1, .w = FB_WIDTH, .h = 1};
+
+    check_mask(PPE_ARGB8888, rect, 0xFF12A4C8);
+    check_mask(PPE_ARGB8888, corner, 0xFF000000);
+    check_mask(PPE_RGB565, rect, 0xFF12A4C8);
+    check_mask(PPE_RGB565, corner, 0xFFFFFFFF);
+}
+
+static uint32_t image_pixel(uint32_t x, uint32_t y)
+{
+    return image[y * IMAGE_WIDTH + x];
+}
+
+/* opaque sources, the model has to place every source pixel unchanged */
+static void check_orient(PPE_ORIENT orient, int32_t x, int32_t y)
+{
+    ppe_buffer_t dst, src;
+    uint32_t bytes = PIXEL_BYTES(PPE_ARGB8888);
+
+    CHECK(bytes == 4);
+    for (uint32_t i = 0; i < IMAGE_WIDTH * IMAGE_HEIGHT; i++)
+    {
+        image[i] |= 0xFF000000;
+    }
+    memcpy(sim_fb, init_fb, sizeof(init_fb));
+    setup_buffer(&dst, sim_fb, FB_WIDTH, FB_HEIGHT, PPE_ARGB8888);
+    setup_buffer(&src, image, IMAGE_WIDTH, IMAGE_HEIGHT, PPE_ARGB8888);
+    src.win_x_max = IMAGE_WIDTH - 1;
+    src.win_y_max = IMAGE_HEIGHT - 1;
+    /* RTL87x3EU scales the layer alpha by const_color alpha too */
+    src.const_color = 0xFF000000;
+    CHECK(PPE_Blit_Orient(&dst, &src, x, y, orient, BLIT_SRC_OVER) == PPE_SUCCESS);
+
+    for (int32_t j = 0; j < FB_HEIGHT; j++)
+    {
+        for (int32_t i = 0; i < FB_WIDTH; i++)
+        {
+            int32_t u = i - x;
+            int32_t v = j - y;
+            uint32_t expect = init_fb[j * FB_WIDTH + i];
+            if ((u >= 0) && (u < IMAGE_WIDTH) && (v >= 0) && (v < IMAGE_HEIGHT))
+            {
+                expect = (orient == PPE_ROTATE_0) ? image_pixel(u, v) :
+                         (orient == PPE_ROTATE_180) ? image_pixel(IMAGE_WIDTH - 1 - u, IMAGE_HEIGHT - 1 - v) :
+                         image_pixel(IMAGE_WIDTH - 1 - u, v);
+            }
+            CHECK(sim_fb[j * FB_WIDTH + i] == expect);
+        }
+    }
+}
+
+static void test_orient_places_source_pixels(void)
+{
+    check_orient(PPE_ROTATE_0, 4, 3);
+    check_orient(PPE_ROTATE_180, 1, 6);
+    check_orient(PPE_FLIP_H, FB_WIDTH - IMAGE_WIDTH, 0);
+}
+
+static void test_job_end_state(void)
+{
+    ppe_buffer_t sim;
+    ppe_rect_t rect = {.x = 1, .y = 1, .w = 4, .h = 4};
+
+    setup_buffer(&sim, sim_fb, FB_WIDTH, FB_HEIGHT, PPE_ARGB8888);
+    CHECK(PPE_Mask(&sim, 0x80FF0000, &rect) == PPE_SUCCESS);
+    CHECK((PPE->REG_GLB_STATUS & 0x3) == 0);
+}
+
+int main(void)
+{
+    if (!host_regs_map(SYS_REG_BASE, 0x1000) || !host_regs_map(PPE_REG_BASE, 0x1000))
+    {
+        printf("cannot map the PPE registers\n");
+        return 1;
+    }
+    fill_random(init_fb, FB_WIDTH * FB_HEIGHT, 1);
+    fill_random(image, IMAGE_WIDTH * IMAGE_HEIGHT, 2);
+
+    RUN_TEST(test_mask_matches_cpu_fill);
+    RUN_TEST(test_orient_places_source_pixels);
+    RUN_TEST(test_job_end_state);
+    return TEST_RESULT();
+}
@@ -0,0 +1,215 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_ppe_sim_87x2g.c
+* \brief    RTL87x2G PPE model as the PPE_Cmd backend against the driver's CPU kernels.
+* \details  Every case runs the same call twice from the same target contents, once under the
+*           software threshold so the CPU kernel draws it and once with the threshold at 0 so the
+*           job is programmed into the registers and rendered by ppe_simulation.c. Formats are
+*           picked off the CPU fast paths, which round differently from the engine.
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include <string.h>
+#include "rtl_ppe.h"
+#include "host_regs.h"
+#include "ppe_simulation.h"
+#include "test_common.h"
+
+#define W                   7
+#define H                   5
+#define STRIDE              9
+
+static uint32_t src_pixels[STRIDE * H];
+static uint32_t cpu_pixels[STRIDE * H];
+static uint32_t sim_pixels[STRIDE * H];
+static uint32_t init_pixels[STRIDE * H];
+
+static void setup_buffer(ppe_buffer_t *buffer, uint32_t *pixels, PPE_PIXEL_FORMAT format)
+{
+    memset(buffer, 0, sizeof(ppe_buffer_t));
+    buffer->memory = pixels;
+    buffer->address = (uint32_t)(uintptr_t)pixels;
+    buffer->format = format;
+    buffer->width = W;
+    buffer->height = H;
+    buffer->stride = STRIDE;
+}
+
+static void fill_random(uint32_t *pixels, uint32_t seed)
+{
+    for (uint32_t i = 0; i < STRIDE * H; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        pixels[i] = seed ^ (seed >> 16);
+    }
+}
+
+/* target contents before the call, for both runs */
+static void reset_targets(void)
+{
+    memcpy(cpu_pixels, init_pixels, sizeof(init_pixels));
+    memcpy(sim_pixels, init_pixels, sizeof(init_pixels));
+}
+
+static void check_blend(PPE_PIXEL_FORMAT src_format, PPE_PIXEL_FORMAT dst_format, PPE_BLEND_MODE mode,
+                        bool global_alpha_en, bool key_en)
+{
+    ppe_buffer_t image, cpu, sim;
+    ppe_translate_t trans = {1, 1};
+    ppe_rect_t rect = {.left = 0, .top = 0, .right = W - 1, .bottom = H - 1};
+
+    setup_buffer(&image, src_pixels, src_format);
+    image.width = W - 2;
+    image.global_alpha_en = global_alpha_en;
+    image.global_alpha = 0x9A;
+    image.color_key_en = key_en;
+    /* key the raw value of source pixel (2, 1) */
+    memcpy(&image.color_key_value, (uint8_t *)src_pixels + (STRIDE + 2) * ppe_get_format_data_len(src_format),
+           ppe_get_format_data_len(src_format));
+    setup_buffer(&cpu, cpu_pixels, dst_format);
+    setup_buffer(&sim, sim_pixels, dst_format);
+    reset_targets();
+
+    PPE_SetSoftwareThreshold(0xFFFFFFFF);
+    CHECK(PPE_blend_rect(&image, &cpu, &trans, &rect, mode) == PPE_SUCCESS);
+    PPE_SetSoftwareThreshold(0);
+    CHECK(PPE_blend_rect(&image, &sim, &trans, &rect, mode) == PPE_SUCCESS);
+    CHECK(memcmp(cpu_pixels, sim_pixels, sizeof(cpu_pixels)) == 0);
+    CHECK(memcmp(cpu_pixels, init_pixels, sizeof(cpu_pixels)) != 0);
+}
+
+static void test_blend_src_over(void)
+{
+    check_blend(PPE_ARGB8888, PPE_RGB888, PPE_SRC_OVER_MODE, false, false);
+    check_blend(PPE_ARGB8888, PPE_ABGR4444, PPE_SRC_OVER_MODE, true, false);
+    check_blend(PPE_ARGB4444, PPE_RGB565, PPE_SRC_OVER_MODE, true, false);
+    check_blend(PPE_BGRA5658, PPE_ARGB8666, PPE_SRC_OVER_MODE, false, false);
+}
+
+static void test_blend_color_key(void)
+{
+    check_blend(PPE_ARGB8888, PPE_RGB888, PPE_SRC_OVER_MODE, false, true);
+    check_blend(PPE_RGB565, PPE_ARGB1555, PPE_SRC_OVER_MODE, true, true);
+}
+
+static void test_blend_bypass(void)
+{
+    check_blend(PPE_XRGB8888, PPE_RGB565, PPE_BYPASS_MODE, false, false);
+    check_blend(PPE_RGB888, PPE_ABGR8888, PPE_BYPASS_MODE, false, true);
+}
+
+static void check_clear(PPE_PIXEL_FORMAT format, uint32_t color)
+{
+    ppe_buffer_t cpu, sim;
+    ppe_rect_t rect = {.left = 2, .top = 1, .right = W + 3, .bottom = 3};
+
+    setup_buffer(&cpu, cpu_pixels, format);
+    setup_buffer(&sim, sim_pixels, format);
+    reset_targets();
+
+    PPE_SetSoftwareThreshold(0xFFFFFFFF);
+    CHECK(PPE_Clear_Rect(&cpu, &rect, color) == PPE_SUCCESS);
+    PPE_SetSoftwareThreshold(0);
+    CHECK(PPE_Clear_Rect(&sim, &rect, color) == PPE_SUCCESS);
+    CHECK(memcmp(cpu_pixels, sim_pixels, sizeof(cpu_pixels)) == 0);
+    CHECK(memcmp(cpu_pixels, init_pixels, sizeof(cpu_pixels)) != 0);
+}
+
+static void test_clear_rect(void)
+{
+    check_clear(PPE_ARGB8888, 0xFF12A4C8);
+    check_clear(PPE_RGB565, 0xFF12A4C8);
+    check_clear(PPE_ARGB8888, 0x6012A4C8);
+    check_clear(PPE_RGBA5658, 0xC0F0400A);
+}
+
+/* two translucent fills share one run, the second one is fetched from the LLI node */
+static void test_cmdlist_lli(void)
+{
+    static ppe_cmd_t cmd[4];
+    ppe_cmdlist_t list;
+    ppe_buffer_t cpu, sim;
+    ppe_rect_t rect1 = {.left = 0, .top = 0, .right = 4, .bottom = 2};
+    ppe_rect_t rect2 = {.left = 3, .top = 1, .right = 6, .bottom = 4};
+
+    setup_buffer(&cpu, cpu_pixels, PPE_RGB888);
+    setup_buffer(&sim, sim_pixels, PPE_RGB888);
+    reset_targets();
+
+    PPE_SetSoftwareThreshold(0xFFFFFFFF);
+    CHECK(PPE_Clear_Rect(&cpu, &rect1, 0x80FF0000) == PPE_SUCCESS);
+    CHECK(PPE_Clear_Rect(&cpu, &rect2, 0x4000FF80) == PPE_SUCCESS);
+
+    PPE_CmdList_Init(&list, cmd, 4);
+    CHECK(PPE_CmdList_Clear_Rect(&list, &sim, &rect1, 0x80FF0000) == PPE_SUCCESS);
+    CHECK(PPE_CmdList_Clear_Rect(&list, &sim, &rect2, 0x4000FF80) == PPE_SUCCESS);
+    CHECK(PPE_CmdList_Submit(&list) == PPE_SUCCESS);
+    CHECK(list.run_num == 1);
+    CHECK(memcmp(cpu_pixels, sim_pixels, sizeof(cpu_pixels)) == 0);
+}
+
+/* 2x up is pixel doubling, there is no CPU scaler to hold it against */
+static void test_scale_nearest(void)
+{
+    static const uint32_t image_words[2] = {0xF8001234, 0x001F07E0};
+    static uint32_t out_words[8];
+    const uint16_t *image_pixels = (const uint16_t *)image_words;
+    uint16_t *out = (uint16_t *)out_words;
+    ppe_buffer_t image, buffer;
+
+    memset(&image, 0, sizeof(image));
+    image.memory = (uint32_t *)image_words;
+    image.address = (uint32_t)(uintptr_t)image_words;
+    image.format = PPE_RGB565;
+    image.width = 2;
+    image.height = 2;
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.memory = out_words;
+    buffer.address = (uint32_t)(uintptr_t)out_words;
+    buffer.format = PPE_RGB565;
+
+    CHECK(PPE_Scale(&image, &buffer, 2, 2) == PPE_SUCCESS);
+    CHECK((buffer.width == 4) && (buffer.height == 4));
+    for (uint32_t y = 0; y < 4; y++)
+    {
+        for (uint32_t x = 0; x < 4; x++)
+        {
+            CHECK(out[y * 4 + x] == image_pixels[(y / 2) * 2 + x / 2]);
+        }
+    }
+}
+
+static void test_job_end_registers(void)
+{
+    CHECK((PPE->GLB_CTL & BIT0) == 0);
+    CHECK(PPE_GetINTStatusRaw(PPE_ALL_OVER_INT) == SET);
+    PPE_ClearINTPendingBit(PPE_ALL_OVER_INT);
+    check_clear(PPE_ARGB8888, 0x6012A4C8);
+    CHECK(PPE_GetINTStatusRaw(PPE_ALL_OVER_INT) == SET);
+    CHECK(PPE->INTR_CLR == 0);
+}
+
+int main(void)
+{
+    if (!host_regs_map(PPE_CFG_REG_BASE, 0x1000))
+    {
+        printf("cannot map the PPE registers\n");
+        return 1;
+    }
+    fill_random(src_pixels, 1);
+    fill_random(init_pixels, 2);
+
+    RUN_TEST(test_blend_src_over);
+    RUN_TEST(test_blend_color_key);
+    RUN_TEST(test_blend_bypass);
+    RUN_TEST(test_clear_rect);
+    RUN_TEST(test_cmdlist_lli);
+    RUN_TEST(test_scale_nearest);
+    RUN_TEST(test_job_end_registers);
+    return TEST_RESULT();
+}
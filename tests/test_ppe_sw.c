@@ -0,0 +1,126 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+*********************************************************************************************************
+* \file     test_ppe_sw.c
+* \brief    RTL87x2G CPU kernels and the CPU/PPE dispatch against the register-level stand-in.
+* \details
+* \author
+* \date     2024-06-28
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#include <string.h>
+#include "rtl_ppe.h"
+#include "host_ppe.h"
+#include "test_common.h"
+
+static uint32_t src_pixels[4 * 4];
+static uint32_t dst_pixels[4 * 4];
+
+static void setup_buffer(ppe_buffer_t *buffer, uint32_t *pixels, PPE_PIXEL_FORMAT format)
+{
+    memset(buffer, 0, sizeof(ppe_buffer_t));
+    buffer->memory = pixels;
+    buffer->address = (uint32_t)(uintptr_t)pixels;
+    buffer->format = format;
+    buffer->width = 4;
+    buffer->height = 4;
+}
+
+static void fill(uint32_t *pixels, uint32_t value)
+{
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        pixels[i] = value;
+    }
+}
+
+static void test_bypass_with_alpha_source_stays_on_ppe(void)
+{
+    ppe_buffer_t image, target;
+    ppe_translate_t trans = {0, 0};
+    ppe_rect_t rect = {.left = 0, .top = 0, .right = 3, .bottom = 3};
+    setup_buffer(&image, src_pixels, PPE_ARGB8888);
+    setup_buffer(&target, dst_pixels, PPE_ARGB8888);
+    fill(src_pixels, 0x80FF0000);
+    uint32_t runs = host_ppe_runs();
+    CHECK(PPE_blend_rect(&image, &target, &trans, &rect, PPE_BYPASS_MODE) == PPE_SUCCESS);
+    CHECK(host_ppe_runs() == runs + 1);
+}
+
+static void test_bypass_with_opaque_source_runs_on_cpu(void)
+{
+    ppe_buffer_t image, target;
+    ppe_translate_t trans = {0, 0};
+    ppe_rect_t rect = {.left = 0, .top = 0, .right = 3, .bottom = 3};
+    setup_buffer(&image, src_pixels, PPE_XRGB8888);
+    setup_buffer(&target, dst_pixels, PPE_ARGB8888);
+    fill(src_pixels, 0x00123456);
+    fill(dst_pixels, 0);
+    uint32_t runs = host_ppe_runs();
+    CHECK(PPE_blend_rect(&image, &target, &trans, &rect, PPE_BYPASS_MODE) == PPE_SUCCESS);
+    CHECK(host_ppe_runs() == runs);
+    CHECK(dst_pixels[0] == 0xFF123456);
+    CHECK(dst_pixels[15] == 0xFF123456);
+}
+
+static void test_cpu_bypass_scales_by_alpha(void)
+{
+    ppe_buffer_t image, target;
+    ppe_translate_t trans = {0, 0};
+    setup_buffer(&image, src_pixels, PPE_ARGB8888);
+    setup_buffer(&target, dst_pixels, PPE_ARGB8888);
+    fill(src_pixels, 0x80FF0000);
+    fill(dst_pixels, 0xFFFFFFFF);
+    src_pixels[6] = 0xFF00FF00;
+    src_pixels[5] = 0x00FFFFFF;
+    CHECK(PPE_Blit_Orient(&image, &target, &trans, PPE_FLIP_H, PPE_BYPASS_MODE) == PPE_SUCCESS);
+    CHECK(dst_pixels[0] == 0x80800000);
+    CHECK(dst_pixels[5] == 0xFF00FF00);
+    CHECK(dst_pixels[6] == 0x00000000);
+}
+
+static void test_convert_unaligned_a8_is_unknown_format(void)
+{
+    ppe_buffer_t image, target;
+    setup_buffer(&image, src_pixels, PPE_A8);
+    setup_buffer(&target, dst_pixels, PPE_ARGB8888);
+    image.memory = (uint32_t *)((uint8_t *)src_pixels + 1);
+    image.address = (uint32_t)(uintptr_t)image.memory;
+    CHECK(ppe_convert(&image, &target, PPE_DITHER_NONE) == PPE_ERROR_UNKNOWN_FORMAT);
+}
+
+static void test_convert_unaligned_runs_on_cpu(void)
+{
+    ppe_buffer_t image, target;
+    setup_buffer(&image, src_pixels, PPE_ARGB8888);
+    setup_buffer(&target, dst_pixels, PPE_RGB565);
+    target.memory = (uint32_t *)((uint8_t *)dst_pixels + 2);
+    target.address = (uint32_t)(uintptr_t)target.memory;
+    fill(src_pixels, 0xFFFF0000);
+    fill(dst_pixels, 0);
+    uint32_t runs = host_ppe_runs();
+    CHECK(ppe_convert(&image, &target, PPE_DITHER_NONE) == PPE_SUCCESS);
+    CHECK(host_ppe_runs() == runs);
+    CHECK(((uint16_t *)target.memory)[0] == 0xF800);
+    CHECK(((uint16_t *)target.memory)[15] == 0xF800);
+}
+
+int main(void)
+{
+    if (!host_ppe_start(PPE_JobIRQHandler))
+    {
+        printf("cannot map the PPE register window\n");
+        return 1;
+    }
+    PPE_SetSoftwareThreshold(PPE_SW_THRESHOLD_PIXELS);
+    RUN_TEST(test_bypass_with_alpha_source_stays_on_ppe);
+    RUN_TEST(test_bypass_with_opaque_source_runs_on_cpu);
+    RUN_TEST(test_cpu_bypass_scales_by_alpha);
+    RUN_TEST(test_convert_unaligned_a8_is_unknown_format);
+    RUN_TEST(test_convert_unaligned_runs_on_cpu);
+    host_ppe_stop();
+    return TEST_RESULT();
+}
@@ -0,0 +1,39 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+**********************************************************************************************************
+* \file     rtl_idu_def.h
+* \brief    Host stand-in for the device rtl_idu_def.h, enough to build rtl_idu_sw.c into the tool.
+* \details  Without RTL87x3EU, pixel_bytes follows the RTL87x2G/RTL8773E encoding.
+* \author
+* \date     2024-06-24
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+#ifndef RTL_IDU_DEF_H
+#define RTL_IDU_DEF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef BIT
+#define BIT(x)      (1U << (x))
+#endif
+#define __I         volatile const
+#define __IO        volatile
+
+typedef enum
+{
+    DISABLE = 0,
+    ENABLE = !DISABLE
+} FunctionalState;
+
+typedef enum
+{
+    RESET = 0,
+    SET = !RESET
+} FlagStatus, ITStatus;
+
+#endif /* RTL_IDU_DEF_H */
@@ -0,0 +1,1153 @@
+/**
+*********************************************************************************************************
+*               Copyright(c) 2024, Realtek Semiconductor Corporation. All rights reserved.
+**********************************************************************************************************
+* \file     idu_encoder.c
+* \brief    Host tool that encodes images into IDU compressed files and packs them.
+* \details  Output layout, as read by IDU_Decode and IDU_Get_Line_Start_Address:
+*           - 12 byte IDU_file_header (algorithm_type byte, 3 reserved, width, height)
+*           - (height + 1) uint32 offsets from the file start, entry height is the file size
+*           - line payloads back to back, each line encoded on its own and zero padded to
+*             4 bytes, the driver fetches lines by word DMA with THROW_AWAY_0BYTE
+*           Line payloads:
+*           - RLE: nodes of {run count (pic_length1_size bytes, LE), pixel}
+*           - FASTLZ: one FastLZ level 1 block per line
+*           - YUV_SAMPLE_BLUR: BT.601 YUV groups (444: Y U V, 422: Y0 Y1 U V,
+*             411: Y0 Y1 Y2 Y3 U V), each component with the blur bits dropped and
+*             packed MSB first, line padded to a byte
+*           - YUV_SAMPLE_BLUR_FASTLZ: the YUV line above as a FastLZ level 1 block
+*           The YUV layouts are experimental: they are not verified against the IDU, so they
+*           are only tried with --experimental-yuv.
+*           Pixels are little endian: RGB565 as uint16, RGB888 as B G R, ARGB8888 as B G R A.
+*           --bench decodes every candidate again with IDU_Decode_SW from the driver, checks it
+*           byte for byte against the reference decode above on the full picture and on random
+*           IDU_decode_range windows, and reports MPix/s per algorithm. Both decoders follow
+*           this tool's reading of the format, neither is checked against the IDU itself.
+* \author
+* \date     2024-06-20
+* \version  v1.0
+*********************************************************************************************************
+*/
+
+/*============================================================================*
+ *                        Header Files
+ *============================================================================*/
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rtl_idu.h"
+
+/*============================================================================*
+ *                           Defines
+ *============================================================================*/
+#define IDU_HEADER_SIZE             12
+#define IDU_LINE_ALIGN              4
+
+#define FASTLZ_MAX_COPY             32
+#define FASTLZ_MAX_LEN              264
+#define FASTLZ_MAX_DISTANCE         8192
+#define FASTLZ_HASH_LOG             13
+
+/* relative decode cost model, in IDU cycles */
+#define COST_LINE                   16
+#define COST_RX_WORD                1
+#define COST_TX_WORD                1
+#define COST_RLE_NODE               1
+#define COST_FASTLZ_TOKEN           2
+#define COST_YUV_GROUP              1
+
+#define PACK_MAGIC                  0x50554449  /* "IDUP" */
+#define PACK_NAME_LEN               16
+
+#define BENCH_WINDOWS               32
+#define BENCH_MIN_CLOCKS            (CLOCKS_PER_SEC / 5)
+
+typedef enum
+{
+    POLICY_SIZE,
+    POLICY_SPEED,
+} encode_policy;
+
+typedef struct
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;               /* bytes per pixel, 2/3/4 */
+    uint8_t *data;
+} image_t;
+
+typedef struct
+{
+    uint8_t algorithm;
+    uint8_t feature_1;          /* RLE: run count bytes, YUV: sample type */
+    uint8_t feature_2;          /* YUV: blur bit code */
+} encode_cfg_t;
+
+typedef struct
+{
+    uint8_t *data;
+    uint32_t size;
+    uint32_t capacity;
+} bytes_t;
+
+typedef struct
+{
+    encode_cfg_t cfg;
+    bytes_t file;
+    uint64_t cost;
+    uint32_t max_error;
+    bool valid;
+} candidate_t;
+
+typedef struct
+{
+    uint32_t bpp;
+    encode_policy policy;
+    bool experimental_yuv;
+    uint32_t max_error;
+    int family;                 /* -1 for all, else IDU algorithm */
+    bool rtl87x3eu;
+    bool verbose;
+    bool bench;
+    const char *raw_size;
+    const char *out_dir;
+    const char *pack;
+} encode_option_t;
+
+typedef struct
+{
+    double pixels;
+    double seconds;
+} bench_stat_t;
+
+static const uint8_t yuv_blur_bits[4] = {0, 1, 2, 4};
+static const uint8_t yuv_group_pixels[3] = {1, 2, 4};
+static const char *algorithm_name[4] = {"rle", "fastlz", "yuv-fastlz", "yuv"};
+
+/*============================================================================*
+ *                           Byte buffer
+ *============================================================================*/
+static void bytes_reserve(bytes_t *b, uint32_t extra)
+{
+    if (b->size + extra <= b->capacity)
+    {
+        return;
+    }
+    uint32_t capacity = b->capacity ? b->capacity : 256;
+    while (capacity < b->size + extra)
+    {
+        capacity *= 2;
+    }
+    b->data = realloc(b->data, capacity);
+    if (b->data == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    b->capacity = capacity;
+}
+
+static void bytes_put(bytes_t *b, const void *src, uint32_t len)
+{
+    bytes_reserve(b, len);
+    memcpy(b->data + b->size, src, len);
+    b->size += len;
+}
+
+static void bytes_put_u8(bytes_t *b, uint8_t v)
+{
+    bytes_put(b, &v, 1);
+}
+
+static void bytes_put_le(bytes_t *b, uint32_t v, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        bytes_put_u8(b, (uint8_t)(v >> (8 * i)));
+    }
+}
+
+static uint32_t read_le(const uint8_t *p, uint32_t len)
+{
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        v |= (uint32_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+/*============================================================================*
+ *                           Pixel helpers
+ *============================================================================*/
+static void pixel_to_rgba(const uint8_t *p, uint32_t bpp, uint8_t *rgba)
+{
+    if (bpp == 2)
+    {
+        uint32_t v = read_le(p, 2);
+        rgba[0] = (uint8_t)(((v >> 11) & 0x1F) * 255 / 31);
+        rgba[1] = (uint8_t)(((v >> 5) & 0x3F) * 255 / 63);
+        rgba[2] = (uint8_t)((v & 0x1F) * 255 / 31);
+        rgba[3] = 0xFF;
+    }
+    else
+    {
+        rgba[0] = p[2];
+        rgba[1] = p[1];
+        rgba[2] = p[0];
+        rgba[3] = (bpp == 4) ? p[3] : 0xFF;
+    }
+}
+
+static void rgba_to_pixel(const uint8_t *rgba, uint32_t bpp, uint8_t *p)
+{
+    if (bpp == 2)
+    {
+        uint32_t v = ((rgba[0] >> 3) << 11) | ((rgba[1] >> 2) << 5) | (rgba[2] >> 3);
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+    }
+    else
+    {
+        p[0] = rgba[2];
+        p[1] = rgba[1];
+        p[2] = rgba[0];
+        if (bpp == 4)
+        {
+            p[3] = rgba[3];
+        }
+    }
+}
+
+static uint8_t clamp_u8(int32_t v)
+{
+    return (uint8_t)((v < 0) ? 0 : ((v > 255) ? 255 : v));
+}
+
+static void rgb_to_yuv(const uint8_t *rgb, int32_t *yuv)
+{
+    int32_t r = rgb[0], g = rgb[1], b = rgb[2];
+    yuv[0] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+    yuv[1] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+    yuv[2] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+static void yuv_to_rgb(int32_t y, int32_t u, int32_t v, uint8_t *rgb)
+{
+    int32_t c = y - 16, d = u - 128, e = v - 128;
+    rgb[0] = clamp_u8((298 * c + 409 * e + 128) >> 8);
+    rgb[1] = clamp_u8((298 * c - 100 * d - 208 * e + 128) >> 8);
+    rgb[2] = clamp_u8((298 * c + 516 * d + 128) >> 8);
+}
+
+/*============================================================================*
+ *                           FastLZ level 1
+ *============================================================================*/
+static uint32_t fastlz_hash(const uint8_t *p)
+{
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (v * 2654435769u) >> (32 - FASTLZ_HASH_LOG);
+}
+
+static void fastlz_literals(bytes_t *out, const uint8_t *src, uint32_t len, uint32_t *tokens)
+{
+    while (len)
+    {
+        uint32_t run = (len > FASTLZ_MAX_COPY) ? FASTLZ_MAX_COPY : len;
+        bytes_put_u8(out, (uint8_t)(run - 1));
+        bytes_put(out, src, run);
+        src += run;
+        len -= run;
+        (*tokens)++;
+    }
+}
+
+/* Returns the number of tokens written; the first token is always a literal run. */
+static uint32_t fastlz_compress(bytes_t *out, const uint8_t *src, uint32_t len)
+{
+    static uint32_t table[1 << FASTLZ_HASH_LOG];
+    uint32_t tokens = 0;
+    uint32_t anchor = 0;
+    uint32_t ip = 1;
+
+    for (uint32_t i = 0; i < (1u << FASTLZ_HASH_LOG); i++)
+    {
+        table[i] = 0;
+    }
+    while (len >= 4 && ip + 3 <= len)
+    {
+        uint32_t h = fastlz_hash(src + ip);
+        uint32_t ref = table[h];
+        table[h] = ip;
+        uint32_t distance = ip - ref;
+        if (ref >= ip || distance > FASTLZ_MAX_DISTANCE || memcmp(src + ref, src + ip, 3) != 0)
+        {
+            ip++;
+            continue;
+        }
+        uint32_t match = 3;
+        while (ip + match < len && match < FASTLZ_MAX_LEN && src[ref + match] == src[ip + match])
+        {
+            match++;
+        }
+        fastlz_literals(out, src + anchor, ip - anchor, &tokens);
+        uint32_t ofs = distance - 1;
+        if (match <= 8)
+        {
+            bytes_put_u8(out, (uint8_t)(((match - 2) << 5) | (ofs >> 8)));
+        }
+        else
+        {
+            bytes_put_u8(out, (uint8_t)((7 << 5) | (ofs >> 8)));
+            bytes_put_u8(out, (uint8_t)(match - 9));
+        }
+        bytes_put_u8(out, (uint8_t)ofs);
+        tokens++;
+        ip += match;
+        anchor = ip;
+    }
+    fastlz_literals(out, src + anchor, len - anchor, &tokens);
+    return tokens;
+}
+
+static bool fastlz_decompress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t out_len)
+{
+    uint32_t ip = 0, op = 0;
+    if (len == 0)
+    {
+        return out_len == 0;
+    }
+    uint32_t ctrl = src[ip++] & 31;
+    while (true)
+    {
+        if (ctrl >= 32)
+        {
+            uint32_t match = (ctrl >> 5) - 1;
+            uint32_t ofs = (ctrl & 31) << 8;
+            if (match == 6)
+            {
+                if (ip >= len)
+                {
+                    return false;
+                }
+                match += src[ip++];
+            }
+            if (ip >= len)
+            {
+                return false;
+            }
+            ofs += src[ip++];
+            match += 3;
+            if (ofs + 1 > op || op + match > out_len)
+            {
+                return false;
+            }
+            for (uint32_t i = 0; i < match; i++, op++)
+            {
+                dst[op] = dst[op - ofs - 1];
+            }
+        }
+        else
+        {
+            ctrl++;
+            if (ip + ctrl > len || op + ctrl > out_len)
+            {
+                return false;
+            }
+            memcpy(dst + op, src + ip, ctrl);
+            ip += ctrl;
+            op += ctrl;
+        }
+        if ((op == out_len) || (ip + 2 > len))
+        {
+            break;
+        }
+        ctrl = src[ip++];
+    }
+    return (len - ip < IDU_LINE_ALIGN) && (op == out_len);
+}
+
+/*============================================================================*
+ *                           Line encoders
+ *============================================================================*/
+static uint64_t rle_encode_line(bytes_t *out, const uint8_t *line, uint32_t width, uint32_t bpp,
+                                uint32_t count_bytes)
+{
+    uint32_t max_run = (count_bytes == 1) ? 0xFF : 0xFFFF;
+    uint64_t nodes = 0;
+    uint32_t x = 0;
+    while (x < width)
+    {
+        uint32_t run = 1;
+        while (x + run < width && run < max_run &&
+               memcmp(line + x * bpp, line + (x + run) * bpp, bpp) == 0)
+        {
+            run++;
+        }
+        bytes_put_le(out, run, count_bytes);
+        bytes_put(out, line + x * bpp, bpp);
+        x += run;
+        nodes++;
+    }
+    return nodes * COST_RLE_NODE;
+}
+
+static uint64_t yuv_pack_line(bytes_t *out, const uint8_t *line, uint32_t width, uint32_t bpp,
+                              uint32_t sample, uint32_t blur)
+{
+    uint32_t group = yuv_group_pixels[sample];
+    uint32_t bits = 8 - yuv_blur_bits[blur];
+    uint32_t acc = 0, acc_bits = 0;
+    uint64_t groups = 0;
+    for (uint32_t x = 0; x < width; x += group)
+    {
+        int32_t comp[6];
+        int32_t u = 0, v = 0;
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < group; i++)
+        {
+            uint32_t px = (x + i < width) ? (x + i) : (width - 1);
+            uint8_t rgba[4];
+            int32_t yuv[3];
+            pixel_to_rgba(line + px * bpp, bpp, rgba);
+            rgb_to_yuv(rgba, yuv);
+            comp[n++] = yuv[0];
+            u += yuv[1];
+            v += yuv[2];
+        }
+        comp[n++] = (u + group / 2) / group;
+        comp[n++] = (v + group / 2) / group;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            acc = (acc << bits) | ((uint32_t)clamp_u8(comp[i]) >> (8 - bits));
+            acc_bits += bits;
+            while (acc_bits >= 8)
+            {
+                acc_bits -= 8;
+                bytes_put_u8(out, (uint8_t)(acc >> acc_bits));
+            }
+        }
+        groups++;
+    }
+    if (acc_bits)
+    {
+        bytes_put_u8(out, (uint8_t)(acc << (8 - acc_bits)));
+    }
+    return groups * COST_YUV_GROUP;
+}
+
+static bool yuv_unpack_line(const uint8_t *src, uint32_t len, uint8_t *line, uint32_t width,
+                            uint32_t bpp, uint32_t sample, uint32_t blur)
+{
+    uint32_t group = yuv_group_pixels[sample];
+    uint32_t drop = yuv_blur_bits[blur];
+    uint32_t bits = 8 - drop;
+    uint32_t acc = 0, acc_bits = 0, ip = 0;
+    for (uint32_t x = 0; x < width; x += group)
+    {
+        int32_t comp[6];
+        for (uint32_t i = 0; i < group + 2; i++)
+        {
+            while (acc_bits < bits)
+            {
+                if (ip >= len)
+                {
+                    return false;
+                }
+                acc = (acc << 8) | src[ip++];
+                acc_bits += 8;
+            }
+            acc_bits -= bits;
+            uint32_t q = (acc >> acc_bits) & ((1u << bits) - 1);
+            comp[i] = (int32_t)((q << drop) | (drop ? (1u << (drop - 1)) : 0));
+        }
+        for (uint32_t i = 0; i < group && x + i < width; i++)
+        {
+            uint8_t rgba[4] = {0, 0, 0, 0xFF};
+            yuv_to_rgb(comp[i], comp[group], comp[group + 1], rgba);
+            rgba_to_pixel(rgba, bpp, line + (x + i) * bpp);
+        }
+    }
+    return len - ip < IDU_LINE_ALIGN;
+}
+
+static bool rle_decode_line(const uint8_t *src, uint32_t len, uint8_t *line, uint32_t width,
+                            uint32_t bpp, uint32_t count_bytes)
+{
+    uint32_t ip = 0, x = 0;
+    while ((x < width) && (ip + count_bytes + bpp <= len))
+    {
+        uint32_t run = read_le(src + ip, count_bytes);
+        ip += count_bytes;
+        if (run == 0 || x + run > width)
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < run; i++, x++)
+        {
+            memcpy(line + x * bpp, src + ip, bpp);
+        }
+        ip += bpp;
+    }
+    return (len - ip < IDU_LINE_ALIGN) && (x == width);
+}
+
+/*============================================================================*
+ *                           File encode/verify
+ *============================================================================*/
+static uint8_t pixel_bytes_code(uint32_t bpp, bool rtl87x3eu)
+{
+    return (uint8_t)(rtl87x3eu ? (bpp - 1) : (bpp - 2));
+}
+
+static void encode_file(const image_t *img, candidate_t *c, bool rtl87x3eu)
+{
+    encode_cfg_t *cfg = &c->cfg;
+    bytes_t *file = &c->file;
+    uint32_t line_bytes = img->width * img->bpp;
+    uint32_t table_size = (img->height + 1) * 4;
+    bytes_t yuv = {0};
+
+    file->size = 0;
+    bytes_put_u8(file, (uint8_t)(cfg->algorithm | (cfg->feature_1 << 2) | (cfg->feature_2 << 4) |
+                                 (pixel_bytes_code(img->bpp, rtl87x3eu) << 6)));
+    bytes_put_le(file, 0, 3);
+    bytes_put_le(file, img->width, 4);
+    bytes_put_le(file, img->height, 4);
+    bytes_reserve(file, table_size);
+    memset(file->data + file->size, 0, table_size);
+    file->size += table_size;
+
+    c->cost = 0;
+    for (uint32_t y = 0; y < img->height; y++)
+    {
+        const uint8_t *line = img->data + y * line_bytes;
+        uint32_t start = file->size;
+        uint64_t work = 0;
+        memcpy(file->data + IDU_HEADER_SIZE + y * 4, &start, 4);
+        switch (cfg->algorithm)
+        {
+        case IDU_RLE:
+            work = rle_encode_line(file, line, img->width, img->bpp, cfg->feature_1);
+            break;
+        case IDU_FASTLZ:
+            work = fastlz_compress(file, line, line_bytes) * COST_FASTLZ_TOKEN;
+            break;
+        case IDU_YUV_SAMPLE_BLUR:
+            work = yuv_pack_line(file, line, img->width, img->bpp, cfg->feature_1, cfg->feature_2);
+            break;
+        default:
+            yuv.size = 0;
+            work = yuv_pack_line(&yuv, line, img->width, img->bpp, cfg->feature_1, cfg->feature_2);
+            work += fastlz_compress(file, yuv.data, yuv.size) * COST_FASTLZ_TOKEN;
+            break;
+        }
+        while (file->size % IDU_LINE_ALIGN)
+        {
+            bytes_put_u8(file, 0);
+        }
+        c->cost += COST_LINE + work + (file->size - start + 3) / 4 * COST_RX_WORD +
+                   (line_bytes + 3) / 4 * COST_TX_WORD;
+    }
+    uint32_t end = file->size;
+    memcpy(file->data + IDU_HEADER_SIZE + img->height * 4, &end, 4);
+    free(yuv.data);
+}
+
+/* Decodes the candidate back and records the largest per-channel error, decoded may be NULL. */
+static bool verify_file(const image_t *img, candidate_t *c, uint8_t *decoded)
+{
+    const uint8_t *file = c->file.data;
+    uint32_t line_bytes = img->width * img->bpp;
+    uint8_t *line = malloc(line_bytes);
+    uint8_t *yuv = malloc(line_bytes * 2 + 16);
+    bool ok = true;
+
+    c->max_error = 0;
+    for (uint32_t y = 0; y < img->height && ok; y++)
+    {
+        uint32_t start = read_le(file + IDU_HEADER_SIZE + y * 4, 4);
+        uint32_t end = read_le(file + IDU_HEADER_SIZE + (y + 1) * 4, 4);
+        const uint8_t *src = file + start;
+        uint32_t len = end - start;
+        uint32_t yuv_len = 0;
+        switch (c->cfg.algorithm)
+        {
+        case IDU_RLE:
+            ok = rle_decode_line(src, len, line, img->width, img->bpp, c->cfg.feature_1);
+            break;
+        case IDU_FASTLZ:
+            ok = fastlz_decompress(src, len, line, line_bytes);
+            break;
+        case IDU_YUV_SAMPLE_BLUR:
+            ok = yuv_unpack_line(src, len, line, img->width, img->bpp, c->cfg.feature_1, c->cfg.feature_2);
+            break;
+        default:
+            {
+                uint32_t group = yuv_group_pixels[c->cfg.feature_1];
+                uint32_t bits = (group + 2) * (8 - yuv_blur_bits[c->cfg.feature_2]);
+                yuv_len = ((img->width + group - 1) / group * bits + 7) / 8;
+                ok = fastlz_decompress(src, len, yuv, yuv_len) &&
+                     yuv_unpack_line(yuv, yuv_len, line, img->width, img->bpp, c->cfg.feature_1,
+                                     c->cfg.feature_2);
+            }
+            break;
+        }
+        if (ok && decoded)
+        {
+            memcpy(decoded + y * line_bytes, line, line_bytes);
+        }
+        for (uint32_t x = 0; x < img->width && ok; x++)
+        {
+            uint8_t a[4], b[4];
+            pixel_to_rgba(img->data + y * line_bytes + x * img->bpp, img->bpp, a);
+            pixel_to_rgba(line + x * img->bpp, img->bpp, b);
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                uint32_t err = (a[i] > b[i]) ? (a[i] - b[i]) : (b[i] - a[i]);
+                if (err > c->max_error)
+                {
+                    c->max_error = err;
+                }
+            }
+        }
+    }
+    free(line);
+    free(yuv);
+    return ok;
+}
+
+static bool image_is_opaque(const image_t *img)
+{
+    if (img->bpp != 4)
+    {
+        return true;
+    }
+    for (uint32_t i = 0; i < img->width * img->height; i++)
+    {
+        if (img->data[i * 4 + 3] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t build_candidates(const image_t *img, const encode_option_t *opt, encode_cfg_t *cfg)
+{
+    uint32_t num = 0;
+    for (uint8_t algorithm = 0; algorithm < 4; algorithm++)
+    {
+        bool yuv = (algorithm == IDU_YUV_SAMPLE_BLUR) || (algorithm == IDU_YUV_SAMPLE_BLUR_FASTLZ);
+        if ((opt->family >= 0 && opt->family != algorithm) ||
+            (yuv && (!opt->experimental_yuv || !image_is_opaque(img))))
+        {
+            continue;
+        }
+        if (algorithm == IDU_RLE)
+        {
+            cfg[num++] = (encode_cfg_t) {IDU_RLE, 1, 0};
+            cfg[num++] = (encode_cfg_t) {IDU_RLE, 2, 0};
+        }
+        else if (algorithm == IDU_FASTLZ)
+        {
+            cfg[num++] = (encode_cfg_t) {IDU_FASTLZ, 0, 0};
+        }
+        else
+        {
+            for (uint8_t sample = 0; sample < 3; sample++)
+            {
+                for (uint8_t blur = 0; blur < 4; blur++)
+                {
+                    cfg[num++] = (encode_cfg_t) {algorithm, sample, blur};
+                }
+            }
+        }
+    }
+    return num;
+}
+
+static bool candidate_better(const candidate_t *a, const candidate_t *b, encode_policy policy)
+{
+    if (!b->valid)
+    {
+        return true;
+    }
+    if (policy == POLICY_SPEED)
+    {
+        return (a->cost < b->cost) || (a->cost == b->cost && a->file.size < b->file.size);
+    }
+    return (a->file.size < b->file.size) || (a->file.size == b->file.size && a->cost < b->cost);
+}
+
+static void describe_cfg(const encode_cfg_t *cfg, char *buf, size_t len)
+{
+    static const char *sample_name[3] = {"444", "422", "411"};
+    if (cfg->algorithm == IDU_RLE)
+    {
+        snprintf(buf, len, "rle len%u", cfg->feature_1);
+    }
+    else if (cfg->algorithm == IDU_FASTLZ)
+    {
+        snprintf(buf, len, "fastlz");
+    }
+    else
+    {
+        snprintf(buf, len, "%s %s blur%u", algorithm_name[cfg->algorithm], sample_name[cfg->feature_1],
+                 yuv_blur_bits[cfg->feature_2]);
+    }
+}
+
+/*============================================================================*
+ *                           Software decoder bench
+ *============================================================================*/
+/* Check of IDU_Decode_SW against the reference decode, then timing of full decodes. */
+static bool bench_candidate(const image_t *img, candidate_t *c, bench_stat_t *stat)
+{
+    uint32_t line_bytes = img->width * img->bpp;
+    uint8_t *reference = malloc(line_bytes * img->height);
+    uint8_t *out = malloc(line_bytes * img->height);
+    bool ok = verify_file(img, c, reference);
+
+    srand(c->file.size);
+    for (uint32_t i = 0; i <= BENCH_WINDOWS && ok; i++)
+    {
+        IDU_decode_range range = {0, img->height - 1, 0, img->width - 1};
+        if (i > 0)
+        {
+            range.start_line = rand() % img->height;
+            range.end_line = range.start_line + rand() % (img->height - range.start_line);
+            range.start_column = rand() % img->width;
+            range.end_column = range.start_column + rand() % (img->width - range.start_column);
+        }
+        uint32_t window_bytes = (range.end_column - range.start_column + 1) * img->bpp;
+        uint32_t stride = (i & 1) ? line_bytes : 0;
+        uint32_t pitch = stride ? stride : window_bytes;
+        ok = (IDU_Decode_SW(c->file.data, &range, out, stride) == IDU_SUCCESS);
+        for (uint32_t y = range.start_line; y <= range.end_line && ok; y++)
+        {
+            ok = !memcmp(out + (y - range.start_line) * pitch,
+                         reference + y * line_bytes + range.start_column * img->bpp, window_bytes);
+        }
+    }
+    if (ok)
+    {
+        uint32_t runs = 0;
+        clock_t start = clock(), elapsed;
+        do
+        {
+            IDU_Decode_SW(c->file.data, NULL, out, 0);
+            runs++;
+            elapsed = clock() - start;
+        }
+        while (elapsed < BENCH_MIN_CLOCKS);
+        stat->pixels += (double)runs * img->width * img->height;
+        stat->seconds += (double)elapsed / CLOCKS_PER_SEC;
+    }
+    free(reference);
+    free(out);
+    return ok;
+}
+
+/*============================================================================*
+ *                           Image loading
+ *============================================================================*/
+static bool read_token(FILE *fp, char *buf, size_t len)
+{
+    int ch;
+    size_t n = 0;
+    while ((ch = fgetc(fp)) != EOF)
+    {
+        if (ch == '#')
+        {
+            while ((ch = fgetc(fp)) != EOF && ch != '\n');
+        }
+        else if (ch > ' ')
+        {
+            break;
+        }
+    }
+    while (ch != EOF && ch > ' ' && n + 1 < len)
+    {
+        buf[n++] = (char)ch;
+        ch = fgetc(fp);
+    }
+    buf[n] = 0;
+    return n > 0;
+}
+
+/* Binary PPM (P6) or PAM (P7, RGB or RGB_ALPHA), converted to opt->bpp. */
+static bool load_netpbm(FILE *fp, image_t *img, uint32_t bpp)
+{
+    char tok[32];
+    uint32_t depth = 3, maxval = 255;
+    if (!read_token(fp, tok, sizeof(tok)))
+    {
+        return false;
+    }
+    if (strcmp(tok, "P6") == 0)
+    {
+        read_token(fp, tok, sizeof(tok));
+        img->width = strtoul(tok, NULL, 10);
+        read_token(fp, tok, sizeof(tok));
+        img->height = strtoul(tok, NULL, 10);
+        read_token(fp, tok, sizeof(tok));
+        maxval = strtoul(tok, NULL, 10);
+    }
+    else if (strcmp(tok, "P7") == 0)
+    {
+        while (read_token(fp, tok, sizeof(tok)) && strcmp(tok, "ENDHDR") != 0)
+        {
+            char val[32];
+            if (!read_token(fp, val, sizeof(val)))
+            {
+                return false;
+            }
+            if (strcmp(tok, "WIDTH") == 0)
+            {
+                img->width = strtoul(val, NULL, 10);
+            }
+            else if (strcmp(tok, "HEIGHT") == 0)
+            {
+                img->height = strtoul(val, NULL, 10);
+            }
+            else if (strcmp(tok, "DEPTH") == 0)
+            {
+                depth = strtoul(val, NULL, 10);
+            }
+            else if (strcmp(tok, "MAXVAL") == 0)
+            {
+                maxval = strtoul(val, NULL, 10);
+            }
+        }
+    }
+    else
+    {
+        return false;
+    }
+    if (maxval != 255 || (depth != 3 && depth != 4) || img->width == 0 || img->height == 0)
+    {
+        return false;
+    }
+    uint32_t count = img->width * img->height;
+    img->bpp = bpp;
+    img->data = malloc(count * bpp);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t rgba[4] = {0, 0, 0, 0xFF};
+        if (fread(rgba, 1, depth, fp) != depth)
+        {
+            return false;
+        }
+        rgba_to_pixel(rgba, bpp, img->data + i * bpp);
+    }
+    return true;
+}
+
+static bool load_image(const char *path, const encode_option_t *opt, image_t *img)
+{
+    FILE *fp = fopen(path, "rb");
+    bool ok;
+    if (fp == NULL)
+    {
+        return false;
+    }
+    memset(img, 0, sizeof(*img));
+    if (opt->raw_size)
+    {
+        ok = (sscanf(opt->raw_size, "%ux%u", &img->width, &img->height) == 2) && img->width && img->height;
+        if (ok)
+        {
+            size_t size = (size_t)img->width * img->height * opt->bpp;
+            img->bpp = opt->bpp;
+            img->data = malloc(size);
+            ok = fread(img->data, 1, size, fp) == size;
+        }
+    }
+    else
+    {
+        ok = load_netpbm(fp, img, opt->bpp);
+    }
+    fclose(fp);
+    return ok;
+}
+
+/*============================================================================*
+ *                           Output
+ *============================================================================*/
+static void asset_name(const char *path, char *name, size_t len)
+{
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    const char *dot = strrchr(base, '.');
+    size_t n = dot ? (size_t)(dot - base) : strlen(base);
+    memset(name, 0, len);
+    memcpy(name, base, (n < len - 1) ? n : (len - 1));
+}
+
+static bool write_file(const char *path, const void *data, size_t len)
+{
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+    {
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, fp) == len;
+    return (fclose(fp) == 0) && ok;
+}
+
+/* Pack: magic, count, then {offset, size, width, height, name[16]} per asset, data 4-byte aligned. */
+static bool write_pack(const char *path, char (*names)[PACK_NAME_LEN], bytes_t *files,
+                       const image_t *imgs, uint32_t count)
+{
+    bytes_t pack = {0};
+    uint32_t offset = 8 + count * (16 + PACK_NAME_LEN);
+    bytes_put_le(&pack, PACK_MAGIC, 4);
+    bytes_put_le(&pack, count, 4);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        offset = (offset + 3) & ~3u;
+        bytes_put_le(&pack, offset, 4);
+        bytes_put_le(&pack, files[i].size, 4);
+        bytes_put_le(&pack, imgs[i].width, 4);
+        bytes_put_le(&pack, imgs[i].height, 4);
+        bytes_put(&pack, names[i], PACK_NAME_LEN);
+        offset += files[i].size;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        while (pack.size & 3)
+        {
+            bytes_put_u8(&pack, 0);
+        }
+        bytes_put(&pack, files[i].data, files[i].size);
+    }
+    bool ok = write_file(path, pack.data, pack.size);
+    free(pack.data);
+    return ok;
+}
+
+static void usage(const char *prog)
+{
+    printf("usage: %s [options] image...\n"
+           "Encode PPM/PAM (or raw) images into IDU compressed files.\n"
+           "  -f, --format FMT      rgb565 | rgb888 | argb8888, default rgb565\n"
+           "  -s, --size WxH        inputs are raw pixels already in FMT\n"
+           "  -p, --policy POLICY   size | speed, default size\n"
+           "  -a, --algorithm ALG   only try rle | fastlz | yuv | yuv-fastlz\n"
+           "  -y, --experimental-yuv  also try the YUV algorithms, not verified on the IDU\n"
+           "  -e, --max-error N     largest channel error a YUV result may have, default 8\n"
+           "  -o, --output DIR      directory for <name>.bin, default .\n"
+           "  -P, --pack FILE       also write every asset into one pack file\n"
+           "  -v, --verbose         list every candidate\n"
+           "  -b, --bench           check and time IDU_Decode_SW on every candidate\n"
+           "      --rtl87x3eu       use the RTL87x3EU pixel_bytes encoding\n", prog);
+}
+
+static bool parse_options(int argc, char **argv, encode_option_t *opt)
+{
+    static const struct option longopts[] =
+    {
+        {"format", required_argument, NULL, 'f'},
+        {"size", required_argument, NULL, 's'},
+        {"policy", required_argument, NULL, 'p'},
+        {"algorithm", required_argument, NULL, 'a'},
+        {"experimental-yuv", no_argument, NULL, 'y'},
+        {"max-error", required_argument, NULL, 'e'},
+        {"output", required_argument, NULL, 'o'},
+        {"pack", required_argument, NULL, 'P'},
+        {"verbose", no_argument, NULL, 'v'},
+        {"bench", no_argument, NULL, 'b'},
+        {"rtl87x3eu", no_argument, NULL, 'r'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int ch;
+    *opt = (encode_option_t) {2, POLICY_SIZE, false, 8, -1, false, false, false, NULL, ".", NULL};
+    while ((ch = getopt_long(argc, argv, "f:s:p:a:ye:o:P:vbh", longopts, NULL)) != -1)
+    {
+        switch (ch)
+        {
+        case 'f':
+            opt->bpp = !strcmp(optarg, "rgb565") ? 2 : !strcmp(optarg, "rgb888") ? 3 :
+                       !strcmp(optarg, "argb8888") ? 4 : 0;
+            if (opt->bpp == 0)
+            {
+                return false;
+            }
+            break;
+        case 's':
+            opt->raw_size = optarg;
+            break;
+        case 'p':
+            if (!strcmp(optarg, "size") || !strcmp(optarg, "speed"))
+            {
+                opt->policy = !strcmp(optarg, "size") ? POLICY_SIZE : POLICY_SPEED;
+                break;
+            }
+            return false;
+        case 'a':
+            opt->family = -1;
+            for (int i = 0; i < 4; i++)
+            {
+                if (!strcmp(optarg, algorithm_name[i]))
+                {
+                    opt->family = i;
+                }
+            }
+            if (opt->family < 0)
+            {
+                return false;
+            }
+            break;
+        case 'y':
+            opt->experimental_yuv = true;
+            break;
+        case 'e':
+            opt->max_error = strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            opt->out_dir = optarg;
+            break;
+        case 'P':
+            opt->pack = optarg;
+            break;
+        case 'v':
+            opt->verbose = true;
+            break;
+        case 'b':
+            opt->bench = true;
+            break;
+        case 'r':
+            opt->rtl87x3eu = true;
+            break;
+        default:
+            return false;
+        }
+    }
+    if ((opt->family >= IDU_YUV_SAMPLE_BLUR_FASTLZ) && !opt->experimental_yuv)
+    {
+        fprintf(stderr, "-a %s needs --experimental-yuv\n", algorithm_name[opt->family]);
+        return false;
+    }
+    return optind < argc;
+}
+
+int main(int argc, char **argv)
+{
+    encode_option_t opt;
+    if (!parse_options(argc, argv, &opt))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (opt.bench && opt.rtl87x3eu)
+    {
+        fprintf(stderr, "--bench is built for the RTL87x2G pixel_bytes encoding\n");
+        return 1;
+    }
+    uint32_t count = argc - optind;
+    image_t *imgs = calloc(count, sizeof(image_t));
+    bytes_t *files = calloc(count, sizeof(bytes_t));
+    char (*names)[PACK_NAME_LEN] = calloc(count, PACK_NAME_LEN);
+    char name[256];
+    bench_stat_t stat[4] = {{0}};
+    int ret = 0;
+
+    printf("%-16s %9s %9s %6s %10s  %s\n", "asset", "raw", "encoded", "ratio", "cost", "setting");
+    for (uint32_t n = 0; n < count; n++)
+    {
+        const char *path = argv[optind + n];
+        image_t *img = &imgs[n];
+        encode_cfg_t cfg[32];
+        candidate_t best = {0};
+        char desc[32];
+
+        if (!load_image(path, &opt, img))
+        {
+            fprintf(stderr, "%s: cannot load image\n", path);
+            ret = 1;
+            continue;
+        }
+        asset_name(path, name, sizeof(name));
+        memcpy(names[n], name, PACK_NAME_LEN - 1);
+        uint32_t raw = img->width * img->height * img->bpp;
+        uint32_t num = build_candidates(img, &opt, cfg);
+        for (uint32_t i = 0; i < num; i++)
+        {
+            candidate_t c = {cfg[i], {0}, 0, 0, false};
+            encode_file(img, &c, opt.rtl87x3eu);
+            bool lossy = (cfg[i].algorithm >= IDU_YUV_SAMPLE_BLUR_FASTLZ);
+            bool decoded = verify_file(img, &c, NULL);
+            c.valid = decoded && (lossy ? (c.max_error <= opt.max_error) : (c.max_error == 0));
+            if (opt.bench && decoded && !bench_candidate(img, &c, &stat[cfg[i].algorithm]))
+            {
+                describe_cfg(&c.cfg, desc, sizeof(desc));
+                fprintf(stderr, "%s: IDU_Decode_SW mismatch on %s\n", path, desc);
+                ret = 1;
+            }
+            if (opt.verbose)
+            {
+                describe_cfg(&c.cfg, desc, sizeof(desc));
+                printf("  %-14s %9u %9u %5.1f%% %10llu  %s err %u%s\n", "", raw, c.file.size,
+                       100.0 * c.file.size / raw, (unsigned long long)c.cost, desc, c.max_error,
+                       c.valid ? "" : " rejected");
+            }
+            if (c.valid && candidate_better(&c, &best, opt.policy))
+            {
+                free(best.file.data);
+                best = c;
+            }
+            else
+            {
+                free(c.file.data);
+            }
+        }
+        if (!best.valid)
+        {
+            fprintf(stderr, "%s: no setting satisfies the constraints\n", path);
+            ret = 1;
+            continue;
+        }
+        char out[512];
+        snprintf(out, sizeof(out), "%s/%s.bin", opt.out_dir, name);
+        if (!write_file(out, best.file.data, best.file.size))
+        {
+            fprintf(stderr, "%s: cannot write\n", out);
+            ret = 1;
+        }
+        describe_cfg(&best.cfg, desc, sizeof(desc));
+        printf("%-16s %9u %9u %5.1f%% %10llu  %s\n", name, raw, best.file.size,
+               100.0 * best.file.size / raw, (unsigned long long)best.cost, desc);
+        files[n] = best.file;
+    }
+    if (opt.pack && ret == 0 && !write_pack(opt.pack, names, files, imgs, count))
+    {
+        fprintf(stderr, "%s: cannot write\n", opt.pack);
+        ret = 1;
+    }
+    if (opt.bench)
+    {
+        printf("\n%-12s %10s\n", "algorithm", "MPix/s");
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            if (stat[i].seconds > 0)
+            {
+                printf("%-12s %10.1f\n", algorithm_name[i], stat[i].pixels / stat[i].seconds / 1e6);
+            }
+        }
+    }
+    for (uint32_t n = 0; n < count; n++)
+    {
+        free(imgs[n].data);
+        free(files[n].data);
+    }
+    free(imgs);
+    free(files);
+    free(names);
+    return ret;
+}